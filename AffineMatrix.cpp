@@ -0,0 +1,70 @@
+#include "AffineMatrix.h"
+
+using namespace DirectX;
+
+// --------------------------------------------------------
+// Builds the world matrix from its components
+//
+// - The rotation matrix's rows are the rotated axes, which
+//   become columns here, each scaled by its axis' scale
+// --------------------------------------------------------
+AffineMatrix AffineMatrix::Compose(XMFLOAT3 position, XMFLOAT4 rotation, XMFLOAT3 scale)
+{
+	XMFLOAT3X3 rot;
+	XMStoreFloat3x3(&rot, XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)));
+	float s[3] = { scale.x, scale.y, scale.z };
+	float t[3] = { position.x, position.y, position.z };
+
+	AffineMatrix result;
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 3; c++)
+			result.rows[r][c] = rot.m[c][r] * s[c];
+		result.rows[r][3] = t[r];
+	}
+	return result;
+}
+
+// --------------------------------------------------------
+// Builds the inverse transpose from the same components
+//
+// - As a column vector matrix the world's 3x3 is R * S, so
+//   its inverse transpose is R * S^-1: the same columns as
+//   Compose(), divided by the scale instead
+// --------------------------------------------------------
+AffineMatrix AffineMatrix::ComposeInverseTranspose(XMFLOAT4 rotation, XMFLOAT3 scale)
+{
+	XMFLOAT3X3 rot;
+	XMStoreFloat3x3(&rot, XMMatrixRotationQuaternion(XMLoadFloat4(&rotation)));
+	float s[3] = { 1.0f / scale.x, 1.0f / scale.y, 1.0f / scale.z };
+
+	AffineMatrix result;
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 3; c++)
+			result.rows[r][c] = rot.m[c][r] * s[c];
+		result.rows[r][3] = 0.0f;
+	}
+	return result;
+}
+
+AffineMatrix AffineMatrix::FromMatrix(const XMFLOAT4X4& m)
+{
+	// A row vector matrix's columns are this one's rows
+	AffineMatrix result;
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 4; c++)
+			result.rows[r][c] = m.m[c][r];
+	}
+	return result;
+}
+
+XMFLOAT4X4 AffineMatrix::ToMatrix() const
+{
+	return XMFLOAT4X4(
+		rows[0][0], rows[1][0], rows[2][0], 0.0f,
+		rows[0][1], rows[1][1], rows[2][1], 0.0f,
+		rows[0][2], rows[1][2], rows[2][2], 0.0f,
+		rows[0][3], rows[1][3], rows[2][3], 1.0f);
+}
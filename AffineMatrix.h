@@ -0,0 +1,29 @@
+#pragma once
+#include <DirectXMath.h>
+
+// --------------------------------------------------------
+// An affine transform stored as the top 3 rows of a 4x4
+// matrix that multiplies column vectors
+//
+// - Same layout as SkinMatrix (see Skeleton.h): p' = rows *
+//   (p, 1), and it uploads as an HLSL row_major float3x4
+// - That's 48 bytes instead of a 4x4's 64, as the 4th row
+//   of an affine matrix is always (0, 0, 0, 1)
+// - Built straight from position, rotation and scale, so the
+//   inverse transpose needs no general 4x4 inverse:
+//   (R * S)^-T = R * S^-1 for a rotation R
+// --------------------------------------------------------
+struct AffineMatrix
+{
+	float rows[3][4];
+
+	// scale, then rotation (a normalized quaternion), then position
+	static AffineMatrix Compose(DirectX::XMFLOAT3 position, DirectX::XMFLOAT4 rotation, DirectX::XMFLOAT3 scale);
+
+	// The matrix for normals. Translation doesn't affect normals, so it's left out
+	static AffineMatrix ComposeInverseTranspose(DirectX::XMFLOAT4 rotation, DirectX::XMFLOAT3 scale);
+
+	// To and from DirectXMath's row vector 4x4 matrices
+	static AffineMatrix FromMatrix(const DirectX::XMFLOAT4X4& m);
+	DirectX::XMFLOAT4X4 ToMatrix() const;
+};
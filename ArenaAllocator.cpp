@@ -0,0 +1,448 @@
+#include "ArenaAllocator.h"
+
+#include <bit>
+
+ArenaAllocator::ArenaAllocator(unsigned int capacity)
+{
+	Reset(capacity);
+}
+
+// --------------------------------------------------------
+// Empties the arena, leaving one free block of capacity
+// --------------------------------------------------------
+void ArenaAllocator::Reset(unsigned int capacity)
+{
+	blocks.clear();
+	unusedBlocks.clear();
+	allocations.clear();
+	firstBlock = NoBlock;
+	lastBlock = NoBlock;
+
+	firstLevelBitmap = 0;
+	for (unsigned int fl = 0; fl < FirstLevelCount; fl++)
+	{
+		secondLevelBitmaps[fl] = 0;
+		for (unsigned int sl = 0; sl < SecondLevelCount; sl++)
+			freeLists[fl][sl] = NoBlock;
+	}
+
+	this->capacity = capacity;
+	used = 0;
+
+	if (capacity > 0)
+	{
+		firstBlock = NewBlock(0, capacity);
+		lastBlock = firstBlock;
+		InsertFree(firstBlock);
+	}
+}
+
+// --------------------------------------------------------
+// Finds the size class of a block
+//
+// - Sizes below 16 each get their own class in the first row
+// - Above that, the first level is the power of two and the
+//   second level is the next 4 bits below the leading one
+// --------------------------------------------------------
+void ArenaAllocator::Mapping(unsigned int size, unsigned int& firstLevel, unsigned int& secondLevel)
+{
+	if (size < SecondLevelCount)
+	{
+		firstLevel = 0;
+		secondLevel = size;
+		return;
+	}
+
+	unsigned int log2 = (unsigned int)std::bit_width(size) - 1;
+	firstLevel = log2 - SecondLevelBits + 1;
+	secondLevel = (size >> (log2 - SecondLevelBits)) ^ SecondLevelCount;
+}
+
+unsigned int ArenaAllocator::NewBlock(unsigned int offset, unsigned int size)
+{
+	Block block = { offset, size, NoBlock, NoBlock, NoBlock, NoBlock, 1, true };
+	if (!unusedBlocks.empty())
+	{
+		unsigned int index = unusedBlocks.back();
+		unusedBlocks.pop_back();
+		blocks[index] = block;
+		return index;
+	}
+
+	blocks.push_back(block);
+	return (unsigned int)blocks.size() - 1;
+}
+
+void ArenaAllocator::ReleaseBlock(unsigned int block)
+{
+	unusedBlocks.push_back(block);
+}
+
+void ArenaAllocator::InsertFree(unsigned int block)
+{
+	unsigned int fl, sl;
+	Mapping(blocks[block].size, fl, sl);
+
+	blocks[block].free = true;
+	blocks[block].prevFree = NoBlock;
+	blocks[block].nextFree = freeLists[fl][sl];
+	if (freeLists[fl][sl] != NoBlock)
+		blocks[freeLists[fl][sl]].prevFree = block;
+	freeLists[fl][sl] = block;
+
+	firstLevelBitmap |= 1u << fl;
+	secondLevelBitmaps[fl] |= 1u << sl;
+}
+
+void ArenaAllocator::RemoveFree(unsigned int block)
+{
+	unsigned int fl, sl;
+	Mapping(blocks[block].size, fl, sl);
+
+	Block& b = blocks[block];
+	if (b.prevFree != NoBlock)
+		blocks[b.prevFree].nextFree = b.nextFree;
+	else
+		freeLists[fl][sl] = b.nextFree;
+	if (b.nextFree != NoBlock)
+		blocks[b.nextFree].prevFree = b.prevFree;
+
+	b.prevFree = NoBlock;
+	b.nextFree = NoBlock;
+	b.free = false;
+
+	if (freeLists[fl][sl] == NoBlock)
+	{
+		secondLevelBitmaps[fl] &= ~(1u << sl);
+		if (secondLevelBitmaps[fl] == 0)
+			firstLevelBitmap &= ~(1u << fl);
+	}
+}
+
+// --------------------------------------------------------
+// Finds a free block of at least size elements
+//
+// - The size is rounded up to the next class boundary first,
+//   so the head of any list at or above it is big enough and
+//   no list ever needs searching
+// --------------------------------------------------------
+unsigned int ArenaAllocator::FindFree(unsigned int size) const
+{
+	if (size >= SecondLevelCount)
+	{
+		unsigned int round = (1u << (std::bit_width(size) - 1 - SecondLevelBits)) - 1;
+		if (size > 0xFFFFFFFFu - round)
+			return NoBlock;
+		size += round;
+	}
+
+	unsigned int fl, sl;
+	Mapping(size, fl, sl);
+
+	// Anything left in this power of two?
+	unsigned int secondLevelMap = secondLevelBitmaps[fl] & (~0u << sl);
+	if (secondLevelMap == 0)
+	{
+		// Otherwise take the smallest class of any bigger power of two
+		unsigned int firstLevelMap = fl + 1 < FirstLevelCount ? firstLevelBitmap & (~0u << (fl + 1)) : 0;
+		if (firstLevelMap == 0)
+			return NoBlock;
+
+		fl = (unsigned int)std::countr_zero(firstLevelMap);
+		secondLevelMap = secondLevelBitmaps[fl];
+	}
+
+	sl = (unsigned int)std::countr_zero(secondLevelMap);
+	return freeLists[fl][sl];
+}
+
+// --------------------------------------------------------
+// Takes a free block big enough for the size once aligned
+// --------------------------------------------------------
+unsigned int ArenaAllocator::Allocate(unsigned int size, unsigned int alignment)
+{
+	if (size == 0 || !std::has_single_bit(alignment) || size > 0xFFFFFFFFu - (alignment - 1))
+		return InvalidOffset;
+
+	unsigned int block = FindFree(size + alignment - 1);
+	if (block == NoBlock)
+		return InvalidOffset;
+
+	unsigned int offset = (blocks[block].offset + alignment - 1) & ~(alignment - 1);
+	RemoveFree(block);
+	Carve(block, offset, size, alignment);
+	return offset;
+}
+
+// --------------------------------------------------------
+// Makes [offset, offset + size) of a free block (already off
+// its free list) an allocation
+//
+// - Whatever's left in front and behind goes back as new free
+//   blocks. The blocks either side of a free block are never
+//   free, so neither needs merging
+// --------------------------------------------------------
+void ArenaAllocator::Carve(unsigned int block, unsigned int offset, unsigned int size, unsigned int alignment)
+{
+	// Split off the gap in front, before this block
+	unsigned int gap = offset - blocks[block].offset;
+	if (gap > 0)
+	{
+		unsigned int front = NewBlock(blocks[block].offset, gap);
+		blocks[block].offset = offset;
+		blocks[block].size -= gap;
+
+		blocks[front].prevPhysical = blocks[block].prevPhysical;
+		blocks[front].nextPhysical = block;
+		if (blocks[block].prevPhysical != NoBlock)
+			blocks[blocks[block].prevPhysical].nextPhysical = front;
+		else
+			firstBlock = front;
+		blocks[block].prevPhysical = front;
+
+		InsertFree(front);
+	}
+
+	// Put the remainder back as a new free block right after this one
+	if (blocks[block].size > size)
+	{
+		unsigned int remainder = NewBlock(blocks[block].offset + size, blocks[block].size - size);
+		blocks[block].size = size;
+
+		blocks[remainder].prevPhysical = block;
+		blocks[remainder].nextPhysical = blocks[block].nextPhysical;
+		if (blocks[block].nextPhysical != NoBlock)
+			blocks[blocks[block].nextPhysical].prevPhysical = remainder;
+		else
+			lastBlock = remainder;
+		blocks[block].nextPhysical = remainder;
+
+		InsertFree(remainder);
+	}
+
+	blocks[block].alignment = alignment;
+	allocations[offset] = block;
+	used += size;
+}
+
+// --------------------------------------------------------
+// Frees an allocation, merging it with free neighbours
+// --------------------------------------------------------
+void ArenaAllocator::Free(unsigned int offset)
+{
+	std::unordered_map<unsigned int, unsigned int>::iterator it = allocations.find(offset);
+	if (it == allocations.end())
+		return;
+
+	unsigned int block = it->second;
+	allocations.erase(it);
+	used -= blocks[block].size;
+
+	// Absorb the next block
+	unsigned int next = blocks[block].nextPhysical;
+	if (next != NoBlock && blocks[next].free)
+	{
+		RemoveFree(next);
+		blocks[block].size += blocks[next].size;
+		blocks[block].nextPhysical = blocks[next].nextPhysical;
+		if (blocks[next].nextPhysical != NoBlock)
+			blocks[blocks[next].nextPhysical].prevPhysical = block;
+		else
+			lastBlock = block;
+		ReleaseBlock(next);
+	}
+
+	// Be absorbed by the previous block
+	unsigned int prev = blocks[block].prevPhysical;
+	if (prev != NoBlock && blocks[prev].free)
+	{
+		RemoveFree(prev);
+		blocks[prev].size += blocks[block].size;
+		blocks[prev].nextPhysical = blocks[block].nextPhysical;
+		if (blocks[block].nextPhysical != NoBlock)
+			blocks[blocks[block].nextPhysical].prevPhysical = prev;
+		else
+			lastBlock = prev;
+		ReleaseBlock(block);
+		block = prev;
+	}
+
+	InsertFree(block);
+}
+
+void ArenaAllocator::Grow(unsigned int newCapacity)
+{
+	if (newCapacity <= capacity)
+		return;
+
+	unsigned int added = newCapacity - capacity;
+	capacity = newCapacity;
+
+	if (lastBlock == NoBlock)
+	{
+		firstBlock = NewBlock(0, added);
+		lastBlock = firstBlock;
+		InsertFree(firstBlock);
+	}
+	else if (blocks[lastBlock].free)
+	{
+		// Extend the free block at the end (its size class changes)
+		RemoveFree(lastBlock);
+		blocks[lastBlock].size += added;
+		InsertFree(lastBlock);
+	}
+	else
+	{
+		unsigned int block = NewBlock(capacity - added, added);
+		blocks[block].prevPhysical = lastBlock;
+		blocks[lastBlock].nextPhysical = block;
+		lastBlock = block;
+		InsertFree(block);
+	}
+}
+
+// --------------------------------------------------------
+// Packs every allocation at the start, in address order
+//
+// - Allocations only ever move down, so the moves can be
+//   applied in order within one buffer as long as overlapping
+//   ranges are copied front to back, or into a fresh buffer
+// - Aligned allocations leave free gaps in front of them
+// --------------------------------------------------------
+std::vector<ArenaMove> ArenaAllocator::Compact()
+{
+	std::vector<ArenaMove> moves;
+	std::vector<unsigned int> alignments;
+	moves.reserve(allocations.size());
+	alignments.reserve(allocations.size());
+
+	unsigned int cursor = 0;
+	for (unsigned int b = firstBlock; b != NoBlock; b = blocks[b].nextPhysical)
+	{
+		if (blocks[b].free)
+			continue;
+
+		cursor = (cursor + blocks[b].alignment - 1) & ~(blocks[b].alignment - 1);
+		moves.push_back({ blocks[b].offset, cursor, blocks[b].size });
+		alignments.push_back(blocks[b].alignment);
+		cursor += blocks[b].size;
+	}
+
+	// Rebuild the block list to match, carving each one out of the free space at the end
+	Reset(capacity);
+	for (unsigned int m = 0; m < (unsigned int)moves.size(); m++)
+	{
+		unsigned int block = lastBlock;
+		RemoveFree(block);
+		Carve(block, moves[m].to, moves[m].size, alignments[m]);
+	}
+
+	return moves;
+}
+
+ArenaStats ArenaAllocator::GetStats() const
+{
+	ArenaStats stats = {};
+	stats.capacity = capacity;
+	stats.used = used;
+	stats.allocations = (unsigned int)allocations.size();
+
+	for (unsigned int b = firstBlock; b != NoBlock; b = blocks[b].nextPhysical)
+	{
+		if (!blocks[b].free)
+			continue;
+
+		stats.freeBlocks++;
+		if (blocks[b].size > stats.largestFreeBlock)
+			stats.largestFreeBlock = blocks[b].size;
+	}
+
+	return stats;
+}
+
+unsigned int ArenaAllocator::GetCapacity() const
+{
+	return this->capacity;
+}
+
+float ArenaAllocator::GetFragmentation() const
+{
+	unsigned int freeSpace = capacity - used;
+	if (freeSpace == 0)
+		return 0.0f;
+
+	return 1.0f - (float)GetStats().largestFreeBlock / freeSpace;
+}
+
+// --------------------------------------------------------
+// Checks that:
+// - The physical blocks tile [0, capacity) in order
+// - No two free blocks are next to each other
+// - Every free block is in the right list, and only those are
+// - The bitmaps match the lists
+// - The allocation map and used count match the used blocks
+// - Every allocation is aligned
+// --------------------------------------------------------
+bool ArenaAllocator::Validate() const
+{
+	unsigned int offset = 0;
+	unsigned int usedSize = 0;
+	unsigned int usedBlocks = 0;
+	unsigned int freeBlocks = 0;
+	unsigned int prev = NoBlock;
+	for (unsigned int b = firstBlock; b != NoBlock; b = blocks[b].nextPhysical)
+	{
+		const Block& block = blocks[b];
+		if (block.offset != offset || block.size == 0 || block.prevPhysical != prev)
+			return false;
+		if (block.free && prev != NoBlock && blocks[prev].free)
+			return false;
+
+		if (block.free)
+		{
+			freeBlocks++;
+		}
+		else
+		{
+			std::unordered_map<unsigned int, unsigned int>::const_iterator it = allocations.find(block.offset);
+			if (it == allocations.end() || it->second != b || (block.offset & (block.alignment - 1)) != 0)
+				return false;
+			usedSize += block.size;
+			usedBlocks++;
+		}
+
+		offset += block.size;
+		prev = b;
+	}
+
+	if (offset != capacity || prev != lastBlock || usedSize != used || usedBlocks != allocations.size())
+		return false;
+
+	unsigned int listed = 0;
+	for (unsigned int fl = 0; fl < FirstLevelCount; fl++)
+	{
+		for (unsigned int sl = 0; sl < SecondLevelCount; sl++)
+		{
+			bool bit = (secondLevelBitmaps[fl] & (1u << sl)) != 0;
+			if (bit != (freeLists[fl][sl] != NoBlock))
+				return false;
+
+			unsigned int prevFree = NoBlock;
+			for (unsigned int b = freeLists[fl][sl]; b != NoBlock; b = blocks[b].nextFree)
+			{
+				unsigned int blockFL, blockSL;
+				Mapping(blocks[b].size, blockFL, blockSL);
+				if (!blocks[b].free || blocks[b].prevFree != prevFree || blockFL != fl || blockSL != sl)
+					return false;
+				prevFree = b;
+				listed++;
+			}
+		}
+
+		bool bit = (firstLevelBitmap & (1u << fl)) != 0;
+		if (bit != (secondLevelBitmaps[fl] != 0))
+			return false;
+	}
+
+	return listed == freeBlocks;
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+
+// --------------------------------------------------------
+// Occupancy of an arena, in elements
+// --------------------------------------------------------
+struct ArenaStats
+{
+	unsigned int capacity;
+	unsigned int used;
+	unsigned int allocations;
+	unsigned int freeBlocks;
+	unsigned int largestFreeBlock;
+};
+
+// --------------------------------------------------------
+// Where one allocation went during compaction
+// --------------------------------------------------------
+struct ArenaMove
+{
+	unsigned int from;
+	unsigned int to;
+	unsigned int size;
+};
+
+// --------------------------------------------------------
+// Hands out ranges of a fixed size buffer without touching
+// the buffer itself
+//
+// - Two-level segregated fit (TLSF, Masmano et al. 2004):
+//   free blocks are kept in lists by size class and found
+//   through two bitmaps, so Allocate() and Free() take the
+//   same time however fragmented the arena is
+// - The second level splits each power of two into 16
+//   classes, so a block is at most ~6% bigger than needed
+//   before it's split
+// - Freed blocks merge with free neighbours straight away
+// - An allocation can ask for an alignment, which must be a
+//   power of two. The search asks for alignment - 1 extra so
+//   whatever it finds fits, and the gap in front is left free
+// - Compact() slides every allocation down to the start,
+//   keeping its alignment, and says where each one went so
+//   the owner can move the real data
+// - Allocations are identified by their offset; offsets and
+//   sizes are in elements rather than bytes
+// - Has no DirectX dependency, so it can be tested on its own
+// --------------------------------------------------------
+class ArenaAllocator
+{
+public:
+	static const unsigned int InvalidOffset = 0xFFFFFFFF;
+
+	explicit ArenaAllocator(unsigned int capacity = 0);
+
+	// Returns InvalidOffset if there's no free block big enough,
+	// or the alignment isn't a power of two
+	unsigned int Allocate(unsigned int size, unsigned int alignment = 1);
+	void Free(unsigned int offset);
+
+	// Adds free space at the end
+	void Grow(unsigned int newCapacity);
+
+	// Returns a move for every allocation, in address order
+	std::vector<ArenaMove> Compact();
+
+	ArenaStats GetStats() const;
+	unsigned int GetCapacity() const;
+
+	// How much of the free space is outside the largest free
+	// block, from 0 (one block) towards 1 (scattered)
+	float GetFragmentation() const;
+
+	// Checks every internal invariant, for testing
+	bool Validate() const;
+
+private:
+	static const unsigned int SecondLevelBits = 4;
+	static const unsigned int SecondLevelCount = 1 << SecondLevelBits;
+	static const unsigned int FirstLevelCount = 32;
+	static const unsigned int NoBlock = 0xFFFFFFFF;
+
+	struct Block
+	{
+		unsigned int offset;
+		unsigned int size;
+		unsigned int prevPhysical;
+		unsigned int nextPhysical;
+		unsigned int prevFree;
+		unsigned int nextFree;
+		unsigned int alignment;
+		bool free;
+	};
+
+	// Blocks refer to each other by index; unused records are recycled
+	std::vector<Block> blocks;
+	std::vector<unsigned int> unusedBlocks;
+	unsigned int firstBlock;
+	unsigned int lastBlock;
+
+	// Offset -> block for every allocation
+	std::unordered_map<unsigned int, unsigned int> allocations;
+
+	// Free lists by size class, with a bit set for each non-empty one
+	unsigned int firstLevelBitmap;
+	unsigned int secondLevelBitmaps[FirstLevelCount];
+	unsigned int freeLists[FirstLevelCount][SecondLevelCount];
+
+	unsigned int capacity;
+	unsigned int used;
+
+	static void Mapping(unsigned int size, unsigned int& firstLevel, unsigned int& secondLevel);
+
+	unsigned int NewBlock(unsigned int offset, unsigned int size);
+	void ReleaseBlock(unsigned int block);
+	void InsertFree(unsigned int block);
+	void RemoveFree(unsigned int block);
+	unsigned int FindFree(unsigned int size) const;
+	void Carve(unsigned int block, unsigned int offset, unsigned int size, unsigned int alignment);
+	void Reset(unsigned int capacity);
+};
@@ -0,0 +1,339 @@
+// --------------------------------------------------------
+// Tests for ArenaAllocator
+//
+// - Freed blocks merge with their free neighbours
+// - Aligned allocations land on their alignment, and the gaps
+//   they leave are reused and merged back
+// - Allocations fail cleanly once nothing big enough is left
+// - Compact() returns one move per live allocation, in order,
+//   never overlapping and never moving anything up, and the
+//   moves carry the real data with them
+// - Not part of the Visual Studio project. On Linux it's the
+//   arena_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 ArenaAllocatorTests.cpp
+//       ArenaAllocator.cpp -o arena_tests
+// --------------------------------------------------------
+#include "ArenaAllocator.h"
+#include "TestChecks.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+	const unsigned int Invalid = ArenaAllocator::InvalidOffset;
+
+	// --------------------------------------------------------
+	// Frees in every order against their neighbours: after the
+	// next one, before it, and between two free blocks
+	// --------------------------------------------------------
+	void TestCoalescing()
+	{
+		ArenaAllocator arena(1000);
+		unsigned int a = arena.Allocate(100);
+		unsigned int b = arena.Allocate(100);
+		unsigned int c = arena.Allocate(100);
+		unsigned int d = arena.Allocate(100);
+		CHECK(a == 0 && b == 100 && c == 200 && d == 300);
+		CHECK(arena.GetStats().freeBlocks == 1);
+		CHECK(arena.Validate());
+
+		// A hole between two allocations stays on its own
+		arena.Free(b);
+		CHECK(arena.GetStats().freeBlocks == 2);
+		CHECK(arena.Validate());
+
+		// Merges with the free space at the end
+		arena.Free(d);
+		ArenaStats stats = arena.GetStats();
+		CHECK(stats.freeBlocks == 2 && stats.largestFreeBlock == 700);
+		CHECK(arena.Validate());
+
+		// Merges with both sides at once
+		arena.Free(c);
+		stats = arena.GetStats();
+		CHECK(stats.freeBlocks == 1 && stats.largestFreeBlock == 900 && stats.used == 100);
+		CHECK(arena.Validate());
+
+		// Freeing something that isn't allocated does nothing
+		arena.Free(c);
+		arena.Free(50);
+		CHECK(arena.GetStats().used == 100 && arena.Validate());
+
+		// The merged space is usable as one piece, bigger than either half
+		CHECK(arena.Allocate(800) == 100);
+		arena.Free(100);
+		arena.Free(a);
+		stats = arena.GetStats();
+		CHECK(stats.freeBlocks == 1 && stats.largestFreeBlock == 1000 && stats.used == 0 && stats.allocations == 0);
+		CHECK(arena.GetFragmentation() == 0.0f);
+		CHECK(arena.Validate());
+
+		// Merging with the block in front, when the block behind is used
+		unsigned int first = arena.Allocate(10);
+		unsigned int second = arena.Allocate(10);
+		unsigned int third = arena.Allocate(10);
+		arena.Free(first);
+		arena.Free(second);
+		stats = arena.GetStats();
+		CHECK(stats.freeBlocks == 2 && stats.largestFreeBlock == 970);
+		CHECK(arena.Allocate(20) == 0);
+		arena.Free(0);
+		arena.Free(third);
+		CHECK(arena.GetStats().freeBlocks == 1 && arena.Validate());
+	}
+
+	// --------------------------------------------------------
+	// Every power of two up to 1024, after an odd sized
+	// allocation so nothing starts out aligned
+	// --------------------------------------------------------
+	void TestAlignment()
+	{
+		ArenaAllocator arena(1 << 16);
+		CHECK(arena.Allocate(3) == 0);
+
+		std::vector<std::pair<unsigned int, unsigned int>> ranges = { { 0, 3 } };
+		bool aligned = true;
+		for (unsigned int alignment = 1; alignment <= 1024; alignment *= 2)
+		{
+			for (unsigned int size : { 1u, 7u, 100u })
+			{
+				unsigned int offset = arena.Allocate(size, alignment);
+				CHECK(offset != Invalid);
+				aligned = aligned && offset % alignment == 0;
+				ranges.push_back({ offset, offset + size });
+			}
+		}
+		CHECK(aligned);
+		CHECK(arena.Validate());
+
+		std::sort(ranges.begin(), ranges.end());
+		bool overlapping = false;
+		for (size_t r = 1; r < ranges.size(); r++)
+			overlapping = overlapping || ranges[r].first < ranges[r - 1].second;
+		CHECK(!overlapping);
+
+		// Not a power of two
+		CHECK(arena.Allocate(4, 0) == Invalid);
+		CHECK(arena.Allocate(4, 3) == Invalid);
+		CHECK(arena.Allocate(4, 48) == Invalid);
+		CHECK(arena.Validate());
+
+		// The gap in front of an aligned allocation is free, gets
+		// reused, and merges back when the allocation goes
+		ArenaAllocator small(1000);
+		CHECK(small.Allocate(1) == 0);
+		CHECK(small.Allocate(10, 64) == 64);
+		ArenaStats stats = small.GetStats();
+		CHECK(stats.freeBlocks == 2 && stats.used == 11);
+		CHECK(small.Validate());
+
+		unsigned int inGap = small.Allocate(8);
+		CHECK(inGap >= 1 && inGap + 8 <= 64);
+		small.Free(inGap);
+		small.Free(64);
+		stats = small.GetStats();
+		CHECK(stats.freeBlocks == 1 && stats.largestFreeBlock == 999);
+		CHECK(small.Validate());
+	}
+
+	// --------------------------------------------------------
+	// Running out, whether from the arena being full, from the
+	// free space being in pieces, or from alignment
+	// --------------------------------------------------------
+	void TestFull()
+	{
+		ArenaAllocator arena(256);
+		CHECK(arena.Allocate(256) == 0);
+		CHECK(arena.Allocate(1) == Invalid);
+		ArenaStats stats = arena.GetStats();
+		CHECK(stats.used == 256 && stats.freeBlocks == 0 && stats.largestFreeBlock == 0);
+		CHECK(arena.GetFragmentation() == 0.0f);
+		CHECK(arena.Validate());
+
+		arena.Free(0);
+		CHECK(arena.Allocate(257) == Invalid);
+		CHECK(arena.Allocate(0) == Invalid);
+		CHECK(arena.Allocate(0xFFFFFFFFu) == Invalid);
+		CHECK(arena.Allocate(0xFFFFFFFFu - 10, 64) == Invalid);
+		CHECK(arena.Validate());
+
+		// Enough space in total, but not in one piece
+		ArenaAllocator pieces(100);
+		for (unsigned int i = 0; i < 10; i++)
+			CHECK(pieces.Allocate(10) == i * 10);
+		for (unsigned int i = 0; i < 10; i += 2)
+			pieces.Free(i * 10);
+
+		stats = pieces.GetStats();
+		CHECK(stats.used == 50 && stats.freeBlocks == 5 && stats.largestFreeBlock == 10);
+		CHECK(pieces.GetFragmentation() > 0.79f && pieces.GetFragmentation() < 0.81f);
+		CHECK(pieces.Allocate(11) == Invalid);
+		CHECK(pieces.Validate());
+
+		pieces.Compact();
+		CHECK(pieces.Allocate(50) == 50);
+		CHECK(pieces.Allocate(1) == Invalid);
+		CHECK(pieces.Validate());
+
+		// Fits, but not once it's aligned
+		ArenaAllocator tight(100);
+		CHECK(tight.Allocate(1) == 0);
+		CHECK(tight.Allocate(50, 64) == Invalid);
+		CHECK(tight.Allocate(30, 64) == 64);
+		CHECK(tight.Validate());
+
+		// An empty arena has nothing until it grows
+		ArenaAllocator empty;
+		CHECK(empty.Allocate(1) == Invalid);
+		empty.Grow(16);
+		CHECK(empty.Allocate(16) == 0);
+		empty.Grow(32);
+		CHECK(empty.Allocate(16) == 16);
+		CHECK(empty.Validate());
+	}
+
+	struct Live
+	{
+		unsigned int size;
+		unsigned int alignment;
+		unsigned int tag;
+	};
+
+	// --------------------------------------------------------
+	// Random allocations and frees, with each allocation's range
+	// of a mirror buffer filled with its tag, then compaction
+	// --------------------------------------------------------
+	void TestCompact(unsigned int seed)
+	{
+		const unsigned int capacity = 1 << 16;
+		const unsigned int alignments[] = { 1, 1, 1, 2, 4, 16, 64, 256 };
+
+		std::mt19937 random(seed);
+		std::uniform_int_distribution<unsigned int> sizes(1, 600);
+		std::uniform_int_distribution<unsigned int> pickAlignment(0, 7);
+		std::uniform_int_distribution<unsigned int> percent(0, 99);
+
+		ArenaAllocator arena(capacity);
+		std::map<unsigned int, Live> live;
+		std::vector<unsigned int> buffer(capacity, 0);
+		unsigned int nextTag = 1;
+
+		bool valid = true;
+		for (unsigned int step = 0; step < 4000; step++)
+		{
+			if (live.empty() || percent(random) < 60)
+			{
+				Live allocation = { sizes(random), alignments[pickAlignment(random)], nextTag++ };
+				unsigned int offset = arena.Allocate(allocation.size, allocation.alignment);
+				if (offset == Invalid)
+					continue;
+
+				live[offset] = allocation;
+				std::fill(buffer.begin() + offset, buffer.begin() + offset + allocation.size, allocation.tag);
+			}
+			else
+			{
+				std::map<unsigned int, Live>::iterator victim = live.begin();
+				std::advance(victim, random() % live.size());
+				arena.Free(victim->first);
+				live.erase(victim);
+			}
+
+			if (step % 64 == 0)
+				valid = valid && arena.Validate();
+		}
+		CHECK(valid);
+
+		ArenaStats before = arena.GetStats();
+		CHECK(before.allocations == live.size());
+		CHECK(before.freeBlocks > 1);
+
+		std::vector<ArenaMove> moves = arena.Compact();
+		CHECK(arena.Validate());
+
+		// One move for every allocation, in address order, with its size
+		CHECK(moves.size() == live.size());
+		bool matches = moves.size() == live.size();
+		std::map<unsigned int, Live>::const_iterator expected = live.begin();
+		for (size_t m = 0; matches && m < moves.size(); m++, expected++)
+			matches = moves[m].from == expected->first && moves[m].size == expected->second.size;
+		CHECK(matches);
+
+		// Destinations stay aligned, move down, and don't overlap or run off the end
+		bool aligned = true;
+		bool down = true;
+		bool overlapping = false;
+		unsigned int end = 0;
+		expected = live.begin();
+		for (size_t m = 0; matches && m < moves.size(); m++, expected++)
+		{
+			aligned = aligned && moves[m].to % expected->second.alignment == 0;
+			down = down && moves[m].to <= moves[m].from;
+			overlapping = overlapping || moves[m].to < end;
+			end = moves[m].to + moves[m].size;
+		}
+		CHECK(aligned && down && !overlapping);
+		CHECK(end <= capacity);
+
+		// Only alignment gaps are left, then one block at the end
+		ArenaStats after = arena.GetStats();
+		CHECK(after.used == before.used && after.allocations == before.allocations);
+		CHECK(after.largestFreeBlock == capacity - end);
+		CHECK(after.largestFreeBlock >= before.largestFreeBlock);
+
+		// Applying the moves front to back, in place, carries every allocation's data
+		for (const ArenaMove& move : moves)
+			std::copy(buffer.begin() + move.from, buffer.begin() + move.from + move.size, buffer.begin() + move.to);
+
+		bool carried = true;
+		expected = live.begin();
+		for (size_t m = 0; matches && m < moves.size(); m++, expected++)
+		{
+			for (unsigned int i = 0; i < moves[m].size; i++)
+				carried = carried && buffer[moves[m].to + i] == expected->second.tag;
+		}
+		CHECK(carried);
+
+		// Allocations are known by their new offsets from now on
+		for (const ArenaMove& move : moves)
+			arena.Free(move.to);
+		after = arena.GetStats();
+		CHECK(after.used == 0 && after.allocations == 0 && after.freeBlocks == 1);
+		CHECK(arena.Validate());
+
+		printf("  Seed %u: %u allocations, %u free blocks (largest %u) -> %u (largest %u)\n",
+			seed, before.allocations, before.freeBlocks, before.largestFreeBlock,
+			arena.GetStats().freeBlocks, capacity - end);
+	}
+
+	// Compacting nothing, and an arena with no gaps, changes nothing
+	void TestCompactTrivial()
+	{
+		ArenaAllocator empty(100);
+		CHECK(empty.Compact().empty());
+		CHECK(empty.GetStats().freeBlocks == 1 && empty.Validate());
+
+		ArenaAllocator packed(100);
+		packed.Allocate(40);
+		packed.Allocate(60);
+		std::vector<ArenaMove> moves = packed.Compact();
+		CHECK(moves.size() == 2);
+		CHECK(moves.size() == 2 && moves[0].from == 0 && moves[0].to == 0 && moves[1].from == 40 && moves[1].to == 40);
+		CHECK(packed.GetStats().freeBlocks == 0 && packed.Validate());
+	}
+}
+
+int main()
+{
+	TestCoalescing();
+	TestAlignment();
+	TestFull();
+	for (unsigned int seed : { 1u, 2u, 3u })
+		TestCompact(seed);
+	TestCompactTrivial();
+
+	return TestChecks::Finish("ArenaAllocator");
+}
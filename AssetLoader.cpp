@@ -0,0 +1,163 @@
+#include "AssetLoader.h"
+
+#include <algorithm>
+
+AssetLoader::AssetLoader(unsigned int threadCount, std::function<void()> workerStart, std::function<void()> workerStop)
+	: workerStart(workerStart), workerStop(workerStop), stopping(false), stats()
+{
+	if (threadCount == 0)
+		threadCount = 1;
+
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&AssetLoader::WorkerLoop, this);
+}
+
+// --------------------------------------------------------
+// Stops the workers once they finish what they're running,
+// then destroys anything that never got to run
+//
+// - That includes coroutines waiting on a handle, as nothing
+//   is left to finish the load they're waiting for
+// --------------------------------------------------------
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (std::coroutine_handle<> coroutine : backgroundQueue)
+		coroutine.destroy();
+	for (std::coroutine_handle<> coroutine : mainThreadQueue)
+		coroutine.destroy();
+	for (std::coroutine_handle<> coroutine : waiters)
+		coroutine.destroy();
+}
+
+AssetLoader::BackgroundAwaiter AssetLoader::ResumeInBackground()
+{
+	return BackgroundAwaiter{ this };
+}
+
+AssetLoader::MainThreadAwaiter AssetLoader::ResumeOnMainThread()
+{
+	return MainThreadAwaiter{ this };
+}
+
+// --------------------------------------------------------
+// Resumes coroutines that are waiting for the main thread
+//
+// - Always resumes at least one, so loads keep moving even
+//   with a tiny budget
+// --------------------------------------------------------
+void AssetLoader::Update(double budgetSeconds)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+	double seconds = 0.0;
+
+	while (true)
+	{
+		std::coroutine_handle<> coroutine;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (mainThreadQueue.empty())
+				break;
+
+			coroutine = mainThreadQueue.front();
+			mainThreadQueue.pop_front();
+		}
+
+		coroutine.resume();
+
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		if (seconds >= budgetSeconds)
+			break;
+	}
+
+	if (seconds > stats.worstUpdateSeconds)
+		stats.worstUpdateSeconds = seconds;
+}
+
+AssetLoaderStats AssetLoader::GetStats() const
+{
+	return this->stats;
+}
+
+void AssetLoader::AssetFinished(bool succeeded)
+{
+	stats.pending--;
+	if (succeeded)
+		stats.completed++;
+	else
+		stats.failed++;
+}
+
+void AssetLoader::AddWaiter(std::coroutine_handle<> waiter)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	waiters.push_back(waiter);
+}
+
+void AssetLoader::RemoveWaiters(const std::vector<std::coroutine_handle<>>& finished)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	for (std::coroutine_handle<> waiter : finished)
+	{
+		std::vector<std::coroutine_handle<>>::iterator found = std::find(waiters.begin(), waiters.end(), waiter);
+		if (found != waiters.end())
+		{
+			*found = waiters.back();
+			waiters.pop_back();
+		}
+	}
+}
+
+void AssetLoader::QueueInBackground(std::coroutine_handle<> coroutine)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		backgroundQueue.push_back(coroutine);
+	}
+	workAvailable.notify_one();
+}
+
+void AssetLoader::QueueOnMainThread(std::coroutine_handle<> coroutine)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	mainThreadQueue.push_back(coroutine);
+}
+
+// --------------------------------------------------------
+// Runs background work until the loader is destroyed
+//
+// - The coroutine may have moved itself to another queue by
+//   the time resume() returns, so it's never touched after
+// --------------------------------------------------------
+void AssetLoader::WorkerLoop()
+{
+	if (workerStart)
+		workerStart();
+
+	while (true)
+	{
+		std::coroutine_handle<> coroutine;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			workAvailable.wait(lock, [this]() { return stopping || !backgroundQueue.empty(); });
+			if (stopping)
+				break;
+
+			coroutine = backgroundQueue.front();
+			backgroundQueue.pop_front();
+		}
+
+		coroutine.resume();
+	}
+
+	if (workerStop)
+		workerStop();
+}
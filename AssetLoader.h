@@ -0,0 +1,269 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template<typename T> class AssetHandle;
+
+enum class AssetState
+{
+	Loading,
+	Ready,
+	Failed
+};
+
+// --------------------------------------------------------
+// Loading progress and how much it cost the main thread
+//
+// - worstUpdateSeconds is the longest a single Update() spent
+//   finishing loads, which is the loader's share of any hitch
+// --------------------------------------------------------
+struct AssetLoaderStats
+{
+	unsigned int pending;
+	unsigned int completed;
+	unsigned int failed;
+	double worstUpdateSeconds;
+};
+
+// --------------------------------------------------------
+// Return type of an asset loading coroutine
+//
+// - Fire and forget: the coroutine starts running straight
+//   away and frees itself when it finishes
+// - Results are handed back through an AssetHandle rather
+//   than through the task
+// --------------------------------------------------------
+struct AssetTask
+{
+	struct promise_type
+	{
+		AssetTask get_return_object() { return {}; }
+		std::suspend_never initial_suspend() noexcept { return {}; }
+		std::suspend_never final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+// --------------------------------------------------------
+// Runs asset loading coroutines across background threads
+// and the main thread
+//
+// - co_await ResumeInBackground() moves a coroutine onto a
+//   worker thread, for file IO, parsing and anything else that
+//   doesn't need the device context
+// - co_await ResumeOnMainThread() moves it back; it resumes
+//   inside the next Update(), which is where handles are
+//   finished and their assets swapped in
+// - Update() stops once it has used its time budget, so a
+//   burst of finished loads is spread over several frames
+// - Coroutines still queued on shutdown, or still waiting on
+//   a handle's WhenFinished(), are destroyed without being
+//   resumed
+// - Has no DirectX dependency; per-thread setup (like COM)
+//   goes in the worker start/stop callbacks
+// --------------------------------------------------------
+class AssetLoader
+{
+public:
+	struct BackgroundAwaiter
+	{
+		AssetLoader* loader;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine) { loader->QueueInBackground(coroutine); }
+		void await_resume() const noexcept {}
+	};
+
+	struct MainThreadAwaiter
+	{
+		AssetLoader* loader;
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> coroutine) { loader->QueueOnMainThread(coroutine); }
+		void await_resume() const noexcept {}
+	};
+
+	AssetLoader(
+		unsigned int threadCount = 2,
+		std::function<void()> workerStart = nullptr,
+		std::function<void()> workerStop = nullptr);
+	~AssetLoader();
+
+	// Creates a handle that shows the placeholder until the load finishes it
+	template<typename T> AssetHandle<T> CreateHandle(T placeholder);
+
+	BackgroundAwaiter ResumeInBackground();
+	MainThreadAwaiter ResumeOnMainThread();
+
+	// Resumes coroutines waiting for the main thread - call once per frame
+	void Update(double budgetSeconds);
+
+	AssetLoaderStats GetStats() const;
+
+	// Called by handles when their load finishes (main thread only)
+	void AssetFinished(bool succeeded);
+
+	// Called by handles as coroutines start and stop waiting on them
+	void AddWaiter(std::coroutine_handle<> waiter);
+	void RemoveWaiters(const std::vector<std::coroutine_handle<>>& finished);
+
+private:
+	std::vector<std::thread> workers;
+	std::function<void()> workerStart;
+	std::function<void()> workerStop;
+
+	std::mutex mutex;
+	std::condition_variable workAvailable;
+	std::deque<std::coroutine_handle<>> backgroundQueue;
+	std::deque<std::coroutine_handle<>> mainThreadQueue;
+	std::vector<std::coroutine_handle<>> waiters;
+	bool stopping;
+
+	AssetLoaderStats stats;
+
+	void QueueInBackground(std::coroutine_handle<> coroutine);
+	void QueueOnMainThread(std::coroutine_handle<> coroutine);
+	void WorkerLoop();
+};
+
+// --------------------------------------------------------
+// A shared reference to an asset that may still be loading
+//
+// - Get() returns the placeholder until the load finishes,
+//   then the real asset, so whatever holds the handle picks
+//   up the swap on its own
+// - A failed load keeps its placeholder
+// - Copies share the same asset; all reads and the finishing
+//   SetAsset() / SetFailed() happen on the main thread
+// - Constructing from an asset makes an already loaded handle
+// - A WeakRef refers to the handle without keeping it (or its
+//   asset) alive, for caches like AssetRegistry
+// - co_await WhenFinished() suspends a coroutine until the
+//   load finishes; it's resumed inside SetAsset() / SetFailed()
+// --------------------------------------------------------
+template<typename T>
+class AssetHandle
+{
+private:
+	struct Slot
+	{
+		T placeholder;
+		T asset;
+		AssetState state;
+		AssetLoader* loader;
+		std::vector<std::coroutine_handle<>> waiters;
+	};
+
+	std::shared_ptr<Slot> slot;
+
+	void Finish(AssetState finalState)
+	{
+		slot->state = finalState;
+		if (slot->loader)
+			slot->loader->AssetFinished(finalState == AssetState::Ready);
+
+		// Resuming can add new waiters, so take the list first
+		std::vector<std::coroutine_handle<>> waiters;
+		waiters.swap(slot->waiters);
+		if (slot->loader)
+			slot->loader->RemoveWaiters(waiters);
+		for (std::coroutine_handle<> waiter : waiters)
+			waiter.resume();
+	}
+
+public:
+	using WeakRef = std::weak_ptr<Slot>;
+
+	struct FinishedAwaiter
+	{
+		std::shared_ptr<Slot> slot;
+		bool await_ready() const noexcept { return slot->state != AssetState::Loading; }
+		void await_suspend(std::coroutine_handle<> coroutine)
+		{
+			// The loader keeps track too, to clean up if it shuts down first
+			slot->waiters.push_back(coroutine);
+			if (slot->loader)
+				slot->loader->AddWaiter(coroutine);
+		}
+		void await_resume() const noexcept {}
+	};
+
+	AssetHandle() = default;
+
+	AssetHandle(T asset)
+		: slot(std::make_shared<Slot>(Slot{ asset, asset, AssetState::Ready, nullptr, {} }))
+	{
+	}
+
+	AssetHandle(T placeholder, AssetLoader* loader)
+		: slot(std::make_shared<Slot>(Slot{ placeholder, T(), AssetState::Loading, loader, {} }))
+	{
+	}
+
+	// Empty if everything referring to the handle is gone
+	explicit AssetHandle(const WeakRef& weak)
+		: slot(weak.lock())
+	{
+	}
+
+	bool IsValid() const
+	{
+		return slot != nullptr;
+	}
+
+	WeakRef GetWeak() const
+	{
+		return slot;
+	}
+
+	const T& Get() const
+	{
+		return slot->state == AssetState::Ready ? slot->asset : slot->placeholder;
+	}
+
+	AssetState GetState() const
+	{
+		return slot->state;
+	}
+
+	bool IsReady() const
+	{
+		return slot->state == AssetState::Ready;
+	}
+
+	FinishedAwaiter WhenFinished() const
+	{
+		return FinishedAwaiter{ slot };
+	}
+
+	void SetAsset(T asset)
+	{
+		if (slot->state != AssetState::Loading)
+			return;
+
+		slot->asset = asset;
+		Finish(AssetState::Ready);
+	}
+
+	void SetFailed()
+	{
+		if (slot->state != AssetState::Loading)
+			return;
+
+		Finish(AssetState::Failed);
+	}
+};
+
+template<typename T>
+AssetHandle<T> AssetLoader::CreateHandle(T placeholder)
+{
+	stats.pending++;
+	return AssetHandle<T>(placeholder, this);
+}
@@ -0,0 +1,555 @@
+#include "AssetRegistry.h"
+#include "CookedMesh.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#include <WICTextureLoader.h>
+
+using namespace DirectX;
+
+namespace
+{
+	// Hashes a whole file and gets its size, or returns 0 if it can't be read
+	unsigned long long HashFile(const std::filesystem::path& fileName, unsigned long long& bytes)
+	{
+		bytes = 0;
+		std::ifstream file(fileName, std::ios::binary | std::ios::ate);
+		if (!file.is_open())
+			return 0;
+
+		std::streamsize size = file.tellg();
+		if (size <= 0)
+			return 0;
+
+		std::vector<char> data((size_t)size);
+		file.seekg(0);
+		if (!file.read(data.data(), size))
+			return 0;
+
+		bytes = (unsigned long long)size;
+		return CookedMesh::HashData(data.data(), data.size());
+	}
+
+	// --------------------------------------------------------
+	// Whether two files hold exactly the same bytes
+	//
+	// - Reads both a piece at a time, stopping at the first
+	//   difference. A file that can't be read matches nothing
+	// --------------------------------------------------------
+	bool FilesMatch(const std::filesystem::path& a, const std::filesystem::path& b)
+	{
+		std::ifstream fileA(a, std::ios::binary);
+		std::ifstream fileB(b, std::ios::binary);
+		if (!fileA.is_open() || !fileB.is_open())
+			return false;
+
+		std::vector<char> pieceA(1 << 16);
+		std::vector<char> pieceB(1 << 16);
+		while (true)
+		{
+			fileA.read(pieceA.data(), pieceA.size());
+			fileB.read(pieceB.data(), pieceB.size());
+			std::streamsize readA = fileA.gcount();
+			if (readA != fileB.gcount() || memcmp(pieceA.data(), pieceB.data(), (size_t)readA) != 0)
+				return false;
+			if (readA < (std::streamsize)pieceA.size())
+				return true;
+		}
+	}
+
+	// Import options that produce different assets from the same file
+	std::string GetMeshOptions(VertexFormat vertexFormat, MeshCPUData cpuData)
+	{
+		return std::string("mesh|") +
+			VertexCompression::GetFormatName(vertexFormat) +
+			(cpuData == MeshCPUData::Keep ? "|keep" : "|release");
+	}
+
+	std::string GetContentKey(const std::string& options, unsigned long long hash)
+	{
+		char hex[17];
+		snprintf(hex, sizeof(hex), "%016llx", hash);
+		return options + "|" + hex;
+	}
+
+	unsigned int GetBytesPerPixel(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R32G32B32A32_FLOAT:
+		case DXGI_FORMAT_R32G32B32A32_UINT:
+			return 16;
+
+		case DXGI_FORMAT_R16G16B16A16_FLOAT:
+		case DXGI_FORMAT_R16G16B16A16_UNORM:
+		case DXGI_FORMAT_R32G32_FLOAT:
+			return 8;
+
+		case DXGI_FORMAT_R16_FLOAT:
+		case DXGI_FORMAT_R16_UNORM:
+		case DXGI_FORMAT_R8G8_UNORM:
+		case DXGI_FORMAT_B5G6R5_UNORM:
+		case DXGI_FORMAT_B5G5R5A1_UNORM:
+			return 2;
+
+		case DXGI_FORMAT_R8_UNORM:
+		case DXGI_FORMAT_A8_UNORM:
+			return 1;
+
+		default:
+			return 4;
+		}
+	}
+
+	// Size of a texture's whole mip chain
+	size_t GetTextureBytes(ID3D11ShaderResourceView* srv)
+	{
+		Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+		Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+		srv->GetResource(resource.GetAddressOf());
+		if (FAILED(resource.As(&texture)))
+			return 0;
+
+		D3D11_TEXTURE2D_DESC desc = {};
+		texture->GetDesc(&desc);
+
+		size_t bytes = 0;
+		for (unsigned int mip = 0; mip < desc.MipLevels; mip++)
+		{
+			unsigned int width = desc.Width >> mip;
+			unsigned int height = desc.Height >> mip;
+			bytes += (size_t)(width ? width : 1) * (height ? height : 1) * GetBytesPerPixel(desc.Format);
+		}
+		return bytes * desc.ArraySize;
+	}
+}
+
+AssetRegistry::AssetRegistry(
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain,
+	Microsoft::WRL::ComPtr<ID3D11Device> device,
+	AssetLoader* loader,
+	std::shared_ptr<GeometryArena> geometryArena)
+	: context(context), swapChain(swapChain), device(device), loader(loader), geometryArena(geometryArena), stats()
+{
+}
+
+// --------------------------------------------------------
+// Gets a mesh, loading it in the background if needed
+//
+// - Returns straight away; entities given the handle draw the
+//   placeholder until the mesh is ready
+// --------------------------------------------------------
+MeshHandle AssetRegistry::LoadMesh(std::string fileName, std::shared_ptr<Mesh> placeholder, VertexFormat vertexFormat, MeshCPUData cpuData)
+{
+	stats.requests++;
+
+	std::string path = NormalizePath(fileName);
+	std::string key = path + "|" + GetMeshOptions(vertexFormat, cpuData);
+
+	// Already loaded (or loading)?
+	std::unordered_map<std::string, Entry>::iterator existing = entries.find(key);
+	if (existing != entries.end())
+	{
+		MeshHandle handle(existing->second.mesh);
+		if (handle.IsValid())
+		{
+			existing->second.info.requests++;
+			stats.pathHits++;
+			return handle;
+		}
+	}
+
+	MeshHandle handle = loader->CreateHandle(placeholder);
+
+	Entry entry = {};
+	entry.info.path = path;
+	entry.info.type = AssetType::Mesh;
+	entry.info.requests = 1;
+	entry.file = fileName;
+	entry.mesh = handle.GetWeak();
+	entries[key] = entry;
+
+	LoadMeshAsync(handle, key, fileName, vertexFormat, cpuData);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Gets a texture, loading it in the background if needed
+//
+// - Returns straight away; materials given the handle bind
+//   the placeholder until the texture is ready
+// --------------------------------------------------------
+TextureHandle AssetRegistry::LoadTexture(std::wstring fileName, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholder)
+{
+	stats.requests++;
+
+	std::string path = NormalizePath(fileName);
+	std::string key = path + "|texture";
+
+	// Already loaded (or loading)?
+	std::unordered_map<std::string, Entry>::iterator existing = entries.find(key);
+	if (existing != entries.end())
+	{
+		TextureHandle handle(existing->second.texture);
+		if (handle.IsValid())
+		{
+			existing->second.info.requests++;
+			stats.pathHits++;
+			return handle;
+		}
+	}
+
+	TextureHandle handle = loader->CreateHandle(placeholder);
+
+	Entry entry = {};
+	entry.info.path = path;
+	entry.info.type = AssetType::Texture;
+	entry.info.requests = 1;
+	entry.file = fileName;
+	entry.texture = handle.GetWeak();
+	entries[key] = entry;
+
+	LoadTextureAsync(handle, key, fileName);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Loads a mesh (see AssetLoader.h)
+//
+// - Parameters are taken by value, as the coroutine outlives
+//   the call that started it. The loader is held as a plain
+//   pointer for the same reason
+// - The handle keeps the entry alive, so it's always there
+//   to update when back on the main thread
+// - The whole import and upload runs on a worker, since it
+//   only needs the device, which is thread-safe
+// - Moving into the arena waits for the main thread
+// --------------------------------------------------------
+AssetTask AssetRegistry::LoadMeshAsync(MeshHandle handle, std::string key, std::string fileName, VertexFormat vertexFormat, MeshCPUData cpuData)
+{
+	AssetLoader* loader = this->loader;
+
+	// Hash the file first, as matching content can skip the import
+	co_await loader->ResumeInBackground();
+	unsigned long long bytes = 0;
+	unsigned long long hash = HashFile(fileName, bytes);
+
+	co_await loader->ResumeOnMainThread();
+	std::string ownerKey = ClaimContent(key, GetContentKey(GetMeshOptions(vertexFormat, cpuData), hash), hash, bytes);
+	if (!ownerKey.empty())
+	{
+		// The hash and size matched, but compare the files to be sure
+		std::filesystem::path ownerFile = entries[ownerKey].file;
+		co_await loader->ResumeInBackground();
+		bool identical = FilesMatch(fileName, ownerFile);
+
+		co_await loader->ResumeOnMainThread();
+		if (identical && ShareContent(key, ownerKey))
+		{
+			// Share the data of an identical file that's already loaded
+			MeshHandle existing(entries[ownerKey].mesh);
+			co_await existing.WhenFinished();
+			if (existing.IsReady())
+				handle.SetAsset(existing.Get());
+			else
+				handle.SetFailed();
+			co_return;
+		}
+	}
+
+	co_await loader->ResumeInBackground();
+	std::shared_ptr<Mesh> mesh = std::make_shared<Mesh>(context, swapChain, device, fileName.c_str(), vertexFormat, cpuData);
+
+	// Swap it in on the main thread, between frames
+	co_await loader->ResumeOnMainThread();
+	if (mesh->GetVertexBuffer())
+	{
+		// The arena copy uses the device context, so it can't happen on the worker
+		if (geometryArena)
+			mesh->MoveToArena(geometryArena);
+		handle.SetAsset(mesh);
+	}
+	else
+	{
+		handle.SetFailed();
+	}
+}
+
+// --------------------------------------------------------
+// Loads a texture (see AssetLoader.h)
+//
+// - Deduplicated by content the same way as meshes
+// - The file is decoded and its top mip uploaded on a worker.
+//   Mip generation needs the device context, which isn't
+//   thread-safe, so the main thread copies the top mip into a
+//   full chain and has the GPU generate the rest
+// --------------------------------------------------------
+AssetTask AssetRegistry::LoadTextureAsync(TextureHandle handle, std::string key, std::wstring fileName)
+{
+	AssetLoader* loader = this->loader;
+
+	// Hash the file first, as matching content can skip the decode
+	co_await loader->ResumeInBackground();
+	unsigned long long bytes = 0;
+	unsigned long long hash = HashFile(fileName, bytes);
+
+	co_await loader->ResumeOnMainThread();
+	std::string ownerKey = ClaimContent(key, GetContentKey("texture", hash), hash, bytes);
+	if (!ownerKey.empty())
+	{
+		// The hash and size matched, but compare the files to be sure
+		std::filesystem::path ownerFile = entries[ownerKey].file;
+		co_await loader->ResumeInBackground();
+		bool identical = FilesMatch(fileName, ownerFile);
+
+		co_await loader->ResumeOnMainThread();
+		if (identical && ShareContent(key, ownerKey))
+		{
+			// Share the data of an identical file that's already loaded
+			TextureHandle existing(entries[ownerKey].texture);
+			co_await existing.WhenFinished();
+			if (existing.IsReady())
+				handle.SetAsset(existing.Get());
+			else
+				handle.SetFailed();
+			co_return;
+		}
+	}
+
+	co_await loader->ResumeInBackground();
+	Microsoft::WRL::ComPtr<ID3D11Resource> resource;
+	HRESULT hr = CreateWICTextureFromFileEx(
+		device.Get(),
+		fileName.c_str(),
+		0,
+		D3D11_USAGE_DEFAULT,
+		D3D11_BIND_SHADER_RESOURCE,
+		0,
+		0,
+		WIC_LOADER_DEFAULT,
+		resource.GetAddressOf(),
+		nullptr
+	);
+
+	co_await loader->ResumeOnMainThread();
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> topMip;
+	if (FAILED(hr) || FAILED(resource.As(&topMip)))
+	{
+		handle.SetFailed();
+		co_return;
+	}
+
+	// Describe the same texture with a full mip chain
+	D3D11_TEXTURE2D_DESC desc = {};
+	topMip->GetDesc(&desc);
+	desc.MipLevels = 0;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_RENDER_TARGET;
+	desc.MiscFlags = D3D11_RESOURCE_MISC_GENERATE_MIPS;
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	if (SUCCEEDED(device->CreateTexture2D(&desc, nullptr, texture.GetAddressOf())) &&
+		SUCCEEDED(device->CreateShaderResourceView(texture.Get(), nullptr, srv.GetAddressOf())))
+	{
+		context->CopySubresourceRegion(texture.Get(), 0, 0, 0, 0, topMip.Get(), 0, nullptr);
+		context->GenerateMips(srv.Get());
+	}
+	else
+	{
+		// Formats that can't be rendered to keep their single mip
+		if (FAILED(device->CreateShaderResourceView(topMip.Get(), nullptr, srv.ReleaseAndGetAddressOf())))
+		{
+			handle.SetFailed();
+			co_return;
+		}
+	}
+
+	handle.SetAsset(srv);
+}
+
+// --------------------------------------------------------
+// Drops entries whose assets nothing references any more
+//
+// - Data shared by content moves to another entry still using
+//   it, so later identical files keep matching
+// --------------------------------------------------------
+void AssetRegistry::Collect()
+{
+	for (std::unordered_map<std::string, Entry>::iterator it = entries.begin(); it != entries.end();)
+	{
+		if (IsAlive(it->second))
+		{
+			it++;
+			continue;
+		}
+
+		it = entries.erase(it);
+		stats.evictions++;
+	}
+
+	for (std::unordered_map<std::string, std::string>::iterator it = contentOwners.begin(); it != contentOwners.end();)
+	{
+		if (entries.count(it->second) > 0)
+		{
+			it++;
+			continue;
+		}
+
+		// Find another entry with the same data to take over
+		std::unordered_map<std::string, Entry>::iterator newOwner = entries.begin();
+		while (newOwner != entries.end() && newOwner->second.contentKey != it->first)
+			newOwner++;
+
+		if (newOwner == entries.end())
+		{
+			it = contentOwners.erase(it);
+			continue;
+		}
+
+		newOwner->second.info.sharedWith.clear();
+		it->second = newOwner->first;
+		it++;
+	}
+}
+
+// --------------------------------------------------------
+// Claims a file's content for an entry, once it's hashed
+//
+// - Returns the key of the entry that already owns data with
+//   the same hash and size, or an empty string if this entry
+//   now owns it
+// - A 64-bit hash can still collide, so the caller compares
+//   the two files before calling ShareContent(). If the sizes
+//   or files differ, this entry loads its own data but doesn't
+//   take over as the owner
+// - Files that couldn't be read (hash 0) are never shared
+// --------------------------------------------------------
+std::string AssetRegistry::ClaimContent(const std::string& key, const std::string& contentKey, unsigned long long hash, unsigned long long bytes)
+{
+	if (hash == 0)
+		return std::string();
+
+	Entry& entry = entries[key];
+	entry.info.contentHash = hash;
+	entry.contentKey = contentKey;
+	entry.contentBytes = bytes;
+
+	std::unordered_map<std::string, std::string>::iterator owner = contentOwners.find(contentKey);
+	if (owner != contentOwners.end() && owner->second != key)
+	{
+		std::unordered_map<std::string, Entry>::iterator ownerEntry = entries.find(owner->second);
+		if (ownerEntry != entries.end() && IsAlive(ownerEntry->second))
+		{
+			// A different size is a hash collision, which keeps its own data
+			return ownerEntry->second.contentBytes == bytes ? owner->second : std::string();
+		}
+	}
+
+	contentOwners[contentKey] = key;
+	return std::string();
+}
+
+// --------------------------------------------------------
+// Shares an owner's data, once the files are known to match
+//
+// - The owner may have been freed while the files were being
+//   compared, in which case this entry takes over as owner and
+//   loads the data itself (returning false)
+// --------------------------------------------------------
+bool AssetRegistry::ShareContent(const std::string& key, const std::string& ownerKey)
+{
+	Entry& entry = entries[key];
+	std::unordered_map<std::string, Entry>::iterator owner = entries.find(ownerKey);
+	if (owner == entries.end() || !IsAlive(owner->second))
+	{
+		contentOwners[entry.contentKey] = key;
+		return false;
+	}
+
+	entry.info.sharedWith = owner->second.info.path;
+	stats.contentHits++;
+	return true;
+}
+
+// --------------------------------------------------------
+// Gets every registered asset and its memory, sorted by path
+// --------------------------------------------------------
+std::vector<AssetInfo> AssetRegistry::GetAssets() const
+{
+	std::vector<AssetInfo> assets;
+	for (const std::pair<const std::string, Entry>& entry : entries)
+	{
+		AssetInfo info = entry.second.info;
+		info.state = AssetState::Failed;
+		info.references = 0;
+		info.cpuBytes = 0;
+		info.gpuBytes = 0;
+
+		if (info.type == AssetType::Mesh)
+		{
+			MeshHandle handle(entry.second.mesh);
+			if (handle.IsValid())
+			{
+				info.references = entry.second.mesh.use_count() - 1;
+				info.state = handle.GetState();
+				if (handle.IsReady() && info.sharedWith.empty())
+				{
+					info.cpuBytes = handle.Get()->GetCPUMemoryBytes();
+					info.gpuBytes = handle.Get()->GetVertexBufferBytes() + handle.Get()->GetIndexBufferBytes();
+				}
+			}
+		}
+		else
+		{
+			TextureHandle handle(entry.second.texture);
+			if (handle.IsValid())
+			{
+				info.references = entry.second.texture.use_count() - 1;
+				info.state = handle.GetState();
+				if (handle.IsReady() && info.sharedWith.empty())
+					info.gpuBytes = GetTextureBytes(handle.Get().Get());
+			}
+		}
+
+		assets.push_back(info);
+	}
+
+	std::sort(assets.begin(), assets.end(), [](const AssetInfo& a, const AssetInfo& b) { return a.path < b.path; });
+	return assets;
+}
+
+AssetRegistryStats AssetRegistry::GetStats() const
+{
+	return this->stats;
+}
+
+// --------------------------------------------------------
+// Makes a path usable as a key: absolute, with '/' separators
+// and "." / ".." removed, and lowercase since Windows paths
+// aren't case-sensitive
+// --------------------------------------------------------
+std::string AssetRegistry::NormalizePath(const std::filesystem::path& fileName)
+{
+	std::error_code error;
+	std::filesystem::path absolute = std::filesystem::absolute(fileName, error);
+	if (error)
+		absolute = fileName;
+
+	std::u8string normalized = absolute.lexically_normal().generic_u8string();
+	std::string path(normalized.begin(), normalized.end());
+	for (char& c : path)
+		c = (char)std::tolower((unsigned char)c);
+
+	return path;
+}
+
+bool AssetRegistry::IsAlive(const Entry& entry) const
+{
+	return entry.info.type == AssetType::Mesh ? !entry.mesh.expired() : !entry.texture.expired();
+}
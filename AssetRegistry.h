@@ -0,0 +1,125 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetLoader.h"
+#include "GeometryArena.h"
+#include "Material.h"
+#include "Mesh.h"
+
+enum class AssetType
+{
+	Mesh,
+	Texture
+};
+
+// --------------------------------------------------------
+// What the registry knows about one loaded asset
+//
+// - references counts the handles still alive, including any
+//   held by a load in progress
+// - An asset whose file matched one already loaded reuses its
+//   data, names it in sharedWith and reports no memory itself
+// --------------------------------------------------------
+struct AssetInfo
+{
+	std::string path;
+	AssetType type;
+	AssetState state;
+	unsigned long long contentHash;
+	std::string sharedWith;
+	long references;
+	unsigned int requests;
+	size_t cpuBytes;
+	size_t gpuBytes;
+};
+
+struct AssetRegistryStats
+{
+	unsigned int requests;
+	unsigned int pathHits;
+	unsigned int contentHits;
+	unsigned int evictions;
+};
+
+// --------------------------------------------------------
+// Loads each mesh and texture once and shares it
+//
+// - Requests are matched by normalized path (absolute, '/'
+//   separators, lowercase) plus the import options, and hand
+//   back the existing handle straight away
+// - New files are hashed on a worker before importing. If the
+//   content matches an asset already loaded with the same
+//   options (same hash and size, then compared byte for byte),
+//   that asset's data is reused instead
+// - The registry only holds weak references, so an asset is
+//   freed as soon as nothing holds its handle. Collect() then
+//   drops its entry
+// - Loads run on the AssetLoader, which must outlive any load
+//   still in progress (so destroy it before the registry)
+// - Given an arena, loaded meshes are moved into it on the
+//   main thread as they finish (see GeometryArena.h)
+// --------------------------------------------------------
+class AssetRegistry
+{
+public:
+	AssetRegistry(
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain,
+		Microsoft::WRL::ComPtr<ID3D11Device> device,
+		AssetLoader* loader,
+		std::shared_ptr<GeometryArena> geometryArena = nullptr);
+
+	MeshHandle LoadMesh(
+		std::string fileName,
+		std::shared_ptr<Mesh> placeholder,
+		VertexFormat vertexFormat = VertexFormat::Standard,
+		MeshCPUData cpuData = MeshCPUData::Keep);
+	TextureHandle LoadTexture(
+		std::wstring fileName,
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> placeholder);
+
+	// Drops entries for assets that are no longer referenced - call once per frame
+	void Collect();
+
+	std::vector<AssetInfo> GetAssets() const;
+	AssetRegistryStats GetStats() const;
+
+	static std::string NormalizePath(const std::filesystem::path& fileName);
+
+private:
+	struct Entry
+	{
+		AssetInfo info;
+		std::filesystem::path file;
+		std::string contentKey;
+		unsigned long long contentBytes;
+		MeshHandle::WeakRef mesh;
+		TextureHandle::WeakRef texture;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain;
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	AssetLoader* loader;
+	std::shared_ptr<GeometryArena> geometryArena;
+
+	// Keyed by normalized path plus import options
+	std::unordered_map<std::string, Entry> entries;
+
+	// Content hash plus import options -> the entry that owns that data
+	std::unordered_map<std::string, std::string> contentOwners;
+
+	AssetRegistryStats stats;
+
+	AssetTask LoadMeshAsync(MeshHandle handle, std::string key, std::string fileName, VertexFormat vertexFormat, MeshCPUData cpuData);
+	AssetTask LoadTextureAsync(TextureHandle handle, std::string key, std::wstring fileName);
+	std::string ClaimContent(const std::string& key, const std::string& contentKey, unsigned long long hash, unsigned long long bytes);
+	bool ShareContent(const std::string& key, const std::string& ownerKey);
+	bool IsAlive(const Entry& entry) const;
+};
@@ -0,0 +1,3 @@
+// ShadowVertexShader.hlsl built for the compact vertex formats (see VertexCompression.h)
+#define COMPACT_VERTEX
+#include "ShadowVertexShader.hlsl"
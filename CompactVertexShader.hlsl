@@ -0,0 +1,3 @@
+// VertexShader.hlsl built for the compact vertex formats (see VertexCompression.h)
+#define COMPACT_VERTEX
+#include "VertexShader.hlsl"
@@ -0,0 +1,392 @@
+#include "CookedMesh.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char cookedMagic[4] = { 'D', 'X', 'M', 'S' };
+
+	// Rounds an offset up to the next 16-byte boundary
+	inline unsigned long long AlignTo16(unsigned long long offset)
+	{
+		return (offset + 15) & ~15ull;
+	}
+
+	inline unsigned long long RotateLeft(unsigned long long value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	const unsigned long long hashPrime1 = 0x9E3779B185EBCA87ull;
+	const unsigned long long hashPrime2 = 0xC2B2AE3D27D4EB4Full;
+}
+
+CookedMesh::CookedMesh() :
+	header(nullptr)
+{
+}
+
+// --------------------------------------------------------
+// Maps a cooked file and validates it against its source
+//
+// - Returns false (and leaves nothing open) if the file is
+//   missing, truncated, from an older version, or was cooked
+//   from different source data
+// --------------------------------------------------------
+bool CookedMesh::Open(const char* fileName, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int vertexStride)
+{
+	Close();
+
+	if (!file.Open(fileName) || file.GetSize() < sizeof(CookedMeshHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const CookedMeshHeader* candidate = reinterpret_cast<const CookedMeshHeader*>(file.GetData());
+
+	// Check that this file belongs to the current source and pipeline
+	bool valid =
+		memcmp(candidate->magic, cookedMagic, sizeof(cookedMagic)) == 0 &&
+		candidate->version == CurrentVersion &&
+		candidate->vertexStride == vertexStride &&
+		candidate->sourceHash == sourceHash &&
+		candidate->sourceSize == sourceSize;
+
+	// Check that the vertex and index data are actually inside the file
+	unsigned long long fileSize = file.GetSize();
+	valid = valid &&
+		candidate->vertexOffset + (unsigned long long)candidate->vertexCount * vertexStride <= fileSize &&
+		candidate->indexOffset + (unsigned long long)candidate->indexCount * sizeof(unsigned int) <= fileSize &&
+		candidate->vertexCount > 0 &&
+		candidate->indexCount > 0;
+
+	// Check that every LOD is inside the index data
+	valid = valid && candidate->lodCount > 0 && candidate->lodCount <= MeshSimplifier::MaxLODs;
+	for (unsigned int l = 0; valid && l < candidate->lodCount; l++)
+		valid = (unsigned long long)candidate->lods[l].indexOffset + candidate->lods[l].indexCount <= candidate->indexCount;
+
+	// Check that the meshlets are inside the file and within LOD 0
+	valid = valid && candidate->meshletOffset + (unsigned long long)candidate->meshletCount * sizeof(Meshlet) <= fileSize;
+	const Meshlet* meshlets = reinterpret_cast<const Meshlet*>(file.GetData() + candidate->meshletOffset);
+	for (unsigned int m = 0; valid && m < candidate->meshletCount; m++)
+		valid = (unsigned long long)meshlets[m].indexOffset + meshlets[m].triangleCount * 3ull <= candidate->lods[0].indexCount;
+
+	if (!valid)
+	{
+		Close();
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+void CookedMesh::Close()
+{
+	header = nullptr;
+	file.Close();
+}
+
+const void* CookedMesh::GetVertexData() const
+{
+	return file.GetData() + header->vertexOffset;
+}
+
+const unsigned int* CookedMesh::GetIndices() const
+{
+	return reinterpret_cast<const unsigned int*>(file.GetData() + header->indexOffset);
+}
+
+unsigned int CookedMesh::GetVertexCount() const
+{
+	return header->vertexCount;
+}
+
+unsigned int CookedMesh::GetIndexCount() const
+{
+	return header->indexCount;
+}
+
+unsigned int CookedMesh::GetLODCount() const
+{
+	return header->lodCount;
+}
+
+const MeshLOD* CookedMesh::GetLODs() const
+{
+	return header->lods;
+}
+
+unsigned int CookedMesh::GetMeshletCount() const
+{
+	return header->meshletCount;
+}
+
+const Meshlet* CookedMesh::GetMeshlets() const
+{
+	return reinterpret_cast<const Meshlet*>(file.GetData() + header->meshletOffset);
+}
+
+const CookedMeshHeader* CookedMesh::GetHeader() const
+{
+	return header;
+}
+
+// --------------------------------------------------------
+// Writes a cooked file in one go (see CookedMeshWriter)
+// --------------------------------------------------------
+bool CookedMesh::Write(
+	const char* fileName,
+	unsigned long long sourceHash,
+	unsigned long long sourceSize,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	const unsigned int* indices, unsigned int indexCount,
+	const MeshLOD* lods, unsigned int lodCount,
+	const Meshlet* meshlets, unsigned int meshletCount,
+	const float boundsMin[3], const float boundsMax[3])
+{
+	CookedMeshWriter writer;
+	if (!writer.Begin(fileName, sourceHash, sourceSize, vertexStride))
+		return false;
+
+	writer.WriteVertices(vertices, vertexCount);
+	writer.WriteIndices(indices, indexCount);
+	writer.WriteMeshlets(meshlets, meshletCount);
+	return writer.Finish(lods, lodCount, boundsMin, boundsMax);
+}
+
+// --------------------------------------------------------
+// Fast 64-bit content hash used to detect source changes
+//
+// - Consumes 8 bytes per step, which is far cheaper than
+//   re-parsing the text it's guarding
+// - Not cryptographic, just needs to notice edits
+// --------------------------------------------------------
+unsigned long long CookedMesh::HashData(const char* data, size_t size)
+{
+	ContentHasher hasher(size);
+	hasher.Update(data, size);
+	return hasher.Finish();
+}
+
+// --------------------------------------------------------
+// Gets the cooked file name for a source file by swapping
+// its extension, ie: "Assets/sphere.obj" -> "Assets/sphere.dxmesh"
+// --------------------------------------------------------
+std::string CookedMesh::GetCookedPath(const char* sourceFileName)
+{
+	std::string path = sourceFileName;
+
+	// Only look for the extension after the last slash
+	size_t lastSlash = path.find_last_of("/\\");
+	size_t lastDot = path.find_last_of('.');
+	if (lastDot != std::string::npos && (lastSlash == std::string::npos || lastDot > lastSlash))
+		path.erase(lastDot);
+
+	return path + ".dxmesh";
+}
+
+ContentHasher::ContentHasher(unsigned long long totalSize) :
+	hash(hashPrime1 ^ (totalSize * hashPrime2))
+{
+}
+
+void ContentHasher::Update(const char* data, size_t size)
+{
+	// Whole 8-byte words
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		unsigned long long word;
+		memcpy(&word, data + i, sizeof(word));
+		hash ^= RotateLeft(word * hashPrime2, 31) * hashPrime1;
+		hash = RotateLeft(hash, 27) * hashPrime1 + hashPrime2;
+	}
+
+	// Remaining bytes (only at the very end of the data)
+	for (; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i] * hashPrime1;
+		hash = RotateLeft(hash, 11) * hashPrime2;
+	}
+}
+
+unsigned long long ContentHasher::Finish() const
+{
+	// Final avalanche
+	unsigned long long result = hash;
+	result ^= result >> 33;
+	result *= hashPrime2;
+	result ^= result >> 29;
+	return result;
+}
+
+CookedMeshWriter::CookedMeshWriter() :
+	header(),
+	section(Section::Done),
+	position(0),
+	vertexCount(0),
+	indexCount(0),
+	meshletCount(0)
+{
+}
+
+CookedMeshWriter::~CookedMeshWriter()
+{
+	Abort();
+}
+
+// --------------------------------------------------------
+// Starts the temporary file with a placeholder header
+// --------------------------------------------------------
+bool CookedMeshWriter::Begin(const char* fileName, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int vertexStride)
+{
+	Abort();
+
+	this->fileName = fileName;
+	tempName = this->fileName + ".tmp";
+	out.open(tempName, std::ios::binary | std::ios::trunc);
+	if (!out.is_open())
+		return false;
+
+	header = {};
+	memcpy(header.magic, cookedMagic, sizeof(cookedMagic));
+	header.version = CookedMesh::CurrentVersion;
+	header.vertexStride = vertexStride;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	vertexCount = 0;
+	indexCount = 0;
+	meshletCount = 0;
+
+	const char padding[16] = {};
+	header.vertexOffset = AlignTo16(sizeof(header));
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(padding, (std::streamsize)(header.vertexOffset - sizeof(header)));
+	position = header.vertexOffset;
+
+	section = Section::Vertices;
+	return out.good();
+}
+
+// --------------------------------------------------------
+// Moves on to a later section, padding each one it passes
+// to a 16-byte boundary and recording where it starts
+// --------------------------------------------------------
+void CookedMeshWriter::EnterSection(Section next)
+{
+	const char padding[16] = {};
+	while (section < next)
+	{
+		unsigned long long aligned = AlignTo16(position);
+		out.write(padding, (std::streamsize)(aligned - position));
+		position = aligned;
+
+		section = (Section)((int)section + 1);
+		if (section == Section::Indices)
+			header.indexOffset = position;
+		else if (section == Section::Meshlets)
+			header.meshletOffset = position;
+	}
+}
+
+void CookedMeshWriter::WriteVertices(const void* vertices, unsigned int count)
+{
+	if (section != Section::Vertices)
+		return;
+
+	unsigned long long bytes = (unsigned long long)count * header.vertexStride;
+	out.write(static_cast<const char*>(vertices), (std::streamsize)bytes);
+	position += bytes;
+	vertexCount += count;
+}
+
+void CookedMeshWriter::WriteIndices(const unsigned int* indices, unsigned int count)
+{
+	if (section > Section::Indices)
+		return;
+
+	EnterSection(Section::Indices);
+	unsigned long long bytes = (unsigned long long)count * sizeof(unsigned int);
+	out.write(reinterpret_cast<const char*>(indices), (std::streamsize)bytes);
+	position += bytes;
+	indexCount += count;
+}
+
+void CookedMeshWriter::WriteMeshlets(const Meshlet* meshlets, unsigned int count)
+{
+	if (section > Section::Meshlets)
+		return;
+
+	EnterSection(Section::Meshlets);
+	unsigned long long bytes = (unsigned long long)count * sizeof(Meshlet);
+	out.write(reinterpret_cast<const char*>(meshlets), (std::streamsize)bytes);
+	position += bytes;
+	meshletCount += count;
+}
+
+// --------------------------------------------------------
+// Rewrites the header with the final counts and moves the
+// file into place, replacing any previous cooked file
+// --------------------------------------------------------
+bool CookedMeshWriter::Finish(const MeshLOD* lods, unsigned int lodCount, const float boundsMin[3], const float boundsMax[3])
+{
+	if (section == Section::Done)
+		return false;
+
+	EnterSection(Section::Meshlets);
+
+	bool valid =
+		lodCount > 0 && lodCount <= MeshSimplifier::MaxLODs &&
+		vertexCount <= 0xFFFFFFFFull &&
+		indexCount <= 0xFFFFFFFFull &&
+		meshletCount <= 0xFFFFFFFFull;
+	if (!valid)
+	{
+		Abort();
+		return false;
+	}
+
+	header.vertexCount = (unsigned int)vertexCount;
+	header.indexCount = (unsigned int)indexCount;
+	header.meshletCount = (unsigned int)meshletCount;
+	memcpy(header.boundsMin, boundsMin, sizeof(header.boundsMin));
+	memcpy(header.boundsMax, boundsMax, sizeof(header.boundsMax));
+	header.lodCount = lodCount;
+	memcpy(header.lods, lods, lodCount * sizeof(MeshLOD));
+
+	out.seekp(0);
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.close();
+	section = Section::Done;
+
+	if (out.fail())
+	{
+		std::remove(tempName.c_str());
+		return false;
+	}
+
+	std::remove(fileName.c_str());
+	return std::rename(tempName.c_str(), fileName.c_str()) == 0;
+}
+
+// --------------------------------------------------------
+// Drops an unfinished file
+// --------------------------------------------------------
+void CookedMeshWriter::Abort()
+{
+	if (section == Section::Done)
+		return;
+
+	out.close();
+	std::remove(tempName.c_str());
+	section = Section::Done;
+}
+
+unsigned long long CookedMeshWriter::GetPosition() const
+{
+	return this->position;
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <cstddef>
+#include <fstream>
+#include <string>
+
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+
+// --------------------------------------------------------
+// Header at the start of every cooked (.dxmesh) file
+//
+// File layout:
+//  - CookedMeshHeader
+//  - Vertex data (vertexCount * vertexStride bytes)
+//  - Index data (indexCount 32-bit indices), holding every LOD
+//    back to back as described by the LOD table
+//  - Meshlet data (meshletCount Meshlets), covering LOD 0
+//
+// All data blocks start on 16-byte boundaries so they can
+// be handed straight to the GPU from the file mapping
+// --------------------------------------------------------
+struct CookedMeshHeader
+{
+	char magic[4];
+	unsigned int version;
+	unsigned int vertexStride;
+	unsigned int vertexCount;
+	unsigned int indexCount;
+	unsigned int flags;
+	unsigned long long sourceHash;
+	unsigned long long sourceSize;
+	float boundsMin[3];
+	float boundsMax[3];
+	unsigned long long vertexOffset;
+	unsigned long long indexOffset;
+	unsigned int lodCount;
+	MeshLOD lods[MeshSimplifier::MaxLODs];
+	unsigned int meshletCount;
+	unsigned long long meshletOffset;
+};
+
+// --------------------------------------------------------
+// Reads and writes the binary, ready-to-upload mesh format
+//
+// - A cooked file is only valid for the exact source file it
+//   was made from (matched by content hash and size) and for
+//   the current format version and vertex stride
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class CookedMesh
+{
+private:
+	MappedFile file;
+	const CookedMeshHeader* header;
+
+public:
+	// Bump whenever the layout or the import pipeline changes,
+	// so stale cooked files are rebuilt automatically
+	static const unsigned int CurrentVersion = 4;
+
+	CookedMesh();
+
+	bool Open(const char* fileName, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int vertexStride);
+	void Close();
+
+	// Getters - only valid while the file is open
+	const void* GetVertexData() const;
+	const unsigned int* GetIndices() const;
+	unsigned int GetVertexCount() const;
+	unsigned int GetIndexCount() const;
+	unsigned int GetLODCount() const;
+	const MeshLOD* GetLODs() const;
+	unsigned int GetMeshletCount() const;
+	const Meshlet* GetMeshlets() const;
+	const CookedMeshHeader* GetHeader() const;
+
+	// Cooking helpers
+	static bool Write(
+		const char* fileName,
+		unsigned long long sourceHash,
+		unsigned long long sourceSize,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		const unsigned int* indices, unsigned int indexCount,
+		const MeshLOD* lods, unsigned int lodCount,
+		const Meshlet* meshlets, unsigned int meshletCount,
+		const float boundsMin[3], const float boundsMax[3]);
+	static unsigned long long HashData(const char* data, size_t size);
+	static std::string GetCookedPath(const char* sourceFileName);
+};
+
+// --------------------------------------------------------
+// CookedMesh::HashData over data that arrives in pieces, for
+// sources too large to hold in memory
+//
+// - The total size must be known up front, and every piece but
+//   the last must be a multiple of 8 bytes long
+// --------------------------------------------------------
+class ContentHasher
+{
+private:
+	unsigned long long hash;
+
+public:
+	explicit ContentHasher(unsigned long long totalSize);
+
+	void Update(const char* data, size_t size);
+	unsigned long long Finish() const;
+};
+
+// --------------------------------------------------------
+// Writes a cooked file one piece at a time
+//
+// - Vertices, then indices, then meshlets, each in as many
+//   calls as needed; the counts, offsets, LODs and bounds go
+//   into the header once Finish() knows them
+// - Like CookedMesh::Write (which uses it), the data goes to a
+//   temporary file that's only renamed once it's complete, and
+//   a writer destroyed before Finish() leaves nothing behind
+// --------------------------------------------------------
+class CookedMeshWriter
+{
+private:
+	enum class Section
+	{
+		Vertices,
+		Indices,
+		Meshlets,
+		Done
+	};
+
+	std::ofstream out;
+	std::string fileName;
+	std::string tempName;
+	CookedMeshHeader header;
+	Section section;
+	unsigned long long position;
+	unsigned long long vertexCount;
+	unsigned long long indexCount;
+	unsigned long long meshletCount;
+
+	void EnterSection(Section next);
+
+public:
+	CookedMeshWriter();
+	~CookedMeshWriter();
+
+	CookedMeshWriter(const CookedMeshWriter&) = delete;
+	CookedMeshWriter& operator=(const CookedMeshWriter&) = delete;
+
+	bool Begin(const char* fileName, unsigned long long sourceHash, unsigned long long sourceSize, unsigned int vertexStride);
+	void WriteVertices(const void* vertices, unsigned int count);
+	void WriteIndices(const unsigned int* indices, unsigned int count);
+	void WriteMeshlets(const Meshlet* meshlets, unsigned int count);
+
+	// Fails (and removes the temporary file) if anything didn't
+	// write or the counts don't fit the format
+	bool Finish(const MeshLOD* lods, unsigned int lodCount, const float boundsMin[3], const float boundsMax[3]);
+	void Abort();
+
+	// Bytes written so far
+	unsigned long long GetPosition() const;
+};
@@ -1,12 +1,19 @@
 #include "DXCore.h"
 #include "Input.h"
+#include "Profiler.h"
 
 #include "ImGui/imgui_impl_win32.h"
 
 #include <dxgi1_5.h>
 #include <WindowsX.h>
+#include <timeapi.h>
 #include <sstream>
 
+// Older SDKs don't have the high resolution timer flag (Windows 10 1803+)
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
 // Define the static instance variable so our OS-level 
 // message handling function below can talk to our object
 DXCore* DXCore::DXCoreInstance = 0;
@@ -50,12 +57,13 @@ DXCore::DXCore(
 	dxFeatureLevel(D3D_FEATURE_LEVEL_11_0),
 	fpsTimeElapsed(0),
 	fpsFrameCount(0),
-	previousTime(0),
-	currentTime(0),
 	hasFocus(true),
 	deltaTime(0),
 	startTime(0),
 	totalTime(0),
+	frameTimer(0),
+	frameTimerHighResolution(false),
+	exitCode(0),
 	hWnd(0)
 {
 	// Save a static reference to this object.
@@ -68,6 +76,14 @@ DXCore::DXCore(
 	__int64 perfFreq = 0;
 	QueryPerformanceFrequency((LARGE_INTEGER*)&perfFreq);
 	perfCounterSeconds = 1.0 / (double)perfFreq;
+	QueryPerformanceCounter((LARGE_INTEGER*)&startTime);
+
+	// A high resolution timer wakes within about half a millisecond. Older
+	// versions of Windows only have the regular one
+	frameTimer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+	frameTimerHighResolution = frameTimer != NULL;
+	if (!frameTimer)
+		frameTimer = CreateWaitableTimerExW(NULL, NULL, 0, TIMER_ALL_ACCESS);
 }
 
 // --------------------------------------------------------
@@ -80,8 +96,14 @@ DXCore::~DXCore()
 	// - If we weren't using smart pointers, we'd need to call
 	//   Release() on each Direct3D object created in DXCore
 
-	// Delete input manager singleton
+	// Delete input manager and profiler singletons
 	delete& Input::GetInstance();
+	delete& Profiler::GetInstance();
+
+	// Stop limiting, which puts the system timer back if it was changed
+	SetTargetFrameRate(0);
+	if (frameTimer)
+		CloseHandle(frameTimer);
 }
 
 // --------------------------------------------------------
@@ -398,88 +420,192 @@ void DXCore::OnResize()
 // This is the main game loop, handling the following:
 //  - OS-level messages coming in from Windows itself
 //  - Calling update & draw back and forth, forever
+//
+// The loop itself is FrameLoop, which calls back into this
+// object as its platform (see PumpMessages() and the rest)
 // --------------------------------------------------------
 HRESULT DXCore::Run()
 {
 	// Grab the start time now that
 	// the game loop is running
-	__int64 now = 0;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	startTime = now;
-	currentTime = now;
-	previousTime = now;
+	frameLoop.Start(*this);
 
 	// Give subclass a chance to initialize
 	Init();
 
 	// Our overall game and message loop
+	frameLoop.Run(*this, *this);
+
+	// We'll end up here once we get a WM_QUIT message,
+	// which usually comes from the user closing the window
+	return (HRESULT)exitCode;
+}
+
+
+// --------------------------------------------------------
+// Handles every message waiting for us
+//
+// - Returns false on WM_QUIT, keeping its exit code
+// --------------------------------------------------------
+bool DXCore::PumpMessages()
+{
 	MSG msg = {};
-	while (msg.message != WM_QUIT)
+	while (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
 	{
-		// Determine if there is a message waiting
-		if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+		if (msg.message == WM_QUIT)
 		{
-			// Translate and dispatch the message
-			// to our custom WindowProc function
-			TranslateMessage(&msg);
-			DispatchMessage(&msg);
+			exitCode = msg.wParam;
+			return false;
 		}
-		else
-		{
-			// Update timer and title bar (if necessary)
-			UpdateTimer();
-			if(titleBarStats)
-				UpdateTitleBarStats();
 
-			// Update the input manager
-			Input::GetInstance().Update();
+		// Translate and dispatch the message
+		// to our custom WindowProc function
+		TranslateMessage(&msg);
+		DispatchMessage(&msg);
+	}
+	return true;
+}
 
-			// The game loop
-			Update(deltaTime, totalTime);
-			Draw(deltaTime, totalTime);
 
-			// Frame is over, notify the input manager
-			Input::GetInstance().EndOfFrame();
-		}
+// --------------------------------------------------------
+// Uses high resolution time stamps to get very accurate
+// timing information
+// --------------------------------------------------------
+double DXCore::GetSeconds()
+{
+	__int64 now = 0;
+	QueryPerformanceCounter((LARGE_INTEGER*)&now);
+	return (now - startTime) * perfCounterSeconds;
+}
+
+
+// --------------------------------------------------------
+// Waits for the frame limit
+//
+// - Sleeps on the timer until shortly before the deadline,
+//   then spins the rest, as a sleep can overshoot but a spin
+//   can't. The margin covers how late the timer may wake
+// --------------------------------------------------------
+double DXCore::WaitUntil(double seconds)
+{
+	double sleepSeconds = 0.0;
+
+	// Sleep most of the way
+	double marginSeconds = frameTimerHighResolution ? 0.001 : 0.002;
+	double now = GetSeconds();
+	double remaining = seconds - now;
+	if (frameTimer && remaining > marginSeconds)
+	{
+		// Relative due times are negative, in 100 nanosecond units
+		LARGE_INTEGER dueTime = {};
+		dueTime.QuadPart = -(LONGLONG)((remaining - marginSeconds) * 10000000.0);
+		double sleepStart = now;
+		if (SetWaitableTimerEx(frameTimer, &dueTime, 0, NULL, NULL, NULL, 0))
+			WaitForSingleObject(frameTimer, INFINITE);
+
+		now = GetSeconds();
+		sleepSeconds = now - sleepStart;
 	}
 
-	// We'll end up here once we get a WM_QUIT message,
-	// which usually comes from the user closing the window
-	return (HRESULT)msg.wParam;
+	// Spin the rest
+	while (now < seconds)
+	{
+		YieldProcessor();
+		now = GetSeconds();
+	}
+	return sleepSeconds;
 }
 
 
 // --------------------------------------------------------
-// Sends an OS-level window close message to our process, which
-// will be handled by our message processing function
+// Gets input and the title bar ready for this frame
 // --------------------------------------------------------
-void DXCore::Quit()
+void DXCore::BeginFrame(float deltaTime, float totalTime)
 {
-	PostMessage(this->hWnd, WM_CLOSE, NULL, NULL);
+	this->deltaTime = deltaTime;
+	this->totalTime = totalTime;
+	if (titleBarStats)
+		UpdateTitleBarStats();
+
+	// Update the input manager
+	Input::GetInstance().Update();
+}
+
+// --------------------------------------------------------
+// Frame is over, notify the input manager
+// --------------------------------------------------------
+void DXCore::EndFrame()
+{
+	Input::GetInstance().EndOfFrame();
+}
+
+
+void DXCore::SetFixedTimestep(float stepSeconds, unsigned int maxSteps)
+{
+	frameLoop.SetFixedTimestep(stepSeconds, maxSteps);
+}
+
+float DXCore::GetFixedTimestep() const
+{
+	return this->frameLoop.GetFixedTimestep();
+}
+
+FixedStepStats DXCore::GetFixedStepStats() const
+{
+	return this->frameLoop.GetFixedStepStats();
+}
+
+float DXCore::GetInterpolationAlpha() const
+{
+	return this->frameLoop.GetInterpolationAlpha();
 }
 
 
 // --------------------------------------------------------
-// Uses high resolution time stamps to get very accurate
-// timing information, and calculates useful time stats
+// Sets the frame rate limit
+//
+// - The regular waitable timer only wakes every 15.6 ms by
+//   default, so without a high resolution timer the system
+//   timer is raised to 1 ms while limiting
 // --------------------------------------------------------
-void DXCore::UpdateTimer()
+void DXCore::SetTargetFrameRate(float framesPerSecond)
 {
-	// Grab the current time
-	__int64 now = 0;
-	QueryPerformanceCounter((LARGE_INTEGER*)&now);
-	currentTime = now;
+	bool wasLimited = frameLoop.GetTargetFrameRate() > 0.0f;
+	frameLoop.SetTargetFrameRate(framesPerSecond);
+	bool limited = frameLoop.GetTargetFrameRate() > 0.0f;
 
-	// Calculate delta time and clamp to zero
-	//  - Could go negative if CPU goes into power save mode 
-	//    or the process itself gets moved to another core
-	deltaTime = max((float)((currentTime - previousTime) * perfCounterSeconds), 0.0f);
+	if (!frameTimerHighResolution && limited != wasLimited)
+	{
+		if (limited)
+			timeBeginPeriod(1);
+		else
+			timeEndPeriod(1);
+	}
+}
 
-	// Calculate the total time from start to now
-	totalTime = (float)((currentTime - startTime) * perfCounterSeconds);
+float DXCore::GetTargetFrameRate() const
+{
+	return this->frameLoop.GetTargetFrameRate();
+}
 
-	// Save current time for next frame
-	previousTime = currentTime;
+FramePacingStats DXCore::GetFramePacingStats() const
+{
+	return this->frameLoop.GetFramePacingStats();
+}
+
+FrameLoopStats DXCore::GetFrameLoopStats() const
+{
+	return this->frameLoop.GetStats();
+}
+
+
+// --------------------------------------------------------
+// Sends an OS-level window close message to our process, which
+// will be handled by our message processing function
+// --------------------------------------------------------
+void DXCore::Quit()
+{
+	PostMessage(this->hWnd, WM_CLOSE, NULL, NULL);
 }
 
 
@@ -5,12 +5,21 @@
 #include <string>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 
+#include "FrameLoop.h"
+
 // We can include the correct library files here
 // instead of in Visual Studio settings if we want
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
-
-class DXCore
+#pragma comment(lib, "winmm.lib")
+
+// --------------------------------------------------------
+// The Win32 and Direct3D 11 platform
+//
+// - Creates the window and device, and runs a FrameLoop with
+//   itself as both the platform and the callbacks
+// --------------------------------------------------------
+class DXCore : public Platform, public FrameCallbacks
 {
 public:
 	DXCore(
@@ -46,6 +55,26 @@ public:
 	virtual void Update(float deltaTime, float totalTime) = 0;
 	virtual void Draw(float deltaTime, float totalTime) = 0;
 
+	// Switches to fixed timestep mode for a stepSeconds above 0, running at
+	// most maxSteps ticks per frame, or back to one tick per frame for 0
+	void SetFixedTimestep(float stepSeconds, unsigned int maxSteps = 5);
+	float GetFixedTimestep() const;
+	FixedStepStats GetFixedStepStats() const;
+
+	// Caps the frame rate at framesPerSecond, or uncaps it for 0. Works with
+	// or without vsync, though vsync already paces frames to the display
+	void SetTargetFrameRate(float framesPerSecond);
+	float GetTargetFrameRate() const;
+	FramePacingStats GetFramePacingStats() const;
+	FrameLoopStats GetFrameLoopStats() const;
+
+	// Platform
+	bool PumpMessages() override;
+	double GetSeconds() override;
+	double WaitUntil(double seconds) override;
+	void BeginFrame(float deltaTime, float totalTime) override;
+	void EndFrame() override;
+
 protected:
 	HINSTANCE		hInstance;		// The handle to the application
 	HWND			hWnd;			// The handle to the window itself
@@ -78,20 +107,28 @@ protected:
 	// Helper function for allocating a console window
 	void CreateConsoleWindow(int bufferLines, int bufferColumns, int windowLines, int windowColumns);
 
+	// How far this frame is between the last two ticks, for rendering
+	// (0 is the previous tick, 1 the last one, and always 1 without a fixed timestep)
+	float GetInterpolationAlpha() const;
+
 private:
 	// Timing related data
 	double perfCounterSeconds;
 	float totalTime;
 	float deltaTime;
 	__int64 startTime;
-	__int64 currentTime;
-	__int64 previousTime;
 
 	// FPS calculation
 	int fpsFrameCount;
 	float fpsTimeElapsed;
 
-	void UpdateTimer();			// Updates the timer for this frame
+	// Fixed timestep, frame limit and timing stats
+	FrameLoop frameLoop;
+	HANDLE frameTimer;
+	bool frameTimerHighResolution;
+
+	// The exit code from the WM_QUIT message
+	WPARAM exitCode;
+
 	void UpdateTitleBarStats();	// Puts debug info in the title bar
 };
-
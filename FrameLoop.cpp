@@ -0,0 +1,287 @@
+#include "FrameLoop.h"
+#include "Profiler.h"
+
+#include <cmath>
+
+FrameLoop::FrameLoop()
+	: started(false),
+	startTime(0),
+	previousTime(0),
+	totalTime(0),
+	deltaTime(0),
+	fixedTimestep(0),
+	maxStepsPerFrame(5),
+	stepAccumulator(0),
+	simulationTime(0),
+	interpolationAlpha(1.0f),
+	fixedStepStats(),
+	targetFrameRate(0),
+	nextFrameTime(-1.0),
+	frameSleepSeconds(0),
+	framePacingStats(),
+	stats()
+{
+	// Nothing sleeps until a limit is set
+	framePacingStats.busyFraction = 1.0f;
+}
+
+void FrameLoop::Start(Platform& platform)
+{
+	startTime = platform.GetSeconds();
+	previousTime = startTime;
+	started = true;
+}
+
+
+// --------------------------------------------------------
+// Runs the loop, handling the following each frame:
+//  - OS-level messages, through the platform
+//  - Calling update & draw back and forth
+//  - Holding off the next frame if it's limited
+// --------------------------------------------------------
+unsigned long long FrameLoop::Run(Platform& platform, FrameCallbacks& callbacks, unsigned long long frameCount)
+{
+	if (!started)
+		Start(platform);
+
+	unsigned long long frames = 0;
+	while ((frameCount == 0 || frames < frameCount) && platform.PumpMessages())
+	{
+		// Update timer and stats
+		Profiler::GetInstance().BeginFrame();
+		UpdateTimer(platform);
+		UpdateFramePacingStats();
+		platform.BeginFrame(deltaTime, totalTime);
+
+		// The game loop
+		double frameStart = platform.GetSeconds();
+		{
+			PROFILE_ZONE("Simulation");
+			RunSimulation(callbacks);
+		}
+
+		double updateStart = platform.GetSeconds();
+		{
+			PROFILE_ZONE("Update");
+			callbacks.Update(deltaTime, totalTime);
+		}
+
+		double drawStart = platform.GetSeconds();
+		{
+			PROFILE_ZONE("Draw");
+			callbacks.Draw(deltaTime, totalTime);
+		}
+
+		double frameEnd = platform.GetSeconds();
+		stats.simulationSeconds += updateStart - frameStart;
+		stats.updateSeconds += drawStart - updateStart;
+		stats.drawSeconds += frameEnd - drawStart;
+		if (frameEnd - frameStart > stats.worstFrameSeconds)
+			stats.worstFrameSeconds = frameEnd - frameStart;
+
+		// Frame is over
+		platform.EndFrame();
+
+		// Hold off the next frame if it's limited
+		{
+			PROFILE_ZONE("Wait");
+			WaitForNextFrame(platform);
+		}
+		stats.waitSeconds += framePacingStats.lastSleepSeconds + framePacingStats.lastSpinSeconds;
+		stats.frames++;
+		frames++;
+	}
+	return frames;
+}
+
+
+// --------------------------------------------------------
+// Sets up the fixed timestep simulation
+//
+// - The accumulator starts over, so switching modes doesn't
+//   cause a burst of catch-up ticks
+// --------------------------------------------------------
+void FrameLoop::SetFixedTimestep(float stepSeconds, unsigned int maxSteps)
+{
+	fixedTimestep = stepSeconds > 0.0f ? stepSeconds : 0.0f;
+	maxStepsPerFrame = maxSteps > 0 ? maxSteps : 1;
+	stepAccumulator = 0.0;
+	simulationTime = totalTime;
+}
+
+float FrameLoop::GetFixedTimestep() const
+{
+	return this->fixedTimestep;
+}
+
+FixedStepStats FrameLoop::GetFixedStepStats() const
+{
+	return this->fixedStepStats;
+}
+
+float FrameLoop::GetInterpolationAlpha() const
+{
+	return this->interpolationAlpha;
+}
+
+void FrameLoop::SetTargetFrameRate(float framesPerSecond)
+{
+	targetFrameRate = framesPerSecond > 0.0f ? framesPerSecond : 0.0f;
+
+	// Start the schedule over from now
+	nextFrameTime = -1.0;
+	framePacingStats.targetFrameTime = targetFrameRate > 0.0f ? 1.0f / targetFrameRate : 0.0f;
+}
+
+float FrameLoop::GetTargetFrameRate() const
+{
+	return this->targetFrameRate;
+}
+
+FramePacingStats FrameLoop::GetFramePacingStats() const
+{
+	return this->framePacingStats;
+}
+
+FrameLoopStats FrameLoop::GetStats() const
+{
+	return this->stats;
+}
+
+
+// --------------------------------------------------------
+// Advances the clock to now
+//
+// - Delta time is clamped to zero, in case a platform's
+//   clock ever does step backwards
+// --------------------------------------------------------
+void FrameLoop::UpdateTimer(Platform& platform)
+{
+	double now = platform.GetSeconds();
+	deltaTime = now > previousTime ? (float)(now - previousTime) : 0.0f;
+	totalTime = (float)(now - startTime);
+	previousTime = now;
+}
+
+
+// --------------------------------------------------------
+// Runs this frame's simulation ticks
+//
+// - With a fixed timestep, the frame's time goes into an
+//   accumulator, and each whole step in it is one tick
+// - Ticks are capped per frame, so a slow frame can't cause
+//   more ticks, which cause a slower frame, and so on. Time
+//   beyond the cap is dropped, and the simulation runs slow
+//   rather than falling further behind
+// - What's left is less than a step, and how much of one is
+//   the alpha that rendering interpolates by
+// --------------------------------------------------------
+void FrameLoop::RunSimulation(FrameCallbacks& callbacks)
+{
+	fixedStepStats.maxSteps = maxStepsPerFrame;
+
+	// One tick per frame, with the frame's own times
+	if (fixedTimestep <= 0.0f)
+	{
+		callbacks.FixedUpdate(deltaTime, totalTime);
+		simulationTime = totalTime;
+		interpolationAlpha = 1.0f;
+		fixedStepStats.steps = 1;
+		fixedStepStats.alpha = interpolationAlpha;
+		stats.ticks++;
+		return;
+	}
+
+	stepAccumulator += deltaTime;
+
+	unsigned int steps = 0;
+	while (stepAccumulator >= fixedTimestep && steps < maxStepsPerFrame)
+	{
+		simulationTime += fixedTimestep;
+		callbacks.FixedUpdate(fixedTimestep, (float)simulationTime);
+		stepAccumulator -= fixedTimestep;
+		steps++;
+	}
+
+	// Keep only the part step, so alpha carries on smoothly
+	if (stepAccumulator >= fixedTimestep)
+	{
+		double remainder = fmod(stepAccumulator, (double)fixedTimestep);
+		fixedStepStats.droppedSeconds += stepAccumulator - remainder;
+		stepAccumulator = remainder;
+	}
+
+	interpolationAlpha = (float)(stepAccumulator / fixedTimestep);
+	fixedStepStats.steps = steps;
+	fixedStepStats.alpha = interpolationAlpha;
+	stats.ticks += steps;
+}
+
+
+// --------------------------------------------------------
+// Waits until the next frame is due
+//
+// - Frames are due at fixed intervals from the first one,
+//   rather than an interval after the last one finished, so
+//   waking a little late doesn't push every later frame back
+// - Falling more than a frame behind starts the schedule over,
+//   instead of rushing frames out to catch up
+// - How the wait is split between sleeping and spinning is
+//   up to the platform
+// --------------------------------------------------------
+void FrameLoop::WaitForNextFrame(Platform& platform)
+{
+	frameSleepSeconds = 0.0;
+	framePacingStats.lastSleepSeconds = 0.0;
+	framePacingStats.lastSpinSeconds = 0.0;
+	if (targetFrameRate <= 0.0f)
+		return;
+
+	double period = 1.0 / targetFrameRate;
+	double now = platform.GetSeconds();
+
+	// The first limited frame starts the schedule
+	if (nextFrameTime < 0.0)
+		nextFrameTime = now;
+	nextFrameTime += period;
+
+	// Already more than a frame late, so go now and start over from here
+	if (now - nextFrameTime > period)
+	{
+		nextFrameTime = now;
+		return;
+	}
+
+	double sleepSeconds = platform.WaitUntil(nextFrameTime);
+	double waitSeconds = platform.GetSeconds() - now;
+	framePacingStats.lastSleepSeconds = sleepSeconds;
+	framePacingStats.lastSpinSeconds = waitSeconds > sleepSeconds ? waitSeconds - sleepSeconds : 0.0;
+	frameSleepSeconds = sleepSeconds;
+}
+
+
+// --------------------------------------------------------
+// Smooths this frame's time into the pacing stats
+//
+// - Exponential moving averages of the frame time and of its
+//   squared difference from the average, so there's no
+//   history to keep
+// --------------------------------------------------------
+void FrameLoop::UpdateFramePacingStats()
+{
+	const float smoothing = 0.05f;
+
+	float frameTime = deltaTime;
+	if (framePacingStats.smoothedFrameTime == 0.0f)
+		framePacingStats.smoothedFrameTime = frameTime;
+
+	float difference = frameTime - framePacingStats.smoothedFrameTime;
+	float variance = framePacingStats.frameTimeStdDev * framePacingStats.frameTimeStdDev;
+	variance += smoothing * (difference * difference - variance);
+	framePacingStats.smoothedFrameTime += smoothing * difference;
+	framePacingStats.frameTimeStdDev = sqrtf(variance);
+
+	float busy = frameTime > 0.0f ? 1.0f - (float)(frameSleepSeconds / frameTime) : 1.0f;
+	busy = busy < 0.0f ? 0.0f : (busy > 1.0f ? 1.0f : busy);
+	framePacingStats.busyFraction += smoothing * (busy - framePacingStats.busyFraction);
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "Platform.h"
+
+// --------------------------------------------------------
+// What the last frame's fixed timestep loop did
+//
+// - droppedSeconds is all the time ever thrown away because
+//   the simulation couldn't catch up within maxSteps ticks
+// --------------------------------------------------------
+struct FixedStepStats
+{
+	unsigned int steps;
+	unsigned int maxSteps;
+	float alpha;
+	double droppedSeconds;
+};
+
+// --------------------------------------------------------
+// How evenly frames are coming out, with or without a limit
+//
+// - Frame times are smoothed over roughly the last 20 frames,
+//   and stdDev is how far they stray from that
+// - busyFraction is the share of each frame not spent asleep.
+//   An uncapped loop never sleeps, so it's always 1 there
+// --------------------------------------------------------
+struct FramePacingStats
+{
+	float targetFrameTime;
+	float smoothedFrameTime;
+	float frameTimeStdDev;
+	float busyFraction;
+	double lastSleepSeconds;
+	double lastSpinSeconds;
+};
+
+// --------------------------------------------------------
+// Where the time went, totalled over every frame run
+//
+// - simulationSeconds covers every FixedUpdate() tick
+// - worstFrameSeconds is the slowest frame's callbacks,
+//   not counting any wait for the frame limit
+// --------------------------------------------------------
+struct FrameLoopStats
+{
+	unsigned long long frames;
+	unsigned long long ticks;
+	double simulationSeconds;
+	double updateSeconds;
+	double drawSeconds;
+	double waitSeconds;
+	double worstFrameSeconds;
+};
+
+// --------------------------------------------------------
+// The game loop, apart from any window or device
+//
+// - Each frame pumps the platform's messages, advances the
+//   clock, runs the simulation ticks, Update() and Draw(),
+//   then waits out any frame limit
+// - With a fixed timestep, the frame's time goes into an
+//   accumulator that runs FixedUpdate() once per whole step
+//   (see RunSimulation())
+// - The frame limit keeps an absolute schedule and waits with
+//   Platform::WaitUntil() (see WaitForNextFrame())
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class FrameLoop
+{
+public:
+	FrameLoop();
+
+	// Starts the clock. Run() starts it if this wasn't called, but calling
+	// it before any setup counts the setup in the first frame's time
+	void Start(Platform& platform);
+
+	// Runs frames until the platform quits, or frameCount frames have run
+	// (0 for no limit). Returns the number of frames run
+	unsigned long long Run(Platform& platform, FrameCallbacks& callbacks, unsigned long long frameCount = 0);
+
+	// Switches to fixed timestep mode for a stepSeconds above 0, running at
+	// most maxSteps ticks per frame, or back to one tick per frame for 0
+	void SetFixedTimestep(float stepSeconds, unsigned int maxSteps = 5);
+	float GetFixedTimestep() const;
+	FixedStepStats GetFixedStepStats() const;
+
+	// How far this frame is between the last two ticks, for rendering
+	// (0 is the previous tick, 1 the last one, and always 1 without a fixed timestep)
+	float GetInterpolationAlpha() const;
+
+	// Caps the frame rate at framesPerSecond, or uncaps it for 0
+	void SetTargetFrameRate(float framesPerSecond);
+	float GetTargetFrameRate() const;
+	FramePacingStats GetFramePacingStats() const;
+
+	FrameLoopStats GetStats() const;
+
+private:
+	// Timing related data
+	bool started;
+	double startTime;
+	double previousTime;
+	float totalTime;
+	float deltaTime;
+
+	// Fixed timestep simulation
+	float fixedTimestep;
+	unsigned int maxStepsPerFrame;
+	double stepAccumulator;
+	double simulationTime;
+	float interpolationAlpha;
+	FixedStepStats fixedStepStats;
+
+	// Frame rate limiter
+	float targetFrameRate;
+	double nextFrameTime;
+	double frameSleepSeconds;
+	FramePacingStats framePacingStats;
+
+	FrameLoopStats stats;
+
+	void UpdateTimer(Platform& platform);
+	void RunSimulation(FrameCallbacks& callbacks);
+	void WaitForNextFrame(Platform& platform);
+	void UpdateFramePacingStats();
+};
@@ -12,6 +12,7 @@
 #pragma comment(lib, "d3dcompiler.lib")
 #include <d3dcompiler.h>
 #include <math.h>
+#include <chrono>
 
 #include <WICTextureLoader.h>
 
@@ -43,6 +44,9 @@ Game::Game(HINSTANCE hInstance)
 	activeCamera = 0;
 	gameRenderer = nullptr;
 	moveTime = 0.0f;
+	firstFrameTime = 0.0;
+	assetsLoadedTime = 0.0;
+	worstStreamingFrameTime = 0.0;
 }
 
 // --------------------------------------------------------
@@ -59,6 +63,11 @@ Game::~Game()
 	// Call Release() on any Direct3D objects made within this class
 	// - Note: this is unnecessary for D3D objects stored in ComPtrs
 
+	// Stop loading first, as loads still running use the device
+	// and the registry
+	assetLoader.reset();
+	assetRegistry.reset();
+
 	// ImGui clean up
 	ImGui_ImplDX11_Shutdown();
 	ImGui_ImplWin32_Shutdown();
@@ -71,6 +80,24 @@ Game::~Game()
 // --------------------------------------------------------
 void Game::Init()
 {
+	// Time from here to the first frame and to every asset being loaded
+	initStartTime = std::chrono::steady_clock::now();
+
+	// Create the asset loader - WIC needs COM on every thread that decodes
+	assetLoader = std::make_shared<AssetLoader>(
+		2,
+		[]() { CoInitializeEx(nullptr, COINIT_MULTITHREADED); },
+		[]() { CoUninitialize(); }
+	);
+
+	// Static meshes share a few large buffers, so drawing them rarely rebinds anything
+	geometryArena = std::make_shared<GeometryArena>(device, context);
+	assetRegistry = std::make_shared<AssetRegistry>(context, swapChain, device, assetLoader.get(), geometryArena);
+
+	// Per-frame engine work fans out across these threads (see JobSystem.h)
+	jobSystem = std::make_shared<JobSystem>();
+	Profiler::SetThreadName("Main");
+
 	// Create a renderer
 	gameRenderer = std::make_shared<GameRenderer>(
 		this->windowWidth, this->windowHeight,
@@ -80,6 +107,11 @@ void Game::Init()
 
 	// Initialize the renderer - initializes shaders as well
 	gameRenderer->Init();
+	gameRenderer->SetGeometryArena(geometryArena);
+	gameRenderer->SetJobSystem(jobSystem);
+
+	// Entity transforms are stored together, so their matrices rebuild in one batch
+	transformSystem = std::make_shared<TransformSystem>(jobSystem);
 
 	// Create geometry
 	CreateGeometry();
@@ -182,343 +214,234 @@ void Game::CreateAssets()
 	CreateMaterials(sampler);
 
 	// Create skybox
-	gameRenderer->CreateSkybox(sampler, meshes[2]);
+	gameRenderer->CreateSkybox(sampler, meshes[2].Get());
 }
 
 // --------------------------------------------------------
-// Creates the geometry we're going to draw - a single triangle for now
+// Create the animated mesh: a helix bent by a chain of
+// joints up its length
+//
+// - Loaded up front like the cube. It's the same file as one
+//   the registry streams in, so it has to be cooked before
+//   that load can start writing the same cooked file
 // --------------------------------------------------------
-void Game::CreateGeometry()
+void Game::CreateSkinnedMesh()
 {
-	meshes.push_back(
-		std::make_shared<Mesh>(
-			context,
-			swapChain,
-			device,
-			FixPath("../../Assets/sphere.obj").c_str()
-		)
-	);
-
-	meshes.push_back(
-		std::make_shared<Mesh>(
-			context,
-			swapChain,
-			device,
-			FixPath("../../Assets/helix.obj").c_str()
-		)
-	);
-
-	meshes.push_back(
-		std::make_shared<Mesh>(
-			context,
-			swapChain,
-			device,
-			FixPath("../../Assets/cube.obj").c_str()
-		)
+	skinnedMesh = std::make_shared<Mesh>(
+		context,
+		swapChain,
+		device,
+		FixPath("../../Assets/helix.obj").c_str()
 	);
-}
 
-// --------------------------------------------------------
-// Create materials
-// --------------------------------------------------------
-void Game::CreateMaterials(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
-{
-	// Create ShaderResourceViews
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> marbleAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> marbleNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> marbleRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> marbleMetalnessSRV;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roofingTileAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roofingTileNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roofingTileRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> roofingTileMetalnessSRV;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> scratchedMetalnessSRV;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> steelAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> steelNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> steelRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> steelMetalnessSRV;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ironAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ironNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ironRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> ironMetalnessSRV;
-
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pavementAlbedoSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pavementNormalSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pavementRoughnessSRV;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> pavementMetalnessSRV;
-
-	// Load Marble
+	// One joint at the bottom, then evenly spaced children up to the top
+	const int jointCount = 6;
+	float bottom = skinnedMesh->GetBoundsMin().y;
+	float segment = (skinnedMesh->GetBoundsMax().y - bottom) / (jointCount - 1);
+	skeleton = std::make_shared<Skeleton>();
+	int parent = -1;
+	for (int j = 0; j < jointCount; j++)
 	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Marble_Albedo.png").c_str(),
-			0,
-			marbleAlbedoSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Marble_Normal.png").c_str(),
-			0,
-			marbleNormalSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Marble_Roughness.png").c_str(),
-			0,
-			marbleRoughnessSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Marble_Metal.png").c_str(),
-			0,
-			marbleMetalnessSRV.GetAddressOf()
-		);
+		JointPose bindPose = { { 0.0f, j == 0 ? bottom : segment, 0.0f }, { 0.0f, 0.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } };
+		parent = skeleton->AddJoint("Joint " + std::to_string(j), parent, bindPose);
 	}
 
-	// Load Roofing Tile
+	// Each joint sways about Z a little behind the one below it
+	swayClip = AnimationClip(2.0f);
+	for (int j = 1; j < jointCount; j++)
 	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/RoofingTile_Albedo.png").c_str(),
-			0,
-			roofingTileAlbedoSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/RoofingTile_Normal.png").c_str(),
-			0,
-			roofingTileNormalSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/RoofingTile_Roughness.png").c_str(),
-			0,
-			roofingTileRoughnessSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/RoofingTile_Metal.png").c_str(),
-			0,
-			roofingTileMetalnessSRV.GetAddressOf()
-		);
+		for (int k = 0; k <= 8; k++)
+		{
+			float time = k * 0.25f;
+			float angle = 0.35f * sinf(XM_2PI * (time / 2.0f) - j * 0.5f);
+			JointPose pose = skeleton->GetJoint(j).bindPose;
+			pose.rotation[2] = sinf(angle / 2.0f);
+			pose.rotation[3] = cosf(angle / 2.0f);
+			swayClip.AddKey(j, time, pose);
+		}
 	}
 
-	// Load Scratched
+	// Weights come from the bind pose vertices' distance to each bone
+	std::span<const Vertex> bindVertices = skinnedMesh->GetVertices();
+	std::vector<SkinWeights> weights(bindVertices.size());
+	Skinning::BindToNearestJoints(
+		reinterpret_cast<const ObjVertex*>(bindVertices.data()), (unsigned int)bindVertices.size(),
+		*skeleton, weights.data());
+	if (!skinnedMesh->EnableSkinning(skeleton, std::move(weights)))
 	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Scratched_Albedo.png").c_str(),
-			0,
-			scratchedAlbedoSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Scratched_Normal.png").c_str(),
-			0,
-			scratchedNormalSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Scratched_Roughness.png").c_str(),
-			0,
-			scratchedRoughnessSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Scratched_Metal.png").c_str(),
-			0,
-			scratchedMetalnessSRV.GetAddressOf()
-		);
+		skinnedMesh.reset();
+		return;
 	}
 
-	// Load Steel
-	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Steel_Albedo.png").c_str(),
-			0,
-			steelAlbedoSRV.GetAddressOf()
-		);
+	skeletonPose.resize(skeleton->GetJointCount());
+	skinningPalette.resize(skeleton->GetJointCount());
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Steel_Normal.png").c_str(),
-			0,
-			steelNormalSRV.GetAddressOf()
-		);
+	// Two blend shapes, each moving only part of the helix (see MorphTargets.h)
+	// - Bulge pushes the middle third out along the normals
+	// - Flare widens the top quarter, more towards the top
+	float height = skinnedMesh->GetBoundsMax().y - bottom;
+	std::vector<XMFLOAT3> bulge(bindVertices.size(), XMFLOAT3(0, 0, 0));
+	std::vector<XMFLOAT3> flare(bindVertices.size(), XMFLOAT3(0, 0, 0));
+	for (size_t v = 0; v < bindVertices.size(); v++)
+	{
+		const Vertex& vertex = bindVertices[v];
+		float t = (vertex.Position.y - bottom) / height;
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Steel_Roughness.png").c_str(),
-			0,
-			steelRoughnessSRV.GetAddressOf()
-		);
+		if (t > 0.33f && t < 0.67f)
+		{
+			float amount = 0.25f * sinf(XM_PI * (t - 0.33f) / 0.34f);
+			bulge[v] = XMFLOAT3(vertex.Normal.x * amount, vertex.Normal.y * amount, vertex.Normal.z * amount);
+		}
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Steel_Metal.png").c_str(),
-			0,
-			steelMetalnessSRV.GetAddressOf()
-		);
+		if (t > 0.75f)
+		{
+			float amount = (t - 0.75f) / 0.25f;
+			flare[v] = XMFLOAT3(vertex.Position.x * amount, 0.0f, vertex.Position.z * amount);
+		}
 	}
+	skinnedMesh->AddMorphTarget("Bulge", bulge, {});
+	skinnedMesh->AddMorphTarget("Flare", flare, {});
+}
 
-	// Load Iron
-	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Iron_Albedo.png").c_str(),
-			0,
-			ironAlbedoSRV.GetAddressOf()
-		);
-
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Iron_Normal.png").c_str(),
-			0,
-			ironNormalSRV.GetAddressOf()
-		);
+// --------------------------------------------------------
+// Creates the geometry we're going to draw
+//
+// - The cube is tiny and the skybox needs it straight away,
+//   so it's loaded up front and stands in for the others
+//   while they stream in
+// --------------------------------------------------------
+void Game::CreateGeometry()
+{
+	std::shared_ptr<Mesh> cube = std::make_shared<Mesh>(
+		context,
+		swapChain,
+		device,
+		FixPath("../../Assets/cube.obj").c_str()
+	);
+	cube->MoveToArena(geometryArena);
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Iron_Roughness.png").c_str(),
-			0,
-			ironRoughnessSRV.GetAddressOf()
-		);
+	CreateSkinnedMesh();
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Iron_Metal.png").c_str(),
-			0,
-			ironMetalnessSRV.GetAddressOf()
-		);
-	}
+	meshes.push_back(
+		assetRegistry->LoadMesh(
+			FixPath("../../Assets/sphere.obj"),
+			cube,
+			VertexFormat::Compact
+		)
+	);
 
-	// Load pavement
-	{
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Pavement_Albedo.png").c_str(),
-			0,
-			pavementAlbedoSRV.GetAddressOf()
-		);
+	meshes.push_back(
+		assetRegistry->LoadMesh(
+			FixPath("../../Assets/helix.obj"),
+			cube,
+			VertexFormat::CompactQuantized,
+			MeshCPUData::ReleaseAfterUpload
+		)
+	);
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Pavement_Normal.png").c_str(),
-			0,
-			pavementNormalSRV.GetAddressOf()
-		);
+	meshes.push_back(cube);
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Pavement_Roughness.png").c_str(),
-			0,
-			pavementRoughnessSRV.GetAddressOf()
-		);
+	// Last, as the entities expect the streamed meshes first
+	if (skinnedMesh)
+		meshes.push_back(skinnedMesh);
+}
 
-		CreateWICTextureFromFile(
-			device.Get(),
-			context.Get(),
-			FixPath(L"../../Textures/Pavement_Metal.png").c_str(),
-			0,
-			pavementMetalnessSRV.GetAddressOf()
-		);
-	}
+// --------------------------------------------------------
+// Create materials
+//
+// - Every texture streams in, with flat placeholders bound
+//   until it's ready
+// --------------------------------------------------------
+void Game::CreateMaterials(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler)
+{
+	// Create placeholders: mid grey, a flat normal and no metalness
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> greySRV = CreateSolidColorTexture(128, 128, 128);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> flatNormalSRV = CreateSolidColorTexture(128, 128, 255);
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> blackSRV = CreateSolidColorTexture(0, 0, 0);
 
 	// Create marble texture
 	std::shared_ptr<Material> marble = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.2f, 1.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	marble->AddTextureSRV("Albedo", marbleAlbedoSRV);
-	marble->AddTextureSRV("NormalMap", marbleNormalSRV);
-	marble->AddTextureSRV("RoughnessMap", marbleRoughnessSRV);
-	marble->AddTextureSRV("MetalnessMap", marbleMetalnessSRV);
+	marble->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/Marble_Albedo.png"), greySRV));
+	marble->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Marble_Normal.png"), flatNormalSRV));
+	marble->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Marble_Roughness.png"), greySRV));
+	marble->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Marble_Metal.png"), blackSRV));
 	marble->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Marble", marble });
 
 	// Create roofing tile texture
 	std::shared_ptr<Material> roofingTile = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.2f, 1.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	roofingTile->AddTextureSRV("Albedo", roofingTileAlbedoSRV);
-	roofingTile->AddTextureSRV("NormalMap", roofingTileNormalSRV);
-	roofingTile->AddTextureSRV("RoughnessMap", roofingTileRoughnessSRV);
-	roofingTile->AddTextureSRV("MetalnessMap", roofingTileMetalnessSRV);
+	roofingTile->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/RoofingTile_Albedo.png"), greySRV));
+	roofingTile->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/RoofingTile_Normal.png"), flatNormalSRV));
+	roofingTile->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/RoofingTile_Roughness.png"), greySRV));
+	roofingTile->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/RoofingTile_Metal.png"), blackSRV));
 	roofingTile->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Roofing Tile", roofingTile });
 
 	// Create scratched texture
 	std::shared_ptr<Material> scratched = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.0f, 0.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	scratched->AddTextureSRV("Albedo", scratchedAlbedoSRV);
-	scratched->AddTextureSRV("NormalMap", scratchedNormalSRV);
-	scratched->AddTextureSRV("RoughnessMap", scratchedRoughnessSRV);
-	scratched->AddTextureSRV("MetalnessMap", scratchedMetalnessSRV);
+	scratched->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/Scratched_Albedo.png"), greySRV));
+	scratched->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Scratched_Normal.png"), flatNormalSRV));
+	scratched->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Scratched_Roughness.png"), greySRV));
+	scratched->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Scratched_Metal.png"), blackSRV));
 	scratched->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Scratched", scratched });
 
 	// Create steel texture
 	std::shared_ptr<Material> steel = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.0f, 2.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	steel->AddTextureSRV("Albedo", steelAlbedoSRV);
-	steel->AddTextureSRV("NormalMap", steelNormalSRV);
-	steel->AddTextureSRV("RoughnessMap", steelRoughnessSRV);
-	steel->AddTextureSRV("MetalnessMap", steelMetalnessSRV);
+	steel->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/Steel_Albedo.png"), greySRV));
+	steel->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Steel_Normal.png"), flatNormalSRV));
+	steel->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Steel_Roughness.png"), greySRV));
+	steel->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Steel_Metal.png"), blackSRV));
 	steel->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Steel", steel });
 
 	// Create iron texture
 	std::shared_ptr<Material> iron = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.0f, 2.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	iron->AddTextureSRV("Albedo", ironAlbedoSRV);
-	iron->AddTextureSRV("NormalMap", ironNormalSRV);
-	iron->AddTextureSRV("RoughnessMap", ironRoughnessSRV);
-	iron->AddTextureSRV("MetalnessMap", ironMetalnessSRV);
+	iron->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/Iron_Albedo.png"), greySRV));
+	iron->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Iron_Normal.png"), flatNormalSRV));
+	iron->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Iron_Roughness.png"), greySRV));
+	iron->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Iron_Metal.png"), blackSRV));
 	iron->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Iron", iron });
 
 	// Create pavement texture
 	std::shared_ptr<Material> pavement = std::make_shared<Material>(XMFLOAT3(1, 1, 1), 0.0f, 0.0f, 1.0f, gameRenderer->GetPixelShader(), gameRenderer->GetVertexShader());
-	pavement->AddTextureSRV("Albedo", pavementAlbedoSRV);
-	pavement->AddTextureSRV("NormalMap", pavementNormalSRV);
-	pavement->AddTextureSRV("RoughnessMap", pavementRoughnessSRV);
-	pavement->AddTextureSRV("MetalnessMap", pavementMetalnessSRV);
+	pavement->AddTextureSRV("Albedo", assetRegistry->LoadTexture(FixPath(L"../../Textures/Pavement_Albedo.png"), greySRV));
+	pavement->AddTextureSRV("NormalMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Pavement_Normal.png"), flatNormalSRV));
+	pavement->AddTextureSRV("RoughnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Pavement_Roughness.png"), greySRV));
+	pavement->AddTextureSRV("MetalnessMap", assetRegistry->LoadTexture(FixPath(L"../../Textures/Pavement_Metal.png"), blackSRV));
 	pavement->AddSamplerState("BasicSampler", sampler);
 	materials.insert({ "Pavement", pavement });
 }
 
+// --------------------------------------------------------
+// Creates a 1x1 texture of a single color, for placeholders
+// --------------------------------------------------------
+Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> Game::CreateSolidColorTexture(unsigned char r, unsigned char g, unsigned char b)
+{
+	unsigned char pixel[4] = { r, g, b, 255 };
+
+	D3D11_TEXTURE2D_DESC desc = {};
+	desc.Width = 1;
+	desc.Height = 1;
+	desc.MipLevels = 1;
+	desc.ArraySize = 1;
+	desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	desc.SampleDesc.Count = 1;
+	desc.Usage = D3D11_USAGE_IMMUTABLE;
+	desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data = {};
+	data.pSysMem = pixel;
+	data.SysMemPitch = sizeof(pixel);
+
+	Microsoft::WRL::ComPtr<ID3D11Texture2D> texture;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> srv;
+	device->CreateTexture2D(&desc, &data, texture.GetAddressOf());
+	device->CreateShaderResourceView(texture.Get(), nullptr, srv.GetAddressOf());
+	return srv;
+}
+
 // --------------------------------------------------------
 // Create the game entities
 // --------------------------------------------------------
@@ -528,7 +451,8 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[0],
-			materials["Steel"]
+			materials["Steel"],
+			transformSystem
 		)
 	);
 	entities[0]->GetTransform()->SetPosition(-10.0f, 0.0f, 0.0f);
@@ -536,7 +460,8 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[0],
-			materials["Scratched"]
+			materials["Scratched"],
+			transformSystem
 		)
 	);
 	entities[1]->GetTransform()->SetPosition(-5.0f, 0.0f, 0.0f);
@@ -544,7 +469,8 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[0],
-			materials["Marble"]
+			materials["Marble"],
+			transformSystem
 		)
 	);
 	entities[2]->GetTransform()->SetPosition(0.0f, 0.0f, 0.0f);
@@ -552,7 +478,8 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[1],
-			materials["Roofing Tile"]
+			materials["Roofing Tile"],
+			transformSystem
 		)
 	);
 	entities[3]->GetTransform()->SetPosition(5.0f, 0.0f, 0.0f);
@@ -560,7 +487,8 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[2],
-			materials["Iron"]
+			materials["Iron"],
+			transformSystem
 		)
 	);
 	entities[4]->GetTransform()->SetPosition(10.0f, 0.0f, 0.0f);
@@ -568,11 +496,36 @@ void Game::CreateEntities()
 	entities.push_back(
 		std::make_shared<GameEntity>(
 			meshes[2],
-			materials["Pavement"]
+			materials["Pavement"],
+			transformSystem
 		)
 	);
 	entities[5]->GetTransform()->SetPosition(0.0f, -5.0f, 0.0f);
 	entities[5]->GetTransform()->SetScale(20.0f, 0.2f, 20.0f);
+
+	if (skinnedMesh)
+	{
+		entities.push_back(
+			std::make_shared<GameEntity>(
+				skinnedMesh,
+				materials["Steel"],
+				transformSystem
+			)
+		);
+		entities[6]->GetTransform()->SetPosition(15.0f, 0.0f, 0.0f);
+	}
+
+	// A small sphere attached to the spinning cube, which carries it around
+	// with no extra work here or in UpdateEntities (see TransformSystem.h)
+	std::shared_ptr<GameEntity> attached = std::make_shared<GameEntity>(
+		meshes[0],
+		materials["Marble"],
+		transformSystem
+	);
+	attached->GetTransform()->SetParent(entities[4]->GetTransform());
+	attached->GetTransform()->SetPosition(0.0f, 2.5f, 0.0f);
+	attached->GetTransform()->SetScale(0.4f, 0.4f, 0.4f);
+	entities.push_back(attached);
 }
 
 // --------------------------------------------------------
@@ -606,6 +559,8 @@ void Game::RefreshUI(const float& deltaTime)
 // --------------------------------------------------------
 void Game::BuildUI()
 {
+	PROFILE_ZONE("BuildUI");
+
 	// Create a new window called "Inspector"
 	ImGui::Begin("Inspector");
 
@@ -650,6 +605,14 @@ void Game::BuildUI()
 		ImGui::SameLine();
 		if (ImGui::Button("Post Processing"))
 			currentTab = 9;
+
+		ImGui::SameLine();
+		if (ImGui::Button("Assets"))
+			currentTab = 10;
+
+		ImGui::SameLine();
+		if (ImGui::Button("Profiler"))
+			currentTab = 11;
 	}
 
 	// Create a small separator
@@ -706,6 +669,16 @@ void Game::BuildUI()
 	case 9:
 		ConstructPostProcessUI();
 		break;
+
+	// Assets tab
+	case 10:
+		ConstructAssetsUI();
+		break;
+
+	// Profiler tab
+	case 11:
+		ConstructProfilerUI();
+		break;
 	}
 
 	// End the "Inspector" window
@@ -717,6 +690,8 @@ void Game::BuildUI()
 // --------------------------------------------------------
 void Game::UpdateEntities(const float& deltaTime, const float& totalTime)
 {
+	PROFILE_ZONE("UpdateEntities");
+
 	moveTime += deltaTime;
 
 	// Scale the first and last entity
@@ -731,6 +706,24 @@ void Game::UpdateEntities(const float& deltaTime, const float& totalTime)
 	entities[4]->GetTransform()->SetRotation(totalTime, 0, totalTime);
 }
 
+// --------------------------------------------------------
+// Poses the skinned mesh for this frame
+// --------------------------------------------------------
+void Game::UpdateAnimation(float totalTime)
+{
+	PROFILE_ZONE("UpdateAnimation");
+
+	if (!skinnedMesh)
+		return;
+
+	// Morph targets go first, as they change the bind pose that's skinned
+	skinnedMesh->UpdateMorphs();
+
+	swayClip.Sample(*skeleton, totalTime, skeletonPose.data());
+	skeleton->ComputeSkinningPalette(skeletonPose.data(), skinningPalette.data());
+	skinnedMesh->UpdateSkin(skinningPalette, skinningThreads);
+}
+
 // --------------------------------------------------------
 // Handle resizing to match the new window size.
 //  - DXCore needs to resize the back buffer
@@ -748,11 +741,55 @@ void Game::OnResize()
 	}
 }
 
+// --------------------------------------------------------
+// Finishes loads waiting for the main thread (see AssetLoader.h)
+//
+// - Only spends a couple of milliseconds per frame, so a burst
+//   of loads finishing together can't stall a frame
+// - Tracks the worst frame while anything is still loading.
+//   The first frame is skipped, as its delta covers Init()
+// --------------------------------------------------------
+void Game::UpdateAssets(float deltaTime)
+{
+	PROFILE_ZONE("UpdateAssets");
+
+	bool streaming = assetLoader->GetStats().pending > 0;
+	if (streaming && firstFrameTime > 0.0 && deltaTime > worstStreamingFrameTime)
+		worstStreamingFrameTime = deltaTime;
+
+	assetLoader->Update(0.002);
+
+	// Free the entries of anything that's no longer used
+	assetRegistry->Collect();
+
+	// Compact the arena if freed meshes left it fragmented
+	geometryArena->Update();
+
+	// Note when the last asset finished
+	if (streaming && assetLoader->GetStats().pending == 0)
+		assetsLoadedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - initStartTime).count();
+}
+
+// --------------------------------------------------------
+// One simulation tick (see FrameCallbacks::FixedUpdate)
+//
+// - The transform system keeps the state from before the
+//   tick, so rendering can blend towards this one
+// --------------------------------------------------------
+void Game::FixedUpdate(float deltaTime, float totalTime)
+{
+	transformSystem->BeginTick();
+	UpdateEntities(deltaTime, totalTime);
+}
+
 // --------------------------------------------------------
 // Update your game here - user input, move objects, AI, etc.
 // --------------------------------------------------------
 void Game::Update(float deltaTime, float totalTime)
 {
+	// Swap in any assets that finished loading, before anything uses them
+	UpdateAssets(deltaTime);
+
 	// Initialize the UI for the next frame
 	RefreshUI(deltaTime);
 
@@ -762,8 +799,13 @@ void Game::Update(float deltaTime, float totalTime)
 	// Update the user input controller
 	userInput->Update(deltaTime);
 
-	// Update entities
-	UpdateEntities(deltaTime, totalTime);
+	// Entities moved in FixedUpdate(), but animation is only for show
+	UpdateAnimation(totalTime);
+
+	// Rebuild every moved entity's matrices at once, before anything draws,
+	// part way between the last two ticks
+	transformSystem->SetInterpolation(GetInterpolationAlpha());
+	transformSystem->Update();
 
 	// Update renderer
 	gameRenderer->Update(totalTime, entities);
@@ -783,6 +825,10 @@ void Game::Draw(float deltaTime, float totalTime)
 {
 	// Use the game renderer to draw
 	gameRenderer->Draw(vsync, deviceSupportsTearing, isFullscreen, cameras[activeCamera]);
+
+	// Note how long the first frame took to get out
+	if (firstFrameTime == 0.0)
+		firstFrameTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - initStartTime).count();
 }
 
 void Game::ConstructGeneralUI()
@@ -792,6 +838,54 @@ void Game::ConstructGeneralUI()
 	ImGui::Text("Current DeltaTime: %f", ImGui::GetIO().DeltaTime);
 	ImGui::Text("Window Resolution: %dx%d", windowWidth, windowHeight);
 
+	// Display startup and streaming timings (see Game::UpdateAssets)
+	AssetLoaderStats assetStats = assetLoader->GetStats();
+	ImGui::Text("Time to First Frame: %.3f ms", firstFrameTime * 1000.0);
+	ImGui::Text("Assets: %u loading, %u loaded, %u failed",
+		assetStats.pending,
+		assetStats.completed,
+		assetStats.failed
+	);
+	if (assetsLoadedTime > 0.0)
+		ImGui::Text("\tAll loaded after %.3f ms", assetsLoadedTime * 1000.0);
+	ImGui::Text("Worst Frame While Streaming: %.3f ms (%.3f ms swapping in)",
+		worstStreamingFrameTime * 1000.0,
+		assetStats.worstUpdateSeconds * 1000.0
+	);
+
+	// Job system totals (see JobSystem.h)
+	JobSystemStats jobStats = jobSystem->GetStats();
+	ImGui::Text("Job Threads: %u, %llu jobs run, %llu stolen", jobStats.threads, jobStats.jobs, jobStats.steals);
+
+	// Frame rate limiter (see FrameLoop::WaitForNextFrame). Comparing against
+	// the uncapped loop is just a matter of unticking it
+	bool limitChanged = ImGui::Checkbox("Limit Frame Rate", &limitFrameRate);
+	limitChanged |= ImGui::SliderInt("Target Frame Rate", &targetFrameRate, 30, 480);
+	if (limitChanged)
+		SetTargetFrameRate(limitFrameRate ? (float)targetFrameRate : 0.0f);
+
+	FramePacingStats pacingStats = GetFramePacingStats();
+	ImGui::Text("Frame Time: %.3f ms average, %.3f ms std dev",
+		pacingStats.smoothedFrameTime * 1000.0f,
+		pacingStats.frameTimeStdDev * 1000.0f
+	);
+	ImGui::Text("CPU Busy: %.0f%% of each frame (%.3f ms asleep, %.3f ms spinning)",
+		pacingStats.busyFraction * 100.0f,
+		pacingStats.lastSleepSeconds * 1000.0,
+		pacingStats.lastSpinSeconds * 1000.0
+	);
+
+	// Fixed timestep simulation (see FrameLoop::RunSimulation)
+	bool changed = ImGui::Checkbox("Fixed Timestep", &useFixedTimestep);
+	changed |= ImGui::SliderInt("Simulation Rate (Hz)", &simulationRate, 10, 240);
+	changed |= ImGui::SliderInt("Max Ticks per Frame", &maxSimulationSteps, 1, 16);
+	if (changed)
+		SetFixedTimestep(useFixedTimestep ? 1.0f / simulationRate : 0.0f, maxSimulationSteps);
+
+	FixedStepStats stepStats = GetFixedStepStats();
+	ImGui::Text("Ticks This Frame: %u (max %u), alpha %.2f", stepStats.steps, stepStats.maxSteps, stepStats.alpha);
+	ImGui::Text("Time Dropped Catching Up: %.3f s", stepStats.droppedSeconds);
+
 	// Edit the background color
 	ImGui::ColorEdit4("Background Color", &gameRenderer->GetBGColor()[0]);
 
@@ -817,6 +911,113 @@ void Game::ConstructInputUI()
 // --------------------------------------------------------
 void Game::ConstructMeshesUI()
 {
+	// LOD selection settings (see GameRenderer::SelectLODs)
+	bool lodEnabled = gameRenderer->GetLODEnabled();
+	float lodPixelError = gameRenderer->GetLODPixelError();
+	int forcedLOD = gameRenderer->GetForcedLOD();
+
+	if (ImGui::Checkbox("Use LODs", &lodEnabled))
+		gameRenderer->SetLODEnabled(lodEnabled);
+
+	if (ImGui::SliderFloat("LOD Pixel Error", &lodPixelError, 0.1f, 16.0f))
+		gameRenderer->SetLODPixelError(lodPixelError);
+
+	if (ImGui::SliderInt("Force LOD (-1 = auto)", &forcedLOD, -1, MeshSimplifier::MaxLODs - 1))
+		gameRenderer->SetForcedLOD(forcedLOD);
+
+	ImGui::Text("Triangles drawn: %u", gameRenderer->GetDrawnTriangles());
+
+	// Meshlet culling settings and how much it rejected this frame (see MeshletBuilder.h)
+	bool meshletCullingEnabled = gameRenderer->GetMeshletCullingEnabled();
+	if (ImGui::Checkbox("Cull Meshlets (LOD 0 only)", &meshletCullingEnabled))
+		gameRenderer->SetMeshletCullingEnabled(meshletCullingEnabled);
+
+	ImGui::Text("Triangles culled: %u by frustum, %u by normal cone",
+		gameRenderer->GetFrustumCulledTriangles(),
+		gameRenderer->GetConeCulledTriangles()
+	);
+
+	// Resident geometry memory for the whole scene (see MeshCPUData)
+	size_t sceneCPUBytes = 0;
+	size_t sceneGPUBytes = 0;
+	for (int i = 0; i < meshes.size(); i++)
+	{
+		sceneCPUBytes += meshes[i].Get()->GetCPUMemoryBytes();
+		sceneGPUBytes += meshes[i].Get()->GetVertexBufferBytes() + meshes[i].Get()->GetIndexBufferBytes();
+	}
+	ImGui::Text("Mesh memory: %.1f KB CPU, %.1f KB GPU",
+		sceneCPUBytes / 1024.0,
+		sceneGPUBytes / 1024.0
+	);
+
+	// Shared buffer use, and how many draws had to rebind (see GeometryArena.h)
+	GeometryArenaStats arenaStats = geometryArena->GetStats();
+	ImGui::Text("Geometry arena: %u meshes in %u buffers, %.1f / %.1f KB used",
+		arenaStats.meshes,
+		arenaStats.buffers,
+		arenaStats.usedBytes / 1024.0,
+		arenaStats.capacityBytes / 1024.0
+	);
+	ImGui::Text("Arena binds: %u for %u draws (%u free blocks, %u compactions, %u growths)",
+		arenaStats.binds,
+		arenaStats.draws,
+		arenaStats.freeBlocks,
+		arenaStats.compactions,
+		arenaStats.growths
+	);
+
+	// Skinning path for the animated mesh, and what the CPU path costs (see Skinning.h)
+	if (skinnedMesh)
+	{
+		bool gpuSkinning = skinnedMesh->GetSkinningMode() == SkinningMode::GPU;
+		if (ImGui::Checkbox("GPU Skinning", &gpuSkinning))
+			skinnedMesh->SetSkinningMode(gpuSkinning ? SkinningMode::GPU : SkinningMode::CPU);
+
+		ImGui::SliderInt("CPU Skinning Threads (0 = all)", &skinningThreads, 0, 16);
+
+		SkinningStats skinningStats = skinnedMesh->GetSkinningStats();
+		if (gpuSkinning)
+		{
+			ImGui::Text("Skinning: %u joints on the GPU", skeleton->GetJointCount());
+		}
+		else
+		{
+			ImGui::Text("Skinning: %u vertices in %.3f ms on %u threads (%.0f vertices/ms)",
+				skinningStats.vertices,
+				skinningStats.seconds * 1000.0,
+				skinningStats.threads,
+				skinningStats.verticesPerMillisecond
+			);
+		}
+
+		// Morph target weights, and what each target and the blend cost (see MorphTargets.h)
+		const MorphTargetSet& morphTargets = skinnedMesh->GetMorphTargets();
+		for (unsigned int t = 0; t < skinnedMesh->GetMorphTargetCount(); t++)
+		{
+			const MorphTarget& target = morphTargets.GetTarget(t);
+			MorphTargetStats targetStats = morphTargets.GetTargetStats(t);
+
+			float weight = skinnedMesh->GetMorphWeight(t);
+			if (ImGui::SliderFloat(target.name.c_str(), &weight, 0.0f, 1.0f))
+				skinnedMesh->SetMorphWeight(t, weight);
+
+			ImGui::Text("  %u vertices in %.1f KB (%.1f KB dense), error at most %.5f",
+				targetStats.affectedVertices,
+				targetStats.bytes / 1024.0,
+				targetStats.denseBytes / 1024.0,
+				targetStats.maxPositionError
+			);
+		}
+
+		MorphBlendStats blendStats = skinnedMesh->GetMorphBlendStats();
+		ImGui::Text("Morph Blend: %u targets, %u deltas, %u vertices written in %.3f ms",
+			blendStats.activeTargets,
+			blendStats.deltasApplied,
+			blendStats.writtenVertices,
+			blendStats.seconds * 1000.0
+		);
+	}
+
 	for (int i = 0; i < meshes.size(); i++)
 	{
 		// Push the current ID
@@ -824,6 +1025,9 @@ void Game::ConstructMeshesUI()
 
 		// Create the header
 		std::string header = "Mesh " + std::to_string(i);
+		if (!meshes[i].IsReady())
+			header += meshes[i].GetState() == AssetState::Failed ? " (failed)" : " (loading)";
+		header += "###Mesh";	// Keep the same ID so it stays open when the label changes
 		const char* cHeader = header.c_str();
 
 		// List meshes under header
@@ -831,35 +1035,201 @@ void Game::ConstructMeshesUI()
 		{
 			// Calculate triangles
 			int triangleNum = 1;
-			if (meshes[i]->GetIndexCount() % 3 == 0)
+			if (meshes[i].Get()->GetIndexCount() % 3 == 0)
 			{
-				triangleNum = meshes[i]->GetIndexCount() / 3;
+				triangleNum = meshes[i].Get()->GetIndexCount() / 3;
 			}
 
 			// Display mesh number and number of triangles
-			ImGui::Text("%d vertices, %d triangles", i, meshes[i]->GetVertexCount(), triangleNum);
+			ImGui::Text("%d vertices, %d triangles", i, meshes[i].Get()->GetVertexCount(), triangleNum);
+
+			// Display where the mesh came from, how long it took and the
+			// process's peak memory use afterwards (to compare import paths)
+			ObjStreamStats streamStats = meshes[i].Get()->GetStreamStats();
+			ImGui::Text("%s in %.3f ms, peak working set %.1f MB",
+				meshes[i].Get()->WasLoadedFromCookedFile() ? "Loaded from cooked .dxmesh" :
+				streamStats.seconds > 0.0 ? "Streamed from OBJ" : "Imported from OBJ",
+				meshes[i].Get()->GetLoadSeconds() * 1000.0,
+				meshes[i].Get()->GetLoadPeakResidentBytes() / (1024.0 * 1024.0)
+			);
+
+			// Display what the streaming importer did, and how much memory it needed (see ObjStreamImporter.h)
+			if (streamStats.seconds > 0.0)
+			{
+				ImGui::Text("Streamed %.1f MB in %.3f ms (%.1f MB/s, %.0f triangles/s), %u windows, %u batches",
+					streamStats.bytes / (1024.0 * 1024.0),
+					streamStats.seconds * 1000.0,
+					streamStats.bytes / streamStats.seconds / (1024.0 * 1024.0),
+					streamStats.triangles / streamStats.seconds,
+					streamStats.windows,
+					streamStats.batches
+				);
+				ImGui::Text("\tBuffers: %.1f MB peak of %.1f MB budget, %.1f MB spilled to disk, %.1f%% attribute cache hits",
+					streamStats.peakBufferBytes / (1024.0 * 1024.0),
+					streamStats.budgetBytes / (1024.0 * 1024.0),
+					streamStats.spillBytes / (1024.0 * 1024.0),
+					streamStats.cacheHits + streamStats.cacheMisses > 0 ? 100.0 * streamStats.cacheHits / (streamStats.cacheHits + streamStats.cacheMisses) : 0.0
+				);
+			}
+
+			// Display the GPU buffer sizes, compared to 44 byte vertices and 32-bit indices
+			unsigned int vertexBytes = meshes[i].Get()->GetVertexBufferBytes();
+			unsigned int indexBytes = meshes[i].Get()->GetIndexBufferBytes();
+			unsigned int baselineBytes = (unsigned int)(meshes[i].Get()->GetVertexCount() * sizeof(Vertex) + meshes[i].Get()->GetIndexCount() * sizeof(unsigned int));
+			ImGui::Text("%s vertices: %.1f KB (%u bytes each), %u-bit indices: %.1f KB",
+				VertexCompression::GetFormatName(meshes[i].Get()->GetVertexFormat()),
+				vertexBytes / 1024.0,
+				meshes[i].Get()->GetVertexCount() > 0 ? vertexBytes / meshes[i].Get()->GetVertexCount() : 0,
+				meshes[i].Get()->GetIndexCount() > 0 ? indexBytes * 8 / meshes[i].Get()->GetIndexCount() : 0,
+				indexBytes / 1024.0
+			);
+			ImGui::Text("	GPU memory: %.1f KB -> %.1f KB (%.2fx smaller)",
+				baselineBytes / 1024.0,
+				(vertexBytes + indexBytes) / 1024.0,
+				vertexBytes + indexBytes > 0 ? (float)baselineBytes / (vertexBytes + indexBytes) : 0.0f
+			);
+
+			// Display the CPU-side copy, which can be dropped once it's on the GPU
+			ImGui::Text("	CPU memory: %.1f KB (%s)",
+				meshes[i].Get()->GetCPUMemoryBytes() / 1024.0,
+				meshes[i].Get()->HasCPUData() ? "geometry kept" : "geometry released"
+			);
+			if (meshes[i].Get()->HasCPUData())
+			{
+				ImGui::SameLine();
+				if (ImGui::Button("Release"))
+					meshes[i].Get()->ReleaseCPUData();
+			}
+
+			// Display the round-trip error of the compact formats (see VertexCompression.h)
+			if (meshes[i].Get()->GetVertexFormat() != VertexFormat::Standard)
+			{
+				VertexCompressionStats compressionStats = meshes[i].Get()->GetCompressionStats();
+				ImGui::Text("	Max error: position %.6f, normal %.3f deg, tangent %.3f deg, UV %.6f",
+					compressionStats.maxPositionError,
+					compressionStats.maxNormalErrorDegrees,
+					compressionStats.maxTangentErrorDegrees,
+					compressionStats.maxUVError
+				);
+				ImGui::Text("	Mismatched bitangent signs: %u", compressionStats.mismatchedTangentSigns);
+			}
+
+			// Display how quickly the OBJ file was parsed
+			ObjParseStats loadStats = meshes[i].Get()->GetLoadStats();
+			if (loadStats.seconds > 0.0)
+			{
+				ImGui::Text("Parsed %.1f KB in %.3f ms on %u thread(s) (%.1f MB/s, %.0f triangles/s)",
+					loadStats.bytes / 1024.0,
+					loadStats.seconds * 1000.0,
+					loadStats.threads,
+					loadStats.bytes / loadStats.seconds / (1024.0 * 1024.0),
+					loadStats.triangles / loadStats.seconds
+				);
+
+				// Display how many corners were merged into shared vertices
+				unsigned int corners = loadStats.triangles * 3;
+				ImGui::Text("%u unique vertices from %u corners (%.2fx dedup ratio)",
+					loadStats.uniqueVertices,
+					corners,
+					loadStats.uniqueVertices > 0 ? (float)corners / loadStats.uniqueVertices : 0.0f
+				);
+
+				// Display what the optimizer gained (see MeshOptimizer.h)
+				MeshOptimizerStats optimizerStats = meshes[i].Get()->GetOptimizerStats();
+				ImGui::Text("Optimized in %.3f ms", optimizerStats.seconds * 1000.0);
+				ImGui::Text("\tACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f (cache size %u)",
+					optimizerStats.cacheBefore.acmr, optimizerStats.cacheAfter.acmr,
+					optimizerStats.cacheBefore.atvr, optimizerStats.cacheAfter.atvr,
+					optimizerStats.cacheAfter.cacheSize
+				);
+				ImGui::Text("\tOverdraw: %.3f -> %.3f",
+					optimizerStats.overdrawBefore.overdraw, optimizerStats.overdrawAfter.overdraw
+				);
+				ImGui::Text("\tVertex Fetch: %.3f -> %.3f overfetch",
+					optimizerStats.fetchBefore.overfetch, optimizerStats.fetchAfter.overfetch
+				);
+
+				// Display how long the LOD chain took to build (see MeshSimplifier.h)
+				MeshSimplifierStats simplifierStats = meshes[i].Get()->GetSimplifierStats();
+				ImGui::Text("LODs built in %.3f ms (%u collapses over %u passes, %u locked vertices)",
+					simplifierStats.seconds * 1000.0,
+					simplifierStats.collapses,
+					simplifierStats.passes,
+					simplifierStats.lockedVertices
+				);
+			}
+
+			// Display the LOD chain
+			for (unsigned int lod = 0; lod < meshes[i].Get()->GetLODCount(); lod++)
+			{
+				MeshLOD meshLOD = meshes[i].Get()->GetLOD(lod);
+				ImGui::Text("\tLOD %u: %u triangles, error %.5f",
+					lod,
+					meshLOD.indexCount / 3,
+					meshLOD.error
+				);
+			}
 
-			// Display vertices
-			for (int v = 0; v < meshes[i]->GetVertices().size(); v++)
+			// Display the meshlets, and how they were built if it happened this launch
+			const std::vector<Meshlet>& meshlets = meshes[i].Get()->GetMeshlets();
+			MeshletStats meshletStats = meshes[i].Get()->GetMeshletStats();
+			ImGui::Text("%u meshlets (up to %u vertices, %u triangles each)",
+				(unsigned int)meshlets.size(),
+				MeshletBuilder::MaxVertices,
+				MeshletBuilder::MaxTriangles
+			);
+			if (meshletStats.meshletCount > 0)
+			{
+				ImGui::Text("\tBuilt in %.3f ms, %.1f vertices and %.1f triangles on average, %.0f%% cone cullable, ACMR %.3f",
+					meshletStats.seconds * 1000.0,
+					meshletStats.averageVertices,
+					meshletStats.averageTriangles,
+					meshletStats.cullableFraction * 100.0f,
+					meshletStats.acmr
+				);
+			}
+
+			// Display how long tangent generation took, and in debug builds how
+			// closely it matched the scalar reference (see TangentGenerator.h)
+			TangentStats tangentStats = meshes[i].Get()->GetTangentStats();
+			if (tangentStats.seconds > 0.0)
+			{
+				ImGui::Text("Tangents generated in %.3f ms on %u thread(s)",
+					tangentStats.seconds * 1000.0,
+					tangentStats.threads
+				);
+				if (tangentStats.referenceSeconds > 0.0)
+				{
+					ImGui::Text("\tScalar reference: %.3f ms, max difference %g",
+						tangentStats.referenceSeconds * 1000.0,
+						tangentStats.maxReferenceError
+					);
+				}
+			}
+
+			// Display vertices (views of the mesh's data, so nothing is copied)
+			std::span<const Vertex> vertices = meshes[i].Get()->GetVertices();
+			for (int v = 0; v < vertices.size(); v++)
 			{
 				ImGui::Text("\tVertex %d: (%.3f, %.3f, %.3f)",
 					v,
-					meshes[i]->GetVertices()[v].Position.x,
-					meshes[i]->GetVertices()[v].Position.y,
-					meshes[i]->GetVertices()[v].Position.z
+					vertices[v].Position.x,
+					vertices[v].Position.y,
+					vertices[v].Position.z
 				);
 			}
 
 			// Display indices
-			ImGui::Text("Indices (%d): {", meshes[i]->GetIndexCount());
-			for (unsigned int ind = 0; ind < meshes[i]->GetIndexCount(); ind++)
+			std::span<const unsigned int> indices = meshes[i].Get()->GetIndices();
+			ImGui::Text("Indices (%d): {", (int)indices.size());
+			for (unsigned int ind = 0; ind < indices.size(); ind++)
 			{
 				// Put it on the same line and display the index
 				ImGui::SameLine();
-				if (ind != meshes[i]->GetIndexCount() - 1)
-					ImGui::Text("%d,", meshes[i]->GetIndices()[ind]);
+				if (ind != indices.size() - 1)
+					ImGui::Text("%d,", indices[ind]);
 				else
-					ImGui::Text("%d", meshes[i]->GetIndices()[ind]);
+					ImGui::Text("%d", indices[ind]);
 			}
 			ImGui::SameLine();
 			ImGui::Text("}");
@@ -916,7 +1286,8 @@ void Game::ConstructShadersUI()
 
 		// Set data
 		ps->SetFloat3("colorTint", colorTint);
-		vs->SetMatrix4x4("world", worldMatrix);
+		AffineMatrix world = AffineMatrix::FromMatrix(worldMatrix);
+		vs->SetData("world", &world, sizeof(AffineMatrix));
 
 		// Update constant buffers
 		ps->CopyAllBufferData();
@@ -932,6 +1303,16 @@ void Game::ConstructShadersUI()
 // --------------------------------------------------------
 void Game::ConstructEntitiesUI()
 {
+	// What last frame's batched matrix rebuild cost (see TransformSystem.h)
+	TransformSystemStats transformStats = transformSystem->GetStats();
+	ImGui::Text("Transforms: %u of %u rebuilt (%u under a parent) in %.3f ms on %u threads",
+		transformStats.rebuilt,
+		transformStats.transforms,
+		transformStats.composed,
+		transformStats.seconds * 1000.0,
+		transformStats.threads
+	);
+
 	// Loop through the entities
 	for (int i = 0; i < entities.size(); ++i)
 	{
@@ -1178,4 +1559,163 @@ void Game::ConstructPostProcessUI()
 
 	if (ImGui::SliderInt("Pixel Size", &pixelSize, 1, 10))
 		gameRenderer->SetPixelSize(pixelSize);
-}
\ No newline at end of file
+}
+
+// --------------------------------------------------------
+// Construct the Assets ImGUI Tab
+// --------------------------------------------------------
+void Game::ConstructAssetsUI()
+{
+	// Display how often requests were served by assets already loaded
+	AssetRegistryStats registryStats = assetRegistry->GetStats();
+	ImGui::Text("%u requests, %u served by path and %u by matching content, %u evicted",
+		registryStats.requests,
+		registryStats.pathHits,
+		registryStats.contentHits,
+		registryStats.evictions
+	);
+
+	// Display each asset and the memory it holds
+	std::vector<AssetInfo> assets = assetRegistry->GetAssets();
+	size_t totalCPUBytes = 0;
+	size_t totalGPUBytes = 0;
+	for (int i = 0; i < assets.size(); i++)
+	{
+		totalCPUBytes += assets[i].cpuBytes;
+		totalGPUBytes += assets[i].gpuBytes;
+	}
+	ImGui::Text("%d assets: %.1f KB CPU, %.1f KB GPU",
+		(int)assets.size(),
+		totalCPUBytes / 1024.0,
+		totalGPUBytes / 1024.0
+	);
+
+	for (int i = 0; i < assets.size(); i++)
+	{
+		const char* state =
+			assets[i].state == AssetState::Ready ? "ready" :
+			assets[i].state == AssetState::Loading ? "loading" : "failed";
+
+		// Trim the path down to the file name
+		std::string name = assets[i].path;
+		size_t lastSlash = name.find_last_of('/');
+		if (lastSlash != std::string::npos)
+			name.erase(0, lastSlash + 1);
+
+		ImGui::Text("%s %s (%s): %ld refs, %u requests",
+			assets[i].type == AssetType::Mesh ? "Mesh" : "Texture",
+			name.c_str(),
+			state,
+			assets[i].references,
+			assets[i].requests
+		);
+
+		if (!assets[i].sharedWith.empty())
+			ImGui::Text("\tShares data with %s", assets[i].sharedWith.c_str());
+		else
+			ImGui::Text("\t%.1f KB CPU, %.1f KB GPU", assets[i].cpuBytes / 1024.0, assets[i].gpuBytes / 1024.0);
+	}
+}
+
+// --------------------------------------------------------
+// Construct the Profiler ImGUI Tab (see Profiler.h)
+//
+// - The flame graph is the last full frame, one band per
+//   thread, with nested zones stacked below their parents
+// - Freezing keeps the captured frame, to hover around it
+// --------------------------------------------------------
+void Game::ConstructProfilerUI()
+{
+	Profiler& profiler = Profiler::GetInstance();
+
+	bool profilerEnabled = profiler.IsEnabled();
+	if (ImGui::Checkbox("Record Zones", &profilerEnabled))
+		profiler.SetEnabled(profilerEnabled);
+
+	ImGui::SameLine();
+	ImGui::Checkbox("Freeze", &freezeProfilerFrame);
+
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome Trace"))
+		profilerExportResult = profiler.ExportChromeTrace("profile.json") ? "Wrote profile.json" : "Couldn't write profile.json";
+	if (!profilerExportResult.empty())
+	{
+		ImGui::SameLine();
+		ImGui::Text("%s", profilerExportResult.c_str());
+	}
+
+	ProfilerStats profilerStats = profiler.GetStats();
+	ImGui::Text("Threads: %u, %llu zones recorded, %llu overwritten",
+		profilerStats.threads,
+		profilerStats.zones,
+		profilerStats.overwritten
+	);
+
+	if (!freezeProfilerFrame && !profiler.GetLastFrame(profilerZones, profilerFrameStart, profilerFrameSeconds))
+		profilerFrameSeconds = 0.0;
+	if (profilerFrameSeconds <= 0.0)
+	{
+		ImGui::Text("Record zones to see a frame");
+		return;
+	}
+	ImGui::Text("Frame: %.3f ms", profilerFrameSeconds * 1000.0);
+
+	// Lay out one band per thread, as deep as its deepest zone
+	std::vector<unsigned int> threadDepths(profilerStats.threads, 0);
+	for (const ProfilerZone& zone : profilerZones)
+	{
+		if (zone.thread < threadDepths.size() && zone.depth + 1 > threadDepths[zone.thread])
+			threadDepths[zone.thread] = zone.depth + 1;
+	}
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	float width = ImGui::GetContentRegionAvail().x;
+	float scale = (float)(width / profilerFrameSeconds);
+
+	std::vector<float> threadTops(threadDepths.size(), 0.0f);
+	float height = 0.0f;
+	for (unsigned int t = 0; t < threadDepths.size(); t++)
+	{
+		if (threadDepths[t] == 0)
+			continue;
+
+		threadTops[t] = height + rowHeight;
+		height += rowHeight * (threadDepths[t] + 1);
+	}
+
+	ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::InvisibleButton("FlameGraph", ImVec2(width, height > 0.0f ? height : 1.0f));
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	drawList->PushClipRect(origin, ImVec2(origin.x + width, origin.y + height), true);
+
+	for (unsigned int t = 0; t < threadDepths.size(); t++)
+	{
+		if (threadDepths[t] > 0)
+			drawList->AddText(ImVec2(origin.x, origin.y + threadTops[t] - rowHeight), IM_COL32(255, 255, 255, 255), profiler.GetThreadName(t).c_str());
+	}
+
+	for (const ProfilerZone& zone : profilerZones)
+	{
+		if (zone.thread >= threadTops.size())
+			continue;
+
+		ImVec2 zoneMin(origin.x + (float)(zone.start - profilerFrameStart) * scale, origin.y + threadTops[zone.thread] + zone.depth * rowHeight);
+		ImVec2 zoneMax(zoneMin.x + (float)zone.duration * scale, zoneMin.y + rowHeight - 1.0f);
+		if (zoneMax.x - zoneMin.x < 1.0f)
+			zoneMax.x = zoneMin.x + 1.0f;
+
+		// Color by name, so the same zone keeps its color from frame to frame
+		unsigned int hash = 2166136261u;
+		for (const char* c = zone.name; *c; c++)
+			hash = (hash ^ (unsigned char)*c) * 16777619u;
+		drawList->AddRectFilled(zoneMin, zoneMax, ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.75f));
+
+		if (ImGui::CalcTextSize(zone.name).x < zoneMax.x - zoneMin.x - 4.0f)
+			drawList->AddText(ImVec2(zoneMin.x + 2.0f, zoneMin.y), IM_COL32(0, 0, 0, 255), zone.name);
+
+		if (ImGui::IsMouseHoveringRect(zoneMin, zoneMax))
+			ImGui::SetTooltip("%s: %.3f ms", zone.name, zone.duration * 1000.0);
+	}
+
+	drawList->PopClipRect();
+}
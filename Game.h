@@ -2,17 +2,23 @@
 #include <DirectXMath.h>
 #include <wrl/client.h> // Used for ComPtr - a smart pointer for COM objects
 #include <memory> // Include Memory for shared_ptr
+#include <chrono>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
 // Renderer classes
 #include "DXCore.h"
+#include "AssetLoader.h"
+#include "AssetRegistry.h"
 #include "Mesh.h"
 #include "GameRenderer.h"
 #include "Camera.h"
 #include "UserInput.h"
 #include "SimpleShader.h"
 #include "Material.h"
+#include "TransformSystem.h"
+#include "Profiler.h"
 
 
 class Game 
@@ -27,6 +33,7 @@ public:
 	// will be called automatically
 	void Init();
 	void OnResize();
+	void FixedUpdate(float deltaTime, float totalTime);
 	void Update(float deltaTime, float totalTime);
 	void Draw(float deltaTime, float totalTime);
 
@@ -35,11 +42,17 @@ private:
 	// Initialization helper methods - feel free to customize, combine, remove, etc.
 	void CreateAssets();
 	void CreateGeometry();
+	void CreateSkinnedMesh();
 	void CreateMaterials(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler);
 	void CreateEntities();
 	void RefreshUI(const float& deltaTime);
 	void BuildUI();
 	void UpdateEntities(const float& deltaTime, const float& totalTime);
+	void UpdateAnimation(float totalTime);
+
+	// Asset streaming (see AssetLoader.h and AssetRegistry.h)
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> CreateSolidColorTexture(unsigned char r, unsigned char g, unsigned char b);
+	void UpdateAssets(float deltaTime);
 
 	// UI Methods
 	void ConstructGeneralUI();
@@ -52,6 +65,8 @@ private:
 	void ConstructMaterialsUI();
 	void ConstructShadowUI();
 	void ConstructPostProcessUI();
+	void ConstructAssetsUI();
+	void ConstructProfilerUI();
 
 	// Camera
 	std::vector<std::shared_ptr<Camera>> cameras;
@@ -64,16 +79,57 @@ private:
 	int currentTab = 0;
 	bool showDemoWindow = true;
 
+	// Profiler flame graph (see Profiler.h)
+	bool freezeProfilerFrame = false;
+	std::vector<ProfilerZone> profilerZones;
+	double profilerFrameStart = 0.0;
+	double profilerFrameSeconds = 0.0;
+	std::string profilerExportResult;
+
 	// Materials
 	std::unordered_map<std::string, std::shared_ptr<Material>> materials;
 
+	// Jobs (see JobSystem.h)
+	std::shared_ptr<JobSystem> jobSystem;
+
+	// Assets
+	std::shared_ptr<AssetLoader> assetLoader;
+	std::shared_ptr<AssetRegistry> assetRegistry;
+	std::shared_ptr<GeometryArena> geometryArena;
+	std::chrono::steady_clock::time_point initStartTime;
+	double firstFrameTime;
+	double assetsLoadedTime;
+	double worstStreamingFrameTime;
+
 	// Meshes
-	std::vector<std::shared_ptr<Mesh>> meshes;
+	std::vector<MeshHandle> meshes;
+
+	// Skeletal animation (see Skeleton.h and Skinning.h)
+	// - skinnedMesh has its own copy of the helix, as its buffer is rewritten every frame
+	// - It also has a couple of morph targets (see MorphTargets.h)
+	std::shared_ptr<Mesh> skinnedMesh;
+	std::shared_ptr<Skeleton> skeleton;
+	AnimationClip swayClip;
+	std::vector<JointPose> skeletonPose;
+	std::vector<SkinMatrix> skinningPalette;
+	int skinningThreads = 0;
 
 	// Entities
+	// - Their transforms live in transformSystem (see TransformSystem.h)
 	std::vector<std::shared_ptr<GameEntity>> entities;
+	std::shared_ptr<TransformSystem> transformSystem;
 	float moveTime;
 
+	// Frame rate limiter (see DXCore::SetTargetFrameRate)
+	bool limitFrameRate = false;
+	int targetFrameRate = 144;
+
+	// Fixed timestep simulation (see DXCore::SetFixedTimestep)
+	// - Entities move in ticks, and are drawn between the last two
+	bool useFixedTimestep = false;
+	int simulationRate = 60;
+	int maxSimulationSteps = 5;
+
 	// User input
 	std::shared_ptr<UserInput> userInput;
 };
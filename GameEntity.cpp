@@ -5,7 +5,7 @@ using namespace DirectX;
 
 std::shared_ptr<Mesh> GameEntity::GetMesh()
 {
-	return this->mesh;
+	return this->mesh.Get();
 }
 
 std::shared_ptr<Material> GameEntity::GetMaterial()
@@ -18,8 +18,8 @@ Transform* GameEntity::GetTransform()
 	return &this->transform;
 }
 
-GameEntity::GameEntity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material)
-	: mesh(mesh), material(material)
+GameEntity::GameEntity(MeshHandle mesh, std::shared_ptr<Material> material, std::shared_ptr<TransformSystem> transformSystem)
+	: transform(transformSystem), mesh(mesh), material(material)
 {
 }
 
@@ -28,8 +28,14 @@ void GameEntity::SetMaterial(std::shared_ptr<Material> material)
 	this->material = material;
 }
 
-void GameEntity::Draw()
+void GameEntity::Draw(unsigned int lod)
 {
 	// Draw the mesh
-	mesh->Draw();
+	mesh.Get()->Draw(lod);
+}
+
+void GameEntity::DrawMeshlets(const std::vector<bool>& visible)
+{
+	// Draw the visible parts of the mesh
+	mesh.Get()->DrawMeshlets(visible);
 }
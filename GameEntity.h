@@ -10,13 +10,16 @@ class GameEntity
 private:
 	// Variables
 	Transform transform;
-	std::shared_ptr<Mesh> mesh;
+	MeshHandle mesh;
 	std::shared_ptr<Material> material;
 
 public:
-	GameEntity(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material);
+	// Passing a TransformSystem stores the transform there, so its
+	// matrices are rebuilt with everyone else's (see TransformSystem.h)
+	GameEntity(MeshHandle mesh, std::shared_ptr<Material> material, std::shared_ptr<TransformSystem> transformSystem = nullptr);
 
 	// Getters
+	// GetMesh() returns the placeholder while the mesh is still loading
 	std::shared_ptr<Mesh> GetMesh();
 	std::shared_ptr<Material> GetMaterial();
 	Transform* GetTransform();
@@ -24,6 +27,7 @@ public:
 	// Setters
 	void SetMaterial(std::shared_ptr<Material> material);
 
-	void Draw();
+	void Draw(unsigned int lod = 0);
+	void DrawMeshlets(const std::vector<bool>& visible);
 };
 
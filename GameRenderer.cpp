@@ -1,7 +1,9 @@
 #include "GameRenderer.h"
 #include <algorithm>
+#include <cstddef>
 
 #include "PathHelpers.h"
+#include "Profiler.h"
 
 // Include ImGUI
 #include "ImGui/imgui.h"
@@ -79,6 +81,41 @@ Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GameRenderer::GetShadowSRV()
 	return this->shadowSRV;
 }
 
+bool GameRenderer::GetLODEnabled() const
+{
+	return this->lodEnabled;
+}
+
+float GameRenderer::GetLODPixelError() const
+{
+	return this->lodPixelError;
+}
+
+int GameRenderer::GetForcedLOD() const
+{
+	return this->forcedLOD;
+}
+
+unsigned int GameRenderer::GetDrawnTriangles() const
+{
+	return this->drawnTriangles;
+}
+
+bool GameRenderer::GetMeshletCullingEnabled() const
+{
+	return this->meshletCullingEnabled;
+}
+
+unsigned int GameRenderer::GetFrustumCulledTriangles() const
+{
+	return this->frustumCulledTriangles;
+}
+
+unsigned int GameRenderer::GetConeCulledTriangles() const
+{
+	return this->coneCulledTriangles;
+}
+
 void GameRenderer::SetBlurRadius(int blurRadius)
 {
 	this->blurRadius = blurRadius;
@@ -89,6 +126,36 @@ void GameRenderer::SetPixelSize(int pixelSize)
 	this->pixelSize = pixelSize;
 }
 
+void GameRenderer::SetLODEnabled(bool lodEnabled)
+{
+	this->lodEnabled = lodEnabled;
+}
+
+void GameRenderer::SetLODPixelError(float lodPixelError)
+{
+	this->lodPixelError = lodPixelError;
+}
+
+void GameRenderer::SetForcedLOD(int forcedLOD)
+{
+	this->forcedLOD = forcedLOD;
+}
+
+void GameRenderer::SetMeshletCullingEnabled(bool meshletCullingEnabled)
+{
+	this->meshletCullingEnabled = meshletCullingEnabled;
+}
+
+void GameRenderer::SetGeometryArena(std::shared_ptr<GeometryArena> geometryArena)
+{
+	this->geometryArena = geometryArena;
+}
+
+void GameRenderer::SetJobSystem(std::shared_ptr<JobSystem> jobSystem)
+{
+	this->jobSystem = jobSystem;
+}
+
 // --------------------------------------------------------
 // Handle Renderer intialization
 // --------------------------------------------------------
@@ -158,6 +225,84 @@ void GameRenderer::LoadShaders()
 		context,
 		FixPath(L"PixelatePixelShader.cso").c_str()
 	);
+
+	LoadCompactShaders();
+	LoadSkinnedShaders();
+}
+
+// --------------------------------------------------------
+// Loads the vertex shaders for the compact vertex formats
+// 
+// - Their inputs are packed integers that reflection can't
+//   describe, so the input layouts are built by hand here
+// - Both formats only differ in how the position is stored
+// --------------------------------------------------------
+void GameRenderer::LoadCompactShaders()
+{
+	// Input layouts are checked against the shader's byte code
+	Microsoft::WRL::ComPtr<ID3DBlob> compactBlob;
+	D3DReadFileToBlob(FixPath(L"CompactVertexShader.cso").c_str(), compactBlob.GetAddressOf());
+
+	D3D11_INPUT_ELEMENT_DESC compactElements[4] = {};
+	compactElements[0] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(CompactVertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	compactElements[1] = { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(CompactVertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	compactElements[2] = { "TANGENT", 0, DXGI_FORMAT_R16G16_SINT, 0, offsetof(CompactVertex, Tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	compactElements[3] = { "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, offsetof(CompactVertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	device->CreateInputLayout(
+		compactElements, 4,
+		compactBlob->GetBufferPointer(), compactBlob->GetBufferSize(),
+		compactInputLayout.GetAddressOf());
+
+	D3D11_INPUT_ELEMENT_DESC quantizedElements[4] = {};
+	quantizedElements[0] = { "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, offsetof(QuantizedVertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	quantizedElements[1] = { "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, offsetof(QuantizedVertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	quantizedElements[2] = { "TANGENT", 0, DXGI_FORMAT_R16G16_SINT, 0, offsetof(QuantizedVertex, Tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	quantizedElements[3] = { "TEXCOORD", 0, DXGI_FORMAT_R16G16_UNORM, 0, offsetof(QuantizedVertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	device->CreateInputLayout(
+		quantizedElements, 4,
+		compactBlob->GetBufferPointer(), compactBlob->GetBufferSize(),
+		quantizedInputLayout.GetAddressOf());
+
+	// The shadow shaders take the same input, so they share the layouts
+	compactVertexShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"CompactVertexShader.cso").c_str(), compactInputLayout, false);
+	quantizedVertexShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"CompactVertexShader.cso").c_str(), quantizedInputLayout, false);
+	compactShadowShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"CompactShadowVertexShader.cso").c_str(), compactInputLayout, false);
+	quantizedShadowShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"CompactShadowVertexShader.cso").c_str(), quantizedInputLayout, false);
+}
+
+// --------------------------------------------------------
+// Loads the vertex shaders for GPU skinned meshes
+//
+// - The vertex itself is the standard one in slot 0, and
+//   its joints and weights are in slot 1, which reflection
+//   can't describe either
+// --------------------------------------------------------
+void GameRenderer::LoadSkinnedShaders()
+{
+	Microsoft::WRL::ComPtr<ID3DBlob> skinnedBlob;
+	D3DReadFileToBlob(FixPath(L"SkinnedVertexShader.cso").c_str(), skinnedBlob.GetAddressOf());
+
+	D3D11_INPUT_ELEMENT_DESC skinnedElements[6] = {};
+	skinnedElements[0] = { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Position), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	skinnedElements[1] = { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Normal), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	skinnedElements[2] = { "TANGENT", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, offsetof(Vertex, Tangent), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	skinnedElements[3] = { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(Vertex, UV), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	skinnedElements[4] = { "BLENDINDICES", 0, DXGI_FORMAT_R8G8B8A8_UINT, 1, offsetof(SkinWeights, joints), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	skinnedElements[5] = { "BLENDWEIGHT", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, offsetof(SkinWeights, weights), D3D11_INPUT_PER_VERTEX_DATA, 0 };
+	device->CreateInputLayout(
+		skinnedElements, 6,
+		skinnedBlob->GetBufferPointer(), skinnedBlob->GetBufferSize(),
+		skinnedInputLayout.GetAddressOf());
+
+	// The shadow shader takes the same input, so it shares the layout
+	skinnedVertexShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"SkinnedVertexShader.cso").c_str(), skinnedInputLayout, false);
+	skinnedShadowShader = std::make_shared<SimpleVertexShader>(
+		device, context, FixPath(L"SkinnedShadowVertexShader.cso").c_str(), skinnedInputLayout, false);
 }
 
 void GameRenderer::CreateSkybox(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler, std::shared_ptr<Mesh> skyMesh)
@@ -330,15 +475,191 @@ bool GameRenderer::CompareEntityMaterials(const std::shared_ptr<GameEntity>& ent
 // --------------------------------------------------------
 void GameRenderer::SortByMaterial(std::vector<std::shared_ptr<GameEntity>>& entities)
 {
+	PROFILE_ZONE("SortByMaterial");
+
 	// Sort the entities using the materials as a lambda function
 	std::sort(entities.begin(), entities.end(), CompareEntityMaterials);
 }
 
+// --------------------------------------------------------
+// Get the vertex shader that can read a compact vertex format,
+// or null for the standard format
+// --------------------------------------------------------
+std::shared_ptr<SimpleVertexShader> GameRenderer::GetCompactVertexShader(VertexFormat format, bool shadowPass)
+{
+	switch (format)
+	{
+	case VertexFormat::Compact: return shadowPass ? compactShadowShader : compactVertexShader;
+	case VertexFormat::CompactQuantized: return shadowPass ? quantizedShadowShader : quantizedVertexShader;
+	default: return nullptr;
+	}
+}
+
+// --------------------------------------------------------
+// Send a mesh's dequantization values to a compact shader
+// --------------------------------------------------------
+void GameRenderer::SetCompactVertexData(std::shared_ptr<SimpleVertexShader> shader, std::shared_ptr<Mesh> mesh)
+{
+	shader->SetFloat3("positionScale", mesh->GetPositionScale());
+	shader->SetFloat3("positionOffset", mesh->GetPositionOffset());
+	shader->SetFloat2("uvScale", mesh->GetUVScale());
+	shader->SetFloat2("uvOffset", mesh->GetUVOffset());
+}
+
+// --------------------------------------------------------
+// Picks the vertex shader for meshes the material's shader
+// can't read, and sends it the mesh's data
+//
+// - Returns nullptr for standard meshes, including skinned
+//   ones posed on the CPU
+// --------------------------------------------------------
+std::shared_ptr<SimpleVertexShader> GameRenderer::GetVertexShaderOverride(std::shared_ptr<Mesh> mesh, bool shadowPass)
+{
+	if (mesh->IsSkinned() && mesh->GetSkinningMode() == SkinningMode::GPU)
+	{
+		std::shared_ptr<SimpleVertexShader> shader = shadowPass ? skinnedShadowShader : skinnedVertexShader;
+		const std::vector<SkinMatrix>& palette = mesh->GetSkinningPalette();
+		shader->SetData("bones", palette.data(), (unsigned int)(palette.size() * sizeof(SkinMatrix)));
+		shader->CopyBufferData("SkinningData");
+		return shader;
+	}
+
+	std::shared_ptr<SimpleVertexShader> compactShader = GetCompactVertexShader(mesh->GetVertexFormat(), shadowPass);
+	if (compactShader)
+		SetCompactVertexData(compactShader, mesh);
+	return compactShader;
+}
+
+// --------------------------------------------------------
+// Pick a level of detail for every render entity
+// 
+// - Each LOD's error is projected to the screen at the mesh's
+//   distance, and the coarsest one under lodPixelError is used
+// - Chosen once per frame, so shadows match what's on screen
+// - Each entity is independent, so they're split across the
+//   job system. That only reads the transforms, so they must
+//   already be up to date (see TransformSystem::Update)
+// --------------------------------------------------------
+void GameRenderer::SelectLODs(std::shared_ptr<Camera> camera)
+{
+	PROFILE_ZONE("SelectLODs");
+
+	renderLODs.assign(renderEntities.size(), 0);
+	if (!lodEnabled)
+		return;
+
+	// Everything about the camera that LOD selection needs
+	XMFLOAT3 cameraPosition = camera->GetTransform()->GetPosition();
+	LODView view = MeshSimplifier::MakeLODView(
+		&cameraPosition.x,
+		camera->GetProjectionType() == ProjectionType::Perspective,
+		camera->GetFieldOfView(),
+		camera->GetOrthographicWidth() / camera->GetAspectRatio(),
+		camera->GetNearClip(),
+		(float)windowHeight);
+
+	auto selectRange = [&](unsigned int first, unsigned int end)
+		{
+			for (unsigned int i = first; i < end; i++)
+			{
+				std::shared_ptr<Mesh> mesh = renderEntities[i]->GetMesh();
+				if (forcedLOD >= 0)
+				{
+					renderLODs[i] = (unsigned int)forcedLOD;
+					continue;
+				}
+
+				// Mesh errors scale with the entity
+				Transform* transform = renderEntities[i]->GetTransform();
+				XMFLOAT3 scale = transform->GetScale();
+				float maxScale = max(fabsf(scale.x), max(fabsf(scale.y), fabsf(scale.z)));
+
+				// The mesh's bounding sphere, in world space
+				XMFLOAT3 boundsMin = mesh->GetBoundsMin();
+				XMFLOAT3 boundsMax = mesh->GetBoundsMax();
+				XMVECTOR minVec = XMLoadFloat3(&boundsMin);
+				XMVECTOR maxVec = XMLoadFloat3(&boundsMax);
+				XMFLOAT4X4 world = transform->GetWorldMatrix();
+				XMFLOAT3 center;
+				XMStoreFloat3(&center, XMVector3Transform((minVec + maxVec) * 0.5f, XMLoadFloat4x4(&world)));
+				float radius = XMVectorGetX(XMVector3Length(maxVec - minVec)) * 0.5f * maxScale;
+
+				float pixelsPerUnit = MeshSimplifier::GetPixelsPerUnit(view, &center.x, radius, maxScale);
+				renderLODs[i] = mesh->SelectLOD(pixelsPerUnit, lodPixelError);
+			}
+		};
+
+	// ParallelFor runs small scenes inline, as they aren't worth a job
+	unsigned int entityCount = (unsigned int)renderEntities.size();
+	if (jobSystem)
+		jobSystem->ParallelFor(entityCount, 256, selectRange);
+	else
+		selectRange(0, entityCount);
+}
+
+// --------------------------------------------------------
+// Decide which of an entity's meshlets the camera can see
+//
+// - Fills meshletVisibility and adds the rejected triangles
+//   to this frame's counters
+// - Tests run in mesh space: the frustum planes come from
+//   world * view * projection and the camera is moved by the
+//   inverse world matrix, so no meshlet bounds get transformed
+// - Returns false if the mesh has no meshlets to cull
+// --------------------------------------------------------
+bool GameRenderer::CullMeshlets(std::shared_ptr<GameEntity> entity, std::shared_ptr<Camera> camera)
+{
+	const std::vector<Meshlet>& meshlets = entity->GetMesh()->GetMeshlets();
+	if (meshlets.empty())
+		return false;
+
+	XMFLOAT4X4 world = entity->GetTransform()->GetWorldMatrix();
+	XMFLOAT4X4 view = camera->GetView();
+	XMFLOAT4X4 projection = camera->GetProjection();
+	XMMATRIX worldMat = XMLoadFloat4x4(&world);
+
+	XMFLOAT4X4 worldViewProjection;
+	XMStoreFloat4x4(&worldViewProjection, worldMat * XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+	float planes[6][4];
+	MeshletBuilder::ExtractFrustumPlanes(&worldViewProjection._11, planes);
+
+	// Orthographic cameras look along a direction rather than from a
+	// point, so their "position" is pushed far back along it instead
+	XMFLOAT3 cameraWorld = camera->GetTransform()->GetPosition();
+	XMVECTOR cameraVec = XMLoadFloat3(&cameraWorld);
+	if (camera->GetProjectionType() != ProjectionType::Perspective)
+	{
+		XMFLOAT3 forward = camera->GetTransform()->GetForward();
+		cameraVec -= XMLoadFloat3(&forward) * 1.0e6f;
+	}
+
+	XMFLOAT3 cameraLocal;
+	XMStoreFloat3(&cameraLocal, XMVector3Transform(cameraVec, XMMatrixInverse(nullptr, worldMat)));
+
+	meshletVisibility.assign(meshlets.size(), true);
+	for (size_t m = 0; m < meshlets.size(); m++)
+	{
+		if (MeshletBuilder::IsOutsideFrustum(meshlets[m], planes))
+		{
+			meshletVisibility[m] = false;
+			frustumCulledTriangles += meshlets[m].triangleCount;
+		}
+		else if (MeshletBuilder::IsBackFacing(meshlets[m], &cameraLocal.x))
+		{
+			meshletVisibility[m] = false;
+			coneCulledTriangles += meshlets[m].triangleCount;
+		}
+	}
+	return true;
+}
+
 // --------------------------------------------------------
 // Choose what entities to render and store them in a list
 // --------------------------------------------------------
 void GameRenderer::SelectRenderableEntities(std::vector<std::shared_ptr<GameEntity>>& gameEntities)
 {
+	PROFILE_ZONE("SelectRenderableEntities");
+
 	// FOR NOW, set the render entities to game entities,
 	// LATER, this function will take care of what entities need to be rendered
 	renderEntities = gameEntities;
@@ -349,6 +670,8 @@ void GameRenderer::SelectRenderableEntities(std::vector<std::shared_ptr<GameEnti
 // --------------------------------------------------------
 void GameRenderer::Update(float& totalTime, std::vector<std::shared_ptr<GameEntity>>& gameEntities)
 {
+	PROFILE_ZONE("GameRenderer::Update");
+
 	// Update total time
 	this->totalTime = totalTime;
 
@@ -361,6 +684,8 @@ void GameRenderer::Update(float& totalTime, std::vector<std::shared_ptr<GameEnti
 
 void GameRenderer::RenderShadows()
 {
+	PROFILE_ZONE("RenderShadows");
+
 	// Set shadow rasterizer state
 	context->RSSetState(shadowRasterizer.Get());
 
@@ -382,19 +707,31 @@ void GameRenderer::RenderShadows()
 	context->RSSetViewports(1, &viewport);
 
 	// Set shaders
-	shadowShader->SetShader();
-	shadowShader->SetMatrix4x4("view", lightViewMatrix);
-	shadowShader->SetMatrix4x4("projection", lightProjectionMatrix);
+	for (std::shared_ptr<SimpleVertexShader> vs : { shadowShader, compactShadowShader, quantizedShadowShader, skinnedShadowShader })
+	{
+		vs->SetMatrix4x4("view", lightViewMatrix);
+		vs->SetMatrix4x4("projection", lightProjectionMatrix);
+	}
 
 	// Draw all entities
-	for (auto& e : renderEntities)
+	for (size_t i = 0; i < renderEntities.size(); i++)
 	{
+		std::shared_ptr<GameEntity> e = renderEntities[i];
+
+		// Compact and GPU skinned meshes need a shader that can read them
+		std::shared_ptr<SimpleVertexShader> overrideShader = GetVertexShaderOverride(e->GetMesh(), true);
+		std::shared_ptr<SimpleVertexShader> vs = overrideShader ? overrideShader : shadowShader;
+
 		// Set buffer data
-		shadowShader->SetMatrix4x4("world", e->GetTransform()->GetWorldMatrix());
-		shadowShader->CopyAllBufferData();
+		vs->SetShader();
+		AffineMatrix world = e->GetTransform()->GetWorldAffine();
+		vs->SetData("world", &world, sizeof(AffineMatrix));
+		vs->CopyAllBufferData();
 
 		// Draw meshes directly
-		e->GetMesh()->Draw();
+		e->GetMesh()->Draw(renderLODs[i]);
+		if (geometryArena && !e->GetMesh()->IsInArena())
+			geometryArena->InvalidateBindings();
 	}
 
 	// Reset pipeline
@@ -411,6 +748,8 @@ void GameRenderer::RenderShadows()
 
 void GameRenderer::RenderPostProcessing()
 {
+	PROFILE_ZONE("RenderPostProcessing");
+
 	// Activate  the vertex shader
 	ppVS->SetShader();
 	
@@ -420,6 +759,8 @@ void GameRenderer::RenderPostProcessing()
 
 void GameRenderer::Blur()
 {
+	PROFILE_ZONE("Blur");
+
 	// Set the render target view
 	context->OMSetRenderTargets(1, blurRTV.GetAddressOf(), 0);
 
@@ -439,6 +780,8 @@ void GameRenderer::Blur()
 
 void GameRenderer::Pixelate()
 {
+	PROFILE_ZONE("Pixelate");
+
 	// Restore the back buffer
 	context->OMSetRenderTargets(1, backBufferRTV.GetAddressOf(), 0);
 
@@ -471,6 +814,10 @@ void GameRenderer::Draw(bool vsync, bool deviceSupportsTearing, BOOL isFullscree
 		// Clear the depth buffer (resets per-pixel occlusion information)
 		context->ClearDepthStencilView(depthBufferDSV.Get(), D3D11_CLEAR_DEPTH, 1.0f, 0);
 
+		// Whatever was bound last frame (UI included) is gone
+		if (geometryArena)
+			geometryArena->BeginFrame();
+
 		// Clear the post-processing render targets
 		const float clearColor[4] = {
 			1.0f,
@@ -482,7 +829,8 @@ void GameRenderer::Draw(bool vsync, bool deviceSupportsTearing, BOOL isFullscree
 		context->ClearRenderTargetView(blurRTV.Get(), clearColor);
 		context->ClearRenderTargetView(pixelateRTV.Get(), clearColor);
 
-		// Render shadows
+		// Pick LODs for this camera, then render shadows
+		SelectLODs(camera);
 		RenderShadows();
 
 		// Swap the active render target
@@ -494,19 +842,32 @@ void GameRenderer::Draw(bool vsync, bool deviceSupportsTearing, BOOL isFullscree
 	pixelShader->CopyBufferData("FrameData");
 
 	// Set vertex shader frame data
-	vertexShader->SetMatrix4x4("view", camera->GetView());
-	vertexShader->SetMatrix4x4("projection", camera->GetProjection());
-	vertexShader->CopyBufferData("FrameData");
+	for (std::shared_ptr<SimpleVertexShader> vs : { vertexShader, compactVertexShader, quantizedVertexShader, skinnedVertexShader })
+	{
+		vs->SetMatrix4x4("view", camera->GetView());
+		vs->SetMatrix4x4("projection", camera->GetProjection());
+		vs->CopyBufferData("FrameData");
+	}
 
 	// Draw entities
+	drawnTriangles = 0;
+	frustumCulledTriangles = 0;
+	coneCulledTriangles = 0;
 	for (int i = 0; i < renderEntities.size(); ++i)
 	{
+		PROFILE_ZONE("DrawEntity");
+
+		// Compact and GPU skinned meshes need a shader that can read them
+		std::shared_ptr<Mesh> mesh = renderEntities[i]->GetMesh();
+		std::shared_ptr<SimpleVertexShader> overrideShader = GetVertexShaderOverride(mesh, false);
+		std::shared_ptr<SimpleVertexShader> vs = overrideShader ? overrideShader : vertexShader;
+
 		// Send light data
 		lightManager->SetPixelData();
 
 		// Set shadow data
-		vertexShader->SetMatrix4x4("lightView", lightViewMatrix);
-		vertexShader->SetMatrix4x4("lightProjection", lightProjectionMatrix);
+		vs->SetMatrix4x4("lightView", lightViewMatrix);
+		vs->SetMatrix4x4("lightProjection", lightProjectionMatrix);
 		pixelShader->SetShaderResourceView("ShadowMap", shadowSRV);
 		pixelShader->SetSamplerState("ShadowSampler", shadowSampler);
 		
@@ -514,11 +875,24 @@ void GameRenderer::Draw(bool vsync, bool deviceSupportsTearing, BOOL isFullscree
 		renderEntities[i]->GetMaterial()->PrepareMaterial(
 			renderEntities[i]->GetTransform(), 
 			lightManager->GetAmbientTerm(),
-			totalTime
+			totalTime,
+			overrideShader
 		);
 
-		// Render the entity
-		renderEntities[i]->Draw();
+		// Render the entity, skipping hidden meshlets at full detail
+		// - Not for skinned or morphed meshes, whose meshlet bounds and cones are for the bind pose
+		unsigned int culledBefore = frustumCulledTriangles + coneCulledTriangles;
+		if (meshletCullingEnabled && renderLODs[i] == 0 && !mesh->IsDeformable() && CullMeshlets(renderEntities[i], camera))
+			renderEntities[i]->DrawMeshlets(meshletVisibility);
+		else
+			renderEntities[i]->Draw(renderLODs[i]);
+		if (geometryArena && !mesh->IsInArena())
+			geometryArena->InvalidateBindings();
+
+		// Count what was actually drawn (Draw clamps to the coarsest LOD)
+		if (mesh->GetLODCount() > 0)
+			drawnTriangles += mesh->GetLOD(min(renderLODs[i], mesh->GetLODCount() - 1)).indexCount / 3;
+		drawnTriangles -= frustumCulledTriangles + coneCulledTriangles - culledBefore;
 	}
 
 	// Draw the skybox last
@@ -542,6 +916,7 @@ void GameRenderer::Draw(bool vsync, bool deviceSupportsTearing, BOOL isFullscree
 		// Present the back buffer to the user
 		//  - Puts the results of what we've drawn onto the window
 		//  - Without this, the user never sees anything
+		PROFILE_ZONE("Present");
 		bool vsyncNecessary = vsync || !deviceSupportsTearing || isFullscreen;
 		swapChain->Present(
 			vsyncNecessary ? 1 : 0,
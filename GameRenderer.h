@@ -6,6 +6,7 @@
 #include "Camera.h"
 #include "LightManager.h"
 #include "Skybox.h"
+#include "JobSystem.h"
 
 class GameRenderer
 {
@@ -25,9 +26,50 @@ private:
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 	std::shared_ptr<SimpleVertexShader> shadowShader;
 
+	// Shaders for the compact vertex formats (see VertexCompression.h)
+	// - Each format needs its own input layout, so there's one
+	//   shader object per format even though they share code
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> compactInputLayout;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> quantizedInputLayout;
+	std::shared_ptr<SimpleVertexShader> compactVertexShader;
+	std::shared_ptr<SimpleVertexShader> quantizedVertexShader;
+	std::shared_ptr<SimpleVertexShader> compactShadowShader;
+	std::shared_ptr<SimpleVertexShader> quantizedShadowShader;
+
+	// Shaders for GPU skinned meshes (see Skinning.h)
+	// - The joints and weights come from a second input slot
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> skinnedInputLayout;
+	std::shared_ptr<SimpleVertexShader> skinnedVertexShader;
+	std::shared_ptr<SimpleVertexShader> skinnedShadowShader;
+
 	// Entities
 	std::vector<std::shared_ptr<GameEntity>> renderEntities;
 
+	// Levels of detail (see MeshSimplifier.h)
+	// - renderLODs holds the LOD picked for each render entity this frame
+	std::vector<unsigned int> renderLODs;
+	bool lodEnabled = true;
+	float lodPixelError = 1.0f;
+	int forcedLOD = -1;
+	unsigned int drawnTriangles = 0;
+
+	// Meshlet culling (see MeshletBuilder.h)
+	// - Only applies to LOD 0 in the main pass, since coarser LODs
+	//   are already cheap and shadows see the other side of the mesh
+	// - meshletVisibility is reused by every entity to avoid allocating
+	bool meshletCullingEnabled = true;
+	std::vector<bool> meshletVisibility;
+	unsigned int frustumCulledTriangles = 0;
+	unsigned int coneCulledTriangles = 0;
+
+	// Shared mesh buffers (see GeometryArena.h)
+	// - Meshes outside it bind their own buffers, so the arena
+	//   has to forget its bindings after each one is drawn
+	std::shared_ptr<GeometryArena> geometryArena;
+
+	// Per entity work fans out over this, if set (see JobSystem.h)
+	std::shared_ptr<JobSystem> jobSystem;
+
 	// Light manager
 	std::shared_ptr<LightManager> lightManager;
 
@@ -71,6 +113,11 @@ private:
 	// Helper functions
 	static bool CompareEntityMaterials(const std::shared_ptr<GameEntity>& entity1, const std::shared_ptr<GameEntity>& entity2);
 	void SortByMaterial(std::vector<std::shared_ptr<GameEntity>>& entities);
+	std::shared_ptr<SimpleVertexShader> GetCompactVertexShader(VertexFormat format, bool shadowPass);
+	void SetCompactVertexData(std::shared_ptr<SimpleVertexShader> shader, std::shared_ptr<Mesh> mesh);
+	std::shared_ptr<SimpleVertexShader> GetVertexShaderOverride(std::shared_ptr<Mesh> mesh, bool shadowPass);
+	void SelectLODs(std::shared_ptr<Camera> camera);
+	bool CullMeshlets(std::shared_ptr<GameEntity> entity, std::shared_ptr<Camera> camera);
 
 public:
 	GameRenderer(
@@ -92,14 +139,29 @@ public:
 	std::vector<std::shared_ptr<GameEntity>> GetRenderedEntities();
 	std::shared_ptr<LightManager> GetLightManager();
 	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> GetShadowSRV();
+	bool GetLODEnabled() const;
+	float GetLODPixelError() const;
+	int GetForcedLOD() const;
+	unsigned int GetDrawnTriangles() const;
+	bool GetMeshletCullingEnabled() const;
+	unsigned int GetFrustumCulledTriangles() const;
+	unsigned int GetConeCulledTriangles() const;
 
 	// Setters
 	void SetBlurRadius(int blurRadius);
 	void SetPixelSize(int pixelSize);
+	void SetLODEnabled(bool lodEnabled);
+	void SetLODPixelError(float lodPixelError);
+	void SetForcedLOD(int forcedLOD);
+	void SetMeshletCullingEnabled(bool meshletCullingEnabled);
+	void SetGeometryArena(std::shared_ptr<GeometryArena> geometryArena);
+	void SetJobSystem(std::shared_ptr<JobSystem> jobSystem);
 
 	// Initialize Functions
 	void Init();
 	void LoadShaders();
+	void LoadCompactShaders();
+	void LoadSkinnedShaders();
 	void CreateSkybox(Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler, std::shared_ptr<Mesh> skyMesh);
 	void InitShadows();
 	void InitPostProcessing();
@@ -0,0 +1,307 @@
+#include "GeometryArena.h"
+
+#include <unordered_map>
+
+GeometryArena::GeometryArena(
+	Microsoft::WRL::ComPtr<ID3D11Device> device,
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+	unsigned int initialVertices,
+	unsigned int initialIndices)
+	: device(device), context(context),
+	initialVertices(initialVertices), initialIndices(initialIndices),
+	boundVertexBuffer(nullptr), boundIndexBuffer(nullptr),
+	compactions(0), growths(0), binds(0), draws(0), lastFrameBinds(0), lastFrameDraws(0)
+{
+}
+
+// --------------------------------------------------------
+// Copies a mesh's buffers into the arena
+//
+// - Both copies stay on the GPU, and the source buffers can
+//   be released straight after
+// --------------------------------------------------------
+unsigned int GeometryArena::Add(
+	ID3D11Buffer* vertexBuffer, unsigned int vertexStride, unsigned int vertexCount,
+	ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat, unsigned int indexCount)
+{
+	if (!vertexBuffer || !indexBuffer || vertexCount == 0 || indexCount == 0)
+		return InvalidAllocation;
+
+	unsigned int indexBytes = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+	Pool* vertexPool = GetPool(vertexPools, vertexStride, vertexStride, D3D11_BIND_VERTEX_BUFFER, initialVertices);
+	Pool* indexPool = GetPool(indexPools, (unsigned int)indexFormat, indexBytes, D3D11_BIND_INDEX_BUFFER, initialIndices);
+	if (!vertexPool || !indexPool)
+		return InvalidAllocation;
+
+	unsigned int vertexOffset = AllocateFromPool(*vertexPool, vertexCount, true, vertexStride);
+	if (vertexOffset == ArenaAllocator::InvalidOffset)
+		return InvalidAllocation;
+
+	unsigned int indexOffset = AllocateFromPool(*indexPool, indexCount, false, (unsigned int)indexFormat);
+	if (indexOffset == ArenaAllocator::InvalidOffset)
+	{
+		vertexPool->allocator.Free(vertexOffset);
+		return InvalidAllocation;
+	}
+
+	// Copy the mesh's data into place
+	D3D11_BOX vertexBox = { 0, 0, 0, vertexCount * vertexStride, 1, 1 };
+	context->CopySubresourceRegion(vertexPool->buffer.Get(), 0, vertexOffset * vertexStride, 0, 0, vertexBuffer, 0, &vertexBox);
+
+	D3D11_BOX indexBox = { 0, 0, 0, indexCount * indexBytes, 1, 1 };
+	context->CopySubresourceRegion(indexPool->buffer.Get(), 0, indexOffset * indexBytes, 0, 0, indexBuffer, 0, &indexBox);
+
+	// Record it, reusing an old id if there is one
+	GeometryAllocation allocation = { vertexStride, vertexOffset, vertexCount, indexFormat, indexOffset, indexCount };
+	unsigned int id;
+	if (!unusedAllocations.empty())
+	{
+		id = unusedAllocations.back();
+		unusedAllocations.pop_back();
+		allocations[id] = allocation;
+		allocationUsed[id] = true;
+	}
+	else
+	{
+		id = (unsigned int)allocations.size();
+		allocations.push_back(allocation);
+		allocationUsed.push_back(true);
+	}
+
+	return id;
+}
+
+void GeometryArena::Remove(unsigned int allocation)
+{
+	if (allocation >= allocations.size() || !allocationUsed[allocation])
+		return;
+
+	const GeometryAllocation& a = allocations[allocation];
+	vertexPools[a.vertexStride].allocator.Free(a.vertexOffset);
+	indexPools[(unsigned int)a.indexFormat].allocator.Free(a.indexOffset);
+
+	allocationUsed[allocation] = false;
+	unusedAllocations.push_back(allocation);
+}
+
+// --------------------------------------------------------
+// Binds the allocation's buffers unless they're already bound
+// --------------------------------------------------------
+const GeometryAllocation& GeometryArena::Bind(unsigned int allocation)
+{
+	const GeometryAllocation& a = allocations[allocation];
+	ID3D11Buffer* vertexBuffer = vertexPools[a.vertexStride].buffer.Get();
+	ID3D11Buffer* indexBuffer = indexPools[(unsigned int)a.indexFormat].buffer.Get();
+
+	if (vertexBuffer != boundVertexBuffer)
+	{
+		UINT stride = a.vertexStride;
+		UINT offset = 0;
+		context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
+		boundVertexBuffer = vertexBuffer;
+		binds++;
+	}
+
+	if (indexBuffer != boundIndexBuffer)
+	{
+		context->IASetIndexBuffer(indexBuffer, a.indexFormat, 0);
+		boundIndexBuffer = indexBuffer;
+		binds++;
+	}
+
+	draws++;
+	return a;
+}
+
+const GeometryAllocation& GeometryArena::GetAllocation(unsigned int allocation) const
+{
+	return this->allocations[allocation];
+}
+
+void GeometryArena::BeginFrame()
+{
+	lastFrameBinds = binds;
+	lastFrameDraws = draws;
+	binds = 0;
+	draws = 0;
+	InvalidateBindings();
+}
+
+void GeometryArena::InvalidateBindings()
+{
+	boundVertexBuffer = nullptr;
+	boundIndexBuffer = nullptr;
+}
+
+// --------------------------------------------------------
+// Compacts any buffer where most of the free space is split
+// into pieces, which happens as meshes are removed
+// --------------------------------------------------------
+void GeometryArena::Update()
+{
+	for (std::pair<const unsigned int, Pool>& pool : vertexPools)
+	{
+		if (pool.second.allocator.GetStats().freeBlocks > 1 && pool.second.allocator.GetFragmentation() > 0.5f)
+			CompactPool(pool.second, true, pool.first);
+	}
+
+	for (std::pair<const unsigned int, Pool>& pool : indexPools)
+	{
+		if (pool.second.allocator.GetStats().freeBlocks > 1 && pool.second.allocator.GetFragmentation() > 0.5f)
+			CompactPool(pool.second, false, pool.first);
+	}
+}
+
+GeometryArenaStats GeometryArena::GetStats() const
+{
+	GeometryArenaStats stats = {};
+	stats.meshes = (unsigned int)(allocations.size() - unusedAllocations.size());
+	stats.buffers = (unsigned int)(vertexPools.size() + indexPools.size());
+	stats.compactions = compactions;
+	stats.growths = growths;
+	stats.binds = lastFrameBinds;
+	stats.draws = lastFrameDraws;
+
+	for (const std::map<unsigned int, Pool>* pools : { &vertexPools, &indexPools })
+	{
+		for (const std::pair<const unsigned int, Pool>& pool : *pools)
+		{
+			ArenaStats arenaStats = pool.second.allocator.GetStats();
+			stats.capacityBytes += (unsigned long long)arenaStats.capacity * pool.second.elementBytes;
+			stats.usedBytes += (unsigned long long)arenaStats.used * pool.second.elementBytes;
+			stats.freeBlocks += arenaStats.freeBlocks;
+		}
+	}
+
+	return stats;
+}
+
+// --------------------------------------------------------
+// Finds the pool for a format, creating it if it's new
+// --------------------------------------------------------
+GeometryArena::Pool* GeometryArena::GetPool(std::map<unsigned int, Pool>& pools, unsigned int key, unsigned int elementBytes, UINT bindFlags, unsigned int initialCapacity)
+{
+	std::map<unsigned int, Pool>::iterator existing = pools.find(key);
+	if (existing != pools.end())
+		return &existing->second;
+
+	Pool pool;
+	pool.elementBytes = elementBytes;
+	pool.bindFlags = bindFlags;
+	pool.buffer = CreatePoolBuffer(pool, initialCapacity);
+	if (!pool.buffer)
+		return nullptr;
+
+	pool.allocator.Grow(initialCapacity);
+	return &pools.emplace(key, pool).first->second;
+}
+
+Microsoft::WRL::ComPtr<ID3D11Buffer> GeometryArena::CreatePoolBuffer(const Pool& pool, unsigned int capacity)
+{
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	unsigned long long bytes = (unsigned long long)capacity * pool.elementBytes;
+	if (bytes == 0 || bytes > 0xFFFFFFFFull)
+		return buffer;
+
+	// Default usage, since compacting and growing copy into it
+	D3D11_BUFFER_DESC desc = {};
+	desc.Usage = D3D11_USAGE_DEFAULT;
+	desc.ByteWidth = (UINT)bytes;
+	desc.BindFlags = pool.bindFlags;
+
+	device->CreateBuffer(&desc, nullptr, buffer.GetAddressOf());
+	return buffer;
+}
+
+// --------------------------------------------------------
+// Allocates from a pool, making room if it has to
+//
+// - If there's enough free space in total, compacting puts
+//   it all in one block; otherwise the buffer doubles
+// --------------------------------------------------------
+unsigned int GeometryArena::AllocateFromPool(Pool& pool, unsigned int count, bool vertexPool, unsigned int key)
+{
+	unsigned int offset = pool.allocator.Allocate(count);
+	if (offset != ArenaAllocator::InvalidOffset)
+		return offset;
+
+	ArenaStats stats = pool.allocator.GetStats();
+	if (stats.capacity - stats.used >= count && CompactPool(pool, vertexPool, key))
+		return pool.allocator.Allocate(count);
+
+	unsigned long long capacity = (unsigned long long)stats.capacity * 2;
+	if (capacity < (unsigned long long)stats.used + count)
+		capacity = (unsigned long long)stats.used + count;
+	if (capacity > 0xFFFFFFFFull || !GrowPool(pool, (unsigned int)capacity))
+		return ArenaAllocator::InvalidOffset;
+
+	return pool.allocator.Allocate(count);
+}
+
+// --------------------------------------------------------
+// Moves a pool into a bigger buffer, keeping every offset
+// --------------------------------------------------------
+bool GeometryArena::GrowPool(Pool& pool, unsigned int capacity)
+{
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer = CreatePoolBuffer(pool, capacity);
+	if (!buffer)
+		return false;
+
+	D3D11_BOX box = { 0, 0, 0, pool.allocator.GetCapacity() * pool.elementBytes, 1, 1 };
+	context->CopySubresourceRegion(buffer.Get(), 0, 0, 0, 0, pool.buffer.Get(), 0, &box);
+
+	pool.buffer = buffer;
+	pool.allocator.Grow(capacity);
+	growths++;
+	InvalidateBindings();
+	return true;
+}
+
+// --------------------------------------------------------
+// Packs a pool's allocations at the start of a fresh buffer
+//
+// - Copying into a new buffer avoids overlapping copies
+//   within one (which D3D doesn't allow)
+// - Neighbouring allocations that move by the same amount
+//   are copied together
+// - Every allocation in the pool gets its new offset
+// --------------------------------------------------------
+bool GeometryArena::CompactPool(Pool& pool, bool vertexPool, unsigned int key)
+{
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer = CreatePoolBuffer(pool, pool.allocator.GetCapacity());
+	if (!buffer)
+		return false;
+
+	std::vector<ArenaMove> moves = pool.allocator.Compact();
+	std::unordered_map<unsigned int, unsigned int> newOffsets;
+	for (size_t m = 0; m < moves.size();)
+	{
+		ArenaMove run = moves[m];
+		newOffsets[moves[m].from] = moves[m].to;
+		for (m++; m < moves.size() && moves[m].from == run.from + run.size && moves[m].to == run.to + run.size; m++)
+		{
+			newOffsets[moves[m].from] = moves[m].to;
+			run.size += moves[m].size;
+		}
+
+		D3D11_BOX box = { run.from * pool.elementBytes, 0, 0, (run.from + run.size) * pool.elementBytes, 1, 1 };
+		context->CopySubresourceRegion(buffer.Get(), 0, run.to * pool.elementBytes, 0, 0, pool.buffer.Get(), 0, &box);
+	}
+	pool.buffer = buffer;
+
+	for (size_t a = 0; a < allocations.size(); a++)
+	{
+		if (!allocationUsed[a])
+			continue;
+
+		GeometryAllocation& allocation = allocations[a];
+		if (vertexPool && allocation.vertexStride == key)
+			allocation.vertexOffset = newOffsets[allocation.vertexOffset];
+		else if (!vertexPool && (unsigned int)allocation.indexFormat == key)
+			allocation.indexOffset = newOffsets[allocation.indexOffset];
+	}
+
+	compactions++;
+	InvalidateBindings();
+	return true;
+}
@@ -0,0 +1,130 @@
+#pragma once
+#include <d3d11.h>
+#include <wrl/client.h>
+#include <map>
+#include <vector>
+
+#include "ArenaAllocator.h"
+
+// --------------------------------------------------------
+// Where one mesh lives in the arena
+//
+// - vertexOffset is in vertices, and is passed to DrawIndexed
+//   as the base vertex, so the mesh's own indices stay as-is
+// - indexOffset is in indices, added to the start index
+// --------------------------------------------------------
+struct GeometryAllocation
+{
+	unsigned int vertexStride;
+	unsigned int vertexOffset;
+	unsigned int vertexCount;
+	DXGI_FORMAT indexFormat;
+	unsigned int indexOffset;
+	unsigned int indexCount;
+};
+
+// --------------------------------------------------------
+// Arena totals, plus how often the input assembler was
+// rebound for the draws of the last frame
+// --------------------------------------------------------
+struct GeometryArenaStats
+{
+	unsigned int meshes;
+	unsigned int buffers;
+	unsigned long long capacityBytes;
+	unsigned long long usedBytes;
+	unsigned int freeBlocks;
+	unsigned int compactions;
+	unsigned int growths;
+	unsigned int binds;
+	unsigned int draws;
+};
+
+// --------------------------------------------------------
+// Holds static meshes together in a few large buffers
+//
+// - There's one vertex buffer per vertex stride and one index
+//   buffer per index format, so meshes sharing a format draw
+//   without rebinding anything in between
+// - Space is handed out by an ArenaAllocator per buffer. A
+//   buffer that runs out is compacted if that makes enough
+//   room, and otherwise doubled
+// - Meshes still create their own buffers (possibly on a
+//   worker thread), then Add() copies them in on the GPU
+// - Update() compacts buffers left fragmented by meshes that
+//   were removed, copying the survivors into a fresh buffer
+// - Bind() skips buffers that are already bound. Anything
+//   else that binds vertex or index buffers needs to call
+//   InvalidateBindings() afterwards
+// - Main thread only, since it uses the device context
+// --------------------------------------------------------
+class GeometryArena
+{
+public:
+	static const unsigned int InvalidAllocation = 0xFFFFFFFF;
+
+	GeometryArena(
+		Microsoft::WRL::ComPtr<ID3D11Device> device,
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context,
+		unsigned int initialVertices = 1 << 16,
+		unsigned int initialIndices = 1 << 18);
+
+	// Returns InvalidAllocation if the buffers couldn't grow to fit
+	unsigned int Add(
+		ID3D11Buffer* vertexBuffer, unsigned int vertexStride, unsigned int vertexCount,
+		ID3D11Buffer* indexBuffer, DXGI_FORMAT indexFormat, unsigned int indexCount);
+	void Remove(unsigned int allocation);
+
+	// Binds the buffers holding an allocation, if needed, for a draw
+	const GeometryAllocation& Bind(unsigned int allocation);
+	const GeometryAllocation& GetAllocation(unsigned int allocation) const;
+
+	// Forgets what's bound - call at the start of every frame
+	void BeginFrame();
+	void InvalidateBindings();
+
+	// Compacts fragmented buffers - call once per frame, outside of drawing
+	void Update();
+
+	GeometryArenaStats GetStats() const;
+
+private:
+	struct Pool
+	{
+		Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+		ArenaAllocator allocator;
+		unsigned int elementBytes;
+		UINT bindFlags;
+	};
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+	unsigned int initialVertices;
+	unsigned int initialIndices;
+
+	// Keyed by vertex stride and by index DXGI_FORMAT
+	std::map<unsigned int, Pool> vertexPools;
+	std::map<unsigned int, Pool> indexPools;
+
+	// Allocations by id; unused ids are recycled
+	std::vector<GeometryAllocation> allocations;
+	std::vector<bool> allocationUsed;
+	std::vector<unsigned int> unusedAllocations;
+
+	// Currently bound buffers
+	ID3D11Buffer* boundVertexBuffer;
+	ID3D11Buffer* boundIndexBuffer;
+
+	unsigned int compactions;
+	unsigned int growths;
+	unsigned int binds;
+	unsigned int draws;
+	unsigned int lastFrameBinds;
+	unsigned int lastFrameDraws;
+
+	Pool* GetPool(std::map<unsigned int, Pool>& pools, unsigned int key, unsigned int elementBytes, UINT bindFlags, unsigned int initialCapacity);
+	Microsoft::WRL::ComPtr<ID3D11Buffer> CreatePoolBuffer(const Pool& pool, unsigned int capacity);
+	unsigned int AllocateFromPool(Pool& pool, unsigned int count, bool vertexPool, unsigned int key);
+	bool GrowPool(Pool& pool, unsigned int capacity);
+	bool CompactPool(Pool& pool, bool vertexPool, unsigned int key);
+};
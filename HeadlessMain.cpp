@@ -0,0 +1,587 @@
+// --------------------------------------------------------
+// Entry point for the headless benchmark, which runs the
+// frame loop with no window or device (see HeadlessPlatform)
+//
+// - Game and GameRenderer need a Direct3D device, so this
+//   runs the same CPU work they do on their behalf: entities
+//   moving in a fixed timestep through a TransformSystem,
+//   Game's camera flown through UserInput by scripted input,
+//   and per frame the renderer's CPU half (frustum culling,
+//   LOD selection on the job system, and the sort by
+//   material), using the same MeshletBuilder and
+//   MeshSimplifier functions as GameRenderer
+// - Streams Game's meshes in through an AssetLoader while it
+//   runs: parsed and split into meshlets on workers, then
+//   copied into an arena on the main thread. Time to first
+//   frame and the worst frame while streaming are measured
+//   the way Game measures them
+// - Not part of the Visual Studio project, which has its own
+//   WinMain. On Linux it's the headless target in
+//   CMakeLists.txt, which needs the DirectXMath headers and
+//   points it at the Assets folder
+// - Usage: headless [frames] [entities] [threads] [fps cap]
+//   [limiter] [trace] (0 threads uses every hardware thread,
+//   0 fps is uncapped). The limiter is on, off (uncapped, like
+//   unticking it in Game's General tab) or compare, which runs
+//   the frames uncapped and then capped, and compares their
+//   frame time variance and CPU use. Giving a trace file
+//   records profiler zones and writes them there as a Chrome
+//   trace (see Profiler.h)
+// --------------------------------------------------------
+#include "ArenaAllocator.h"
+#include "AssetLoader.h"
+#include "Camera.h"
+#include "FrameLoop.h"
+#include "HeadlessPlatform.h"
+#include "Input.h"
+#include "JobSystem.h"
+#include "MeshletBuilder.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+#include "Profiler.h"
+#include "TransformSystem.h"
+#include "UserInput.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace DirectX;
+
+// Relative to the working directory, unless the build says where
+#ifndef HEADLESS_ASSET_DIRECTORY
+#define HEADLESS_ASSET_DIRECTORY "Assets/"
+#endif
+
+namespace
+{
+	// Mirrors GameRenderer's default
+	const float lodPixelError = 1.0f;
+	const unsigned int materialCount = 8;
+
+	// A four level chain, each level twice as coarse as the last
+	const MeshLOD lodChain[] =
+	{
+		{ 0, 0, 0.0f },
+		{ 0, 0, 0.01f },
+		{ 0, 0, 0.02f },
+		{ 0, 0, 0.04f },
+	};
+
+	// Every mesh in the Assets folder
+	const char* meshFiles[] =
+	{
+		"cube.obj",
+		"cylinder.obj",
+		"helix.obj",
+		"quad.obj",
+		"quad_double_sided.obj",
+		"sphere.obj",
+		"torus.obj",
+	};
+
+	// Where a loaded mesh went in the arena, standing in for Mesh
+	struct HeadlessMesh
+	{
+		unsigned int vertexOffset;
+		unsigned int vertexCount;
+		unsigned int indexOffset;
+		unsigned int indexCount;
+		unsigned int meshletCount;
+	};
+
+	using HeadlessMeshHandle = AssetHandle<std::shared_ptr<HeadlessMesh>>;
+
+	double GetSecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// --------------------------------------------------------
+	// The CPU side of a game, standing in for Game and the
+	// non-Direct3D half of GameRenderer
+	// --------------------------------------------------------
+	class HeadlessGame : public FrameCallbacks
+	{
+	public:
+		HeadlessGame(
+			FrameLoop& frameLoop,
+			std::shared_ptr<JobSystem> jobSystem,
+			unsigned int entityCount,
+			int windowWidth,
+			int windowHeight,
+			std::chrono::steady_clock::time_point startTime)
+			: frameLoop(frameLoop),
+			jobSystem(jobSystem),
+			transformSystem(jobSystem),
+			windowHeight(windowHeight),
+			vertexArena(1 << 16),
+			indexArena(1 << 18),
+			startTime(startTime),
+			firstFrameTime(0.0),
+			assetsLoadedTime(0.0),
+			worstStreamingFrameTime(0.0),
+			streamingFrames(0),
+			tick(0),
+			visibleCount(0),
+			placeholderCount(0)
+		{
+			// Start loading before anything else, as Game::Init() does
+			assetLoader = std::make_shared<AssetLoader>(2);
+			vertexData.resize(vertexArena.GetCapacity());
+			indexData.resize(indexArena.GetCapacity());
+			for (const char* file : meshFiles)
+			{
+				HeadlessMeshHandle handle = assetLoader->CreateHandle<std::shared_ptr<HeadlessMesh>>(nullptr);
+				meshes.push_back(handle);
+				LoadMeshAsync(handle, std::string(HEADLESS_ASSET_DIRECTORY) + file);
+			}
+
+			// Game's first camera, and its controller
+			camera = std::make_shared<Camera>(
+				-5.0f, 2.0f, -10.0f,
+				5.0f,
+				0.002f,
+				XM_PIDIV4,
+				(float)windowWidth / windowHeight,
+				0.01f,
+				100.0f,
+				ProjectionType::Perspective);
+			userInput = std::make_shared<UserInput>(*camera->GetTransform(), ControlType::Camera);
+			userInput->SetMovementSpeed(camera->GetMovementSpeed());
+			userInput->SetLookSpeed(camera->GetMouseLookSpeed());
+
+			// A grid of entities, every fourth one a child of the one before
+			// it, so moving parents drag their children along
+			unsigned int side = (unsigned int)ceilf(sqrtf((float)entityCount));
+			transformSystem.Reserve(entityCount);
+			for (unsigned int i = 0; i < entityCount; i++)
+			{
+				unsigned int slot = transformSystem.Add();
+				slots.push_back(slot);
+				materials.push_back(i % materialCount);
+
+				if (i % 4 == 3)
+				{
+					transformSystem.SetParent(slot, slots[i - 1]);
+					transformSystem.SetPosition(slot, XMFLOAT3(0.0f, 1.5f, 0.0f));
+				}
+				else
+				{
+					transformSystem.SetPosition(slot, XMFLOAT3((float)(i % side) * 3.0f, 0.0f, (float)(i / side) * 3.0f));
+				}
+			}
+			transformSystem.Update();
+
+			// Nothing has moved yet, so the first frames don't blend in from the origin
+			transformSystem.BeginTick();
+
+			lods.resize(entityCount);
+			drawOrder.reserve(entityCount);
+		}
+
+		// Bobs and spins an eighth of the entities each tick, like Game::UpdateEntities()
+		void FixedUpdate(float /*deltaTime*/, float totalTime) override
+		{
+			transformSystem.BeginTick();
+
+			unsigned int count = (unsigned int)slots.size();
+			for (unsigned int i = tick % 8; i < count; i += 8)
+			{
+				XMFLOAT3 position = transformSystem.GetPosition(slots[i]);
+				if (i % 4 != 3)
+					position.y = sinf(totalTime + i) * 0.5f;
+
+				transformSystem.SetPosition(slots[i], position);
+				XMFLOAT4 rotation;
+				XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(0.0f, totalTime + i, 0.0f));
+				transformSystem.SetRotation(slots[i], rotation);
+			}
+			tick++;
+		}
+
+		// Flies the camera and blends every moved entity, as Game::Update() does
+		void Update(float deltaTime, float /*totalTime*/) override
+		{
+			frameTimes.push_back(deltaTime);
+			UpdateAssets(deltaTime);
+			userInput->Update(deltaTime);
+
+			transformSystem.SetInterpolation(frameLoop.GetInterpolationAlpha());
+			transformSystem.Update();
+
+			camera->Update();
+		}
+
+		// --------------------------------------------------------
+		// The renderer's CPU half: cull, pick LODs, then sort by
+		// material
+		//
+		// - Entities are culled by their bounding spheres against
+		//   world space frustum planes, with the same tests the
+		//   renderer runs on meshlets
+		// - LODs are picked the way GameRenderer::SelectLODs() does
+		// - Entities whose mesh hasn't loaded yet are counted, as
+		//   Game would draw them with a placeholder
+		// --------------------------------------------------------
+		void Draw(float /*deltaTime*/, float /*totalTime*/) override
+		{
+			XMFLOAT4X4 view = camera->GetView();
+			XMFLOAT4X4 projection = camera->GetProjection();
+			XMFLOAT4X4 viewProjection;
+			XMStoreFloat4x4(&viewProjection, XMLoadFloat4x4(&view) * XMLoadFloat4x4(&projection));
+			float planes[6][4];
+			MeshletBuilder::ExtractFrustumPlanes(&viewProjection._11, planes);
+
+			XMFLOAT3 cameraPosition = camera->GetTransform()->GetPosition();
+			LODView lodView = MeshSimplifier::MakeLODView(
+				&cameraPosition.x,
+				camera->GetProjectionType() == ProjectionType::Perspective,
+				camera->GetFieldOfView(),
+				camera->GetOrthographicWidth() / camera->GetAspectRatio(),
+				camera->GetNearClip(),
+				(float)windowHeight);
+
+			auto selectRange = [&](unsigned int first, unsigned int end)
+				{
+					for (unsigned int i = first; i < end; i++)
+					{
+						// Unit bounding spheres around each entity's origin
+						const XMFLOAT4X4& world = transformSystem.GetWorldMatrix(slots[i]);
+						const float radius = 1.0f;
+						if (MeshletBuilder::IsSphereOutsideFrustum(&world._41, radius, planes))
+						{
+							lods[i] = InvalidLOD;
+							continue;
+						}
+
+						float pixelsPerUnit = MeshSimplifier::GetPixelsPerUnit(lodView, &world._41, radius, 1.0f);
+						lods[i] = MeshSimplifier::SelectLOD(lodChain, 4, pixelsPerUnit, lodPixelError);
+					}
+				};
+
+			unsigned int entityCount = (unsigned int)slots.size();
+			jobSystem->ParallelFor(entityCount, 256, selectRange);
+
+			drawOrder.clear();
+			placeholderCount = 0;
+			for (unsigned int i = 0; i < entityCount; i++)
+			{
+				if (lods[i] == InvalidLOD)
+					continue;
+
+				drawOrder.push_back(i);
+				if (!meshes[i % meshes.size()].IsReady())
+					placeholderCount++;
+			}
+			std::sort(drawOrder.begin(), drawOrder.end(), [&](unsigned int a, unsigned int b)
+				{
+					return materials[a] != materials[b] ? materials[a] < materials[b] : lods[a] < lods[b];
+				});
+			visibleCount = (unsigned int)drawOrder.size();
+
+			// Note how long the first frame took to get out
+			if (firstFrameTime == 0.0)
+				firstFrameTime = GetSecondsSince(startTime);
+		}
+
+		void PrintStats() const
+		{
+			std::vector<float> sorted = frameTimes;
+			std::sort(sorted.begin(), sorted.end());
+			auto percentile = [&](float p) { return sorted.empty() ? 0.0f : sorted[(size_t)(p * (sorted.size() - 1))]; };
+
+			TransformSystemStats transformStats = transformSystem.GetStats();
+			JobSystemStats jobStats = jobSystem->GetStats();
+			AssetLoaderStats assetStats = assetLoader->GetStats();
+			printf("Entities: %u (%u visible last frame, %u waiting for their mesh)\n", (unsigned int)slots.size(), visibleCount, placeholderCount);
+			printf("Startup: first frame after %.3f ms, ", firstFrameTime * 1000.0);
+			if (assetStats.pending == 0)
+				printf("%u meshes loaded (%u failed) after %.3f ms\n", assetStats.completed, assetStats.failed, assetsLoadedTime * 1000.0);
+			else
+				printf("%u of %u meshes still loading\n", assetStats.pending, (unsigned int)meshes.size());
+			printf("Streaming: worst frame %.3f ms of %u frames (%.3f ms swapping in)\n",
+				worstStreamingFrameTime * 1000.0, streamingFrames, assetStats.worstUpdateSeconds * 1000.0);
+			printf("Frame time: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+				percentile(0.5f) * 1000.0f, percentile(0.99f) * 1000.0f, percentile(1.0f) * 1000.0f);
+			printf("Last transform update: %u rebuilt, %u composed, %.3f ms on %u threads\n",
+				transformStats.rebuilt, transformStats.composed, transformStats.seconds * 1000.0, transformStats.threads);
+			printf("Jobs: %llu run, %llu stolen, %u threads\n", jobStats.jobs, jobStats.steals, jobStats.threads);
+		}
+
+	private:
+		static const unsigned int InvalidLOD = 0xFFFFFFFFu;
+
+		// --------------------------------------------------------
+		// Finishes loads and tracks streaming, as Game::UpdateAssets()
+		// does
+		//
+		// - The first frame is skipped, as its delta covers setup
+		// --------------------------------------------------------
+		void UpdateAssets(float deltaTime)
+		{
+			bool streaming = assetLoader->GetStats().pending > 0;
+			if (streaming && firstFrameTime > 0.0)
+			{
+				streamingFrames++;
+				if (deltaTime > worstStreamingFrameTime)
+					worstStreamingFrameTime = deltaTime;
+			}
+
+			assetLoader->Update(0.002);
+
+			// Note when the last asset finished
+			if (streaming && assetLoader->GetStats().pending == 0)
+				assetsLoadedTime = GetSecondsSince(startTime);
+		}
+
+		// --------------------------------------------------------
+		// Loads a mesh the way AssetRegistry::LoadMeshAsync() does
+		//
+		// - Parsing and building meshlets run on a worker, standing
+		//   in for Mesh's import
+		// - The copy into the arena waits for the main thread, as
+		//   GeometryArena::Add() does
+		// --------------------------------------------------------
+		AssetTask LoadMeshAsync(HeadlessMeshHandle handle, std::string fileName)
+		{
+			AssetLoader* loader = assetLoader.get();
+
+			co_await loader->ResumeInBackground();
+			ObjMeshData data;
+			std::vector<Meshlet> meshlets;
+			bool loaded = ObjParser::ParseFile(fileName.c_str(), data, 1) && !data.indices.empty();
+			if (loaded)
+			{
+				MeshletBuilder::BuildMeshlets(
+					data.indices.data(), (unsigned int)data.indices.size(),
+					data.vertices.data(), (unsigned int)data.vertices.size(), sizeof(ObjVertex),
+					meshlets);
+			}
+
+			// Swap it in on the main thread, between frames
+			co_await loader->ResumeOnMainThread();
+			if (!loaded)
+			{
+				handle.SetFailed();
+				co_return;
+			}
+
+			std::shared_ptr<HeadlessMesh> mesh = std::make_shared<HeadlessMesh>();
+			mesh->vertexOffset = CopyIntoArena(vertexArena, vertexData, data.vertices);
+			mesh->vertexCount = (unsigned int)data.vertices.size();
+			mesh->indexOffset = CopyIntoArena(indexArena, indexData, data.indices);
+			mesh->indexCount = (unsigned int)data.indices.size();
+			mesh->meshletCount = (unsigned int)meshlets.size();
+			handle.SetAsset(mesh);
+		}
+
+		// Doubles an arena that runs out, as GeometryArena's pools do
+		template<typename T>
+		static unsigned int CopyIntoArena(ArenaAllocator& arena, std::vector<T>& buffer, const std::vector<T>& source)
+		{
+			unsigned int count = (unsigned int)source.size();
+			unsigned int offset = arena.Allocate(count);
+			while (offset == ArenaAllocator::InvalidOffset)
+			{
+				arena.Grow(arena.GetCapacity() * 2 + count);
+				buffer.resize(arena.GetCapacity());
+				offset = arena.Allocate(count);
+			}
+
+			std::copy(source.begin(), source.end(), buffer.begin() + offset);
+			return offset;
+		}
+
+		FrameLoop& frameLoop;
+		std::shared_ptr<JobSystem> jobSystem;
+		TransformSystem transformSystem;
+		int windowHeight;
+
+		std::shared_ptr<Camera> camera;
+		std::shared_ptr<UserInput> userInput;
+
+		std::vector<unsigned int> slots;
+		std::vector<unsigned int> materials;
+		std::vector<unsigned int> lods;
+		std::vector<unsigned int> drawOrder;
+		std::vector<float> frameTimes;
+
+		// Loaded meshes, in CPU buffers standing in for the arena's
+		ArenaAllocator vertexArena;
+		ArenaAllocator indexArena;
+		std::vector<ObjVertex> vertexData;
+		std::vector<unsigned int> indexData;
+		std::vector<HeadlessMeshHandle> meshes;
+
+		// Startup and streaming timings (see UpdateAssets)
+		std::chrono::steady_clock::time_point startTime;
+		double firstFrameTime;
+		double assetsLoadedTime;
+		double worstStreamingFrameTime;
+		unsigned int streamingFrames;
+
+		unsigned int tick;
+		unsigned int visibleCount;
+		unsigned int placeholderCount;
+
+		// Last, so it stops its workers before anything they finish into goes
+		std::shared_ptr<AssetLoader> assetLoader;
+	};
+
+	// --------------------------------------------------------
+	// What one run of the scripted frames measured
+	//
+	// - cpuSeconds is the whole process's CPU time (every
+	//   thread), so over wallSeconds 1.0 is one core flat out
+	// --------------------------------------------------------
+	struct RunResult
+	{
+		FramePacingStats pacing;
+		double wallSeconds;
+		double cpuSeconds;
+	};
+
+	// CPU time the process has used so far, or 0 if unknown
+	double GetProcessCpuSeconds()
+	{
+#ifdef _WIN32
+		FILETIME creation, exit, kernel, user;
+		if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+			return 0.0;
+		ULARGE_INTEGER kernelTime = { { kernel.dwLowDateTime, kernel.dwHighDateTime } };
+		ULARGE_INTEGER userTime = { { user.dwLowDateTime, user.dwHighDateTime } };
+		return (kernelTime.QuadPart + userTime.QuadPart) * 100e-9;
+#else
+		struct rusage usage = {};
+		if (getrusage(RUSAGE_SELF, &usage) != 0)
+			return 0.0;
+		return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+	}
+
+	// --------------------------------------------------------
+	// Runs the scripted frames once, with a fresh game, and
+	// prints its stats
+	//
+	// - A frame rate of 0 runs uncapped
+	// --------------------------------------------------------
+	RunResult RunFrames(
+		unsigned long long frameCount, unsigned int entityCount, unsigned int threadCount, float frameRate,
+		std::chrono::steady_clock::time_point startTime)
+	{
+		HeadlessPlatform platform;
+		FrameLoop frameLoop;
+		frameLoop.SetFixedTimestep(1.0f / 60.0f);
+		frameLoop.SetTargetFrameRate(frameRate);
+
+		std::shared_ptr<JobSystem> jobSystem = std::make_shared<JobSystem>(threadCount);
+		HeadlessGame game(frameLoop, jobSystem, entityCount, platform.GetWindowWidth(), platform.GetWindowHeight(), startTime);
+
+		// Fly forward, look around while turning, then climb and strafe at speed
+		unsigned long long quarter = frameCount / 4;
+		platform.HoldKey('W', 0, frameCount);
+		platform.HoldKey(VK_LBUTTON, quarter, quarter);
+		platform.MoveMouse(2, 0, quarter, quarter);
+		platform.HoldKey(VK_SPACE, quarter * 2, quarter);
+		platform.HoldKey(VK_SHIFT, quarter * 3, frameCount - quarter * 3);
+		platform.HoldKey('D', quarter * 3, frameCount - quarter * 3);
+
+		double cpuStart = GetProcessCpuSeconds();
+		std::chrono::steady_clock::time_point runStart = std::chrono::steady_clock::now();
+		frameLoop.Start(platform);
+		unsigned long long frames = frameLoop.Run(platform, game, frameCount);
+
+		RunResult result = {};
+		result.pacing = frameLoop.GetFramePacingStats();
+		result.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+		result.cpuSeconds = GetProcessCpuSeconds() - cpuStart;
+
+		FrameLoopStats loopStats = frameLoop.GetStats();
+		FixedStepStats stepStats = frameLoop.GetFixedStepStats();
+		double perFrame = frames > 0 ? 1000.0 / frames : 0.0;
+		if (frameRate > 0.0f)
+			printf("Limiter: on, %.0f fps\n", frameRate);
+		else
+			printf("Limiter: off\n");
+		printf("Frames: %llu, ticks: %llu (%.1f ms dropped)\n", loopStats.frames, loopStats.ticks, stepStats.droppedSeconds * 1000.0);
+		printf("Per frame: simulation %.3f ms, update %.3f ms, draw %.3f ms, waiting %.3f ms, worst %.3f ms\n",
+			loopStats.simulationSeconds * perFrame, loopStats.updateSeconds * perFrame,
+			loopStats.drawSeconds * perFrame, loopStats.waitSeconds * perFrame, loopStats.worstFrameSeconds * 1000.0);
+		printf("Pacing: %.3f ms smoothed, %.3f ms std dev, %.0f%% busy, %.0f%% CPU\n",
+			result.pacing.smoothedFrameTime * 1000.0f, result.pacing.frameTimeStdDev * 1000.0f, result.pacing.busyFraction * 100.0f,
+			result.wallSeconds > 0.0 ? result.cpuSeconds / result.wallSeconds * 100.0 : 0.0);
+		game.PrintStats();
+		return result;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	// Time to first frame counts from here, as Game's does from Init()
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	unsigned long long frameCount = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000;
+	unsigned int entityCount = argc > 2 ? (unsigned int)strtoul(argv[2], nullptr, 10) : 20000;
+	unsigned int threadCount = argc > 3 ? (unsigned int)strtoul(argv[3], nullptr, 10) : 0;
+	float frameRate = argc > 4 ? (float)atof(argv[4]) : 0.0f;
+	std::string limiter = argc > 5 ? argv[5] : "on";
+	const char* traceFile = argc > 6 ? argv[6] : nullptr;
+	if (frameCount == 0)
+		frameCount = 1;
+	if (limiter != "on" && limiter != "off" && limiter != "compare")
+	{
+		printf("The limiter must be on, off or compare, not %s\n", limiter.c_str());
+		return 1;
+	}
+	if (limiter == "compare" && frameRate <= 0.0f)
+	{
+		printf("Comparing needs an fps cap to compare against\n");
+		return 1;
+	}
+
+	Profiler::SetThreadName("Main");
+	Profiler::GetInstance().SetEnabled(traceFile != nullptr);
+
+	if (limiter == "compare")
+	{
+		// The same frames uncapped, then capped, each from a fresh start
+		RunResult uncapped = RunFrames(frameCount, entityCount, threadCount, 0.0f, startTime);
+		printf("\n");
+		RunResult capped = RunFrames(frameCount, entityCount, threadCount, frameRate, std::chrono::steady_clock::now());
+
+		printf("\nUncapped vs %.0f fps: %.3f -> %.3f ms smoothed, %.3f -> %.3f ms std dev, %.0f%% -> %.0f%% CPU\n",
+			frameRate,
+			uncapped.pacing.smoothedFrameTime * 1000.0f, capped.pacing.smoothedFrameTime * 1000.0f,
+			uncapped.pacing.frameTimeStdDev * 1000.0f, capped.pacing.frameTimeStdDev * 1000.0f,
+			uncapped.wallSeconds > 0.0 ? uncapped.cpuSeconds / uncapped.wallSeconds * 100.0 : 0.0,
+			capped.wallSeconds > 0.0 ? capped.cpuSeconds / capped.wallSeconds * 100.0 : 0.0);
+	}
+	else
+	{
+		RunFrames(frameCount, entityCount, threadCount, limiter == "on" ? frameRate : 0.0f, startTime);
+	}
+
+	if (traceFile)
+	{
+		ProfilerStats profilerStats = Profiler::GetInstance().GetStats();
+		bool written = Profiler::GetInstance().ExportChromeTrace(traceFile);
+		printf("Trace: %llu zones (%llu overwritten) %s %s\n", profilerStats.zones, profilerStats.overwritten,
+			written ? "written to" : "couldn't be written to", traceFile);
+	}
+
+	delete& Input::GetInstance();
+	delete& Profiler::GetInstance();
+	return 0;
+}
@@ -0,0 +1,135 @@
+#include "HeadlessPlatform.h"
+#include "Input.h"
+
+#include <thread>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// Tells the CPU this is a spin loop, like Win32's YieldProcessor()
+	inline void SpinPause()
+	{
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#endif
+	}
+}
+
+HeadlessPlatform::HeadlessPlatform(int windowWidth, int windowHeight)
+	: windowWidth(windowWidth),
+	windowHeight(windowHeight),
+	startTime(std::chrono::steady_clock::now()),
+	frame(0),
+	quitting(false),
+	mouseX(windowWidth / 2),
+	mouseY(windowHeight / 2)
+{
+	Input::GetInstance().Initialize();
+}
+
+void HeadlessPlatform::HoldKey(int key, unsigned long long firstFrame, unsigned long long frameCount)
+{
+	script.push_back(ScriptedInput{ firstFrame, firstFrame + frameCount, key, 0, 0 });
+}
+
+void HeadlessPlatform::MoveMouse(int xDelta, int yDelta, unsigned long long firstFrame, unsigned long long frameCount)
+{
+	script.push_back(ScriptedInput{ firstFrame, firstFrame + frameCount, -1, xDelta, yDelta });
+}
+
+void HeadlessPlatform::Quit()
+{
+	quitting = true;
+}
+
+unsigned long long HeadlessPlatform::GetFrame() const
+{
+	return this->frame;
+}
+
+int HeadlessPlatform::GetWindowWidth() const
+{
+	return this->windowWidth;
+}
+
+int HeadlessPlatform::GetWindowHeight() const
+{
+	return this->windowHeight;
+}
+
+bool HeadlessPlatform::PumpMessages()
+{
+	return !quitting;
+}
+
+double HeadlessPlatform::GetSeconds()
+{
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// --------------------------------------------------------
+// Waits for the frame limit
+//
+// - Sleeps until a millisecond before the deadline, as OS
+//   sleeps can wake late, then spins the rest
+// --------------------------------------------------------
+double HeadlessPlatform::WaitUntil(double seconds)
+{
+	const double marginSeconds = 0.001;
+
+	double sleepSeconds = 0.0;
+	double now = GetSeconds();
+	if (seconds - now > marginSeconds)
+	{
+		double sleepStart = now;
+		std::this_thread::sleep_for(std::chrono::duration<double>(seconds - now - marginSeconds));
+		now = GetSeconds();
+		sleepSeconds = now - sleepStart;
+	}
+
+	while (now < seconds)
+	{
+		SpinPause();
+		now = GetSeconds();
+	}
+	return sleepSeconds;
+}
+
+// --------------------------------------------------------
+// Plays this frame's part of the script into Input
+// --------------------------------------------------------
+void HeadlessPlatform::BeginFrame(float /*deltaTime*/, float /*totalTime*/)
+{
+	PlatformInputState state = {};
+	for (const ScriptedInput& input : script)
+	{
+		if (frame < input.firstFrame || frame >= input.endFrame)
+			continue;
+
+		if (input.key >= 0 && input.key < 256)
+			state.keys[input.key] = 0x80;
+
+		state.rawMouseXDelta += input.mouseXDelta;
+		state.rawMouseYDelta += input.mouseYDelta;
+	}
+
+	mouseX += state.rawMouseXDelta;
+	mouseY += state.rawMouseYDelta;
+	mouseX = mouseX < 0 ? 0 : (mouseX >= windowWidth ? windowWidth - 1 : mouseX);
+	mouseY = mouseY < 0 ? 0 : (mouseY >= windowHeight ? windowHeight - 1 : mouseY);
+	state.mouseX = mouseX;
+	state.mouseY = mouseY;
+
+	Input::GetInstance().Update(state);
+}
+
+void HeadlessPlatform::EndFrame()
+{
+	Input::GetInstance().EndOfFrame();
+	frame++;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+
+#include "Platform.h"
+
+// --------------------------------------------------------
+// A platform with no window or device, for running the
+// frame loop on build machines
+//
+// - Time is the real (steady) clock, so frame timings are
+//   the same as they'd be on a window's loop
+// - Input comes from a script of key holds and mouse moves,
+//   each over a range of frames, and goes through Input as a
+//   window's would, so the game can't tell the difference
+// - Waits sleep until a millisecond before the deadline, then
+//   spin, like DXCore's
+// - Quits once Quit() is called, or when the loop's frame
+//   count runs out
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class HeadlessPlatform : public Platform
+{
+public:
+	HeadlessPlatform(int windowWidth = 1280, int windowHeight = 720);
+
+	// Holds key (a virtual key code or mouse button) down for frameCount frames
+	void HoldKey(int key, unsigned long long firstFrame, unsigned long long frameCount);
+
+	// Moves the mouse by (xDelta, yDelta) raw units every frame for frameCount frames
+	void MoveMouse(int xDelta, int yDelta, unsigned long long firstFrame, unsigned long long frameCount);
+
+	void Quit();
+	unsigned long long GetFrame() const;
+	int GetWindowWidth() const;
+	int GetWindowHeight() const;
+
+	bool PumpMessages() override;
+	double GetSeconds() override;
+	double WaitUntil(double seconds) override;
+	void BeginFrame(float deltaTime, float totalTime) override;
+	void EndFrame() override;
+
+private:
+	struct ScriptedInput
+	{
+		unsigned long long firstFrame;
+		unsigned long long endFrame;
+		int key;
+		int mouseXDelta;
+		int mouseYDelta;
+	};
+
+	int windowWidth;
+	int windowHeight;
+	std::vector<ScriptedInput> script;
+	std::chrono::steady_clock::time_point startTime;
+	unsigned long long frame;
+	bool quitting;
+
+	// Where the mouse would be, kept within the window
+	int mouseX;
+	int mouseY;
+};
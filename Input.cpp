@@ -1,5 +1,9 @@
 #include "Input.h"
+#include <cstring>
+
+#ifdef _WIN32
 #include <hidusage.h>
+#endif
 
 // Singleton requirement
 Input* Input::instance;
@@ -99,15 +103,16 @@ Input::~Input()
 
 // ---------------------------------------------------
 //  Initializes the input variables and sets up the
-//  initial arrays of key states
-//
-//  windowHandle - the handle (id) of the window,
-//                 which is necessary for mouse input
+//  initial arrays of key states, for platforms that
+//  pass their input to Update() themselves
 // ---------------------------------------------------
-void Input::Initialize(HWND windowHandle)
+void Input::Initialize()
 {
-	kbState = new unsigned char[256];
-	prevKbState = new unsigned char[256];
+	if (!kbState)
+	{
+		kbState = new unsigned char[256];
+		prevKbState = new unsigned char[256];
+	}
 
 	memset(kbState, 0, sizeof(unsigned char) * 256);
 	memset(prevKbState, 0, sizeof(unsigned char) * 256);
@@ -116,7 +121,44 @@ void Input::Initialize(HWND windowHandle)
 	mouseX = 0; mouseY = 0;
 	prevMouseX = 0; prevMouseY = 0;
 	mouseXDelta = 0; mouseYDelta = 0;
+	rawMouseXDelta = 0; rawMouseYDelta = 0;
 	keyboardCaptured = false; mouseCaptured = false;
+}
+
+// ----------------------------------------------------------
+//  Updates the input manager for this frame from a state
+//  the platform gathered, the same way Update() does from
+//  Windows. The raw deltas and wheel replace this frame's
+//  values, and are still reset by EndOfFrame()
+// ----------------------------------------------------------
+void Input::Update(const PlatformInputState& state)
+{
+	memcpy(prevKbState, kbState, sizeof(unsigned char) * 256);
+	memcpy(kbState, state.keys, sizeof(unsigned char) * 256);
+
+	prevMouseX = mouseX;
+	prevMouseY = mouseY;
+	mouseX = state.mouseX;
+	mouseY = state.mouseY;
+	mouseXDelta = mouseX - prevMouseX;
+	mouseYDelta = mouseY - prevMouseY;
+
+	rawMouseXDelta = state.rawMouseXDelta;
+	rawMouseYDelta = state.rawMouseYDelta;
+	wheelDelta = state.wheelDelta;
+}
+
+#ifdef _WIN32
+// ---------------------------------------------------
+//  Initializes the input variables and sets up the
+//  initial arrays of key states
+//
+//  windowHandle - the handle (id) of the window,
+//                 which is necessary for mouse input
+// ---------------------------------------------------
+void Input::Initialize(HWND windowHandle)
+{
+	Initialize();
 
 	this->windowHandle = windowHandle;
 
@@ -158,6 +200,7 @@ void Input::Update()
 	mouseXDelta = mouseX - prevMouseX;
 	mouseYDelta = mouseY - prevMouseY;
 }
+#endif
 
 // ----------------------------------------------------------
 //  Resets the mouse wheel value and raw mouse delta at the 
@@ -189,6 +232,7 @@ int Input::GetMouseXDelta() { return mouseXDelta; }
 int Input::GetMouseYDelta() { return mouseYDelta; }
 
 
+#ifdef _WIN32
 // ---------------------------------------------------------------
 //  Passes raw mouse input data to the input manager to be
 //  processed.  This input is the lParam of the WM_INPUT
@@ -217,6 +261,7 @@ void Input::ProcessRawMouseInput(LPARAM lParam)
 		rawMouseYDelta = raw->data.mouse.lLastY;
 	}
 }
+#endif
 
 // ---------------------------------------------------------------
 //  Get the mouse's change (delta) in position since last
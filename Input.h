@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Windows.h>
+#include "Platform.h"
 
 class Input
 {
@@ -29,16 +29,25 @@ private:
 public:
 	~Input();
 
+	void Initialize();
+	void EndOfFrame();
+
+	// Takes a frame's input from a platform, rather than from Windows
+	void Update(const PlatformInputState& state);
+
+#ifdef _WIN32
 	void Initialize(HWND windowHandle);
 	void Update();
-	void EndOfFrame();
+#endif
 
 	int GetMouseX();
 	int GetMouseY();
 	int GetMouseXDelta();
 	int GetMouseYDelta();
 
+#ifdef _WIN32
 	void ProcessRawMouseInput(LPARAM input);
+#endif
 	int GetRawMouseXDelta();
 	int GetRawMouseYDelta();
 
@@ -93,8 +102,10 @@ private:
 	bool keyboardCaptured {0};
 	bool mouseCaptured {0};
 
+#ifdef _WIN32
 	// The window's handle (id) from the OS, so
 	// we can get the cursor's position
 	HWND windowHandle {0};
+#endif
 };
 
@@ -0,0 +1,247 @@
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <string>
+
+namespace
+{
+	// The job system (if any) whose worker is running on this thread, and its queue
+	thread_local const JobSystem* currentSystem = nullptr;
+	thread_local unsigned int currentQueue = 0;
+}
+
+JobCounter::JobCounter()
+	: pending(0)
+{
+}
+
+// --------------------------------------------------------
+// Checks whether every counted job has finished
+//
+// - Taking the lock waits out a job that has just finished
+//   but is still handing over its continuations
+// --------------------------------------------------------
+bool JobCounter::IsDone()
+{
+	if (pending.load() != 0)
+		return false;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	return true;
+}
+
+JobSystem::JobSystem(unsigned int threadCount)
+	: queuedJobs(0), sleepingWorkers(0), stopping(false)
+{
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+	for (unsigned int q = 0; q < threadCount; q++)
+	{
+		queues.push_back(std::make_unique<Queue>());
+		queues.back()->jobsRun = 0;
+		queues.back()->steals = 0;
+	}
+
+	for (unsigned int w = 1; w < threadCount; w++)
+		workers.emplace_back([this, w]() { WorkerLoop(w); });
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping = true;
+	}
+	workAvailable.notify_all();
+
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void JobSystem::Run(std::function<void()> work, JobCounter* counter)
+{
+	if (counter)
+		counter->pending++;
+
+	Push(Job{ std::move(work), counter });
+}
+
+// --------------------------------------------------------
+// Queues a job behind a dependency
+//
+// - Checking and adding happen under the dependency's lock,
+//   so the job is either queued by the last job to finish or
+//   queued here, never both or neither
+// --------------------------------------------------------
+void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter)
+{
+	if (counter)
+		counter->pending++;
+
+	{
+		std::lock_guard<std::mutex> lock(dependency.mutex);
+		if (dependency.pending.load() != 0)
+		{
+			dependency.continuations.push_back(JobCounter::Continuation{ std::move(work), counter });
+			return;
+		}
+	}
+
+	Push(Job{ std::move(work), counter });
+}
+
+// Helps out rather than blocking, so waiting inside a job can't deadlock
+void JobSystem::Wait(JobCounter& counter)
+{
+	unsigned int queueIndex = GetQueueIndex();
+	while (!counter.IsDone())
+	{
+		Job job;
+		if (TryGetJob(queueIndex, job))
+			Execute(queueIndex, job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+unsigned int JobSystem::GetThreadCount() const
+{
+	return (unsigned int)this->queues.size();
+}
+
+JobSystemStats JobSystem::GetStats() const
+{
+	JobSystemStats stats = {};
+	stats.threads = (unsigned int)queues.size();
+	for (const std::unique_ptr<Queue>& queue : queues)
+	{
+		stats.jobs += queue->jobsRun.load(std::memory_order_relaxed);
+		stats.steals += queue->steals.load(std::memory_order_relaxed);
+	}
+	return stats;
+}
+
+unsigned int JobSystem::GetQueueIndex() const
+{
+	return currentSystem == this ? currentQueue : 0;
+}
+
+// --------------------------------------------------------
+// Puts a job on this thread's deque and wakes a worker
+//
+// - The queued count goes up before sleepers are checked, and
+//   a worker counts itself as sleeping before checking for
+//   jobs, so at least one of them sees the other
+// --------------------------------------------------------
+void JobSystem::Push(Job job)
+{
+	Queue& queue = *queues[GetQueueIndex()];
+	{
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(std::move(job));
+	}
+	queuedJobs++;
+
+	if (sleepingWorkers.load() > 0)
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		workAvailable.notify_one();
+	}
+}
+
+// --------------------------------------------------------
+// Takes the newest job from this thread's deque, or else
+// steals the oldest from another
+//
+// - Victims are tried in order from the next queue along,
+//   which spreads thieves out over the queues
+// --------------------------------------------------------
+bool JobSystem::TryGetJob(unsigned int queueIndex, Job& job)
+{
+	if (queuedJobs.load() == 0)
+		return false;
+
+	Queue& own = *queues[queueIndex];
+	{
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty())
+		{
+			job = std::move(own.jobs.back());
+			own.jobs.pop_back();
+			queuedJobs--;
+			return true;
+		}
+	}
+
+	unsigned int queueCount = (unsigned int)queues.size();
+	for (unsigned int i = 1; i < queueCount; i++)
+	{
+		Queue& victim = *queues[(queueIndex + i) % queueCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty())
+		{
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+			queuedJobs--;
+			own.steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::Execute(unsigned int queueIndex, Job& job)
+{
+	{
+		PROFILE_ZONE("Job");
+		job.work();
+	}
+	queues[queueIndex]->jobsRun.fetch_add(1, std::memory_order_relaxed);
+
+	if (job.counter)
+		Finish(job.counter);
+}
+
+// --------------------------------------------------------
+// Counts a job as done, queueing anything that waited on it
+//
+// - The count drops under the counter's lock, so whoever sees
+//   it reach zero and takes the lock knows this is done with
+//   the counter, and can free it
+// --------------------------------------------------------
+void JobSystem::Finish(JobCounter* counter)
+{
+	std::vector<JobCounter::Continuation> ready;
+	{
+		std::lock_guard<std::mutex> lock(counter->mutex);
+		if (--counter->pending == 0)
+			ready.swap(counter->continuations);
+	}
+
+	for (JobCounter::Continuation& continuation : ready)
+		Push(Job{ std::move(continuation.work), continuation.counter });
+}
+
+void JobSystem::WorkerLoop(unsigned int queueIndex)
+{
+	currentSystem = this;
+	currentQueue = queueIndex;
+	Profiler::SetThreadName("Job Worker " + std::to_string(queueIndex));
+
+	while (!stopping)
+	{
+		Job job;
+		if (TryGetJob(queueIndex, job))
+		{
+			Execute(queueIndex, job);
+			continue;
+		}
+
+		// Nothing to run or steal, so sleep until something is queued
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleepingWorkers++;
+		workAvailable.wait(lock, [this]() { return stopping || queuedJobs.load() > 0; });
+		sleepingWorkers--;
+	}
+}
@@ -0,0 +1,169 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// --------------------------------------------------------
+// Totals since the job system started
+//
+// - steals counts jobs taken from another thread's deque,
+//   which is how the load gets evened out
+// --------------------------------------------------------
+struct JobSystemStats
+{
+	unsigned int threads;
+	unsigned long long jobs;
+	unsigned long long steals;
+};
+
+// --------------------------------------------------------
+// Counts a group of jobs that haven't finished yet
+//
+// - Run() adds one, and the job finishing takes it away
+// - Jobs given to JobSystem::RunAfter() wait for it to reach
+//   zero, so a counter is also a dependency
+// - Must outlive its jobs. JobSystem::Wait() makes sure of it
+// --------------------------------------------------------
+class JobCounter
+{
+public:
+	JobCounter();
+	bool IsDone();
+
+private:
+	friend class JobSystem;
+
+	struct Continuation
+	{
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	std::atomic<unsigned int> pending;
+	std::mutex mutex;
+	std::vector<Continuation> continuations;
+};
+
+// --------------------------------------------------------
+// Runs short jobs across a fixed set of worker threads
+//
+// - Each thread has its own deque. It pushes and pops its own
+//   jobs at the back (newest first, while they're in cache),
+//   and an idle thread steals from the front of another's
+//   (oldest first, which for ParallelFor is the biggest)
+// - Threads that aren't workers, like the main thread, share
+//   one extra deque, and help run jobs while they Wait()
+// - ParallelFor() splits its range in half until it's small
+//   enough, pushing one half each time, so idle threads can
+//   steal big pieces and splitting is spread across threads
+// - Workers with nothing to do or steal sleep until a job is
+//   queued, so an idle job system costs nothing
+// - Jobs still queued on shutdown are dropped
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class JobSystem
+{
+public:
+	// A threadCount of 0 uses every hardware thread. The thread that
+	// waits is one of them, so this starts threadCount - 1 workers
+	explicit JobSystem(unsigned int threadCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Queues a job, counted by counter if there is one
+	void Run(std::function<void()> work, JobCounter* counter = nullptr);
+
+	// Queues a job once dependency reaches zero (straight away if it has)
+	void RunAfter(JobCounter& dependency, std::function<void()> work, JobCounter* counter = nullptr);
+
+	// Runs queued jobs until counter reaches zero
+	void Wait(JobCounter& counter);
+
+	// Calls work(first, end) over ranges covering [0, count), none smaller
+	// than minPerJob unless count is. Returns once every range is done
+	template<typename Work>
+	void ParallelFor(unsigned int count, unsigned int minPerJob, Work work);
+
+	unsigned int GetThreadCount() const;
+	JobSystemStats GetStats() const;
+
+private:
+	struct Job
+	{
+		std::function<void()> work;
+		JobCounter* counter;
+	};
+
+	// Padded, so threads updating their own counts don't share a cache line
+	struct alignas(64) Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+		std::atomic<unsigned long long> jobsRun;
+		std::atomic<unsigned long long> steals;
+	};
+
+	// Queue 0 is for threads that aren't workers
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+
+	// Sleeping workers
+	std::atomic<unsigned int> queuedJobs;
+	std::atomic<unsigned int> sleepingWorkers;
+	std::atomic<bool> stopping;
+	std::mutex sleepMutex;
+	std::condition_variable workAvailable;
+
+	unsigned int GetQueueIndex() const;
+	void Push(Job job);
+	bool TryGetJob(unsigned int queueIndex, Job& job);
+	void Execute(unsigned int queueIndex, Job& job);
+	void Finish(JobCounter* counter);
+	void WorkerLoop(unsigned int queueIndex);
+};
+
+// --------------------------------------------------------
+// Splits [0, count) in half until another split would leave
+// a piece smaller than minPerJob
+//
+// - Pieces end up from minPerJob to just under twice that
+// - Each split pushes the upper half as its own job and keeps
+//   going with the lower half, so a thread that steals the
+//   upper half goes on splitting it for others
+// --------------------------------------------------------
+template<typename Work>
+void JobSystem::ParallelFor(unsigned int count, unsigned int minPerJob, Work work)
+{
+	if (minPerJob < 1)
+		minPerJob = 1;
+
+	// Not worth a job, or nobody else to run it
+	if (count <= minPerJob || workers.empty())
+	{
+		if (count > 0)
+			work(0u, count);
+		return;
+	}
+
+	JobCounter counter;
+	std::function<void(unsigned int, unsigned int)> split = [&](unsigned int first, unsigned int end)
+		{
+			while ((end - first) / 2 >= minPerJob)
+			{
+				unsigned int middle = first + (end - first) / 2;
+				Run([&split, middle, end]() { split(middle, end); }, &counter);
+				end = middle;
+			}
+			work(first, end);
+		};
+
+	split(0, count);
+	Wait(counter);
+}
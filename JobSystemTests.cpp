@@ -0,0 +1,338 @@
+// --------------------------------------------------------
+// Tests and benchmark for JobSystem
+//
+// - Checks ParallelFor's splitting, RunAfter's ordering,
+//   waiting from inside a job and shutting down with jobs
+//   still queued, at several thread counts
+// - Given "bench", also measures job throughput and how
+//   ParallelFor scales with threads, with steal counts
+// - Not part of the Visual Studio project. On Linux it's the
+//   jobsystem_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 JobSystemTests.cpp JobSystem.cpp
+//       Profiler.cpp -lpthread -o jobsystem_tests
+// - Usage: jobsystem_tests [bench]
+// --------------------------------------------------------
+#include "JobSystem.h"
+#include "TestChecks.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	double GetSeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// --------------------------------------------------------
+	// Every index is covered exactly once, and every range is
+	// at least minPerJob long (unless count is shorter) and
+	// less than twice that
+	//
+	// - With no workers there's nobody to split for, so the
+	//   whole range is one call
+	// --------------------------------------------------------
+	void TestParallelForSplitting(JobSystem& jobSystem)
+	{
+		const unsigned int counts[] = { 0, 1, 63, 64, 65, 127, 128, 1000, 100000 };
+		const unsigned int minimums[] = { 0, 1, 64, 256 };
+
+		for (unsigned int count : counts)
+		{
+			for (unsigned int minPerJob : minimums)
+			{
+				std::vector<std::atomic<unsigned int>> hits(count);
+				std::mutex rangesMutex;
+				std::vector<std::pair<unsigned int, unsigned int>> ranges;
+
+				jobSystem.ParallelFor(count, minPerJob, [&](unsigned int first, unsigned int end)
+					{
+						for (unsigned int i = first; i < end; i++)
+							hits[i]++;
+
+						std::lock_guard<std::mutex> lock(rangesMutex);
+						ranges.push_back(std::make_pair(first, end));
+					});
+
+				bool coveredOnce = true;
+				for (unsigned int i = 0; i < count; i++)
+					coveredOnce = coveredOnce && hits[i] == 1;
+				CHECK(coveredOnce);
+
+				unsigned int minimum = minPerJob > 0 ? minPerJob : 1;
+				for (const std::pair<unsigned int, unsigned int>& range : ranges)
+				{
+					unsigned int size = range.second - range.first;
+					if (count <= minimum || jobSystem.GetThreadCount() == 1)
+						CHECK(size == count);
+					else
+						CHECK(size >= minimum && size < minimum * 2);
+				}
+				CHECK(count > 0 || ranges.empty());
+			}
+		}
+	}
+
+	// A ParallelFor inside a ParallelFor's range waits inside a job
+	void TestParallelForNested(JobSystem& jobSystem)
+	{
+		const unsigned int outer = 64;
+		const unsigned int inner = 500;
+		std::vector<std::atomic<unsigned int>> hits(outer * inner);
+
+		jobSystem.ParallelFor(outer, 1, [&](unsigned int first, unsigned int end)
+			{
+				for (unsigned int o = first; o < end; o++)
+				{
+					jobSystem.ParallelFor(inner, 16, [&, o](unsigned int innerFirst, unsigned int innerEnd)
+						{
+							for (unsigned int i = innerFirst; i < innerEnd; i++)
+								hits[o * inner + i]++;
+						});
+				}
+			});
+
+		bool coveredOnce = true;
+		for (std::atomic<unsigned int>& hit : hits)
+			coveredOnce = coveredOnce && hit == 1;
+		CHECK(coveredOnce);
+	}
+
+	// --------------------------------------------------------
+	// Continuations only start once every job they depend on
+	// has finished, including down a chain of them
+	// --------------------------------------------------------
+	void TestRunAfterOrdering(JobSystem& jobSystem)
+	{
+		const unsigned int firstJobs = 16;
+		std::atomic<unsigned int> firstFinished(0);
+		std::atomic<unsigned int> seenBySecond(0xFFFFFFFFu);
+		std::atomic<bool> secondFinished(false);
+		std::atomic<bool> secondSeenByThird(false);
+
+		JobCounter first;
+		JobCounter second;
+		JobCounter third;
+		for (unsigned int j = 0; j < firstJobs; j++)
+		{
+			jobSystem.Run([&]()
+				{
+					std::this_thread::sleep_for(std::chrono::microseconds(200));
+					firstFinished++;
+				}, &first);
+		}
+
+		jobSystem.RunAfter(first, [&]()
+			{
+				seenBySecond = firstFinished.load();
+				secondFinished = true;
+			}, &second);
+
+		jobSystem.RunAfter(second, [&]()
+			{
+				secondSeenByThird = secondFinished.load();
+			}, &third);
+
+		jobSystem.Wait(third);
+		CHECK(seenBySecond == firstJobs);
+		CHECK(secondSeenByThird);
+		CHECK(first.IsDone() && second.IsDone() && third.IsDone());
+
+		// A dependency that's already done doesn't hold anything up
+		std::atomic<bool> ran(false);
+		JobCounter after;
+		jobSystem.RunAfter(first, [&]() { ran = true; }, &after);
+		jobSystem.Wait(after);
+		CHECK(ran);
+	}
+
+	// --------------------------------------------------------
+	// Jobs that queue more jobs and wait for them, three deep,
+	// finish even when there are fewer threads than waiters
+	// --------------------------------------------------------
+	void SpawnAndWait(JobSystem& jobSystem, unsigned int depth, std::atomic<unsigned int>& leaves)
+	{
+		if (depth == 0)
+		{
+			leaves++;
+			return;
+		}
+
+		JobCounter children;
+		for (unsigned int c = 0; c < 4; c++)
+			jobSystem.Run([&jobSystem, depth, &leaves]() { SpawnAndWait(jobSystem, depth - 1, leaves); }, &children);
+		jobSystem.Wait(children);
+	}
+
+	void TestWaitInsideJob(JobSystem& jobSystem)
+	{
+		std::atomic<unsigned int> leaves(0);
+		JobCounter root;
+		jobSystem.Run([&]() { SpawnAndWait(jobSystem, 3, leaves); }, &root);
+		jobSystem.Wait(root);
+		CHECK(leaves == 4 * 4 * 4);
+	}
+
+	// Every job run is counted, and a job can only be stolen once
+	void TestStats(unsigned int threadCount)
+	{
+		JobSystem jobSystem(threadCount);
+		CHECK(jobSystem.GetThreadCount() == threadCount);
+
+		JobCounter counter;
+		for (unsigned int j = 0; j < 1000; j++)
+			jobSystem.Run([]() {}, &counter);
+		jobSystem.Wait(counter);
+
+		JobSystemStats stats = jobSystem.GetStats();
+		CHECK(stats.threads == threadCount);
+		CHECK(stats.jobs == 1000);
+		CHECK(stats.steals <= stats.jobs);
+		CHECK(threadCount > 1 || stats.steals == 0);
+		printf("  %u threads: 1000 jobs, %llu stolen\n", threadCount, stats.steals);
+	}
+
+	// --------------------------------------------------------
+	// Destroying the system with jobs still queued drops them:
+	// it returns, never runs them, and frees what they held
+	// --------------------------------------------------------
+	void TestShutdownWithQueuedJobs()
+	{
+		const unsigned int threadCount = 3;
+		const unsigned int queuedCount = 100;
+
+		std::atomic<unsigned int> blocked(0);
+		std::atomic<bool> release(false);
+		std::atomic<unsigned int> ran(0);
+		std::shared_ptr<int> held = std::make_shared<int>(0);
+		std::thread releaser;
+		{
+			JobSystem jobSystem(threadCount);
+
+			// Keep every worker busy, so nothing else gets picked up
+			for (unsigned int w = 0; w < threadCount - 1; w++)
+			{
+				jobSystem.Run([&]()
+					{
+						blocked++;
+						while (!release)
+							std::this_thread::yield();
+					});
+			}
+
+			double deadline = GetSeconds() + 5.0;
+			while (blocked < threadCount - 1 && GetSeconds() < deadline)
+				std::this_thread::yield();
+			CHECK(blocked == threadCount - 1);
+
+			for (unsigned int j = 0; j < queuedCount; j++)
+				jobSystem.Run([&ran, held]() { ran++; });
+			CHECK(held.use_count() == queuedCount + 1);
+
+			// Let the workers go once the destructor has started stopping them
+			releaser = std::thread([&]()
+				{
+					std::this_thread::sleep_for(std::chrono::milliseconds(20));
+					release = true;
+				});
+		}
+		releaser.join();
+
+		CHECK(ran == 0);
+		CHECK(held.use_count() == 1);
+	}
+
+	void RunTests(unsigned int threadCount)
+	{
+		JobSystem jobSystem(threadCount);
+		TestParallelForSplitting(jobSystem);
+		TestParallelForNested(jobSystem);
+		TestRunAfterOrdering(jobSystem);
+		TestWaitInsideJob(jobSystem);
+
+		JobSystemStats stats = jobSystem.GetStats();
+		printf("  %u threads: %llu jobs, %llu stolen\n", threadCount, stats.jobs, stats.steals);
+	}
+
+	// --------------------------------------------------------
+	// Throughput of tiny jobs, and ParallelFor's speedup over
+	// one thread, at each thread count
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		const unsigned int tinyJobs = 200000;
+		const unsigned int elements = 1 << 22;
+		const unsigned int passes = 10;
+		std::vector<float> values(elements, 1.0f);
+
+		unsigned int hardwareThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+		std::vector<unsigned int> threadCounts = { 1, 2, 4, 8 };
+		if (hardwareThreads > 8)
+			threadCounts.push_back(hardwareThreads);
+
+		printf("\nThreads  Tiny jobs/s  ParallelFor ms  Speedup  Jobs  Stolen\n");
+		double oneThreadSeconds = 0.0;
+		for (unsigned int threadCount : threadCounts)
+		{
+			JobSystem jobSystem(threadCount);
+
+			double start = GetSeconds();
+			JobCounter counter;
+			for (unsigned int j = 0; j < tinyJobs; j++)
+				jobSystem.Run([]() {}, &counter);
+			jobSystem.Wait(counter);
+			double tinySeconds = GetSeconds() - start;
+
+			JobSystemStats before = jobSystem.GetStats();
+			start = GetSeconds();
+			for (unsigned int p = 0; p < passes; p++)
+			{
+				jobSystem.ParallelFor(elements, 4096, [&](unsigned int first, unsigned int end)
+					{
+						for (unsigned int i = first; i < end; i++)
+							values[i] = sqrtf(values[i] * 1.0001f + 0.5f);
+					});
+			}
+			double forSeconds = (GetSeconds() - start) / passes;
+			JobSystemStats after = jobSystem.GetStats();
+
+			if (threadCount == 1)
+				oneThreadSeconds = forSeconds;
+
+			printf("%7u  %11.0f  %14.3f  %6.2fx  %4llu  %6llu\n",
+				threadCount,
+				tinyJobs / tinySeconds,
+				forSeconds * 1000.0,
+				forSeconds > 0.0 ? oneThreadSeconds / forSeconds : 0.0,
+				(after.jobs - before.jobs) / passes,
+				(after.steals - before.steals) / passes);
+		}
+		printf("(%u hardware threads; jobs and steals are per ParallelFor)\n", hardwareThreads);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	for (unsigned int threadCount : { 1u, 2u, 4u, 8u })
+		RunTests(threadCount);
+
+	for (unsigned int threadCount : { 1u, 4u })
+		TestStats(threadCount);
+
+	TestShutdownWithQueuedJobs();
+
+	int result = TestChecks::Finish("JobSystem");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
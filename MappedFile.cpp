@@ -0,0 +1,165 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+	data(nullptr),
+	size(0),
+#ifdef _WIN32
+	fileHandle(nullptr),
+	mappingHandle(nullptr)
+#else
+	fileDescriptor(-1)
+#endif
+{
+}
+
+MappedFile::MappedFile(const char* fileName) : MappedFile()
+{
+	Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+// --------------------------------------------------------
+// Maps the whole file into memory as read-only
+//
+// - Returns false if the file can't be opened or mapped
+// - An empty file opens successfully with a null data pointer
+// --------------------------------------------------------
+bool MappedFile::Open(const char* fileName)
+{
+	// Release any previous mapping
+	Close();
+
+#ifdef _WIN32
+	// Open the file for sequential reading
+	HANDLE file = CreateFileA(
+		fileName,
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize))
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	size = (size_t)fileSize.QuadPart;
+
+	// Windows can't map a zero-byte file, so there's nothing else to do
+	if (size == 0)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		Close();
+		return false;
+	}
+	mappingHandle = mapping;
+
+	data = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!data)
+	{
+		Close();
+		return false;
+	}
+#else
+	int fd = open(fileName, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat fileStats = {};
+	if (fstat(fd, &fileStats) != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	fileDescriptor = fd;
+	size = (size_t)fileStats.st_size;
+
+	// Zero-length mappings are invalid, so there's nothing else to do
+	if (size == 0)
+		return true;
+
+	void* view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (view == MAP_FAILED)
+	{
+		Close();
+		return false;
+	}
+	data = (const char*)view;
+
+	// We read front to back, so let the kernel read ahead aggressively
+	madvise(view, size, MADV_SEQUENTIAL);
+#endif
+
+	return true;
+}
+
+// --------------------------------------------------------
+// Unmaps the view and closes all handles
+// --------------------------------------------------------
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (data)
+		UnmapViewOfFile(data);
+	if (mappingHandle)
+		CloseHandle((HANDLE)mappingHandle);
+	if (fileHandle)
+		CloseHandle((HANDLE)fileHandle);
+
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+#else
+	if (data)
+		munmap((void*)data, size);
+	if (fileDescriptor >= 0)
+		close(fileDescriptor);
+
+	fileDescriptor = -1;
+#endif
+
+	data = nullptr;
+	size = 0;
+}
+
+bool MappedFile::IsOpen() const
+{
+#ifdef _WIN32
+	return fileHandle != nullptr;
+#else
+	return fileDescriptor >= 0;
+#endif
+}
+
+const char* MappedFile::GetData() const
+{
+	return this->data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return this->size;
+}
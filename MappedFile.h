@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+
+// --------------------------------------------------------
+// A read-only, memory-mapped view of an entire file
+//
+// - Has no DirectX dependency so it can be used by the
+//   asset tools on any platform (Win32 or POSIX)
+// - The mapping is released when the object is destroyed
+// --------------------------------------------------------
+class MappedFile
+{
+private:
+	const char* data;
+	size_t size;
+
+#ifdef _WIN32
+	void* fileHandle;
+	void* mappingHandle;
+#else
+	int fileDescriptor;
+#endif
+
+public:
+	MappedFile();
+	explicit MappedFile(const char* fileName);
+	~MappedFile();
+
+	// Mappings own OS handles, so they can't be copied
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool Open(const char* fileName);
+	void Close();
+
+	// Getters
+	bool IsOpen() const;
+	const char* GetData() const;
+	size_t GetSize() const;
+};
@@ -1,4 +1,5 @@
 #include "Material.h"
+#include "Profiler.h"
 
 Material::Material(
     DirectX::XMFLOAT3 colorTint,
@@ -92,8 +93,11 @@ void Material::SetVertexShader(std::shared_ptr<SimpleVertexShader> vertexShader)
 
 // --------------------------------------------------------
 // Add a ShaderResourceView to the map associated with a string
+//
+// - Takes a handle so a texture can still be loading; its
+//   placeholder is bound until then
 // --------------------------------------------------------
-void Material::AddTextureSRV(std::string key, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> value)
+void Material::AddTextureSRV(std::string key, TextureHandle value)
 {
     textureSRVs.insert({ key, value });
 }
@@ -107,14 +111,25 @@ void Material::AddSamplerState(std::string key, Microsoft::WRL::ComPtr<ID3D11Sam
     textureSamplers.insert({ key, value });
 }
 
-void Material::PrepareMaterial(Transform* transform, DirectX::XMFLOAT3 ambientTerm, float totalTime)
+// --------------------------------------------------------
+// Set the shaders and their per-entity data
+// 
+// - vertexShaderOverride replaces the material's vertex shader,
+//   for meshes whose vertex format it can't read
+// --------------------------------------------------------
+void Material::PrepareMaterial(Transform* transform, DirectX::XMFLOAT3 ambientTerm, float totalTime,
+    std::shared_ptr<SimpleVertexShader> vertexShaderOverride)
 {
+    PROFILE_ZONE("PrepareMaterial");
+
+    std::shared_ptr<SimpleVertexShader> activeVertexShader = vertexShaderOverride ? vertexShaderOverride : vertexShader;
+
     // Set shaders
     pixelShader->SetShader();
-    vertexShader->SetShader();
+    activeVertexShader->SetShader();
 
     // Update textures
-    for (auto& t : textureSRVs) { pixelShader->SetShaderResourceView(t.first.c_str(), t.second); }
+    for (auto& t : textureSRVs) { pixelShader->SetShaderResourceView(t.first.c_str(), t.second.Get()); }
     for (auto& s : textureSamplers) { pixelShader->SetSamplerState(s.first.c_str(), s.second); }
 
     // Update pixel shader info for each entity
@@ -126,10 +141,12 @@ void Material::PrepareMaterial(Transform* transform, DirectX::XMFLOAT3 ambientTe
     pixelShader->SetFloat("scale", scale);
     
 
-    // Update vertex shader info for each entity
-    vertexShader->SetMatrix4x4("world", transform->GetWorldMatrix());
-    vertexShader->SetMatrix4x4("worldInvTranspose", transform->GetWorldInverseTransposeMatrix());
+    // Update vertex shader info for each entity (as 3x4s, see AffineMatrix.h)
+    AffineMatrix world = transform->GetWorldAffine();
+    AffineMatrix worldInvTranspose = transform->GetWorldInverseTransposeAffine();
+    activeVertexShader->SetData("world", &world, sizeof(AffineMatrix));
+    activeVertexShader->SetData("worldInvTranspose", &worldInvTranspose, sizeof(AffineMatrix));
 
     pixelShader->CopyBufferData("EntityData");
-    vertexShader->CopyBufferData("EntityData");
+    activeVertexShader->CopyBufferData("EntityData");
 }
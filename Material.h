@@ -2,9 +2,13 @@
 #include <DirectXMath.h>
 #include <memory>
 
+#include "AssetLoader.h"
 #include "SimpleShader.h"
 #include "Transform.h"
 
+// A texture that may still be loading (see AssetLoader.h)
+using TextureHandle = AssetHandle<Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>>;
+
 class Material
 {
 private:
@@ -17,7 +21,7 @@ private:
 	std::shared_ptr<SimpleVertexShader> vertexShader;
 
 	// Textures
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>> textureSRVs;
+	std::unordered_map<std::string, TextureHandle> textureSRVs;
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D11SamplerState>> textureSamplers;
 
 public:
@@ -48,10 +52,11 @@ public:
 	void SetScale(float scale);
 	void SetPixelShader(std::shared_ptr<SimplePixelShader> pixelShader);
 	void SetVertexShader(std::shared_ptr<SimpleVertexShader> vertexShader);
-	void AddTextureSRV(std::string key, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> value);
+	void AddTextureSRV(std::string key, TextureHandle value);
 	void AddSamplerState(std::string key, Microsoft::WRL::ComPtr<ID3D11SamplerState> value);
 
 	// Functions
-	void PrepareMaterial(Transform* transform, DirectX::XMFLOAT3 ambientTerm, float totalTime);
+	void PrepareMaterial(Transform* transform, DirectX::XMFLOAT3 ambientTerm, float totalTime,
+		std::shared_ptr<SimpleVertexShader> vertexShaderOverride = nullptr);
 };
 
@@ -1,18 +1,45 @@
 #include "Mesh.h"
-#include <fstream>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <string>
 
 using namespace DirectX;
 
+// The OBJ parser writes vertices that are reinterpreted as Vertex
+static_assert(sizeof(ObjVertex) == sizeof(Vertex), "ObjVertex must match Vertex");
+static_assert(offsetof(ObjVertex, Normal) == offsetof(Vertex, Normal), "ObjVertex must match Vertex");
+static_assert(offsetof(ObjVertex, Tangent) == offsetof(Vertex, Tangent), "ObjVertex must match Vertex");
+static_assert(offsetof(ObjVertex, UV) == offsetof(Vertex, UV), "ObjVertex must match Vertex");
+
 Mesh::Mesh(
 	Microsoft::WRL::ComPtr<ID3D11DeviceContext>	_context,
 	Microsoft::WRL::ComPtr<IDXGISwapChain> _swapChain,
 	Microsoft::WRL::ComPtr<ID3D11Device> _device,
-	Vertex* meshVertices, unsigned int* meshIndices, unsigned int numVertices, unsigned int numIndices)
-	: context(_context), swapChain(_swapChain), device(_device)
+	Vertex* meshVertices, unsigned int* meshIndices, unsigned int numVertices, unsigned int numIndices,
+	VertexFormat vertexFormat,
+	MeshCPUData cpuData)
+	: context(_context), swapChain(_swapChain), device(_device),
+	cpuData(cpuData), boundsMin(0, 0, 0), boundsMax(0, 0, 0),
+	vertexFormat(vertexFormat), vertexStride(sizeof(Vertex)), indexFormat(DXGI_FORMAT_R32_UINT),
+	positionScale(1, 1, 1), positionOffset(0, 0, 0), uvScale(1, 1), uvOffset(0, 0),
+	compressionStats(), vertexBufferBytes(0), indexBufferBytes(0),
+	loadStats(), optimizerStats(), simplifierStats(), meshletStats(), tangentStats(), streamStats(), loadSeconds(0.0), loadPeakResidentBytes(0), loadedFromCookedFile(false),
+	skinningMode(SkinningMode::CPU), skinningStats(), morphStats(), morphWeightsChanged(false),
+	arenaAllocation(GeometryArena::InvalidAllocation)
 {
 	// Calculate tangents
 	CalculateTangents(meshVertices, numVertices, meshIndices, numIndices);
 
+	// Calculate bounds
+	CalculateBounds(meshVertices, numVertices);
+
+	// Group the triangles into culling clusters
+	MeshletBuilder::BuildMeshlets(meshIndices, numIndices, meshVertices, numVertices, sizeof(Vertex), meshlets, &meshletStats);
+
 	// Create Buffers
 	CreateBuffers(meshVertices, numVertices, meshIndices, numIndices);
 }
@@ -20,306 +47,248 @@ Mesh::Mesh(
 Mesh::Mesh(Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context,
 	Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain,
 	Microsoft::WRL::ComPtr<ID3D11Device> device,
-	const char* fileName)
+	const char* fileName,
+	VertexFormat vertexFormat,
+	MeshCPUData cpuData)
+	: cpuData(cpuData), boundsMin(0, 0, 0), boundsMax(0, 0, 0),
+	vertexFormat(vertexFormat), vertexStride(sizeof(Vertex)), indexFormat(DXGI_FORMAT_R32_UINT),
+	positionScale(1, 1, 1), positionOffset(0, 0, 0), uvScale(1, 1), uvOffset(0, 0),
+	compressionStats(), vertexBufferBytes(0), indexBufferBytes(0),
+	loadStats(), optimizerStats(), simplifierStats(), meshletStats(), tangentStats(), streamStats(), loadSeconds(0.0), loadPeakResidentBytes(0), loadedFromCookedFile(false),
+	skinningMode(SkinningMode::CPU), skinningStats(), morphStats(), morphWeightsChanged(false),
+	arenaAllocation(GeometryArena::InvalidAllocation)
 {
 	this->context = context;
 	this->swapChain = swapChain;
 	this->device = device;
 
-	// Object loading code by Chris Cascioli
-	// File input object
-	std::ifstream obj(fileName);
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 
-	// Check for successful open
-	if (!obj.is_open())
+	// Files too large to parse in memory are streamed instead (see ObjStreamImporter.h)
+	std::error_code sizeError;
+	unsigned long long fileSize = std::filesystem::file_size(fileName, sizeError);
+	if (!sizeError && fileSize >= ObjStreamImporter::DefaultThresholdBytes)
+	{
+		LoadStreamed(fileName);
+		loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		loadPeakResidentBytes = ObjStreamImporter::GetPeakResidentBytes();
 		return;
+	}
 
-	// Variables used while reading the file
-	std::vector<XMFLOAT3> positions;	// Positions from the file
-	std::vector<XMFLOAT3> normals;		// Normals from the file
-	std::vector<XMFLOAT2> uvs;		// UVs from the file
-	std::vector<Vertex> verts;		// Verts we're assembling
-	std::vector<UINT> indices;		// Indices of these verts
-	int vertCounter = 0;			// Count of vertices
-	int indexCounter = 0;			// Count of indices
-	char chars[100];			// String for line reading
-
-	// Still have data left?
-	while (obj.good())
-	{
-		// Get the line (100 characters should be more than enough)
-		obj.getline(chars, 100);
+	// Map the source file - its hash decides whether the cooked file is still valid
+	MappedFile source;
+	if (!source.Open(fileName))
+		return;
 
-		// Check the type of line
-		if (chars[0] == 'v' && chars[1] == 'n')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 norm;
-			sscanf_s(
-				chars,
-				"vn %f %f %f",
-				&norm.x, &norm.y, &norm.z);
-
-			// Add to the list of normals
-			normals.push_back(norm);
-		}
-		else if (chars[0] == 'v' && chars[1] == 't')
-		{
-			// Read the 2 numbers directly into an XMFLOAT2
-			XMFLOAT2 uv;
-			sscanf_s(
-				chars,
-				"vt %f %f",
-				&uv.x, &uv.y);
-
-			// Add to the list of uv's
-			uvs.push_back(uv);
-		}
-		else if (chars[0] == 'v')
-		{
-			// Read the 3 numbers directly into an XMFLOAT3
-			XMFLOAT3 pos;
-			sscanf_s(
-				chars,
-				"v %f %f %f",
-				&pos.x, &pos.y, &pos.z);
-
-			// Add to the positions
-			positions.push_back(pos);
-		}
-		else if (chars[0] == 'f')
-		{
-			// Read the face indices into an array
-			// NOTE: This assumes the given obj file contains
-			//  vertex positions, uv coordinates AND normals.
-			unsigned int i[12];
-			int numbersRead = sscanf_s(
-				chars,
-				"f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d",
-				&i[0], &i[1], &i[2],
-				&i[3], &i[4], &i[5],
-				&i[6], &i[7], &i[8],
-				&i[9], &i[10], &i[11]);
-
-			// If we only got the first number, chances are the OBJ
-			// file has no UV coordinates.  This isn't great, but we
-			// still want to load the model without crashing, so we
-			// need to re-read a different pattern (in which we assume
-			// there are no UVs denoted for any of the vertices)
-			if (numbersRead == 1)
-			{
-				// Re-read with a different pattern
-				numbersRead = sscanf_s(
-					chars,
-					"f %d//%d %d//%d %d//%d %d//%d",
-					&i[0], &i[2],
-					&i[3], &i[5],
-					&i[6], &i[8],
-					&i[9], &i[11]);
-
-				// The following indices are where the UVs should 
-				// have been, so give them a valid value
-				i[1] = 1;
-				i[4] = 1;
-				i[7] = 1;
-				i[10] = 1;
-
-				// If we have no UVs, create a single UV coordinate
-				// that will be used for all vertices
-				if (uvs.size() == 0)
-					uvs.push_back(XMFLOAT2(0, 0));
-			}
+	unsigned long long sourceHash = CookedMesh::HashData(source.GetData(), source.GetSize());
+	std::string cookedPath = CookedMesh::GetCookedPath(fileName);
 
-			// - Create the verts by looking up
-			//    corresponding data from vectors
-			// - OBJ File indices are 1-based, so
-			//    they need to be adusted
-			Vertex v1;
-			v1.Position = positions[i[0] - 1];
-			v1.UV = uvs[i[1] - 1];
-			v1.Normal = normals[i[2] - 1];
-
-			Vertex v2;
-			v2.Position = positions[i[3] - 1];
-			v2.UV = uvs[i[4] - 1];
-			v2.Normal = normals[i[5] - 1];
-
-			Vertex v3;
-			v3.Position = positions[i[6] - 1];
-			v3.UV = uvs[i[7] - 1];
-			v3.Normal = normals[i[8] - 1];
-
-			// Flip the UV's since they're probably "upside down"
-			v1.UV.y = 1.0f - v1.UV.y;
-			v2.UV.y = 1.0f - v2.UV.y;
-			v3.UV.y = 1.0f - v3.UV.y;
-
-			// Flip Z (LH vs. RH)
-			v1.Position.z *= -1.0f;
-			v2.Position.z *= -1.0f;
-			v3.Position.z *= -1.0f;
-
-			// Flip normal's Z
-			v1.Normal.z *= -1.0f;
-			v2.Normal.z *= -1.0f;
-			v3.Normal.z *= -1.0f;
-
-			// Add the verts to the vector (flipping the winding order)
-			verts.push_back(v1);
-			verts.push_back(v3);
-			verts.push_back(v2);
-			vertCounter += 3;
-
-			// Add three more indices
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-			indices.push_back(indexCounter); indexCounter += 1;
-
-			// Was there a 4th face?
-			// - 12 numbers read means 4 faces WITH uv's
-			// - 8 numbers read means 4 faces WITHOUT uv's
-			if (numbersRead == 12 || numbersRead == 8)
-			{
-				// Make the last vertex
-				Vertex v4;
-				v4.Position = positions[i[9] - 1];
-				v4.UV = uvs[i[10] - 1];
-				v4.Normal = normals[i[11] - 1];
-
-				// Flip the UV, Z pos and normal's Z
-				v4.UV.y = 1.0f - v4.UV.y;
-				v4.Position.z *= -1.0f;
-				v4.Normal.z *= -1.0f;
-
-				// Add a whole triangle (flipping the winding order)
-				verts.push_back(v1);
-				verts.push_back(v4);
-				verts.push_back(v3);
-				vertCounter += 3;
-
-				// Add three more indices
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-				indices.push_back(indexCounter); indexCounter += 1;
-			}
-		}
+	// Try to map the cooked file and upload straight from it (no parsing)
+	CookedMesh cooked;
+	if (cooked.Open(cookedPath.c_str(), sourceHash, source.GetSize(), sizeof(Vertex)))
+	{
+		CreateBuffersFromCookedFile(cooked);
+		loadedFromCookedFile = true;
+	}
+	else
+	{
+		// Parse the mapped OBJ text (see ObjParser.h)
+		ObjMeshData objData;
+		if (!ObjParser::Parse(source.GetData(), source.GetSize(), objData))
+			return;
+
+		// Save the parse stats so throughput can be displayed
+		this->loadStats = objData.stats;
+
+		// The parser's vertices share Vertex's memory layout
+		Vertex* verts = reinterpret_cast<Vertex*>(objData.vertices.data());
+		int vertCounter = (int)objData.vertices.size();
+		int indexCounter = (int)objData.indices.size();
+
+		// Reorder for the vertex cache, overdraw and vertex fetch (see MeshOptimizer.h)
+		vertCounter = (int)MeshOptimizer::OptimizeMesh(
+			verts, vertCounter, sizeof(Vertex),
+			&objData.indices[0], indexCounter,
+			&optimizerStats);
+
+		// Group the full mesh into culling clusters, which reorders its triangles (see MeshletBuilder.h)
+		MeshletBuilder::BuildMeshlets(&objData.indices[0], indexCounter, verts, vertCounter, sizeof(Vertex), meshlets, &meshletStats);
+
+		// Build the LOD chain, appending each LOD's indices (see MeshSimplifier.h)
+		MeshSimplifier::GenerateLODs(objData.indices, verts, vertCounter, sizeof(Vertex), lods, &simplifierStats);
+		int lodIndexCounter = (int)objData.indices.size();
+
+		// Calculate tangents (LODs share the vertices, so only the full mesh is needed)
+		CalculateTangents(verts, vertCounter, &objData.indices[0], indexCounter);
+
+		// Calculate bounds
+		CalculateBounds(verts, vertCounter);
+
+		// Cook the final data so the next launch can skip all of the above
+		CookedMesh::Write(
+			cookedPath.c_str(), sourceHash, source.GetSize(),
+			verts, vertCounter, sizeof(Vertex),
+			&objData.indices[0], lodIndexCounter,
+			lods.data(), (unsigned int)lods.size(),
+			meshlets.data(), (unsigned int)meshlets.size(),
+			&boundsMin.x, &boundsMax.x);
+
+		// Create buffers
+		CreateBuffers(verts, vertCounter, &objData.indices[0], lodIndexCounter);
 	}
 
-	// Close the file
-	obj.close();
+	loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	loadPeakResidentBytes = ObjStreamImporter::GetPeakResidentBytes();
+}
 
-	this->vertices = verts;
-	this->indices = indices;
+Mesh::~Mesh()
+{
+	if (arena)
+		arena->Remove(arenaAllocation);
+}
 
-	// Calculate tangents
-	CalculateTangents(&verts[0], vertCounter, &indices[0], indexCounter);
+// --------------------------------------------------------
+// Loads a source file too large to parse in memory
+//
+// - The source is hashed a window at a time rather than
+//   mapped, and only the cooked file is ever mapped; if it's
+//   missing or stale the streaming importer rebuilds it first
+// - The CPU copy is never kept, whatever cpuData asked for
+// --------------------------------------------------------
+void Mesh::LoadStreamed(const char* fileName)
+{
+	ObjStreamConfig config = ObjStreamImporter::GetDefaultConfig();
+	std::string cookedPath = CookedMesh::GetCookedPath(fileName);
+
+	unsigned long long sourceHash = 0;
+	unsigned long long sourceSize = 0;
+	if (!ObjStreamImporter::HashFile(fileName, config.windowBytes, sourceHash, sourceSize))
+		return;
+
+	CookedMesh cooked;
+	loadedFromCookedFile = cooked.Open(cookedPath.c_str(), sourceHash, sourceSize, sizeof(Vertex));
+	if (!loadedFromCookedFile)
+	{
+		if (!ObjStreamImporter::Import(fileName, cookedPath.c_str(), config, &streamStats) ||
+			!cooked.Open(cookedPath.c_str(), sourceHash, sourceSize, sizeof(Vertex)))
+			return;
+	}
 
-	// Create buffers
-	CreateBuffers(&verts[0], vertCounter, &indices[0], indexCounter);
+	cpuData = MeshCPUData::ReleaseAfterUpload;
+	CreateBuffersFromCookedFile(cooked);
 }
 
-Mesh::~Mesh()
+// --------------------------------------------------------
+// Takes the bounds, LODs and meshlets from a cooked file and
+// creates the buffers directly from its mapping
+// --------------------------------------------------------
+void Mesh::CreateBuffersFromCookedFile(const CookedMesh& cooked)
 {
+	const CookedMeshHeader* header = cooked.GetHeader();
+	boundsMin = XMFLOAT3(header->boundsMin);
+	boundsMax = XMFLOAT3(header->boundsMax);
+	lods.assign(cooked.GetLODs(), cooked.GetLODs() + cooked.GetLODCount());
+	meshlets.assign(cooked.GetMeshlets(), cooked.GetMeshlets() + cooked.GetMeshletCount());
+
+	CreateBuffers(
+		static_cast<const Vertex*>(cooked.GetVertexData()), cooked.GetVertexCount(),
+		cooked.GetIndices(), cooked.GetIndexCount());
 }
 
 // --------------------------------------------------------
-// Author: Chris Cascioli
-// Purpose: Calculates the tangents of the vertices in a mesh
-// 
-// - You are allowed to directly copy/paste this into your code base
-//   for assignments, given that you clearly cite that this is not
-//   code of your own design.
+// Calculates the tangents of the vertices in a mesh
 //
-// - Code originally adapted from: http://www.terathon.com/code/tangent.html
-//   - Updated version now found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
-//   - See listing 7.4 in section 7.5 (page 9 of the PDF)
-//
-// - Note: For this code to work, your Vertex format must
-//         contain an XMFLOAT3 called Tangent
+// - Uses the SSE, multithreaded TangentGenerator (see
+//   TangentGenerator.h); debug builds also run the original
+//   scalar version on a copy and record how far apart they are
 //
 // - Be sure to call this BEFORE creating your D3D vertex/index buffers
 // --------------------------------------------------------
 void Mesh::CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices)
 {
-	// Reset tangents
-	for (int i = 0; i < numVerts; i++)
-	{
-		verts[i].Tangent = XMFLOAT3(0, 0, 0);
-	}
+	// The generator works on the parser's vertices, which share Vertex's layout
+	ObjVertex* objVerts = reinterpret_cast<ObjVertex*>(verts);
+
+#if defined(DEBUG) || defined(_DEBUG)
+	std::vector<ObjVertex> reference(objVerts, objVerts + numVerts);
+	std::chrono::steady_clock::time_point referenceStart = std::chrono::steady_clock::now();
+	TangentGenerator::GenerateTangentsReference(reference.data(), numVerts, indices, numIndices);
+	double referenceSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - referenceStart).count();
+#endif
+
+	TangentGenerator::GenerateTangents(objVerts, numVerts, indices, numIndices, 0, &tangentStats);
+
+#if defined(DEBUG) || defined(_DEBUG)
+	tangentStats.referenceSeconds = referenceSeconds;
+	tangentStats.maxReferenceError = TangentGenerator::CompareTangents(objVerts, reference.data(), numVerts);
+#endif
+}
 
-	// Calculate tangents one whole triangle at a time
-	for (int i = 0; i < numIndices;)
+// --------------------------------------------------------
+// Calculates the local space axis-aligned bounds of the mesh
+// --------------------------------------------------------
+void Mesh::CalculateBounds(const Vertex* verts, int numVerts)
+{
+	if (numVerts <= 0)
 	{
-		// Grab indices and vertices of first triangle
-		unsigned int i1 = indices[i++];
-		unsigned int i2 = indices[i++];
-		unsigned int i3 = indices[i++];
-		Vertex* v1 = &verts[i1];
-		Vertex* v2 = &verts[i2];
-		Vertex* v3 = &verts[i3];
-
-		// Calculate vectors relative to triangle positions
-		float x1 = v2->Position.x - v1->Position.x;
-		float y1 = v2->Position.y - v1->Position.y;
-		float z1 = v2->Position.z - v1->Position.z;
-
-		float x2 = v3->Position.x - v1->Position.x;
-		float y2 = v3->Position.y - v1->Position.y;
-		float z2 = v3->Position.z - v1->Position.z;
-
-		// Do the same for vectors relative to triangle uv's
-		float s1 = v2->UV.x - v1->UV.x;
-		float t1 = v2->UV.y - v1->UV.y;
-
-		float s2 = v3->UV.x - v1->UV.x;
-		float t2 = v3->UV.y - v1->UV.y;
-
-		// Create vectors for tangent calculation
-		float r = 1.0f / (s1 * t2 - s2 * t1);
-
-		float tx = (t2 * x1 - t1 * x2) * r;
-		float ty = (t2 * y1 - t1 * y2) * r;
-		float tz = (t2 * z1 - t1 * z2) * r;
-
-		// Adjust tangents of each vert of the triangle
-		v1->Tangent.x += tx;
-		v1->Tangent.y += ty;
-		v1->Tangent.z += tz;
-
-		v2->Tangent.x += tx;
-		v2->Tangent.y += ty;
-		v2->Tangent.z += tz;
-
-		v3->Tangent.x += tx;
-		v3->Tangent.y += ty;
-		v3->Tangent.z += tz;
+		boundsMin = XMFLOAT3(0, 0, 0);
+		boundsMax = XMFLOAT3(0, 0, 0);
+		return;
 	}
 
-	// Ensure all of the tangents are orthogonal to the normals
-	for (int i = 0; i < numVerts; i++)
+	XMVECTOR minVec = XMLoadFloat3(&verts[0].Position);
+	XMVECTOR maxVec = minVec;
+	for (int i = 1; i < numVerts; i++)
 	{
-		// Grab the two vectors
-		XMVECTOR normal = XMLoadFloat3(&verts[i].Normal);
-		XMVECTOR tangent = XMLoadFloat3(&verts[i].Tangent);
-
-		// Use Gram-Schmidt orthonormalize to ensure
-		// the normal and tangent are exactly 90 degrees apart
-		tangent = XMVector3Normalize(
-			tangent - normal * XMVector3Dot(normal, tangent));
-
-		// Store the tangent
-		XMStoreFloat3(&verts[i].Tangent, tangent);
+		XMVECTOR pos = XMLoadFloat3(&verts[i].Position);
+		minVec = XMVectorMin(minVec, pos);
+		maxVec = XMVectorMax(maxVec, pos);
 	}
+
+	XMStoreFloat3(&boundsMin, minVec);
+	XMStoreFloat3(&boundsMax, maxVec);
 }
 
-void Mesh::CreateBuffers(Vertex* meshVertices, unsigned int numVertices, unsigned int* meshIndices, unsigned int numIndices)
+// --------------------------------------------------------
+// Creates the GPU buffers
+//
+// - Vertices are compressed here if the mesh uses a compact
+//   format, so cooked files always hold the full Vertex
+// - Indices drop to 16 bits whenever the vertex count allows
+// - The index data holds every LOD; without a LOD table it's
+//   all treated as LOD 0
+// - This is the only place the CPU copy is made, and only for
+//   meshes that keep it (see MeshCPUData)
+// --------------------------------------------------------
+void Mesh::CreateBuffers(const Vertex* meshVertices, unsigned int numVertices, const unsigned int* meshIndices, unsigned int numIndices)
 {
+	if (lods.empty())
+		lods.push_back({ 0, numIndices, 0.0f });
+
 	// Create a vertex buffer
 	{
+		// Compress the vertices for the compact formats
+		CompressedVertices compressed;
+		const void* vertexData = meshVertices;
+		if (VertexCompression::Compress(
+			reinterpret_cast<const ObjVertex*>(meshVertices), numVertices,
+			meshIndices, numIndices,
+			vertexFormat, compressed))
+		{
+			vertexData = compressed.data.data();
+			positionScale = XMFLOAT3(compressed.positionScale);
+			positionOffset = XMFLOAT3(compressed.positionOffset);
+			uvScale = XMFLOAT2(compressed.uvScale);
+			uvOffset = XMFLOAT2(compressed.uvOffset);
+			compressionStats = compressed.stats;
+		}
+		vertexStride = VertexCompression::GetStride(vertexFormat);
+		vertexBufferBytes = vertexStride * numVertices;
+
 		// Fill the buffer struct
 		D3D11_BUFFER_DESC vbd = {};
 		vbd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		vbd.ByteWidth = sizeof(Vertex) * numVertices;  // Multiply by the number of vertices in the buffer
+		vbd.ByteWidth = vertexBufferBytes;  // Stride multiplied by the number of vertices in the buffer
 		vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER; // Tells Direct3D this is a vertex buffer
 		vbd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
 		vbd.MiscFlags = 0;
@@ -327,7 +296,7 @@ void Mesh::CreateBuffers(Vertex* meshVertices, unsigned int numVertices, unsigne
 
 		// Specify the initial data for the buffer
 		D3D11_SUBRESOURCE_DATA initialVertexData = {};
-		initialVertexData.pSysMem = meshVertices; // pSysMem = Pointer to System Memory
+		initialVertexData.pSysMem = vertexData; // pSysMem = Pointer to System Memory
 
 		// Create the vertex buffer
 		device->CreateBuffer(&vbd, &initialVertexData, vertexBuffer.GetAddressOf());
@@ -335,19 +304,34 @@ void Mesh::CreateBuffers(Vertex* meshVertices, unsigned int numVertices, unsigne
 		// Set the size of the vertices array
 		this->numVertices = numVertices;
 
-		// Add vertices to the vector
-		for (unsigned int i = 0; i < numVertices; i++)
-		{
-			vertices.push_back(meshVertices[i]);
-		}
+		// Keep the uncompressed vertices on the CPU if requested
+		if (cpuData == MeshCPUData::Keep)
+			vertices.assign(meshVertices, meshVertices + numVertices);
 	}
 
 	// Create an index buffer
 	{
+		// Use 16-bit indices when every vertex can be addressed by them
+		std::vector<unsigned short> shortIndices;
+		const void* indexData = meshIndices;
+		unsigned int indexSize = sizeof(unsigned int);
+		indexFormat = DXGI_FORMAT_R32_UINT;
+		if (VertexCompression::FitsIn16BitIndices(numVertices))
+		{
+			shortIndices.resize(numIndices);
+			for (unsigned int i = 0; i < numIndices; i++)
+				shortIndices[i] = (unsigned short)meshIndices[i];
+
+			indexData = shortIndices.data();
+			indexSize = sizeof(unsigned short);
+			indexFormat = DXGI_FORMAT_R16_UINT;
+		}
+		indexBufferBytes = indexSize * numIndices;
+
 		// Fill the buffer struct
 		D3D11_BUFFER_DESC ibd = {};
 		ibd.Usage = D3D11_USAGE_IMMUTABLE;	// Will NEVER change
-		ibd.ByteWidth = sizeof(unsigned int) * numIndices;	// Multiply by the number of indices in the buffer
+		ibd.ByteWidth = indexBufferBytes;	// Index size multiplied by the number of indices in the buffer
 		ibd.BindFlags = D3D11_BIND_INDEX_BUFFER;	// Tells Direct3D this is an index buffer
 		ibd.CPUAccessFlags = 0;	// Note: We cannot access the data from C++ (this is good)
 		ibd.MiscFlags = 0;
@@ -355,19 +339,17 @@ void Mesh::CreateBuffers(Vertex* meshVertices, unsigned int numVertices, unsigne
 
 		// Specify the initial data for the
 		D3D11_SUBRESOURCE_DATA initialIndexData = {};
-		initialIndexData.pSysMem = &indices[0]; // pSysMem = Pointer to System Memory
+		initialIndexData.pSysMem = indexData; // pSysMem = Pointer to System Memory
 
 		// Create the index buffer
 		device->CreateBuffer(&ibd, &initialIndexData, indexBuffer.GetAddressOf());
 
-		// Set the size of the index array
-		this->numIndices = numIndices;
+		// Set the size of the index array (full detail only)
+		this->numIndices = lods[0].indexCount;
 
-		// Add indices to the vector
-		for (unsigned int i = 0; i < numIndices; i++)
-		{
-			indices.push_back(meshIndices[i]);
-		}
+		// Keep the full detail indices on the CPU if requested
+		if (cpuData == MeshCPUData::Keep)
+			indices.assign(meshIndices, meshIndices + this->numIndices);
 	}
 }
 
@@ -381,12 +363,14 @@ Microsoft::WRL::ComPtr<ID3D11Buffer> Mesh::GetIndexBuffer()
 	return this->indexBuffer;
 }
 
-std::vector<Vertex> Mesh::GetVertices()
+// Empty if the CPU copy was released
+std::span<const Vertex> Mesh::GetVertices() const
 {
 	return this->vertices;
 }
 
-std::vector<unsigned int> Mesh::GetIndices()
+// Full detail (LOD 0) only - empty if the CPU copy was released
+std::span<const unsigned int> Mesh::GetIndices() const
 {
 	return this->indices;
 }
@@ -401,15 +385,505 @@ unsigned int Mesh::GetIndexCount()
 	return this->numIndices;
 }
 
-void Mesh::Draw()
+ObjParseStats Mesh::GetLoadStats() const
+{
+	return this->loadStats;
+}
+
+MeshOptimizerStats Mesh::GetOptimizerStats() const
+{
+	return this->optimizerStats;
+}
+
+MeshSimplifierStats Mesh::GetSimplifierStats() const
+{
+	return this->simplifierStats;
+}
+
+unsigned int Mesh::GetLODCount() const
+{
+	return (unsigned int)this->lods.size();
+}
+
+MeshLOD Mesh::GetLOD(unsigned int lod) const
+{
+	return this->lods[lod];
+}
+
+MeshletStats Mesh::GetMeshletStats() const
+{
+	return this->meshletStats;
+}
+
+TangentStats Mesh::GetTangentStats() const
+{
+	return this->tangentStats;
+}
+
+// Only filled in when the mesh was imported by streaming
+ObjStreamStats Mesh::GetStreamStats() const
+{
+	return this->streamStats;
+}
+
+const std::vector<Meshlet>& Mesh::GetMeshlets() const
+{
+	return this->meshlets;
+}
+
+unsigned int Mesh::SelectLOD(float pixelsPerUnit, float maxPixelError) const
+{
+	return MeshSimplifier::SelectLOD(lods.data(), (unsigned int)lods.size(), pixelsPerUnit, maxPixelError);
+}
+
+double Mesh::GetLoadSeconds() const
+{
+	return this->loadSeconds;
+}
+
+// The process's peak working set right after this mesh loaded
+size_t Mesh::GetLoadPeakResidentBytes() const
+{
+	return this->loadPeakResidentBytes;
+}
+
+bool Mesh::WasLoadedFromCookedFile() const
+{
+	return this->loadedFromCookedFile;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMin() const
+{
+	return this->boundsMin;
+}
+
+DirectX::XMFLOAT3 Mesh::GetBoundsMax() const
+{
+	return this->boundsMax;
+}
+
+VertexFormat Mesh::GetVertexFormat() const
+{
+	return this->vertexFormat;
+}
+
+DirectX::XMFLOAT3 Mesh::GetPositionScale() const
+{
+	return this->positionScale;
+}
+
+DirectX::XMFLOAT3 Mesh::GetPositionOffset() const
+{
+	return this->positionOffset;
+}
+
+DirectX::XMFLOAT2 Mesh::GetUVScale() const
+{
+	return this->uvScale;
+}
+
+DirectX::XMFLOAT2 Mesh::GetUVOffset() const
+{
+	return this->uvOffset;
+}
+
+VertexCompressionStats Mesh::GetCompressionStats() const
+{
+	return this->compressionStats;
+}
+
+unsigned int Mesh::GetVertexBufferBytes() const
+{
+	return this->vertexBufferBytes;
+}
+
+unsigned int Mesh::GetIndexBufferBytes() const
+{
+	return this->indexBufferBytes;
+}
+
+bool Mesh::HasCPUData() const
+{
+	return !this->vertices.empty();
+}
+
+// --------------------------------------------------------
+// Gets how much CPU memory this mesh's geometry holds
+//
+// - Counts allocated capacity, not just the used size
+// - Includes the LOD table and meshlets, which stay resident
+//   even after ReleaseCPUData()
+// --------------------------------------------------------
+size_t Mesh::GetCPUMemoryBytes() const
+{
+	return
+		vertices.capacity() * sizeof(Vertex) +
+		indices.capacity() * sizeof(unsigned int) +
+		lods.capacity() * sizeof(MeshLOD) +
+		meshlets.capacity() * sizeof(Meshlet) +
+		skinWeights.capacity() * sizeof(SkinWeights) +
+		morphedVertices.capacity() * sizeof(Vertex) +
+		morphWeights.capacity() * sizeof(float) +
+		morphTargets.GetMemoryBytes();
+}
+
+// --------------------------------------------------------
+// Frees the CPU-side geometry
+//
+// - Swaps with empty vectors, since clear() keeps the memory
+// - Drawing is unaffected, as it only uses the GPU buffers
+// --------------------------------------------------------
+void Mesh::ReleaseCPUData()
+{
+	// Skinned and morphed meshes still need their base vertices
+	if (skeleton || !morphWeights.empty())
+		return;
+
+	std::vector<Vertex>().swap(vertices);
+	std::vector<unsigned int>().swap(indices);
+	cpuData = MeshCPUData::ReleaseAfterUpload;
+}
+
+// --------------------------------------------------------
+// Binds the mesh to a skeleton
+//
+// - The vertex buffer is recreated as dynamic, so the CPU
+//   path can rewrite it every frame. It starts in the bind pose
+// - The weights get their own immutable buffer for the GPU
+//   path, rather than widening every vertex
+// - The palette starts as the identity (the bind pose)
+// --------------------------------------------------------
+bool Mesh::EnableSkinning(std::shared_ptr<Skeleton> skeleton, std::vector<SkinWeights> weights)
+{
+	if (!skeleton || this->skeleton || arena ||
+		vertexFormat != VertexFormat::Standard ||
+		vertices.empty() || weights.size() != vertices.size())
+		return false;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> dynamicBuffer;
+	D3D11_BUFFER_DESC vbd = {};
+	vbd.Usage = D3D11_USAGE_DYNAMIC;
+	vbd.ByteWidth = vertexBufferBytes;
+	vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	vbd.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	D3D11_SUBRESOURCE_DATA initialVertexData = {};
+	initialVertexData.pSysMem = morphedVertices.empty() ? vertices.data() : morphedVertices.data();
+	if (FAILED(device->CreateBuffer(&vbd, &initialVertexData, dynamicBuffer.GetAddressOf())))
+		return false;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> weightBuffer;
+	D3D11_BUFFER_DESC wbd = {};
+	wbd.Usage = D3D11_USAGE_IMMUTABLE;
+	wbd.ByteWidth = (UINT)(sizeof(SkinWeights) * weights.size());
+	wbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+	D3D11_SUBRESOURCE_DATA initialWeightData = {};
+	initialWeightData.pSysMem = weights.data();
+	if (FAILED(device->CreateBuffer(&wbd, &initialWeightData, weightBuffer.GetAddressOf())))
+		return false;
+
+	this->skeleton = skeleton;
+	vertexBuffer = dynamicBuffer;
+	skinWeightBuffer = weightBuffer;
+	skinWeights = std::move(weights);
+	skinningPalette.assign(skeleton->GetJointCount(), Skeleton::Identity());
+	return true;
+}
+
+bool Mesh::IsSkinned() const
+{
+	return this->skeleton != nullptr;
+}
+
+std::shared_ptr<Skeleton> Mesh::GetSkeleton() const
+{
+	return this->skeleton;
+}
+
+SkinningMode Mesh::GetSkinningMode() const
+{
+	return this->skinningMode;
+}
+
+// --------------------------------------------------------
+// Switches between CPU and GPU skinning
+//
+// - The GPU path needs the bind pose (after morphing) back in
+//   the buffer; the CPU path rewrites it on the next UpdateSkin()
+// --------------------------------------------------------
+void Mesh::SetSkinningMode(SkinningMode mode)
+{
+	if (!skeleton || mode == skinningMode)
+		return;
+
+	skinningMode = mode;
+	if (mode == SkinningMode::GPU)
+	{
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		if (SUCCEEDED(context->Map(vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		{
+			memcpy(mapped.pData, morphedVertices.empty() ? vertices.data() : morphedVertices.data(), vertexBufferBytes);
+			context->Unmap(vertexBuffer.Get(), 0);
+		}
+	}
+}
+
+const std::vector<SkinMatrix>& Mesh::GetSkinningPalette() const
+{
+	return this->skinningPalette;
+}
+
+SkinningStats Mesh::GetSkinningStats() const
+{
+	return this->skinningStats;
+}
+
+// --------------------------------------------------------
+// Poses the mesh
+//
+// - The CPU path skins straight into the mapped buffer, which
+//   the skinning code writes once, front to back
+// --------------------------------------------------------
+void Mesh::UpdateSkin(const std::vector<SkinMatrix>& palette, unsigned int threadCount)
+{
+	if (!skeleton)
+		return;
+
+	skinningPalette = palette;
+	if (skinningMode != SkinningMode::CPU)
+		return;
+
+	D3D11_MAPPED_SUBRESOURCE mapped = {};
+	if (FAILED(context->Map(vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+		return;
+
+	// Morph targets are blended into the bind pose first
+	const Vertex* bindVertices = morphedVertices.empty() ? vertices.data() : morphedVertices.data();
+	Skinning::SkinVertices(
+		reinterpret_cast<const ObjVertex*>(bindVertices), skinWeights.data(), numVertices,
+		palette.data(), (unsigned int)palette.size(),
+		static_cast<ObjVertex*>(mapped.pData),
+		threadCount, &skinningStats);
+
+	context->Unmap(vertexBuffer.Get(), 0);
+}
+
+// --------------------------------------------------------
+// Adds a morph target
+//
+// - The first one recreates the vertex buffer as default
+//   usage (unless skinning already made it dynamic), so
+//   blends can upload just the vertices they moved
+// - The bounds grow by the target's largest delta, which
+//   covers any weights between 0 and 1
+// --------------------------------------------------------
+int Mesh::AddMorphTarget(const std::string& name, const std::vector<DirectX::XMFLOAT3>& positionDeltas, const std::vector<DirectX::XMFLOAT3>& normalDeltas)
+{
+	if (arena || vertexFormat != VertexFormat::Standard ||
+		vertices.empty() || positionDeltas.size() != vertices.size() ||
+		(!normalDeltas.empty() && normalDeltas.size() != vertices.size()))
+		return -1;
+
+	if (morphWeights.empty())
+	{
+		if (!skeleton)
+		{
+			Microsoft::WRL::ComPtr<ID3D11Buffer> defaultBuffer;
+			D3D11_BUFFER_DESC vbd = {};
+			vbd.Usage = D3D11_USAGE_DEFAULT;
+			vbd.ByteWidth = vertexBufferBytes;
+			vbd.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+
+			D3D11_SUBRESOURCE_DATA initialVertexData = {};
+			initialVertexData.pSysMem = vertices.data();
+			if (FAILED(device->CreateBuffer(&vbd, &initialVertexData, defaultBuffer.GetAddressOf())))
+				return -1;
+			vertexBuffer = defaultBuffer;
+		}
+
+		morphTargets = MorphTargetSet((unsigned int)vertices.size());
+		morphedVertices = vertices;
+	}
+
+	// XMFLOAT3 and ObjFloat3 are both three packed floats
+	unsigned int target = morphTargets.AddTarget(
+		name,
+		reinterpret_cast<const ObjFloat3*>(positionDeltas.data()),
+		normalDeltas.empty() ? nullptr : reinterpret_cast<const ObjFloat3*>(normalDeltas.data()));
+	morphWeights.push_back(0.0f);
+
+	float reach = 0.0f;
+	for (const XMFLOAT3& delta : positionDeltas)
+	{
+		float x = fabsf(delta.x);
+		float y = fabsf(delta.y);
+		float z = fabsf(delta.z);
+		float largest = x > y ? (x > z ? x : z) : (y > z ? y : z);
+		reach = largest > reach ? largest : reach;
+	}
+	boundsMin = XMFLOAT3(boundsMin.x - reach, boundsMin.y - reach, boundsMin.z - reach);
+	boundsMax = XMFLOAT3(boundsMax.x + reach, boundsMax.y + reach, boundsMax.z + reach);
+
+	return (int)target;
+}
+
+unsigned int Mesh::GetMorphTargetCount() const
+{
+	return (unsigned int)this->morphWeights.size();
+}
+
+const MorphTargetSet& Mesh::GetMorphTargets() const
+{
+	return this->morphTargets;
+}
+
+float Mesh::GetMorphWeight(unsigned int target) const
 {
-	// Declare starter variables
-	UINT stride = sizeof(Vertex);
+	return target < morphWeights.size() ? this->morphWeights[target] : 0.0f;
+}
+
+void Mesh::SetMorphWeight(unsigned int target, float weight)
+{
+	if (target >= morphWeights.size() || morphWeights[target] == weight)
+		return;
+
+	morphWeights[target] = weight;
+	morphWeightsChanged = true;
+}
+
+MorphBlendStats Mesh::GetMorphBlendStats() const
+{
+	return this->morphStats;
+}
+
+// --------------------------------------------------------
+// Blends the morph targets into morphedVertices
+//
+// - Unskinned meshes upload only the range of vertices the
+//   blend wrote
+// - CPU skinning picks the blend up on the next UpdateSkin();
+//   GPU skinning needs the whole bind pose rewritten, as the
+//   buffer is dynamic
+// --------------------------------------------------------
+void Mesh::UpdateMorphs()
+{
+	if (morphWeights.empty() || !morphWeightsChanged)
+		return;
+	morphWeightsChanged = false;
+
+	unsigned int firstWritten = 0;
+	unsigned int lastWritten = 0;
+	morphTargets.Blend(
+		reinterpret_cast<const ObjVertex*>(vertices.data()), morphWeights.data(),
+		reinterpret_cast<ObjVertex*>(morphedVertices.data()),
+		firstWritten, lastWritten, &morphStats);
+	if (firstWritten > lastWritten)
+		return;
+
+	if (skeleton)
+	{
+		if (skinningMode == SkinningMode::GPU)
+		{
+			D3D11_MAPPED_SUBRESOURCE mapped = {};
+			if (SUCCEEDED(context->Map(vertexBuffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped)))
+			{
+				memcpy(mapped.pData, morphedVertices.data(), vertexBufferBytes);
+				context->Unmap(vertexBuffer.Get(), 0);
+			}
+		}
+		return;
+	}
+
+	D3D11_BOX box = {};
+	box.left = firstWritten * sizeof(Vertex);
+	box.right = (lastWritten + 1) * sizeof(Vertex);
+	box.bottom = 1;
+	box.back = 1;
+	context->UpdateSubresource(vertexBuffer.Get(), 0, &box, &morphedVertices[firstWritten], 0, 0);
+}
+
+bool Mesh::IsDeformable() const
+{
+	return skeleton != nullptr || !this->morphWeights.empty();
+}
+
+// --------------------------------------------------------
+// Moves the geometry into a shared arena
+//
+// - The arena copies the buffers on the GPU, so this works
+//   with or without the CPU copy
+// - Draws then bind the arena's buffers (usually a no-op, as
+//   the last mesh drawn left them bound) and offset into them
+// - The mesh keeps its own buffers if the arena couldn't fit it
+// --------------------------------------------------------
+bool Mesh::MoveToArena(std::shared_ptr<GeometryArena> arena)
+{
+	// Skinned and morphed vertices change every frame, so they keep their own buffer
+	if (!arena || this->arena || IsDeformable() || !vertexBuffer || !indexBuffer)
+		return false;
+
+	// The index buffer holds every LOD, not just the first
+	unsigned int indexSize = indexFormat == DXGI_FORMAT_R16_UINT ? sizeof(unsigned short) : sizeof(unsigned int);
+	unsigned int allocation = arena->Add(
+		vertexBuffer.Get(), vertexStride, vertexBufferBytes / vertexStride,
+		indexBuffer.Get(), indexFormat, indexBufferBytes / indexSize);
+	if (allocation == GeometryArena::InvalidAllocation)
+		return false;
+
+	this->arena = arena;
+	arenaAllocation = allocation;
+	vertexBuffer.Reset();
+	indexBuffer.Reset();
+	return true;
+}
+
+bool Mesh::IsInArena() const
+{
+	return this->arena != nullptr;
+}
+
+void Mesh::BindBuffers(unsigned int& startIndex, int& baseVertex)
+{
+	if (arena)
+	{
+		const GeometryAllocation& allocation = arena->Bind(arenaAllocation);
+		startIndex = allocation.indexOffset;
+		baseVertex = (int)allocation.vertexOffset;
+		return;
+	}
+
+	UINT stride = vertexStride;
 	UINT offset = 0;
+	context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
+	context->IASetIndexBuffer(indexBuffer.Get(), indexFormat, 0);
+
+	// The GPU skinning shader reads the joints from a second stream
+	if (skeleton && skinningMode == SkinningMode::GPU)
+	{
+		UINT weightStride = sizeof(SkinWeights);
+		context->IASetVertexBuffers(1, 1, skinWeightBuffer.GetAddressOf(), &weightStride, &offset);
+	}
+
+	startIndex = 0;
+	baseVertex = 0;
+}
+
+void Mesh::Draw(unsigned int lod)
+{
+	// Nothing was loaded
+	if (lods.empty())
+		return;
+
+	// Fall back to the coarsest LOD there is
+	if (lod >= lods.size())
+		lod = (unsigned int)lods.size() - 1;
+
 	{
-		// Set buffers in the input assembler (IA) stage - needs to be once per geometry
-		context->IASetVertexBuffers(0, 1, vertexBuffer.GetAddressOf(), &stride, &offset);
-		context->IASetIndexBuffer(indexBuffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+		// Set buffers in the input assembler (IA) stage - skipped if they're already set
+		unsigned int startIndex;
+		int baseVertex;
+		BindBuffers(startIndex, baseVertex);
 
 		// Tell Direct3D to draw
 		//  - Begins the rendering pipeline on the GPU
@@ -418,8 +892,47 @@ void Mesh::Draw()
 		//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
 		//     vertices in the currently set VERTEX BUFFER
 		context->DrawIndexed(
-			numIndices,    // The number of indices to use (we could draw a subset if we wanted)
-			0,					// Offset to the first index we want to use
-			0);					// Offset to add to each index when looking up vertices
+			lods[lod].indexCount,	// The number of indices to use (each LOD is a subset)
+			startIndex + lods[lod].indexOffset,	// Offset to the first index we want to use
+			baseVertex);			// Offset to add to each index when looking up vertices
+	}
+}
+
+// --------------------------------------------------------
+// Draws the visible meshlets of LOD 0
+//
+// - Meshlets are contiguous in the index buffer, so each run
+//   of visible ones is a single DrawIndexed
+// --------------------------------------------------------
+void Mesh::DrawMeshlets(const std::vector<bool>& visible)
+{
+	if (meshlets.empty() || visible.size() < meshlets.size())
+	{
+		Draw(0);
+		return;
+	}
+
+	unsigned int startIndex;
+	int baseVertex;
+	BindBuffers(startIndex, baseVertex);
+
+	size_t m = 0;
+	while (m < meshlets.size())
+	{
+		if (!visible[m])
+		{
+			m++;
+			continue;
+		}
+
+		unsigned int runOffset = meshlets[m].indexOffset;
+		unsigned int runCount = 0;
+		while (m < meshlets.size() && visible[m])
+		{
+			runCount += meshlets[m].triangleCount * 3;
+			m++;
+		}
+
+		context->DrawIndexed(runCount, startIndex + runOffset, baseVertex);
 	}
 }
@@ -3,8 +3,53 @@
 #include <wrl/client.h>
 #include <DirectXMath.h>
 #include "Vertex.h"
+#include "AssetLoader.h"
+#include "ObjParser.h"
+#include "ObjStreamImporter.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MorphTargets.h"
+#include "Skinning.h"
+#include "TangentGenerator.h"
+#include "VertexCompression.h"
+#include "CookedMesh.h"
+#include "GeometryArena.h"
+#include <memory>
+#include <span>
+#include <string>
 #include <vector>
 
+// --------------------------------------------------------
+// What a mesh does with its CPU-side geometry once the GPU
+// buffers have been created
+//
+// - Keep holds one copy of the vertices and full detail
+//   indices, for tools and the UI
+// - ReleaseAfterUpload frees it, leaving only the GPU buffers
+//   (bounds, LODs and meshlets are always kept for culling)
+// --------------------------------------------------------
+enum class MeshCPUData
+{
+	Keep,
+	ReleaseAfterUpload
+};
+
+// --------------------------------------------------------
+// Where a skinned mesh is posed (see Skinning.h)
+//
+// - CPU skins the vertices into a dynamic vertex buffer
+//   every time the pose changes, so any shader can draw them
+// - GPU leaves the bind pose in the buffer and has the vertex
+//   shader blend the palette, read from a second stream of
+//   joints and weights
+// --------------------------------------------------------
+enum class SkinningMode
+{
+	CPU,
+	GPU
+};
+
 class Mesh
 {
 private:
@@ -17,28 +62,167 @@ private:
 	unsigned int numIndices;
 	std::vector<Vertex> vertices;
 	std::vector<unsigned int> indices;
+	MeshCPUData cpuData;
+	DirectX::XMFLOAT3 boundsMin;
+	DirectX::XMFLOAT3 boundsMax;
+
+	// Levels of detail, as ranges of the index buffer (see MeshSimplifier.h)
+	std::vector<MeshLOD> lods;
+
+	// Culling clusters within LOD 0 (see MeshletBuilder.h)
+	std::vector<Meshlet> meshlets;
+
+	// GPU buffer layout (see VertexCompression.h)
+	VertexFormat vertexFormat;
+	unsigned int vertexStride;
+	DXGI_FORMAT indexFormat;
+	DirectX::XMFLOAT3 positionScale;
+	DirectX::XMFLOAT3 positionOffset;
+	DirectX::XMFLOAT2 uvScale;
+	DirectX::XMFLOAT2 uvOffset;
+	VertexCompressionStats compressionStats;
+	unsigned int vertexBufferBytes;
+	unsigned int indexBufferBytes;
+
+	// Load info
+	ObjParseStats loadStats;
+	MeshOptimizerStats optimizerStats;
+	MeshSimplifierStats simplifierStats;
+	MeshletStats meshletStats;
+	TangentStats tangentStats;
+	ObjStreamStats streamStats;
+	double loadSeconds;
+	size_t loadPeakResidentBytes;
+	bool loadedFromCookedFile;
+
+	// Skinning (see Skinning.h), only for meshes bound to a skeleton
+	// - vertices holds the bind pose, which is never released
+	std::shared_ptr<Skeleton> skeleton;
+	std::vector<SkinWeights> skinWeights;
+	std::vector<SkinMatrix> skinningPalette;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> skinWeightBuffer;
+	SkinningMode skinningMode;
+	SkinningStats skinningStats;
+
+	// Morph targets (see MorphTargets.h), blended before skinning
+	// - morphedVertices holds the last blend; it's what gets skinned, or
+	//   what's uploaded for meshes that aren't skinned
+	MorphTargetSet morphTargets;
+	std::vector<float> morphWeights;
+	std::vector<Vertex> morphedVertices;
+	MorphBlendStats morphStats;
+	bool morphWeightsChanged;
+
+	// Shared buffers holding the geometry, once moved there (see GeometryArena.h)
+	std::shared_ptr<GeometryArena> arena;
+	unsigned int arenaAllocation;
+
+	void LoadStreamed(const char* fileName);
+	void CreateBuffersFromCookedFile(const CookedMesh& cooked);
+
+	// Binds whichever buffers hold the geometry, and gets the offsets
+	// to add to the start index and base vertex of each draw
+	void BindBuffers(unsigned int& startIndex, int& baseVertex);
 
 public:
 	Mesh(Microsoft::WRL::ComPtr<ID3D11DeviceContext>	_context,
 		Microsoft::WRL::ComPtr<IDXGISwapChain> _swapChain,
 		Microsoft::WRL::ComPtr<ID3D11Device> _device, 
-		Vertex* meshVertices, unsigned int* meshIndices, unsigned int numVertices, unsigned int numIndices);
+		Vertex* meshVertices, unsigned int* meshIndices, unsigned int numVertices, unsigned int numIndices,
+		VertexFormat vertexFormat = VertexFormat::Standard,
+		MeshCPUData cpuData = MeshCPUData::Keep);
 	Mesh(Microsoft::WRL::ComPtr<ID3D11DeviceContext>	context,
 		Microsoft::WRL::ComPtr<IDXGISwapChain> swapChain,
 		Microsoft::WRL::ComPtr<ID3D11Device> device,
-		const char* fileName);
+		const char* fileName,
+		VertexFormat vertexFormat = VertexFormat::Standard,
+		MeshCPUData cpuData = MeshCPUData::Keep);
 	~Mesh();
 
 	void CalculateTangents(Vertex* verts, int numVerts, unsigned int* indices, int numIndices);
-	void CreateBuffers(Vertex* meshVertices, unsigned int numVertices, unsigned int* meshIndices, unsigned int numIndices);
+	void CalculateBounds(const Vertex* verts, int numVerts);
+	void CreateBuffers(const Vertex* meshVertices, unsigned int numVertices, const unsigned int* meshIndices, unsigned int numIndices);
 
 	// Getters
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetVertexBuffer();
 	Microsoft::WRL::ComPtr<ID3D11Buffer> GetIndexBuffer();
-	std::vector<Vertex> GetVertices();
-	std::vector<unsigned int> GetIndices();
+	std::span<const Vertex> GetVertices() const;
+	std::span<const unsigned int> GetIndices() const;
 	unsigned int GetVertexCount();
 	unsigned int GetIndexCount();
+	DirectX::XMFLOAT3 GetBoundsMin() const;
+	DirectX::XMFLOAT3 GetBoundsMax() const;
+	ObjParseStats GetLoadStats() const;
+	MeshOptimizerStats GetOptimizerStats() const;
+	MeshSimplifierStats GetSimplifierStats() const;
+	unsigned int GetLODCount() const;
+	MeshLOD GetLOD(unsigned int lod) const;
+	MeshletStats GetMeshletStats() const;
+	TangentStats GetTangentStats() const;
+	ObjStreamStats GetStreamStats() const;
+	const std::vector<Meshlet>& GetMeshlets() const;
+	double GetLoadSeconds() const;
+	size_t GetLoadPeakResidentBytes() const;
+	bool WasLoadedFromCookedFile() const;
+	VertexFormat GetVertexFormat() const;
+	DirectX::XMFLOAT3 GetPositionScale() const;
+	DirectX::XMFLOAT3 GetPositionOffset() const;
+	DirectX::XMFLOAT2 GetUVScale() const;
+	DirectX::XMFLOAT2 GetUVOffset() const;
+	VertexCompressionStats GetCompressionStats() const;
+	unsigned int GetVertexBufferBytes() const;
+	unsigned int GetIndexBufferBytes() const;
+	bool HasCPUData() const;
+	size_t GetCPUMemoryBytes() const;
+
+	// Frees the CPU-side vertices and indices (the GPU buffers are unaffected)
+	void ReleaseCPUData();
+
+	// Binds the mesh to a skeleton, with one set of weights per vertex.
+	// Needs the standard vertex format and the CPU copy of the vertices
+	bool EnableSkinning(std::shared_ptr<Skeleton> skeleton, std::vector<SkinWeights> weights);
+	bool IsSkinned() const;
+	std::shared_ptr<Skeleton> GetSkeleton() const;
+	SkinningMode GetSkinningMode() const;
+	void SetSkinningMode(SkinningMode mode);
+	const std::vector<SkinMatrix>& GetSkinningPalette() const;
+	SkinningStats GetSkinningStats() const;
+
+	// Poses the mesh with a skinning palette (see Skeleton::ComputeSkinningPalette).
+	// Skins the vertices straight away in CPU mode - main thread only
+	void UpdateSkin(const std::vector<SkinMatrix>& palette, unsigned int threadCount = 0);
+
+	// Adds a blend shape from one position delta and one normal delta per vertex
+	// (normalDeltas may be empty), and returns its index, or -1 if it couldn't.
+	// Needs the standard vertex format and the CPU copy of the vertices
+	int AddMorphTarget(const std::string& name, const std::vector<DirectX::XMFLOAT3>& positionDeltas, const std::vector<DirectX::XMFLOAT3>& normalDeltas);
+	unsigned int GetMorphTargetCount() const;
+	const MorphTargetSet& GetMorphTargets() const;
+	float GetMorphWeight(unsigned int target) const;
+	void SetMorphWeight(unsigned int target, float weight);
+	MorphBlendStats GetMorphBlendStats() const;
+
+	// Blends the morph targets if any weight has changed - main thread only.
+	// Skinned meshes should call this before UpdateSkin()
+	void UpdateMorphs();
+
+	// Whether the vertices move after loading (skinned or morphed)
+	bool IsDeformable() const;
+
+	// Copies the GPU buffers into the arena and releases them - main thread only
+	bool MoveToArena(std::shared_ptr<GeometryArena> arena);
+	bool IsInArena() const;
+
+	// Picks the coarsest LOD whose error covers at most maxPixelError
+	// pixels, given how many pixels one mesh unit currently covers
+	unsigned int SelectLOD(float pixelsPerUnit, float maxPixelError) const;
+
+	void Draw(unsigned int lod = 0);
+
+	// Draws LOD 0, skipping meshlets that aren't visible. Neighbouring
+	// visible meshlets are merged into one draw call
+	void DrawMeshlets(const std::vector<bool>& visible);
+};
 
-	void Draw();
-};
\ No newline at end of file
+// A mesh that may still be loading (see AssetLoader.h)
+using MeshHandle = AssetHandle<std::shared_ptr<Mesh>>;
\ No newline at end of file
@@ -0,0 +1,595 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// Resolution of each view rendered by the overdraw analyzer
+	const int overdrawResolution = 256;
+	const float clearDepth = FLT_MAX;
+
+	// Cache lines tracked by the vertex fetch analyzer (4 KB of 64 byte lines)
+	const unsigned int fetchCacheLines = 64;
+	const unsigned int fetchLineSize = 64;
+
+	inline const float* GetPosition(const void* vertices, unsigned int vertexStride, unsigned int index)
+	{
+		return reinterpret_cast<const float*>(static_cast<const unsigned char*>(vertices) + (size_t)index * vertexStride);
+	}
+
+	// --------------------------------------------------------
+	// Vertex to triangle adjacency, stored flat
+	//
+	// - The triangles using vertex v are
+	//   triangles[offsets[v]] to triangles[offsets[v + 1] - 1]
+	// --------------------------------------------------------
+	struct Adjacency
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+	};
+
+	void BuildAdjacency(Adjacency& adjacency, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+	{
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		adjacency.triangles.resize(indexCount);
+
+		// Count, then prefix sum, then fill
+		for (unsigned int i = 0; i < indexCount; i++)
+			adjacency.offsets[indices[i] + 1]++;
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+			adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+		std::vector<unsigned int> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (unsigned int i = 0; i < indexCount; i++)
+			adjacency.triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	// --------------------------------------------------------
+	// Runs one triangle through a FIFO cache and returns the misses
+	//
+	// - A vertex is still cached if fewer than cacheSize vertices
+	//   have been added since it was, which is exact for a FIFO
+	// - Bumping timestamp by cacheSize + 1 empties the cache
+	// --------------------------------------------------------
+	inline unsigned int UpdateCache(const unsigned int* triangle, unsigned int cacheSize, std::vector<unsigned int>& cacheTime, unsigned int& timestamp)
+	{
+		unsigned int misses = 0;
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int v = triangle[k];
+			if (timestamp - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	}
+
+	// --------------------------------------------------------
+	// Finds the next vertex to fan around once the candidates
+	// are exhausted, walking back through recently used vertices
+	// first and then through the input order
+	// --------------------------------------------------------
+	int SkipDeadEnd(std::vector<unsigned int>& deadEnd, const std::vector<unsigned int>& liveTriangles, unsigned int& cursor, unsigned int vertexCount)
+	{
+		while (!deadEnd.empty())
+		{
+			unsigned int v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveTriangles[v] > 0)
+				return (int)v;
+		}
+
+		while (cursor < vertexCount)
+		{
+			if (liveTriangles[cursor] > 0)
+				return (int)cursor;
+			cursor++;
+		}
+
+		return -1;
+	}
+
+	// --------------------------------------------------------
+	// Depth-tested, back-face culled triangle rasterizer
+	//
+	// - Coordinates are in pixels with counter-clockwise front faces
+	// - Follows the top-left rule so shared edges aren't counted twice
+	// --------------------------------------------------------
+	void RasterizeTriangle(const float a[3], const float b[3], const float c[3], std::vector<float>& depth, OverdrawStats& stats)
+	{
+		float area = (b[0] - a[0]) * (c[1] - a[1]) - (b[1] - a[1]) * (c[0] - a[0]);
+		if (area <= 0.0f)
+			return;
+
+		int minX = std::max(0, (int)std::floor(std::min(a[0], std::min(b[0], c[0]))));
+		int minY = std::max(0, (int)std::floor(std::min(a[1], std::min(b[1], c[1]))));
+		int maxX = std::min(overdrawResolution - 1, (int)std::ceil(std::max(a[0], std::max(b[0], c[0]))));
+		int maxY = std::min(overdrawResolution - 1, (int)std::ceil(std::max(a[1], std::max(b[1], c[1]))));
+
+		// Edges are opposite each corner: bc, ca, ab
+		const float* edgeStart[3] = { b, c, a };
+		const float* edgeEnd[3] = { c, a, b };
+		bool topLeft[3];
+		for (int e = 0; e < 3; e++)
+		{
+			float dx = edgeEnd[e][0] - edgeStart[e][0];
+			float dy = edgeEnd[e][1] - edgeStart[e][1];
+			topLeft[e] = dy < 0.0f || (dy == 0.0f && dx < 0.0f);
+		}
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			float py = y + 0.5f;
+			for (int x = minX; x <= maxX; x++)
+			{
+				float px = x + 0.5f;
+
+				// Barycentric weights (scaled by area)
+				float w[3];
+				bool inside = true;
+				for (int e = 0; e < 3 && inside; e++)
+				{
+					w[e] = (edgeEnd[e][0] - edgeStart[e][0]) * (py - edgeStart[e][1]) -
+						(edgeEnd[e][1] - edgeStart[e][1]) * (px - edgeStart[e][0]);
+					inside = w[e] > 0.0f || (w[e] == 0.0f && topLeft[e]);
+				}
+				if (!inside)
+					continue;
+
+				float z = (w[0] * a[2] + w[1] * b[2] + w[2] * c[2]) / area;
+				float& stored = depth[(size_t)y * overdrawResolution + x];
+				if (z < stored)
+				{
+					if (stored == clearDepth)
+						stats.pixelsCovered++;
+
+					stored = z;
+					stats.pixelsShaded++;
+				}
+			}
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Runs the whole pipeline on an indexed triangle list
+//
+// - Cache order comes first, overdraw then splits that order
+//   into clusters, and the vertex buffer is remapped last so
+//   it follows the final index order
+// --------------------------------------------------------
+unsigned int MeshOptimizer::OptimizeMesh(
+	void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	unsigned int* indices, unsigned int indexCount,
+	MeshOptimizerStats* stats)
+{
+	if (stats)
+	{
+		stats->cacheBefore = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		stats->overdrawBefore = AnalyzeOverdraw(indices, indexCount, vertices, vertexCount, vertexStride);
+		stats->fetchBefore = AnalyzeVertexFetch(indices, indexCount, vertexCount, vertexStride);
+	}
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	OptimizeVertexCache(indices, indexCount, vertexCount);
+	OptimizeOverdraw(indices, indexCount, vertices, vertexCount, vertexStride);
+	vertexCount = OptimizeVertexFetch(vertices, vertexCount, vertexStride, indices, indexCount);
+
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (stats)
+	{
+		stats->cacheAfter = AnalyzeVertexCache(indices, indexCount, vertexCount);
+		stats->overdrawAfter = AnalyzeOverdraw(indices, indexCount, vertices, vertexCount, vertexStride);
+		stats->fetchAfter = AnalyzeVertexFetch(indices, indexCount, vertexCount, vertexStride);
+		stats->seconds = seconds;
+	}
+
+	return vertexCount;
+}
+
+// --------------------------------------------------------
+// Reorders triangles for the post-transform vertex cache
+//
+// Tipsify: fans around one vertex at a time, emitting all of
+// its remaining triangles, then moves to the neighbour that
+// will most likely still be in the cache. Runs in linear time
+// --------------------------------------------------------
+void MeshOptimizer::OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize)
+{
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	Adjacency adjacency;
+	BuildAdjacency(adjacency, indices, indexCount, vertexCount);
+
+	// Triangles not yet emitted for each vertex
+	std::vector<unsigned int> liveTriangles(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++)
+		liveTriangles[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<unsigned int> deadEnd;
+	std::vector<unsigned int> candidates;
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> result;
+	deadEnd.reserve(indexCount);
+	result.reserve(triangleCount * 3);
+
+	unsigned int timestamp = cacheSize + 1;
+	unsigned int cursor = 0;
+	int fanning = (int)indices[0];
+
+	while (fanning >= 0)
+	{
+		// Emit every remaining triangle around the fanning vertex
+		candidates.clear();
+		for (unsigned int a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++)
+		{
+			unsigned int t = adjacency.triangles[a];
+			if (emitted[t])
+				continue;
+
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int v = indices[t * 3 + k];
+				result.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveTriangles[v]--;
+
+				if (timestamp - cacheTime[v] > cacheSize)
+					cacheTime[v] = timestamp++;
+			}
+			emitted[t] = true;
+		}
+
+		// Prefer the candidate that's been in the cache the longest
+		// but won't fall out of it before its own fan is emitted
+		int next = -1;
+		int bestPriority = -1;
+		for (unsigned int v : candidates)
+		{
+			if (liveTriangles[v] == 0)
+				continue;
+
+			int priority = 0;
+			if (timestamp - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				priority = (int)(timestamp - cacheTime[v]);
+
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				next = (int)v;
+			}
+		}
+
+		if (next == -1)
+			next = SkipDeadEnd(deadEnd, liveTriangles, cursor, vertexCount);
+
+		fanning = next;
+	}
+
+	memcpy(indices, result.data(), result.size() * sizeof(unsigned int));
+}
+
+// --------------------------------------------------------
+// Reorders clusters of triangles to reduce overdraw
+//
+// - Expects indices that are already cache optimized
+// - Splits wherever the cache order jumped to unconnected
+//   triangles, then splits further while each piece stays
+//   within threshold times the ACMR of its parent
+// - Sorts clusters so those facing away from the mesh centre
+//   (which tend to occlude the rest) are drawn first
+// --------------------------------------------------------
+void MeshOptimizer::OptimizeOverdraw(
+	unsigned int* indices, unsigned int indexCount,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	unsigned int cacheSize, float threshold)
+{
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return;
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+
+	// Hard boundaries: triangles that missed on every vertex
+	std::vector<unsigned int> hardClusters;
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		unsigned int misses = UpdateCache(&indices[t * 3], cacheSize, cacheTime, timestamp);
+		if (t == 0 || misses == 3)
+			hardClusters.push_back(t);
+	}
+
+	// Soft boundaries: split each hard cluster into the smallest
+	// pieces that don't hurt the cache by more than the threshold
+	std::vector<unsigned int> clusters;
+	for (size_t c = 0; c < hardClusters.size(); c++)
+	{
+		unsigned int start = hardClusters[c];
+		unsigned int end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : triangleCount;
+
+		timestamp += cacheSize + 1;
+		unsigned int clusterMisses = 0;
+		for (unsigned int t = start; t < end; t++)
+			clusterMisses += UpdateCache(&indices[t * 3], cacheSize, cacheTime, timestamp);
+
+		float clusterThreshold = threshold * clusterMisses / (end - start);
+
+		timestamp += cacheSize + 1;
+		unsigned int pieceStart = start;
+		unsigned int pieceMisses = 0;
+		for (unsigned int t = start; t < end; t++)
+		{
+			pieceMisses += UpdateCache(&indices[t * 3], cacheSize, cacheTime, timestamp);
+			if (pieceMisses <= clusterThreshold * (t - pieceStart + 1))
+			{
+				clusters.push_back(pieceStart);
+				pieceStart = t + 1;
+				pieceMisses = 0;
+				timestamp += cacheSize + 1;
+			}
+		}
+
+		if (pieceStart < end)
+			clusters.push_back(pieceStart);
+	}
+
+	// Area weighted centroid and normal of each cluster, plus the whole mesh
+	std::vector<float> clusterCentroids(clusters.size() * 3, 0.0f);
+	std::vector<float> clusterNormals(clusters.size() * 3, 0.0f);
+	float meshCentroid[3] = {};
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		float clusterArea = 0.0f;
+		for (unsigned int t = clusters[c]; t < end; t++)
+		{
+			const float* p0 = GetPosition(vertices, vertexStride, indices[t * 3 + 0]);
+			const float* p1 = GetPosition(vertices, vertexStride, indices[t * 3 + 1]);
+			const float* p2 = GetPosition(vertices, vertexStride, indices[t * 3 + 2]);
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] =
+			{
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0]
+			};
+			float area = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (int i = 0; i < 3; i++)
+			{
+				float centre = (p0[i] + p1[i] + p2[i]) / 3.0f;
+				clusterCentroids[c * 3 + i] += centre * area;
+				clusterNormals[c * 3 + i] += n[i];
+				meshCentroid[i] += centre * area;
+			}
+			clusterArea += area;
+		}
+
+		for (int i = 0; i < 3; i++)
+			clusterCentroids[c * 3 + i] /= clusterArea > 0.0f ? clusterArea : 1.0f;
+		meshArea += clusterArea;
+	}
+
+	for (int i = 0; i < 3; i++)
+		meshCentroid[i] /= meshArea > 0.0f ? meshArea : 1.0f;
+
+	// Sort key: how much the cluster faces away from the centre
+	std::vector<float> sortKeys(clusters.size());
+	std::vector<unsigned int> order(clusters.size());
+	for (size_t c = 0; c < clusters.size(); c++)
+	{
+		const float* n = &clusterNormals[c * 3];
+		float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		float dot = 0.0f;
+		for (int i = 0; i < 3; i++)
+			dot += (clusterCentroids[c * 3 + i] - meshCentroid[i]) * n[i];
+
+		sortKeys[c] = length > 0.0f ? dot / length : 0.0f;
+		order[c] = (unsigned int)c;
+	}
+
+	std::stable_sort(order.begin(), order.end(),
+		[&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+	// Emit whole clusters in the new order
+	std::vector<unsigned int> result;
+	result.reserve(triangleCount * 3);
+	for (unsigned int c : order)
+	{
+		unsigned int end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+		result.insert(result.end(), indices + clusters[c] * 3, indices + end * 3);
+	}
+
+	memcpy(indices, result.data(), result.size() * sizeof(unsigned int));
+}
+
+// --------------------------------------------------------
+// Reorders the vertex buffer into the order the indices first
+// use each vertex, and rewrites the indices to match
+//
+// - Unreferenced vertices are dropped, so the returned count
+//   may be smaller than vertexCount
+// --------------------------------------------------------
+unsigned int MeshOptimizer::OptimizeVertexFetch(void* vertices, unsigned int vertexCount, unsigned int vertexStride, unsigned int* indices, unsigned int indexCount)
+{
+	const unsigned int unused = 0xFFFFFFFF;
+	std::vector<unsigned int> remap(vertexCount, unused);
+
+	unsigned int nextVertex = 0;
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int& newIndex = remap[indices[i]];
+		if (newIndex == unused)
+			newIndex = nextVertex++;
+
+		indices[i] = newIndex;
+	}
+
+	// Move the vertex data itself
+	unsigned char* vertexBytes = static_cast<unsigned char*>(vertices);
+	std::vector<unsigned char> original(vertexBytes, vertexBytes + (size_t)vertexCount * vertexStride);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != unused)
+			memcpy(vertexBytes + (size_t)remap[v] * vertexStride, &original[(size_t)v * vertexStride], vertexStride);
+	}
+
+	return nextVertex;
+}
+
+// --------------------------------------------------------
+// Simulates a FIFO post-transform cache over the index buffer
+// --------------------------------------------------------
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize)
+{
+	VertexCacheStats stats = {};
+	stats.cacheSize = cacheSize;
+
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0 || vertexCount == 0)
+		return stats;
+
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	unsigned int timestamp = cacheSize + 1;
+	for (unsigned int t = 0; t < triangleCount; t++)
+		stats.misses += UpdateCache(&indices[t * 3], cacheSize, cacheTime, timestamp);
+
+	stats.acmr = (float)stats.misses / triangleCount;
+	stats.atvr = (float)stats.misses / vertexCount;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Measures overdraw by rasterizing the mesh in index order
+// from all six axis directions
+//
+// - Positions are normalized to the unit cube so every view
+//   fills the same small depth buffer
+// - Each view keeps the same handedness, so the same winding
+//   is front facing in all of them
+// --------------------------------------------------------
+OverdrawStats MeshOptimizer::AnalyzeOverdraw(const unsigned int* indices, unsigned int indexCount, const void* vertices, unsigned int vertexCount, unsigned int vertexStride)
+{
+	OverdrawStats stats = {};
+	if (indexCount < 3 || vertexCount == 0)
+		return stats;
+
+	// Find the bounds to normalize against
+	float minPos[3];
+	float maxPos[3];
+	memcpy(minPos, GetPosition(vertices, vertexStride, 0), sizeof(minPos));
+	memcpy(maxPos, minPos, sizeof(maxPos));
+	for (unsigned int v = 1; v < vertexCount; v++)
+	{
+		const float* p = GetPosition(vertices, vertexStride, v);
+		for (int i = 0; i < 3; i++)
+		{
+			minPos[i] = std::min(minPos[i], p[i]);
+			maxPos[i] = std::max(maxPos[i], p[i]);
+		}
+	}
+
+	float extent = std::max(maxPos[0] - minPos[0], std::max(maxPos[1] - minPos[1], maxPos[2] - minPos[2]));
+	float scale = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+	std::vector<float> depth((size_t)overdrawResolution * overdrawResolution);
+	for (int view = 0; view < 6; view++)
+	{
+		std::fill(depth.begin(), depth.end(), clearDepth);
+
+		// Pick the axes for this view: which normalized axis maps to
+		// screen x, screen y and depth, and whether x and depth flip
+		// - Views 0/1 look along +Z/-Z, 2/3 along +X/-X, 4/5 along +Y/-Y
+		int axis = view / 2;
+		bool flip = (view & 1) != 0;
+		int xAxis = axis == 0 ? 0 : (axis == 1 ? 2 : 0);
+		int yAxis = axis == 2 ? 2 : 1;
+		int zAxis = axis == 0 ? 2 : (axis == 1 ? 0 : 1);
+		bool mirrorX = (axis != 0) != flip;
+
+		for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+		{
+			float corners[3][3];
+			for (int k = 0; k < 3; k++)
+			{
+				const float* p = GetPosition(vertices, vertexStride, indices[i + k]);
+				float x = (p[xAxis] - minPos[xAxis]) * scale;
+				float y = (p[yAxis] - minPos[yAxis]) * scale;
+				float z = (p[zAxis] - minPos[zAxis]) * scale;
+
+				corners[k][0] = (mirrorX ? 1.0f - x : x) * overdrawResolution;
+				corners[k][1] = y * overdrawResolution;
+				corners[k][2] = flip ? 1.0f - z : z;
+			}
+
+			// Front faces are clockwise (the D3D default), so swap two
+			// corners to make them counter-clockwise for the rasterizer
+			RasterizeTriangle(corners[0], corners[2], corners[1], depth, stats);
+		}
+	}
+
+	stats.overdraw = stats.pixelsCovered > 0 ? (float)stats.pixelsShaded / stats.pixelsCovered : 0.0f;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Measures how many bytes of the vertex buffer get read
+//
+// - Only vertices that miss the post-transform cache are
+//   fetched, and each fetch goes through a small FIFO cache
+//   of 64 byte lines
+// --------------------------------------------------------
+VertexFetchStats MeshOptimizer::AnalyzeVertexFetch(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int vertexStride)
+{
+	VertexFetchStats stats = {};
+	if (indexCount < 3 || vertexCount == 0 || vertexStride == 0)
+		return stats;
+
+	unsigned long long bufferBytes = (unsigned long long)vertexCount * vertexStride;
+	std::vector<unsigned int> cacheTime(vertexCount, 0);
+	std::vector<unsigned int> lineTime((size_t)((bufferBytes + fetchLineSize - 1) / fetchLineSize), 0);
+	unsigned int timestamp = DefaultCacheSize + 1;
+	unsigned int lineTimestamp = fetchCacheLines + 1;
+
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int v = indices[i];
+		if (timestamp - cacheTime[v] <= DefaultCacheSize)
+			continue;
+		cacheTime[v] = timestamp++;
+
+		// Fetch every line this vertex touches
+		unsigned long long firstLine = (unsigned long long)v * vertexStride / fetchLineSize;
+		unsigned long long lastLine = ((unsigned long long)v * vertexStride + vertexStride - 1) / fetchLineSize;
+		for (unsigned long long line = firstLine; line <= lastLine; line++)
+		{
+			if (lineTimestamp - lineTime[(size_t)line] > fetchCacheLines)
+			{
+				lineTime[(size_t)line] = lineTimestamp++;
+				stats.bytesFetched += fetchLineSize;
+			}
+		}
+	}
+
+	stats.overfetch = (float)((double)stats.bytesFetched / bufferBytes);
+	return stats;
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+
+// --------------------------------------------------------
+// Post-transform vertex cache results from a FIFO simulation
+//
+// - ACMR: average cache misses per triangle (0.5 is ideal for
+//   large regular grids, 3.0 means no reuse at all)
+// - ATVR: average transforms per vertex (1.0 is ideal)
+// --------------------------------------------------------
+struct VertexCacheStats
+{
+	unsigned int cacheSize;
+	unsigned int misses;
+	float acmr;
+	float atvr;
+};
+
+// --------------------------------------------------------
+// Overdraw results from the software rasterizer
+//
+// - Overdraw is pixels shaded / pixels covered, so 1.0 means
+//   every covered pixel was only shaded once
+// --------------------------------------------------------
+struct OverdrawStats
+{
+	unsigned long long pixelsCovered;
+	unsigned long long pixelsShaded;
+	float overdraw;
+};
+
+// --------------------------------------------------------
+// Vertex fetch results from a cache line simulation
+//
+// - Overfetch is bytes fetched / vertex buffer size, so 1.0
+//   means every byte of the buffer was read exactly once
+// --------------------------------------------------------
+struct VertexFetchStats
+{
+	unsigned long long bytesFetched;
+	float overfetch;
+};
+
+// --------------------------------------------------------
+// Before/after report for a full optimization pass
+// --------------------------------------------------------
+struct MeshOptimizerStats
+{
+	VertexCacheStats cacheBefore;
+	VertexCacheStats cacheAfter;
+	OverdrawStats overdrawBefore;
+	OverdrawStats overdrawAfter;
+	VertexFetchStats fetchBefore;
+	VertexFetchStats fetchAfter;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Reorders indexed triangle meshes for the GPU
+//
+// - OptimizeVertexCache: Tipsify (Sander et al. 2007) ordering
+//   for the post-transform vertex cache
+// - OptimizeOverdraw: splits the cache-ordered triangles into
+//   clusters and draws outward-facing clusters first, giving up
+//   at most "threshold" times the ACMR
+// - OptimizeVertexFetch: reorders the vertex buffer by first use
+//   so vertex fetches walk memory linearly
+// - The Analyze functions measure each of these on the CPU, so
+//   the gains can be checked without a GPU
+// - Positions are read as 3 floats at the start of each vertex,
+//   and there's no DirectX dependency so it can be used by tools
+// --------------------------------------------------------
+class MeshOptimizer
+{
+public:
+	// Typical post-transform cache size to optimize and measure against
+	static const unsigned int DefaultCacheSize = 16;
+
+	// Runs every pass in the order they need to happen, measuring
+	// before and after. Returns the (possibly smaller) vertex count
+	static unsigned int OptimizeMesh(
+		void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		unsigned int* indices, unsigned int indexCount,
+		MeshOptimizerStats* stats = nullptr);
+
+	// Individual passes
+	static void OptimizeVertexCache(unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize = DefaultCacheSize);
+	static void OptimizeOverdraw(
+		unsigned int* indices, unsigned int indexCount,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		unsigned int cacheSize = DefaultCacheSize, float threshold = 1.05f);
+	static unsigned int OptimizeVertexFetch(void* vertices, unsigned int vertexCount, unsigned int vertexStride, unsigned int* indices, unsigned int indexCount);
+
+	// Measurements
+	static VertexCacheStats AnalyzeVertexCache(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int cacheSize = DefaultCacheSize);
+	static OverdrawStats AnalyzeOverdraw(const unsigned int* indices, unsigned int indexCount, const void* vertices, unsigned int vertexCount, unsigned int vertexStride);
+	static VertexFetchStats AnalyzeVertexFetch(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount, unsigned int vertexStride);
+};
@@ -0,0 +1,838 @@
+#include "MeshSimplifier.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	// Smallest LOD worth generating, in triangles
+	const unsigned int minLODTriangles = 16;
+
+	// A LOD has to drop at least this fraction of the previous
+	// LOD's triangles to be kept
+	const float minLODReduction = 0.25f;
+
+	// A collapse may only turn a triangle's normal by up to ~75 degrees
+	const float minNormalDot = 0.25f;
+
+	// How strongly borders and seams resist moving, relative to surfaces
+	const double edgeQuadricWeight = 10.0;
+
+	inline const float* GetPosition(const void* vertices, unsigned int vertexStride, unsigned int index)
+	{
+		return reinterpret_cast<const float*>(static_cast<const unsigned char*>(vertices) + (size_t)index * vertexStride);
+	}
+
+	inline void Cross(const float a[3], const float b[3], const float c[3], double out[3])
+	{
+		double e1[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+		double e2[3] = { (double)c[0] - a[0], (double)c[1] - a[1], (double)c[2] - a[2] };
+		out[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		out[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		out[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	// --------------------------------------------------------
+	// Exact position match for welding vertices across seams
+	// --------------------------------------------------------
+	struct PositionKey
+	{
+		unsigned int bits[3];
+
+		bool operator==(const PositionKey& other) const
+		{
+			return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+		}
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			size_t hash = key.bits[0] * 73856093u;
+			hash ^= key.bits[1] * 19349663u;
+			hash ^= key.bits[2] * 83492791u;
+			return hash;
+		}
+	};
+
+	// --------------------------------------------------------
+	// Symmetric 4x4 error quadric, weighted by triangle area
+	//
+	// - Evaluate() / weight is the average squared distance from
+	//   a point to the planes that were added
+	// --------------------------------------------------------
+	struct Quadric
+	{
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		void AddPlane(const double n[3], double d, double w)
+		{
+			a00 += w * n[0] * n[0]; a01 += w * n[0] * n[1]; a02 += w * n[0] * n[2];
+			a11 += w * n[1] * n[1]; a12 += w * n[1] * n[2]; a22 += w * n[2] * n[2];
+			b0 += w * n[0] * d; b1 += w * n[1] * d; b2 += w * n[2] * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& q)
+		{
+			a00 += q.a00; a01 += q.a01; a02 += q.a02;
+			a11 += q.a11; a12 += q.a12; a22 += q.a22;
+			b0 += q.b0; b1 += q.b1; b2 += q.b2;
+			c += q.c;
+			weight += q.weight;
+		}
+
+		double Evaluate(const float p[3]) const
+		{
+			double x = p[0], y = p[1], z = p[2];
+			double result =
+				a00 * x * x + a11 * y * y + a22 * z * z +
+				2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2.0 * (b0 * x + b1 * y + b2 * z) +
+				c;
+			return result > 0.0 ? result : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		unsigned int from;
+		unsigned int to;
+		float cost;
+	};
+
+	// --------------------------------------------------------
+	// Vertex to triangle adjacency, stored flat
+	//
+	// - The triangles using vertex v are
+	//   triangles[offsets[v]] to triangles[offsets[v + 1] - 1]
+	// --------------------------------------------------------
+	struct Adjacency
+	{
+		std::vector<unsigned int> offsets;
+		std::vector<unsigned int> triangles;
+	};
+
+	void BuildAdjacency(Adjacency& adjacency, const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount)
+	{
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		adjacency.triangles.resize(indexCount);
+
+		// Count, then prefix sum, then fill
+		for (unsigned int i = 0; i < indexCount; i++)
+			adjacency.offsets[indices[i] + 1]++;
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+			adjacency.offsets[v + 1] += adjacency.offsets[v];
+
+		std::vector<unsigned int> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (unsigned int i = 0; i < indexCount; i++)
+			adjacency.triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	// --------------------------------------------------------
+	// Points indices at one copy of each byte-identical vertex and
+	// drops repeated triangles, keeping the first of each
+	//
+	// - Returns the new index count
+	// - Some exporters write surfaces twice, which only ever
+	//   adds overdraw, and would lock every vertex here
+	// --------------------------------------------------------
+	unsigned int RemoveDuplicates(unsigned int* indices, unsigned int indexCount, const void* vertices, unsigned int vertexCount, unsigned int vertexStride)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(vertices);
+
+		std::vector<bool> referenced(vertexCount, false);
+		for (unsigned int i = 0; i < indexCount; i++)
+			referenced[indices[i]] = true;
+
+		std::vector<unsigned int> order;
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			if (referenced[v])
+				order.push_back(v);
+		}
+
+		std::sort(order.begin(), order.end(),
+			[&](unsigned int a, unsigned int b)
+			{
+				int compare = memcmp(bytes + (size_t)a * vertexStride, bytes + (size_t)b * vertexStride, vertexStride);
+				return compare < 0 || (compare == 0 && a < b);
+			});
+
+		std::vector<unsigned int> canonical(vertexCount);
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			bool same = i > 0 && memcmp(bytes + (size_t)order[i - 1] * vertexStride, bytes + (size_t)order[i] * vertexStride, vertexStride) == 0;
+			canonical[order[i]] = same ? canonical[order[i - 1]] : order[i];
+		}
+
+		// Rotate each triangle to start at its lowest index (keeping the
+		// winding), so repeats sort next to each other
+		unsigned int triangleCount = indexCount / 3;
+		std::vector<unsigned int> triangles(indexCount);
+		std::vector<bool> keep(triangleCount, true);
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			unsigned int corners[3] = { canonical[indices[t * 3]], canonical[indices[t * 3 + 1]], canonical[indices[t * 3 + 2]] };
+
+			// Merged vertices can also leave triangles with no area
+			if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+				keep[t] = false;
+
+			int first = corners[1] < corners[0] ? (corners[2] < corners[1] ? 2 : 1) : (corners[2] < corners[0] ? 2 : 0);
+			for (int k = 0; k < 3; k++)
+				triangles[t * 3 + k] = corners[(first + k) % 3];
+		}
+
+		std::vector<unsigned int> triangleOrder(triangleCount);
+		for (unsigned int t = 0; t < triangleCount; t++)
+			triangleOrder[t] = t;
+
+		std::sort(triangleOrder.begin(), triangleOrder.end(),
+			[&](unsigned int a, unsigned int b)
+			{
+				int compare = memcmp(&triangles[a * 3], &triangles[b * 3], 3 * sizeof(unsigned int));
+				return compare < 0 || (compare == 0 && a < b);
+			});
+
+		for (unsigned int i = 1; i < triangleCount; i++)
+		{
+			if (memcmp(&triangles[triangleOrder[i - 1] * 3], &triangles[triangleOrder[i] * 3], 3 * sizeof(unsigned int)) == 0)
+				keep[triangleOrder[i]] = false;
+		}
+
+		unsigned int writeIndex = 0;
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			if (!keep[t])
+				continue;
+
+			for (int k = 0; k < 3; k++)
+				indices[writeIndex++] = triangles[t * 3 + k];
+		}
+		return writeIndex;
+	}
+
+	// --------------------------------------------------------
+	// What a position is allowed to do during simplification
+	//
+	// - Manifold: one vertex, fully surrounded, can collapse anywhere
+	// - Border: one vertex on an open edge, can only slide along it
+	// - Seam: two vertices with different attributes, can only
+	//   slide along the seam, taking both vertices with it
+	// - Locked: anything else (corners, seam ends, non-manifold)
+	// --------------------------------------------------------
+	enum VertexKind : unsigned char
+	{
+		Manifold,
+		Border,
+		Seam,
+		Locked
+	};
+
+	// --------------------------------------------------------
+	// Everything a collapse check needs about the current pass
+	// --------------------------------------------------------
+	struct SimplifyState
+	{
+		const unsigned int* indices;
+		const void* vertices;
+		unsigned int vertexStride;
+		const std::vector<unsigned int>* remap;
+		const std::vector<unsigned char>* kinds;
+		const std::vector<unsigned int>* wedgeCount;
+		const std::vector<unsigned int>* collapseTo;
+		const Adjacency* adjacency;
+
+		// Scratch space, reused between checks
+		std::vector<unsigned int> fromNeighbours;
+		std::vector<std::pair<unsigned int, unsigned int>> wedgeMoves;
+	};
+
+	// --------------------------------------------------------
+	// Checks whether every vertex at from's position can collapse
+	// onto to's position without breaking a seam or border,
+	// flipping a triangle or pinching the surface
+	//
+	// - On success, wedgeMoves holds where each of from's vertices
+	//   goes, removedTriangles how many triangles vanish and
+	//   distance how far from's position is from the new surface
+	// - The adjacency is by position, so it covers all the
+	//   vertices sharing one
+	// --------------------------------------------------------
+	bool CanCollapse(SimplifyState& state, unsigned int from, unsigned int to, unsigned int& removedTriangles, float& distance)
+	{
+		const std::vector<unsigned int>& remap = *state.remap;
+		const std::vector<unsigned int>& collapseTo = *state.collapseTo;
+		const Adjacency& adjacency = *state.adjacency;
+		unsigned int fromPosition = remap[from];
+		unsigned int toPosition = remap[to];
+		const float* source = GetPosition(state.vertices, state.vertexStride, from);
+		const float* target = GetPosition(state.vertices, state.vertexStride, to);
+		double offset[3] = { (double)source[0] - target[0], (double)source[1] - target[1], (double)source[2] - target[2] };
+
+		removedTriangles = 0;
+		distance = 0.0f;
+		state.fromNeighbours.clear();
+		state.wedgeMoves.clear();
+
+		for (unsigned int a = adjacency.offsets[fromPosition]; a < adjacency.offsets[fromPosition + 1]; a++)
+		{
+			const unsigned int* triangle = state.indices + adjacency.triangles[a] * 3;
+			unsigned int corners[3] = { collapseTo[triangle[0]], collapseTo[triangle[1]], collapseTo[triangle[2]] };
+
+			int fromCorner = -1;
+			int toCorner = -1;
+			for (int k = 0; k < 3; k++)
+			{
+				if (remap[corners[k]] == fromPosition) fromCorner = k;
+				if (remap[corners[k]] == toPosition) toCorner = k;
+			}
+
+			// Triangles on the collapsing edge vanish, and say which
+			// vertex at the target each of from's vertices lines up with
+			if (toCorner >= 0)
+			{
+				removedTriangles++;
+
+				unsigned int wedge = corners[fromCorner];
+				bool found = false;
+				for (const std::pair<unsigned int, unsigned int>& move : state.wedgeMoves)
+				{
+					if (move.first != wedge)
+						continue;
+
+					// A vertex pulled two ways would tear its attributes
+					if (move.second != corners[toCorner])
+						return false;
+					found = true;
+				}
+
+				if (!found)
+					state.wedgeMoves.push_back({ wedge, corners[toCorner] });
+				continue;
+			}
+
+			// Every other triangle must keep roughly the same facing
+			const float* positions[3];
+			const float* moved[3];
+			for (int k = 0; k < 3; k++)
+			{
+				positions[k] = GetPosition(state.vertices, state.vertexStride, corners[k]);
+				moved[k] = k == fromCorner ? target : positions[k];
+
+				if (k != fromCorner)
+					state.fromNeighbours.push_back(remap[corners[k]]);
+			}
+
+			double before[3], after[3];
+			Cross(positions[0], positions[1], positions[2], before);
+			Cross(moved[0], moved[1], moved[2], after);
+
+			double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+			double lengths =
+				std::sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+				std::sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+			if (dot < minNormalDot * lengths)
+				return false;
+
+			// The moved triangle's plane passes through the target
+			double afterLength = std::sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+			double planeDistance = std::fabs(after[0] * offset[0] + after[1] * offset[1] + after[2] * offset[2]) / afterLength;
+			distance = std::max(distance, (float)planeDistance);
+		}
+
+		// Borders slide along their single-triangle edges, and seams need
+		// both of their vertices to follow the seam to the same place
+		unsigned char kind = (*state.kinds)[fromPosition];
+		if (kind == Border && removedTriangles != 1)
+			return false;
+
+		if (state.wedgeMoves.size() != (*state.wedgeCount)[fromPosition])
+			return false;
+
+		// Link condition: the only positions both ends share should be
+		// the ones opposite the edge, or the surface gets pinched
+		std::sort(state.fromNeighbours.begin(), state.fromNeighbours.end());
+		state.fromNeighbours.erase(std::unique(state.fromNeighbours.begin(), state.fromNeighbours.end()), state.fromNeighbours.end());
+
+		unsigned int shared = 0;
+		for (unsigned int a = adjacency.offsets[toPosition]; a < adjacency.offsets[toPosition + 1]; a++)
+		{
+			const unsigned int* triangle = state.indices + adjacency.triangles[a] * 3;
+			for (int k = 0; k < 3; k++)
+			{
+				unsigned int corner = remap[collapseTo[triangle[k]]];
+				if (corner == toPosition || corner == fromPosition)
+					continue;
+
+				std::vector<unsigned int>::iterator it = std::lower_bound(state.fromNeighbours.begin(), state.fromNeighbours.end(), corner);
+				if (it != state.fromNeighbours.end() && *it == corner)
+				{
+					// Only count each shared neighbour once
+					shared++;
+					state.fromNeighbours.erase(it);
+				}
+			}
+		}
+
+		return shared <= removedTriangles;
+	}
+
+	// --------------------------------------------------------
+	// Adds a plane through an open edge, perpendicular to its
+	// triangle, so borders and seams keep their shape
+	// --------------------------------------------------------
+	void AddEdgeQuadric(Quadric& quadric, const float a[3], const float b[3], const double triangleNormal[3])
+	{
+		double edge[3] = { (double)b[0] - a[0], (double)b[1] - a[1], (double)b[2] - a[2] };
+		double normal[3] = {
+			edge[1] * triangleNormal[2] - edge[2] * triangleNormal[1],
+			edge[2] * triangleNormal[0] - edge[0] * triangleNormal[2],
+			edge[0] * triangleNormal[1] - edge[1] * triangleNormal[0]
+		};
+
+		double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length == 0.0)
+			return;
+
+		for (int k = 0; k < 3; k++)
+			normal[k] /= length;
+
+		double d = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+		double edgeLengthSquared = edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2];
+		quadric.AddPlane(normal, d, edgeLengthSquared * edgeQuadricWeight);
+	}
+}
+
+// --------------------------------------------------------
+// Simplifies a triangle list with quadric error collapses
+//
+// Works in passes: every edge is scored, then the cheapest
+// collapses are applied as long as they don't touch a position
+// that already changed this pass. Repeats until the target
+// is met or nothing else can collapse within targetError
+// --------------------------------------------------------
+unsigned int MeshSimplifier::Simplify(
+	unsigned int* destination,
+	const unsigned int* indices, unsigned int indexCount,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	unsigned int targetIndexCount, float targetError,
+	float* resultError,
+	MeshSimplifierStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	indexCount -= indexCount % 3;
+	memmove(destination, indices, indexCount * sizeof(unsigned int));
+
+	if (stats)
+		*stats = MeshSimplifierStats();
+
+	// Duplicate surfaces look non-manifold and would lock everything
+	indexCount = RemoveDuplicates(destination, indexCount, vertices, vertexCount, vertexStride);
+
+	// Weld referenced vertices by position, so seams can be found
+	// and each position gets a single quadric
+	std::vector<unsigned int> remap(vertexCount);
+	std::vector<unsigned int> wedgeCount(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	for (unsigned int i = 0; i < indexCount; i++)
+		referenced[destination[i]] = true;
+
+	std::unordered_map<PositionKey, unsigned int, PositionKeyHash> positionIds;
+	positionIds.reserve(vertexCount);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		remap[v] = v;
+		if (!referenced[v])
+			continue;
+
+		// Adding zero folds -0 into +0
+		const float* p = GetPosition(vertices, vertexStride, v);
+		PositionKey key;
+		for (int k = 0; k < 3; k++)
+		{
+			float value = p[k] + 0.0f;
+			memcpy(&key.bits[k], &value, sizeof(float));
+		}
+
+		remap[v] = positionIds.emplace(key, v).first->second;
+		wedgeCount[remap[v]]++;
+	}
+
+	// Triangles around each position
+	std::vector<unsigned int> positionIndices(indexCount);
+	for (unsigned int i = 0; i < indexCount; i++)
+		positionIndices[i] = remap[destination[i]];
+
+	Adjacency adjacency;
+	BuildAdjacency(adjacency, positionIndices.data(), indexCount, vertexCount);
+
+	// Plane quadrics per position
+	std::vector<Quadric> quadrics(vertexCount, Quadric());
+	std::vector<double> triangleNormals(indexCount, 0.0);
+	for (unsigned int i = 0; i < indexCount; i += 3)
+	{
+		const float* p0 = GetPosition(vertices, vertexStride, destination[i]);
+		const float* p1 = GetPosition(vertices, vertexStride, destination[i + 1]);
+		const float* p2 = GetPosition(vertices, vertexStride, destination[i + 2]);
+
+		double* normal = &triangleNormals[i];
+		Cross(p0, p1, p2, normal);
+		double length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		if (length == 0.0)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+			normal[k] /= length;
+
+		double d = -(normal[0] * p0[0] + normal[1] * p0[1] + normal[2] * p0[2]);
+		double area = length * 0.5;
+		for (unsigned int k = 0; k < 3; k++)
+			quadrics[positionIndices[i + k]].AddPlane(normal, d, area);
+	}
+
+	// Classify every edge by looking for its opposite: missing by
+	// position is a border, missing only by vertex is a seam
+	std::vector<unsigned int> borderEdges(vertexCount, 0);
+	std::vector<unsigned int> seamEdges(vertexCount, 0);
+	std::vector<bool> nonManifold(vertexCount, false);
+	for (unsigned int i = 0; i < indexCount; i++)
+	{
+		unsigned int next = i - i % 3 + (i + 1) % 3;
+		unsigned int a = destination[i];
+		unsigned int b = destination[next];
+		unsigned int positionA = positionIndices[i];
+		unsigned int positionB = positionIndices[next];
+
+		bool positionOpposite = false;
+		bool vertexOpposite = false;
+		unsigned int sameDirection = 0;
+		for (unsigned int t = adjacency.offsets[positionB]; t < adjacency.offsets[positionB + 1]; t++)
+		{
+			unsigned int triangle = adjacency.triangles[t] * 3;
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				unsigned int c = triangle + k;
+				unsigned int d = triangle + (k + 1) % 3;
+				if (positionIndices[c] == positionB && positionIndices[d] == positionA)
+				{
+					positionOpposite = true;
+					vertexOpposite = vertexOpposite || (destination[c] == b && destination[d] == a);
+				}
+				if (positionIndices[c] == positionA && positionIndices[d] == positionB)
+					sameDirection++;
+			}
+		}
+
+		if (sameDirection > 1)
+			nonManifold[positionA] = nonManifold[positionB] = true;
+
+		if (!positionOpposite)
+		{
+			borderEdges[positionA]++;
+			borderEdges[positionB]++;
+		}
+		else if (!vertexOpposite)
+		{
+			seamEdges[positionA]++;
+			seamEdges[positionB]++;
+		}
+
+		// Open edges of either kind keep their shape
+		if (!vertexOpposite)
+		{
+			const float* pa = GetPosition(vertices, vertexStride, a);
+			const float* pb = GetPosition(vertices, vertexStride, b);
+			AddEdgeQuadric(quadrics[positionA], pa, pb, &triangleNormals[i - i % 3]);
+			AddEdgeQuadric(quadrics[positionB], pa, pb, &triangleNormals[i - i % 3]);
+		}
+	}
+
+	// A border position touches exactly two border edges, and a seam
+	// position is two vertices that each touch two seam edges
+	std::vector<unsigned char> kinds(vertexCount, Locked);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		if (remap[v] != v || !referenced[v] || nonManifold[v])
+			continue;
+
+		if (wedgeCount[v] == 1 && borderEdges[v] == 0 && seamEdges[v] == 0)
+			kinds[v] = Manifold;
+		else if (wedgeCount[v] == 1 && borderEdges[v] == 2 && seamEdges[v] == 0)
+			kinds[v] = Border;
+		else if (wedgeCount[v] == 2 && borderEdges[v] == 0 && seamEdges[v] == 4)
+			kinds[v] = Seam;
+	}
+
+	if (stats)
+	{
+		for (unsigned int v = 0; v < vertexCount; v++)
+			stats->lockedVertices += referenced[v] && kinds[remap[v]] == Locked ? 1 : 0;
+	}
+
+	// Collapse in passes
+	// - Quadrics decide the order, but the reported error is the
+	//   distance each collapsed position ends up from the surface,
+	//   carried along by whatever it collapsed onto
+	std::vector<float> positionErrors(vertexCount, 0.0f);
+	float maxError = 0.0f;
+
+	std::vector<Collapse> candidates;
+	std::vector<unsigned int> collapseTo(vertexCount);
+	std::vector<bool> touched(vertexCount);
+
+	SimplifyState state;
+	state.indices = destination;
+	state.vertices = vertices;
+	state.vertexStride = vertexStride;
+	state.remap = &remap;
+	state.kinds = &kinds;
+	state.wedgeCount = &wedgeCount;
+	state.collapseTo = &collapseTo;
+	state.adjacency = &adjacency;
+
+	for (bool firstPass = true; indexCount > targetIndexCount; firstPass = false)
+	{
+		if (!firstPass)
+		{
+			for (unsigned int i = 0; i < indexCount; i++)
+				positionIndices[i] = remap[destination[i]];
+			BuildAdjacency(adjacency, positionIndices.data(), indexCount, vertexCount);
+		}
+
+		// Score both directions of every edge that can move, skipping
+		// the ones that would drag a border or seam off itself
+		candidates.clear();
+		for (unsigned int i = 0; i < indexCount; i++)
+		{
+			unsigned int a = destination[i];
+			unsigned int b = destination[i - i % 3 + (i + 1) % 3];
+			unsigned int ends[2][2] = { { a, b }, { b, a } };
+			for (int e = 0; e < 2; e++)
+			{
+				unsigned int from = remap[ends[e][0]];
+				unsigned int to = remap[ends[e][1]];
+				unsigned char kind = kinds[from];
+				if (from == to || kind == Locked || (kind != Manifold && kinds[to] == Manifold))
+					continue;
+
+				// Interior edges show up once from each side
+				if (kind == Manifold && e == 1)
+					continue;
+
+				Quadric q = quadrics[from];
+				q.Add(quadrics[to]);
+
+				Collapse collapse;
+				collapse.from = ends[e][0];
+				collapse.to = ends[e][1];
+				collapse.cost = q.weight > 0.0 ? (float)(q.Evaluate(GetPosition(vertices, vertexStride, collapse.to)) / q.weight) : 0.0f;
+				candidates.push_back(collapse);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(),
+			[](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+			collapseTo[v] = v;
+		touched.assign(vertexCount, false);
+
+		// Apply the cheapest collapses first, each position at most once
+		unsigned int trianglesToRemove = (indexCount - targetIndexCount) / 3;
+		unsigned int trianglesRemoved = 0;
+		unsigned int passCollapses = 0;
+		for (const Collapse& collapse : candidates)
+		{
+			if (trianglesRemoved >= trianglesToRemove)
+				break;
+
+			unsigned int from = remap[collapse.from];
+			unsigned int to = remap[collapse.to];
+			if (touched[from] || touched[to])
+				continue;
+
+			unsigned int removedTriangles;
+			float distance;
+			if (!CanCollapse(state, collapse.from, collapse.to, removedTriangles, distance))
+				continue;
+
+			float error = std::max(positionErrors[from], distance);
+			if (error > targetError)
+				continue;
+
+			for (const std::pair<unsigned int, unsigned int>& move : state.wedgeMoves)
+				collapseTo[move.first] = move.second;
+			quadrics[to].Add(quadrics[from]);
+			touched[from] = touched[to] = true;
+
+			positionErrors[to] = std::max(positionErrors[to], error);
+			maxError = std::max(maxError, error);
+			trianglesRemoved += removedTriangles;
+			passCollapses++;
+		}
+
+		if (stats)
+		{
+			stats->collapses += passCollapses;
+			stats->passes++;
+		}
+
+		if (passCollapses == 0)
+			break;
+
+		// Apply the collapses and drop the triangles that vanished
+		unsigned int writeIndex = 0;
+		for (unsigned int i = 0; i < indexCount; i += 3)
+		{
+			unsigned int corners[3] = { collapseTo[destination[i]], collapseTo[destination[i + 1]], collapseTo[destination[i + 2]] };
+			if (remap[corners[0]] == remap[corners[1]] || remap[corners[1]] == remap[corners[2]] || remap[corners[0]] == remap[corners[2]])
+				continue;
+
+			destination[writeIndex++] = corners[0];
+			destination[writeIndex++] = corners[1];
+			destination[writeIndex++] = corners[2];
+		}
+		indexCount = writeIndex;
+	}
+
+	if (resultError)
+		*resultError = maxError;
+
+	if (stats)
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	return indexCount;
+}
+
+// --------------------------------------------------------
+// Builds a chain of LODs, each simplified from the one before
+//
+// - Errors are summed down the chain, since each LOD's error
+//   is measured against the LOD it was made from
+// - Each LOD is reordered for the vertex cache on its own
+// --------------------------------------------------------
+void MeshSimplifier::GenerateLODs(
+	std::vector<unsigned int>& indices,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	std::vector<MeshLOD>& lods,
+	MeshSimplifierStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	if (stats)
+		*stats = MeshSimplifierStats();
+
+	lods.clear();
+	lods.push_back({ 0, (unsigned int)indices.size(), 0.0f });
+
+	std::vector<unsigned int> source;
+	std::vector<unsigned int> simplified;
+	while (lods.size() < MaxLODs)
+	{
+		MeshLOD previous = lods.back();
+		unsigned int targetIndexCount = previous.indexCount / 6 * 3;
+		if (targetIndexCount < minLODTriangles * 3)
+			break;
+
+		source.assign(indices.begin() + previous.indexOffset, indices.begin() + previous.indexOffset + previous.indexCount);
+		simplified.resize(source.size());
+
+		float error = 0.0f;
+		MeshSimplifierStats lodStats = {};
+		unsigned int indexCount = Simplify(
+			simplified.data(),
+			source.data(), (unsigned int)source.size(),
+			vertices, vertexCount, vertexStride,
+			targetIndexCount, FLT_MAX,
+			&error, &lodStats);
+
+		if (stats)
+		{
+			stats->lockedVertices = std::max(stats->lockedVertices, lodStats.lockedVertices);
+			stats->collapses += lodStats.collapses;
+			stats->passes += lodStats.passes;
+		}
+
+		// Stop once the locked vertices stop it from paying off
+		if (indexCount == 0 || indexCount > previous.indexCount * (1.0f - minLODReduction))
+			break;
+
+		MeshOptimizer::OptimizeVertexCache(simplified.data(), indexCount, vertexCount);
+
+		lods.push_back({ (unsigned int)indices.size(), indexCount, previous.error + error });
+		indices.insert(indices.end(), simplified.begin(), simplified.begin() + indexCount);
+	}
+
+	if (stats)
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+// --------------------------------------------------------
+// Picks a LOD by projected error
+//
+// - Errors only grow down the chain, so the first LOD that
+//   would be visibly wrong ends the search
+// --------------------------------------------------------
+unsigned int MeshSimplifier::SelectLOD(const MeshLOD* lods, unsigned int lodCount, float pixelsPerUnit, float maxPixelError)
+{
+	unsigned int selected = 0;
+	for (unsigned int l = 1; l < lodCount; l++)
+	{
+		if (lods[l].error * pixelsPerUnit > maxPixelError)
+			break;
+
+		selected = l;
+	}
+	return selected;
+}
+
+LODView MeshSimplifier::MakeLODView(const float cameraPosition[3], bool perspective,
+	float fieldOfView, float orthographicHeight, float nearClip, float viewportHeight)
+{
+	LODView view = {};
+	view.position[0] = cameraPosition[0];
+	view.position[1] = cameraPosition[1];
+	view.position[2] = cameraPosition[2];
+	view.screenScale = perspective ?
+		viewportHeight / (2.0f * tanf(fieldOfView * 0.5f)) :
+		viewportHeight / orthographicHeight;
+	view.nearClip = nearClip;
+	view.perspective = perspective;
+	return view;
+}
+
+// --------------------------------------------------------
+// Projects one mesh unit to the screen
+//
+// - Mesh errors grow with the mesh's scale
+// - With perspective, the nearest point of the bounding sphere
+//   is used, kept past the near clip so meshes around the
+//   camera don't divide by zero
+// --------------------------------------------------------
+float MeshSimplifier::GetPixelsPerUnit(const LODView& view, const float center[3], float radius, float scale)
+{
+	float pixelsPerUnit = view.screenScale * scale;
+	if (!view.perspective)
+		return pixelsPerUnit;
+
+	float x = center[0] - view.position[0];
+	float y = center[1] - view.position[1];
+	float z = center[2] - view.position[2];
+	float distance = sqrtf(x * x + y * y + z * z) - radius;
+	return pixelsPerUnit / (distance > view.nearClip ? distance : view.nearClip);
+}
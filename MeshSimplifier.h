@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// One level of detail within a mesh's index buffer
+//
+// - Every LOD shares the mesh's vertex buffer; only the
+//   triangles change, so a LOD is just a range of indices
+// - Error is the largest distance (in mesh units) the LOD's
+//   surface may be from the full resolution surface
+// --------------------------------------------------------
+struct MeshLOD
+{
+	unsigned int indexOffset;
+	unsigned int indexCount;
+	float error;
+};
+
+// --------------------------------------------------------
+// What LOD selection needs from a camera, gathered once a
+// frame (see MeshSimplifier::GetPixelsPerUnit)
+//
+// - screenScale is how many pixels one world unit covers one
+//   unit in front of the camera, or at any distance for an
+//   orthographic camera
+// --------------------------------------------------------
+struct LODView
+{
+	float position[3];
+	float screenScale;
+	float nearClip;
+	bool perspective;
+};
+
+// --------------------------------------------------------
+// Counters from building a LOD chain, used for benchmarking
+// --------------------------------------------------------
+struct MeshSimplifierStats
+{
+	unsigned int lockedVertices;
+	unsigned int collapses;
+	unsigned int passes;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Reduces triangle counts with quadric error edge collapses
+//
+// - Each position gets a quadric (Garland & Heckbert 1997)
+//   summing the squared distance to its triangles' planes,
+//   and the cheapest collapses are applied first
+// - Vertices only ever collapse onto existing vertices, so
+//   the vertex buffer never changes and LODs can share it
+// - Vertices on open borders and on UV/normal seams (more than
+//   one vertex at the same position) may only slide along them,
+//   so outlines and attribute discontinuities keep their shape;
+//   corners and anything non-manifold are locked
+// - Byte-identical vertices and repeated triangles are merged
+//   first, since duplicated surfaces would otherwise lock everything
+// - Collapses that would flip a triangle or pinch the surface
+//   are rejected
+// - Positions are read as 3 floats at the start of each vertex,
+//   and there's no DirectX dependency so it can be used by tools
+// --------------------------------------------------------
+class MeshSimplifier
+{
+public:
+	// Most LODs (including the full resolution one) in a chain
+	static const unsigned int MaxLODs = 4;
+
+	// Simplifies towards targetIndexCount without going past
+	// targetError, writing to destination (which needs room for
+	// indexCount indices). Returns the new index count
+	static unsigned int Simplify(
+		unsigned int* destination,
+		const unsigned int* indices, unsigned int indexCount,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		unsigned int targetIndexCount, float targetError,
+		float* resultError = nullptr,
+		MeshSimplifierStats* stats = nullptr);
+
+	// Appends LODs with half the triangles of the one before until
+	// MaxLODs is reached or simplification stops paying off. The
+	// indices start out as LOD 0, and the LOD table covers all of them
+	static void GenerateLODs(
+		std::vector<unsigned int>& indices,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		std::vector<MeshLOD>& lods,
+		MeshSimplifierStats* stats = nullptr);
+
+	// Picks the coarsest LOD whose error stays under maxPixelError,
+	// given how many pixels one mesh unit currently covers
+	static unsigned int SelectLOD(const MeshLOD* lods, unsigned int lodCount, float pixelsPerUnit, float maxPixelError);
+
+	// Gathers a camera's LOD settings. orthographicHeight is the view's
+	// height in world units, and is only used when not perspective
+	static LODView MakeLODView(const float cameraPosition[3], bool perspective,
+		float fieldOfView, float orthographicHeight, float nearClip, float viewportHeight);
+
+	// How many pixels one mesh unit covers, for a mesh scaled by scale
+	// with the world space bounding sphere (center, radius)
+	static float GetPixelsPerUnit(const LODView& view, const float center[3], float radius, float scale);
+};
@@ -0,0 +1,423 @@
+#include "MeshletBuilder.h"
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+
+namespace
+{
+	// Marks a vertex that isn't in the meshlet being built
+	const unsigned int notInMeshlet = 0xFFFFFFFFu;
+
+	inline const float* GetPosition(const void* vertices, unsigned int vertexStride, unsigned int index)
+	{
+		return reinterpret_cast<const float*>(static_cast<const unsigned char*>(vertices) + (size_t)index * vertexStride);
+	}
+
+	// --------------------------------------------------------
+	// Unit face normals, or zero for degenerate triangles
+	// --------------------------------------------------------
+	void ComputeTriangleNormals(
+		const unsigned int* indices, unsigned int triangleCount,
+		const void* vertices, unsigned int vertexStride,
+		std::vector<float>& normals)
+	{
+		normals.assign((size_t)triangleCount * 3, 0.0f);
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			const float* a = GetPosition(vertices, vertexStride, indices[t * 3 + 0]);
+			const float* b = GetPosition(vertices, vertexStride, indices[t * 3 + 1]);
+			const float* c = GetPosition(vertices, vertexStride, indices[t * 3 + 2]);
+
+			float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+			float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+			float n[3] = {
+				e1[1] * e2[2] - e1[2] * e2[1],
+				e1[2] * e2[0] - e1[0] * e2[2],
+				e1[0] * e2[1] - e1[1] * e2[0] };
+
+			float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			if (length <= FLT_MIN)
+				continue;
+
+			normals[t * 3 + 0] = n[0] / length;
+			normals[t * 3 + 1] = n[1] / length;
+			normals[t * 3 + 2] = n[2] / length;
+		}
+	}
+
+	// --------------------------------------------------------
+	// Vertex -> triangle lists, stored as offsets into one array
+	// --------------------------------------------------------
+	void BuildAdjacency(
+		const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+		std::vector<unsigned int>& offsets, std::vector<unsigned int>& triangles)
+	{
+		offsets.assign(vertexCount + 1, 0);
+		for (unsigned int i = 0; i < indexCount; i++)
+			offsets[indices[i] + 1]++;
+
+		for (unsigned int v = 0; v < vertexCount; v++)
+			offsets[v + 1] += offsets[v];
+
+		triangles.resize(indexCount);
+		std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+		for (unsigned int i = 0; i < indexCount; i++)
+			triangles[fill[indices[i]]++] = i / 3;
+	}
+
+	// --------------------------------------------------------
+	// Fills in a meshlet's bounding sphere and normal cone
+	//
+	// - The sphere is centered on the bounding box, which is
+	//   close enough to minimal for clusters this small
+	// - The cone axis is the average face normal, and the cutoff
+	//   is the widest any face strays from it
+	// --------------------------------------------------------
+	void ComputeBounds(
+		Meshlet& meshlet,
+		const unsigned int* indices,
+		const void* vertices, unsigned int vertexStride,
+		const float* normals, unsigned int firstTriangle)
+	{
+		unsigned int indexCount = meshlet.triangleCount * 3;
+		const unsigned int* meshletIndices = indices + meshlet.indexOffset;
+
+		// Bounding sphere
+		float minPos[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxPos[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (unsigned int i = 0; i < indexCount; i++)
+		{
+			const float* p = GetPosition(vertices, vertexStride, meshletIndices[i]);
+			for (int k = 0; k < 3; k++)
+			{
+				minPos[k] = std::min(minPos[k], p[k]);
+				maxPos[k] = std::max(maxPos[k], p[k]);
+			}
+		}
+
+		for (int k = 0; k < 3; k++)
+			meshlet.center[k] = (minPos[k] + maxPos[k]) * 0.5f;
+
+		float radiusSquared = 0.0f;
+		for (unsigned int i = 0; i < indexCount; i++)
+		{
+			const float* p = GetPosition(vertices, vertexStride, meshletIndices[i]);
+			float dx = p[0] - meshlet.center[0];
+			float dy = p[1] - meshlet.center[1];
+			float dz = p[2] - meshlet.center[2];
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		meshlet.radius = sqrtf(radiusSquared);
+
+		// Normal cone
+		float axis[3] = { 0, 0, 0 };
+		for (unsigned int t = 0; t < meshlet.triangleCount; t++)
+		{
+			const float* n = normals + (size_t)(firstTriangle + t) * 3;
+			axis[0] += n[0];
+			axis[1] += n[1];
+			axis[2] += n[2];
+		}
+
+		float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		if (axisLength <= FLT_MIN)
+		{
+			meshlet.coneAxis[0] = 0.0f;
+			meshlet.coneAxis[1] = 0.0f;
+			meshlet.coneAxis[2] = 1.0f;
+			meshlet.coneCutoff = -1.0f;
+			return;
+		}
+
+		for (int k = 0; k < 3; k++)
+			meshlet.coneAxis[k] = axis[k] / axisLength;
+
+		float minDot = 1.0f;
+		for (unsigned int t = 0; t < meshlet.triangleCount; t++)
+		{
+			const float* n = normals + (size_t)(firstTriangle + t) * 3;
+
+			// Degenerate triangles are never rasterized, so they don't count
+			if (n[0] == 0.0f && n[1] == 0.0f && n[2] == 0.0f)
+				continue;
+
+			minDot = std::min(minDot, n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2]);
+		}
+		meshlet.coneCutoff = minDot;
+	}
+}
+
+// --------------------------------------------------------
+// Partitions the triangles into meshlets
+//
+// - Each meshlet is seeded with the first unused triangle in
+//   the current order, so meshlets roughly follow the vertex
+//   cache ordering and their triangles stay in that order
+// - It then grows through triangles sharing a vertex with it:
+//   fewest new vertices first (keeps it compact and under the
+//   vertex limit), then closest to its average normal (keeps
+//   the cone tight)
+// --------------------------------------------------------
+void MeshletBuilder::BuildMeshlets(
+	unsigned int* indices, unsigned int indexCount,
+	const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+	std::vector<Meshlet>& meshlets,
+	MeshletStats* stats,
+	unsigned int maxVertices, unsigned int maxTriangles)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	meshlets.clear();
+	if (stats)
+		*stats = {};
+
+	unsigned int triangleCount = indexCount / 3;
+	if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0)
+		return;
+
+	std::vector<float> normals;
+	ComputeTriangleNormals(indices, triangleCount, vertices, vertexStride, normals);
+
+	std::vector<unsigned int> adjacencyOffsets;
+	std::vector<unsigned int> adjacency;
+	BuildAdjacency(indices, indexCount, vertexCount, adjacencyOffsets, adjacency);
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<unsigned int> slot(vertexCount, notInMeshlet);
+
+	// Triangles in meshlet order, plus the per-meshlet working set
+	std::vector<unsigned int> order;
+	order.reserve(triangleCount);
+	std::vector<unsigned int> meshletVertices;
+	std::vector<unsigned int> candidates;
+
+	unsigned int seedCursor = 0;
+	while (order.size() < triangleCount)
+	{
+		while (emitted[seedCursor])
+			seedCursor++;
+
+		Meshlet meshlet = {};
+		meshlet.indexOffset = (unsigned int)order.size() * 3;
+		float normalSum[3] = { 0, 0, 0 };
+		meshletVertices.clear();
+		candidates.clear();
+
+		unsigned int next = seedCursor;
+		while (true)
+		{
+			// Add the chosen triangle, queueing up the neighbours of its new vertices
+			emitted[next] = true;
+			order.push_back(next);
+			meshlet.triangleCount++;
+			for (int k = 0; k < 3; k++)
+				normalSum[k] += normals[next * 3 + k];
+
+			for (int c = 0; c < 3; c++)
+			{
+				unsigned int v = indices[next * 3 + c];
+				if (slot[v] != notInMeshlet)
+					continue;
+
+				slot[v] = (unsigned int)meshletVertices.size();
+				meshletVertices.push_back(v);
+				for (unsigned int a = adjacencyOffsets[v]; a < adjacencyOffsets[v + 1]; a++)
+				{
+					if (!emitted[adjacency[a]])
+						candidates.push_back(adjacency[a]);
+				}
+			}
+
+			if (meshlet.triangleCount >= maxTriangles)
+				break;
+
+			// Pick the best neighbour that still fits, dropping used ones as we go
+			float sumLength = sqrtf(normalSum[0] * normalSum[0] + normalSum[1] * normalSum[1] + normalSum[2] * normalSum[2]);
+			float facingScale = sumLength > FLT_MIN ? 1.0f / sumLength : 0.0f;
+			unsigned int best = notInMeshlet;
+			float bestScore = FLT_MAX;
+			size_t kept = 0;
+			for (size_t i = 0; i < candidates.size(); i++)
+			{
+				unsigned int t = candidates[i];
+				if (emitted[t])
+					continue;
+				candidates[kept++] = t;
+
+				unsigned int newVertices =
+					(slot[indices[t * 3 + 0]] == notInMeshlet) +
+					(slot[indices[t * 3 + 1]] == notInMeshlet) +
+					(slot[indices[t * 3 + 2]] == notInMeshlet);
+				if (meshletVertices.size() + newVertices > maxVertices)
+					continue;
+
+				// New vertices dominate; facing (dot in [-1, 1]) breaks ties
+				float facing = facingScale * (
+					normals[t * 3 + 0] * normalSum[0] +
+					normals[t * 3 + 1] * normalSum[1] +
+					normals[t * 3 + 2] * normalSum[2]);
+
+				float score = newVertices * 4.0f - facing;
+				if (score < bestScore)
+				{
+					bestScore = score;
+					best = t;
+				}
+			}
+			candidates.resize(kept);
+
+			if (best == notInMeshlet)
+				break;
+
+			next = best;
+		}
+
+		meshlet.vertexCount = (unsigned int)meshletVertices.size();
+		for (size_t i = 0; i < meshletVertices.size(); i++)
+			slot[meshletVertices[i]] = notInMeshlet;
+
+		meshlets.push_back(meshlet);
+	}
+
+	// Rewrite the indices (and normals to match) in meshlet order
+	std::vector<unsigned int> sourceIndices(indices, indices + triangleCount * 3);
+	std::vector<float> orderedNormals((size_t)triangleCount * 3);
+	for (unsigned int t = 0; t < triangleCount; t++)
+	{
+		unsigned int source = order[t];
+		for (int c = 0; c < 3; c++)
+		{
+			indices[t * 3 + c] = sourceIndices[source * 3 + c];
+			orderedNormals[t * 3 + c] = normals[source * 3 + c];
+		}
+	}
+
+	unsigned int cullable = 0;
+	for (size_t m = 0; m < meshlets.size(); m++)
+	{
+		ComputeBounds(meshlets[m], indices, vertices, vertexStride, orderedNormals.data(), meshlets[m].indexOffset / 3);
+		if (meshlets[m].coneCutoff > 0.0f)
+			cullable++;
+	}
+
+	if (stats)
+	{
+		unsigned int totalVertices = 0;
+		for (size_t m = 0; m < meshlets.size(); m++)
+			totalVertices += meshlets[m].vertexCount;
+
+		stats->meshletCount = (unsigned int)meshlets.size();
+		stats->averageVertices = (float)totalVertices / meshlets.size();
+		stats->averageTriangles = (float)triangleCount / meshlets.size();
+		stats->cullableFraction = (float)cullable / meshlets.size();
+		stats->acmr = MeshOptimizer::AnalyzeVertexCache(indices, triangleCount * 3, vertexCount).acmr;
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+}
+
+// --------------------------------------------------------
+// Gets the frustum planes from a row-vector (DirectX style)
+// matrix, with clip space z in [0, 1]
+//
+// - Planes face inwards and are normalized, so a plane's dot
+//   with a point is its signed distance
+// - Passing world * view * projection gives mesh space planes
+// --------------------------------------------------------
+void MeshletBuilder::ExtractFrustumPlanes(const float m[16], float planes[6][4])
+{
+	// Column j of the matrix gives clip coordinate j
+	for (int k = 0; k < 4; k++)
+	{
+		float x = m[k * 4 + 0];
+		float y = m[k * 4 + 1];
+		float z = m[k * 4 + 2];
+		float w = m[k * 4 + 3];
+
+		planes[0][k] = w + x;	// Left
+		planes[1][k] = w - x;	// Right
+		planes[2][k] = w + y;	// Bottom
+		planes[3][k] = w - y;	// Top
+		planes[4][k] = z;		// Near
+		planes[5][k] = w - z;	// Far
+	}
+
+	for (int p = 0; p < 6; p++)
+	{
+		float length = sqrtf(planes[p][0] * planes[p][0] + planes[p][1] * planes[p][1] + planes[p][2] * planes[p][2]);
+		if (length <= FLT_MIN)
+			continue;
+
+		for (int k = 0; k < 4; k++)
+			planes[p][k] /= length;
+	}
+}
+
+// --------------------------------------------------------
+// True if the bounding sphere is entirely behind any plane
+// --------------------------------------------------------
+bool MeshletBuilder::IsOutsideFrustum(const Meshlet& meshlet, const float planes[6][4])
+{
+	return IsSphereOutsideFrustum(meshlet.center, meshlet.radius, planes);
+}
+
+bool MeshletBuilder::IsSphereOutsideFrustum(const float center[3], float radius, const float planes[6][4])
+{
+	for (int p = 0; p < 6; p++)
+	{
+		float distance =
+			planes[p][0] * center[0] +
+			planes[p][1] * center[1] +
+			planes[p][2] * center[2] +
+			planes[p][3];
+
+		if (distance < -radius)
+			return true;
+	}
+	return false;
+}
+
+// --------------------------------------------------------
+// True if every triangle faces away from the camera
+//
+// - Seen from the camera, the sphere covers directions within
+//   beta = asin(radius / distance) of its center, and the faces
+//   are within alpha = acos(coneCutoff) of the cone axis
+// - Every face points away from every point if the axis is
+//   within 90 - alpha - beta degrees of the view direction,
+//   ie: dot(axis, view) > sin(alpha + beta)
+// --------------------------------------------------------
+bool MeshletBuilder::IsBackFacing(const Meshlet& meshlet, const float cameraPosition[3])
+{
+	if (meshlet.coneCutoff <= 0.0f)
+		return false;
+
+	float view[3] = {
+		meshlet.center[0] - cameraPosition[0],
+		meshlet.center[1] - cameraPosition[1],
+		meshlet.center[2] - cameraPosition[2] };
+	float distance = sqrtf(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+
+	// Inside the sphere, something might face the camera
+	if (distance <= meshlet.radius)
+		return false;
+
+	float cosAlpha = meshlet.coneCutoff;
+	float sinAlpha = sqrtf(std::max(0.0f, 1.0f - cosAlpha * cosAlpha));
+	float sinBeta = meshlet.radius / distance;
+	float cosBeta = sqrtf(std::max(0.0f, 1.0f - sinBeta * sinBeta));
+
+	// No margin left once alpha + beta reaches 90 degrees
+	if (cosAlpha * cosBeta - sinAlpha * sinBeta <= 0.0f)
+		return false;
+
+	float sinAlphaBeta = sinAlpha * cosBeta + cosAlpha * sinBeta;
+	float axisDot =
+		(view[0] * meshlet.coneAxis[0] +
+		view[1] * meshlet.coneAxis[1] +
+		view[2] * meshlet.coneAxis[2]) / distance;
+
+	return axisDot > sinAlphaBeta;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// A small cluster of triangles that can be culled as a whole
+//
+// - Its triangles are a contiguous range of the mesh's index
+//   buffer, so the visible ones can be drawn with DrawIndexed
+// - The bounding sphere and normal cone are in mesh space
+// - Every triangle normal is within the cone around coneAxis,
+//   where coneCutoff is the cosine of the cone's half angle.
+//   A cutoff of 0 or less means the normals are too spread out
+//   for the cluster to ever be entirely back facing
+// --------------------------------------------------------
+struct Meshlet
+{
+	unsigned int indexOffset;
+	unsigned int triangleCount;
+	unsigned int vertexCount;
+	float center[3];
+	float radius;
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+// --------------------------------------------------------
+// Summary of a meshlet build, used for benchmarking
+//
+// - ACMR is measured over the reordered index buffer, since
+//   grouping triangles can undo some vertex cache ordering
+// --------------------------------------------------------
+struct MeshletStats
+{
+	unsigned int meshletCount;
+	float averageVertices;
+	float averageTriangles;
+	float cullableFraction;
+	float acmr;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Splits meshes into meshlets and culls them
+//
+// - Meshlets are grown greedily from the current triangle
+//   order, preferring neighbours that add the fewest new
+//   vertices and face the same way, until either limit is hit
+// - Culling works in mesh space: frustum planes come straight
+//   from a world * view * projection matrix, and the camera
+//   position is moved into mesh space. Back facing is
+//   unaffected by affine transforms, so this stays exact
+//   under non-uniform scale
+// - Positions are read as 3 floats at the start of each vertex,
+//   and there's no DirectX dependency so it can be used by tools
+// --------------------------------------------------------
+class MeshletBuilder
+{
+public:
+	// Typical limits for mesh shader hardware
+	static const unsigned int MaxVertices = 64;
+	static const unsigned int MaxTriangles = 124;
+
+	// Reorders the triangles so each meshlet is contiguous and fills
+	// out the meshlet list
+	static void BuildMeshlets(
+		unsigned int* indices, unsigned int indexCount,
+		const void* vertices, unsigned int vertexCount, unsigned int vertexStride,
+		std::vector<Meshlet>& meshlets,
+		MeshletStats* stats = nullptr,
+		unsigned int maxVertices = MaxVertices, unsigned int maxTriangles = MaxTriangles);
+
+	// Culling tests. The sphere test works in whatever space the planes are
+	// in, so planes from view * projection cull world space bounds
+	static void ExtractFrustumPlanes(const float worldViewProjection[16], float planes[6][4]);
+	static bool IsOutsideFrustum(const Meshlet& meshlet, const float planes[6][4]);
+	static bool IsSphereOutsideFrustum(const float center[3], float radius, const float planes[6][4]);
+	static bool IsBackFacing(const Meshlet& meshlet, const float cameraPosition[3]);
+};
@@ -0,0 +1,287 @@
+// --------------------------------------------------------
+// Tests for MeshletBuilder
+//
+// - Builds meshlets for a sphere, a bumpy grid and a random
+//   triangle soup (with some degenerate triangles) at several
+//   limits, then checks that:
+//   - no meshlet goes over either limit
+//   - every triangle comes out exactly once, winding intact
+//   - every meshlet's sphere holds all of its vertices
+//   - the normal cone is conservative, so no triangle that
+//     faces a camera is ever culled as back facing
+// - Not part of the Visual Studio project. On Linux it's the
+//   meshlet_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 MeshletBuilderTests.cpp
+//       MeshletBuilder.cpp MeshOptimizer.cpp -o meshlet_tests
+// --------------------------------------------------------
+#include "MeshletBuilder.h"
+#include "TestChecks.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace
+{
+	// Positions first, like Vertex, with other data after them
+	struct TestVertex
+	{
+		float position[3];
+		float normal[3];
+		float uv[2];
+	};
+
+	struct TestMesh
+	{
+		const char* name;
+		std::vector<TestVertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	TestVertex MakeVertex(float x, float y, float z)
+	{
+		TestVertex vertex = {};
+		vertex.position[0] = x;
+		vertex.position[1] = y;
+		vertex.position[2] = z;
+		return vertex;
+	}
+
+	TestMesh MakeSphere(unsigned int rings, unsigned int segments)
+	{
+		TestMesh mesh = { "sphere", {}, {} };
+		for (unsigned int r = 0; r <= rings; r++)
+		{
+			float phi = 3.14159265f * r / rings;
+			for (unsigned int s = 0; s <= segments; s++)
+			{
+				float theta = 6.28318531f * s / segments;
+				mesh.vertices.push_back(MakeVertex(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)));
+			}
+		}
+
+		for (unsigned int r = 0; r < rings; r++)
+		{
+			for (unsigned int s = 0; s < segments; s++)
+			{
+				unsigned int a = r * (segments + 1) + s;
+				unsigned int b = a + segments + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+			}
+		}
+		return mesh;
+	}
+
+	TestMesh MakeBumpyGrid(unsigned int side)
+	{
+		TestMesh mesh = { "bumpy grid", {}, {} };
+		for (unsigned int z = 0; z <= side; z++)
+		{
+			for (unsigned int x = 0; x <= side; x++)
+				mesh.vertices.push_back(MakeVertex((float)x, sinf(x * 0.7f) * cosf(z * 0.4f), (float)z));
+		}
+
+		for (unsigned int z = 0; z < side; z++)
+		{
+			for (unsigned int x = 0; x < side; x++)
+			{
+				unsigned int a = z * (side + 1) + x;
+				unsigned int b = a + side + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+		return mesh;
+	}
+
+	// Random triangles over shared vertices, some with repeated corners
+	TestMesh MakeSoup(unsigned int vertexCount, unsigned int triangleCount, std::mt19937& random)
+	{
+		TestMesh mesh = { "soup", {}, {} };
+		std::uniform_real_distribution<float> position(-10.0f, 10.0f);
+		for (unsigned int v = 0; v < vertexCount; v++)
+			mesh.vertices.push_back(MakeVertex(position(random), position(random), position(random)));
+
+		std::uniform_int_distribution<unsigned int> vertex(0, vertexCount - 1);
+		for (unsigned int t = 0; t < triangleCount; t++)
+		{
+			unsigned int a = vertex(random);
+			unsigned int b = t % 17 == 0 ? a : vertex(random);
+			mesh.indices.insert(mesh.indices.end(), { a, b, vertex(random) });
+		}
+		return mesh;
+	}
+
+	const float* GetPosition(const TestMesh& mesh, unsigned int index)
+	{
+		return mesh.vertices[index].position;
+	}
+
+	// Unnormalized face normal, (b - a) x (c - a)
+	std::array<float, 3> GetFaceNormal(const TestMesh& mesh, const unsigned int* triangle)
+	{
+		const float* a = GetPosition(mesh, triangle[0]);
+		const float* b = GetPosition(mesh, triangle[1]);
+		const float* c = GetPosition(mesh, triangle[2]);
+		float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		return {
+			e1[1] * e2[2] - e1[2] * e2[1],
+			e1[2] * e2[0] - e1[0] * e2[2],
+			e1[0] * e2[1] - e1[1] * e2[0] };
+	}
+
+	// Triangles as a sorted list, for comparing two index buffers
+	std::vector<std::array<unsigned int, 3>> GetTriangles(const std::vector<unsigned int>& indices)
+	{
+		std::vector<std::array<unsigned int, 3>> triangles;
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+			triangles.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	void CheckMeshlets(const TestMesh& source, unsigned int maxVertices, unsigned int maxTriangles, std::mt19937& random)
+	{
+		TestMesh mesh = source;
+		std::vector<Meshlet> meshlets;
+		MeshletStats stats = {};
+		MeshletBuilder::BuildMeshlets(
+			mesh.indices.data(), (unsigned int)mesh.indices.size(),
+			mesh.vertices.data(), (unsigned int)mesh.vertices.size(), sizeof(TestVertex),
+			meshlets, &stats, maxVertices, maxTriangles);
+
+		printf("  %s, %u/%u: %u meshlets, %.1f vertices, %.1f triangles, %.0f%% cullable\n",
+			mesh.name, maxVertices, maxTriangles, stats.meshletCount,
+			stats.averageVertices, stats.averageTriangles, stats.cullableFraction * 100.0f);
+		CHECK(stats.meshletCount == meshlets.size());
+
+		// Every triangle exactly once, with the same winding
+		CHECK(GetTriangles(mesh.indices) == GetTriangles(source.indices));
+
+		// Meshlets tile the index buffer in order
+		unsigned int nextOffset = 0;
+		for (const Meshlet& meshlet : meshlets)
+		{
+			CHECK(meshlet.indexOffset == nextOffset);
+			nextOffset += meshlet.triangleCount * 3;
+		}
+		CHECK(nextOffset == mesh.indices.size());
+
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> distance(0.0f, 4.0f);
+		for (const Meshlet& meshlet : meshlets)
+		{
+			const unsigned int* indices = mesh.indices.data() + meshlet.indexOffset;
+			unsigned int indexCount = meshlet.triangleCount * 3;
+
+			// Limits, and the vertex count is the meshlet's unique vertices
+			std::set<unsigned int> unique(indices, indices + indexCount);
+			CHECK(meshlet.triangleCount >= 1 && meshlet.triangleCount <= maxTriangles);
+			CHECK(meshlet.vertexCount <= maxVertices);
+			CHECK(meshlet.vertexCount == unique.size());
+
+			// The bounding sphere holds every vertex
+			bool contained = true;
+			for (unsigned int v : unique)
+			{
+				const float* p = GetPosition(mesh, v);
+				float dx = p[0] - meshlet.center[0];
+				float dy = p[1] - meshlet.center[1];
+				float dz = p[2] - meshlet.center[2];
+				contained = contained && sqrtf(dx * dx + dy * dy + dz * dz) <= meshlet.radius * 1.0001f + 1e-5f;
+			}
+			CHECK(contained);
+
+			// Every real triangle's normal is inside the cone
+			bool insideCone = true;
+			for (unsigned int t = 0; t < meshlet.triangleCount && meshlet.coneCutoff > 0.0f; t++)
+			{
+				std::array<float, 3> n = GetFaceNormal(mesh, indices + t * 3);
+				float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+				if (length <= 1e-12f)
+					continue;
+
+				float dot = (n[0] * meshlet.coneAxis[0] + n[1] * meshlet.coneAxis[1] + n[2] * meshlet.coneAxis[2]) / length;
+				insideCone = insideCone && dot >= meshlet.coneCutoff - 1e-4f;
+			}
+			CHECK(insideCone);
+
+			// Cameras around the meshlet, some inside its sphere, and along
+			// the cone axis where culling is most likely
+			bool conservative = true;
+			for (unsigned int c = 0; c < 64; c++)
+			{
+				float direction[3] = { unit(random), unit(random), unit(random) };
+				if (c % 4 == 0)
+				{
+					direction[0] = -meshlet.coneAxis[0] + unit(random) * 0.2f;
+					direction[1] = -meshlet.coneAxis[1] + unit(random) * 0.2f;
+					direction[2] = -meshlet.coneAxis[2] + unit(random) * 0.2f;
+				}
+
+				float scale = (meshlet.radius + 0.01f) * distance(random);
+				float camera[3] = {
+					meshlet.center[0] + direction[0] * scale,
+					meshlet.center[1] + direction[1] * scale,
+					meshlet.center[2] + direction[2] * scale };
+				if (!MeshletBuilder::IsBackFacing(meshlet, camera))
+					continue;
+
+				// Culled, so no triangle may face the camera
+				for (unsigned int t = 0; t < meshlet.triangleCount; t++)
+				{
+					std::array<float, 3> n = GetFaceNormal(mesh, indices + t * 3);
+					const float* a = GetPosition(mesh, indices[t * 3]);
+					float facing =
+						n[0] * (camera[0] - a[0]) +
+						n[1] * (camera[1] - a[1]) +
+						n[2] * (camera[2] - a[2]);
+					conservative = conservative && facing <= 1e-5f;
+				}
+			}
+			CHECK(conservative);
+		}
+	}
+
+	// Nothing to build from gives nothing, rather than a crash
+	void TestEmpty()
+	{
+		std::vector<Meshlet> meshlets(3);
+		TestVertex vertex = MakeVertex(0, 0, 0);
+		MeshletBuilder::BuildMeshlets(nullptr, 0, &vertex, 1, sizeof(TestVertex), meshlets);
+		CHECK(meshlets.empty());
+
+		TestMesh sphere = MakeSphere(4, 4);
+		MeshletBuilder::BuildMeshlets(
+			sphere.indices.data(), (unsigned int)sphere.indices.size(),
+			sphere.vertices.data(), (unsigned int)sphere.vertices.size(), sizeof(TestVertex),
+			meshlets, nullptr, 2, 16);
+		CHECK(meshlets.empty());
+	}
+}
+
+int main()
+{
+	std::mt19937 random(1234);
+	std::vector<TestMesh> meshes = { MakeSphere(24, 48), MakeBumpyGrid(40), MakeSoup(500, 2000, random) };
+
+	const unsigned int limits[][2] =
+	{
+		{ MeshletBuilder::MaxVertices, MeshletBuilder::MaxTriangles },
+		{ 32, 32 },
+		{ 128, 256 },
+		{ 3, 1 },
+	};
+
+	for (const TestMesh& mesh : meshes)
+	{
+		for (const unsigned int* limit : limits)
+			CheckMeshlets(mesh, limit[0], limit[1], random);
+	}
+	TestEmpty();
+
+	return TestChecks::Finish("MeshletBuilder");
+}
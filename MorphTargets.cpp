@@ -0,0 +1,271 @@
+#include "MorphTargets.h"
+
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+
+namespace
+{
+	inline float MaxAbs(const ObjFloat3& v)
+	{
+		float x = fabsf(v.x);
+		float y = fabsf(v.y);
+		float z = fabsf(v.z);
+		float m = x > y ? x : y;
+		return m > z ? m : z;
+	}
+
+	inline short Quantize(float value, float inverseScale)
+	{
+		float q = value * inverseScale;
+		q = q > 32767.0f ? 32767.0f : (q < -32767.0f ? -32767.0f : q);
+		return (short)lrintf(q);
+	}
+
+	// --------------------------------------------------------
+	// Adds one target's weighted deltas into the sums
+	//
+	// - Each delta is one 16-byte load. Its shorts are widened
+	//   to ints by unpacking with themselves and shifting the
+	//   sign back down (SSE2 has no sign-extending load)
+	// - The 4th lane of each scale is 0, so whatever lands in
+	//   the sums' 4th floats stays 0
+	// - Vertices seen for the first time this blend are noted,
+	//   which is a well predicted branch once targets overlap
+	// --------------------------------------------------------
+	unsigned int AccumulateTarget(
+		const MorphTarget& target, float weight,
+		float* positionSums, float* normalSums,
+		unsigned char* touchedFlags, std::vector<unsigned int>& touched)
+	{
+		__m128 positionScale = _mm_setr_ps(weight * target.positionScale, weight * target.positionScale, weight * target.positionScale, 0.0f);
+		__m128 normalScale = _mm_setr_ps(weight * target.normalScale, weight * target.normalScale, weight * target.normalScale, 0.0f);
+
+		for (const MorphDelta& delta : target.deltas)
+		{
+			unsigned int v = delta.vertex;
+			if (!touchedFlags[v])
+			{
+				touchedFlags[v] = 1;
+				touched.push_back(v);
+			}
+
+			__m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&delta));
+			__m128i position = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+			__m128i normalShorts = _mm_srli_si128(packed, 6);
+			__m128i normal = _mm_srai_epi32(_mm_unpacklo_epi16(normalShorts, normalShorts), 16);
+
+			float* positionSum = positionSums + (size_t)v * 4;
+			float* normalSum = normalSums + (size_t)v * 4;
+			_mm_storeu_ps(positionSum, _mm_add_ps(_mm_loadu_ps(positionSum), _mm_mul_ps(_mm_cvtepi32_ps(position), positionScale)));
+			_mm_storeu_ps(normalSum, _mm_add_ps(_mm_loadu_ps(normalSum), _mm_mul_ps(_mm_cvtepi32_ps(normal), normalScale)));
+		}
+
+		return (unsigned int)target.deltas.size();
+	}
+}
+
+MorphTargetSet::MorphTargetSet(unsigned int vertexCount)
+	: vertexCount(vertexCount)
+{
+}
+
+// --------------------------------------------------------
+// Builds a sparse target from dense deltas
+//
+// - Each target gets its own scales, from its largest delta,
+//   so a subtle target keeps its precision
+// --------------------------------------------------------
+unsigned int MorphTargetSet::AddTarget(
+	const std::string& name,
+	const ObjFloat3* positionDeltas, const ObjFloat3* normalDeltas,
+	float threshold)
+{
+	ObjFloat3 zero = { 0, 0, 0 };
+
+	float maxPosition = 0.0f;
+	float maxNormal = 0.0f;
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		float p = MaxAbs(positionDeltas[v]);
+		float n = normalDeltas ? MaxAbs(normalDeltas[v]) : 0.0f;
+		maxPosition = p > maxPosition ? p : maxPosition;
+		maxNormal = n > maxNormal ? n : maxNormal;
+	}
+
+	MorphTarget target;
+	target.name = name;
+	target.positionScale = maxPosition > 0.0f ? maxPosition / 32767.0f : 0.0f;
+	target.normalScale = maxNormal > 0.0f ? maxNormal / 32767.0f : 0.0f;
+	float inversePositionScale = maxPosition > 0.0f ? 32767.0f / maxPosition : 0.0f;
+	float inverseNormalScale = maxNormal > 0.0f ? 32767.0f / maxNormal : 0.0f;
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		const ObjFloat3& p = positionDeltas[v];
+		const ObjFloat3& n = normalDeltas ? normalDeltas[v] : zero;
+		if (MaxAbs(p) <= threshold && MaxAbs(n) <= threshold)
+			continue;
+
+		MorphDelta delta;
+		delta.position[0] = Quantize(p.x, inversePositionScale);
+		delta.position[1] = Quantize(p.y, inversePositionScale);
+		delta.position[2] = Quantize(p.z, inversePositionScale);
+		delta.normal[0] = Quantize(n.x, inverseNormalScale);
+		delta.normal[1] = Quantize(n.y, inverseNormalScale);
+		delta.normal[2] = Quantize(n.z, inverseNormalScale);
+		delta.vertex = v;
+		target.deltas.push_back(delta);
+	}
+	target.deltas.shrink_to_fit();
+
+	// The sums are only needed once there's something to blend
+	if (positionSums.empty())
+	{
+		positionSums.assign((size_t)vertexCount * 4, 0.0f);
+		normalSums.assign((size_t)vertexCount * 4, 0.0f);
+		touchedFlags.assign(vertexCount, 0);
+	}
+
+	targets.push_back(target);
+	return (unsigned int)targets.size() - 1;
+}
+
+unsigned int MorphTargetSet::GetTargetCount() const
+{
+	return (unsigned int)this->targets.size();
+}
+
+unsigned int MorphTargetSet::GetVertexCount() const
+{
+	return this->vertexCount;
+}
+
+const MorphTarget& MorphTargetSet::GetTarget(unsigned int target) const
+{
+	return this->targets[target];
+}
+
+MorphTargetStats MorphTargetSet::GetTargetStats(unsigned int target) const
+{
+	const MorphTarget& t = targets[target];
+
+	MorphTargetStats stats = {};
+	stats.affectedVertices = (unsigned int)t.deltas.size();
+	stats.bytes = sizeof(MorphTarget) + t.name.capacity() + t.deltas.capacity() * sizeof(MorphDelta);
+	stats.denseBytes = (size_t)vertexCount * sizeof(ObjVertex);
+
+	// Rounding to the nearest step is off by at most half a step, and
+	// the float scales add a few ulps of the largest delta (32767
+	// steps), which stays under a hundredth of a step
+	stats.maxPositionError = t.positionScale * 0.51f;
+	return stats;
+}
+
+// --------------------------------------------------------
+// Gets the memory held by the targets and the blend scratch
+// --------------------------------------------------------
+size_t MorphTargetSet::GetMemoryBytes() const
+{
+	size_t bytes =
+		positionSums.capacity() * sizeof(float) +
+		normalSums.capacity() * sizeof(float) +
+		touchedFlags.capacity() +
+		(touched.capacity() + previousTouched.capacity()) * sizeof(unsigned int);
+
+	for (unsigned int t = 0; t < targets.size(); t++)
+		bytes += GetTargetStats(t).bytes;
+	return bytes;
+}
+
+// --------------------------------------------------------
+// Blends the weighted targets onto the base vertices
+//
+// - Pass 1: sum the active targets' deltas, noting each
+//   vertex they move
+// - Pass 2: vertices moved last time but not this time go
+//   back to the base vertex
+// - Pass 3: moved vertices get base + sum, and their sums are
+//   cleared for next time
+// --------------------------------------------------------
+void MorphTargetSet::Blend(
+	const ObjVertex* base, const float* weights,
+	ObjVertex* output,
+	unsigned int& firstWritten, unsigned int& lastWritten,
+	MorphBlendStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	unsigned int activeTargets = 0;
+	unsigned int deltasApplied = 0;
+	touched.clear();
+
+	// Pass 1
+	for (unsigned int t = 0; t < targets.size(); t++)
+	{
+		if (weights[t] == 0.0f)
+			continue;
+
+		deltasApplied += AccumulateTarget(targets[t], weights[t], positionSums.data(), normalSums.data(), touchedFlags.data(), touched);
+		activeTargets++;
+	}
+
+	firstWritten = 0xFFFFFFFFu;
+	lastWritten = 0;
+	unsigned int restoredVertices = 0;
+
+	// Pass 2
+	for (unsigned int v : previousTouched)
+	{
+		if (touchedFlags[v])
+			continue;
+
+		output[v].Position = base[v].Position;
+		output[v].Normal = base[v].Normal;
+		restoredVertices++;
+		firstWritten = v < firstWritten ? v : firstWritten;
+		lastWritten = v > lastWritten ? v : lastWritten;
+	}
+
+	// Pass 3
+	for (unsigned int v : touched)
+	{
+		float* positionSum = &positionSums[(size_t)v * 4];
+		float* normalSum = &normalSums[(size_t)v * 4];
+
+		output[v].Position = ObjFloat3{
+			base[v].Position.x + positionSum[0],
+			base[v].Position.y + positionSum[1],
+			base[v].Position.z + positionSum[2] };
+
+		ObjFloat3 normal = {
+			base[v].Normal.x + normalSum[0],
+			base[v].Normal.y + normalSum[1],
+			base[v].Normal.z + normalSum[2] };
+		float lengthSquared = normal.x * normal.x + normal.y * normal.y + normal.z * normal.z;
+		if (lengthSquared > 0.0f)
+		{
+			float length = sqrtf(lengthSquared);
+			normal = ObjFloat3{ normal.x / length, normal.y / length, normal.z / length };
+		}
+		output[v].Normal = normal;
+
+		_mm_storeu_ps(positionSum, _mm_setzero_ps());
+		_mm_storeu_ps(normalSum, _mm_setzero_ps());
+		touchedFlags[v] = 0;
+
+		firstWritten = v < firstWritten ? v : firstWritten;
+		lastWritten = v > lastWritten ? v : lastWritten;
+	}
+
+	touched.swap(previousTouched);
+
+	if (stats)
+	{
+		*stats = {};
+		stats->activeTargets = activeTargets;
+		stats->deltasApplied = deltasApplied;
+		stats->writtenVertices = (unsigned int)previousTouched.size() + restoredVertices;
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "ObjParser.h"
+
+// --------------------------------------------------------
+// One moved vertex of a morph target
+//
+// - Deltas are snorm16, scaled by the target's position and
+//   normal scales
+// - 16 bytes, so the kernel reads each one with a single load
+//   (the vertex index is read separately)
+// --------------------------------------------------------
+struct MorphDelta
+{
+	short position[3];
+	short normal[3];
+	unsigned int vertex;
+};
+
+// --------------------------------------------------------
+// A blend shape, as only the vertices it moves
+// --------------------------------------------------------
+struct MorphTarget
+{
+	std::string name;
+	float positionScale;
+	float normalScale;
+	std::vector<MorphDelta> deltas;
+};
+
+// --------------------------------------------------------
+// Size and accuracy of one morph target
+//
+// - denseBytes is what a full copy of every vertex would take
+// - maxPositionError is the largest quantization error
+// --------------------------------------------------------
+struct MorphTargetStats
+{
+	unsigned int affectedVertices;
+	size_t bytes;
+	size_t denseBytes;
+	float maxPositionError;
+};
+
+// --------------------------------------------------------
+// Timings from blending morph targets
+// --------------------------------------------------------
+struct MorphBlendStats
+{
+	unsigned int activeTargets;
+	unsigned int deltasApplied;
+	unsigned int writtenVertices;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Sparse, quantized morph targets for one mesh, and the
+// kernel that blends them
+//
+// - Blend() adds each active target's weighted deltas into
+//   per-vertex sums with SSE, visiting only the vertices that
+//   target moves. Inactive targets (weight 0) cost nothing
+// - Only vertices moved this time or last time are written
+//   to the output, which must therefore hold the previous
+//   result (start it as a copy of the base vertices)
+// - Positions get the summed delta; normals get theirs and
+//   are renormalized. Tangents are left as they are
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class MorphTargetSet
+{
+public:
+	explicit MorphTargetSet(unsigned int vertexCount = 0);
+
+	// Builds a target from one delta per vertex (normalDeltas may be
+	// null), keeping only vertices that move by more than threshold.
+	// Returns its index
+	unsigned int AddTarget(
+		const std::string& name,
+		const ObjFloat3* positionDeltas, const ObjFloat3* normalDeltas,
+		float threshold = 1e-5f);
+
+	unsigned int GetTargetCount() const;
+	unsigned int GetVertexCount() const;
+	const MorphTarget& GetTarget(unsigned int target) const;
+	MorphTargetStats GetTargetStats(unsigned int target) const;
+	size_t GetMemoryBytes() const;
+
+	// Blends one weight per target onto the base vertices. The range
+	// of vertices written is [firstWritten, lastWritten], or empty if
+	// firstWritten > lastWritten
+	void Blend(
+		const ObjVertex* base, const float* weights,
+		ObjVertex* output,
+		unsigned int& firstWritten, unsigned int& lastWritten,
+		MorphBlendStats* stats = nullptr);
+
+private:
+	unsigned int vertexCount;
+	std::vector<MorphTarget> targets;
+
+	// Per-vertex sums (4 floats each), which stay zero outside of Blend()
+	std::vector<float> positionSums;
+	std::vector<float> normalSums;
+
+	// Vertices moved by the current and previous blends
+	std::vector<unsigned char> touchedFlags;
+	std::vector<unsigned int> touched;
+	std::vector<unsigned int> previousTouched;
+};
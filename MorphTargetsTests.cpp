@@ -0,0 +1,366 @@
+// --------------------------------------------------------
+// Tests and benchmark for MorphTargetSet
+//
+// - Checks the quantized deltas stay within the reported
+//   error bound, and that tiny moves are dropped
+// - Checks several frames of sparse blends against a dense
+//   blend of the original float deltas, including vertices
+//   moved last frame but not this one going back to the base,
+//   and that [firstWritten, lastWritten] covers every change
+// - Given "bench", also compares memory and blend time with
+//   dense float targets, for 50 targets on 100k vertices
+// - Not part of the Visual Studio project. On Linux it's the
+//   morph_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 MorphTargetsTests.cpp MorphTargets.cpp
+//       -o morph_tests
+// - Usage: morph_tests [bench]
+// --------------------------------------------------------
+#include "MorphTargets.h"
+#include "TestChecks.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Quantization error adds up across targets, so allow for a few at full weight
+	const float maxBlendDifference = 1e-3f;
+
+	// Where the benchmark loops put their results, so they aren't optimized away
+	volatile float benchmarkSink;
+
+	// A blend shape as one float delta per vertex, as it was authored
+	struct DenseTarget
+	{
+		std::vector<ObjFloat3> positions;
+		std::vector<ObjFloat3> normals;
+	};
+
+	std::vector<ObjVertex> MakeVertices(unsigned int vertexCount, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<ObjVertex> vertices(vertexCount);
+		for (ObjVertex& vertex : vertices)
+		{
+			vertex = {};
+			vertex.Position = ObjFloat3{ unit(random) * 10.0f, unit(random) * 10.0f, unit(random) * 10.0f };
+			ObjFloat3 normal = { unit(random), unit(random), unit(random) + 2.0f };
+			float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			vertex.Normal = ObjFloat3{ normal.x / length, normal.y / length, normal.z / length };
+		}
+		return vertices;
+	}
+
+	// --------------------------------------------------------
+	// A target moving vertices [first, first + count) by up to
+	// size, and everything else not at all
+	// --------------------------------------------------------
+	DenseTarget MakeTarget(unsigned int vertexCount, unsigned int first, unsigned int count, float size, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		DenseTarget target;
+		target.positions.assign(vertexCount, ObjFloat3{ 0, 0, 0 });
+		target.normals.assign(vertexCount, ObjFloat3{ 0, 0, 0 });
+		for (unsigned int v = first; v < first + count && v < vertexCount; v++)
+		{
+			target.positions[v] = ObjFloat3{ unit(random) * size, unit(random) * size, unit(random) * size };
+			target.normals[v] = ObjFloat3{ unit(random) * 0.3f, unit(random) * 0.3f, unit(random) * 0.3f };
+		}
+		return target;
+	}
+
+	// --------------------------------------------------------
+	// The blend done the obvious way: every vertex of every
+	// active target, from the unquantized deltas
+	// --------------------------------------------------------
+	void BlendDense(
+		const std::vector<ObjVertex>& base, const std::vector<DenseTarget>& targets, const float* weights,
+		std::vector<ObjVertex>& output)
+	{
+		output = base;
+		std::vector<bool> moved(base.size(), false);
+		for (unsigned int t = 0; t < targets.size(); t++)
+		{
+			if (weights[t] == 0.0f)
+				continue;
+
+			for (unsigned int v = 0; v < base.size(); v++)
+			{
+				const ObjFloat3& p = targets[t].positions[v];
+				const ObjFloat3& n = targets[t].normals[v];
+				output[v].Position.x += p.x * weights[t];
+				output[v].Position.y += p.y * weights[t];
+				output[v].Position.z += p.z * weights[t];
+				output[v].Normal.x += n.x * weights[t];
+				output[v].Normal.y += n.y * weights[t];
+				output[v].Normal.z += n.z * weights[t];
+				moved[v] = moved[v] || p.x != 0.0f || p.y != 0.0f || p.z != 0.0f || n.x != 0.0f || n.y != 0.0f || n.z != 0.0f;
+			}
+		}
+
+		for (unsigned int v = 0; v < base.size(); v++)
+		{
+			ObjFloat3& normal = output[v].Normal;
+			float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			if (moved[v] && length > 0.0f)
+				normal = ObjFloat3{ normal.x / length, normal.y / length, normal.z / length };
+		}
+	}
+
+	float Difference(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		float x = fabsf(a.x - b.x);
+		float y = fabsf(a.y - b.y);
+		float z = fabsf(a.z - b.z);
+		return x > y ? (x > z ? x : z) : (y > z ? y : z);
+	}
+
+	bool SamePositionAndNormal(const ObjVertex& a, const ObjVertex& b)
+	{
+		return memcmp(&a.Position, &b.Position, sizeof(ObjFloat3)) == 0 && memcmp(&a.Normal, &b.Normal, sizeof(ObjFloat3)) == 0;
+	}
+
+	// --------------------------------------------------------
+	// Every stored delta is within half a step of the original,
+	// as GetTargetStats() reports, for big and subtle targets
+	// --------------------------------------------------------
+	void TestQuantizationError(std::mt19937& random)
+	{
+		const unsigned int vertexCount = 5000;
+		const float sizes[] = { 0.001f, 0.5f, 40.0f };
+		MorphTargetSet set(vertexCount);
+
+		for (float size : sizes)
+		{
+			DenseTarget dense = MakeTarget(vertexCount, 1000, 2000, size, random);
+			unsigned int t = set.AddTarget("target", dense.positions.data(), dense.normals.data(), 0.0f);
+			const MorphTarget& target = set.GetTarget(t);
+			MorphTargetStats stats = set.GetTargetStats(t);
+			CHECK(stats.affectedVertices == 2000);
+			CHECK(stats.bytes < stats.denseBytes);
+
+			float positionError = 0.0f;
+			float normalError = 0.0f;
+			for (const MorphDelta& delta : target.deltas)
+			{
+				ObjFloat3 position = { delta.position[0] * target.positionScale, delta.position[1] * target.positionScale, delta.position[2] * target.positionScale };
+				ObjFloat3 normal = { delta.normal[0] * target.normalScale, delta.normal[1] * target.normalScale, delta.normal[2] * target.normalScale };
+				float p = Difference(position, dense.positions[delta.vertex]);
+				float n = Difference(normal, dense.normals[delta.vertex]);
+				positionError = p > positionError ? p : positionError;
+				normalError = n > normalError ? n : normalError;
+			}
+
+			printf("  deltas up to %g: %g max position error, bound %g\n", size, positionError, stats.maxPositionError);
+			CHECK(positionError <= stats.maxPositionError);
+			CHECK(normalError <= target.normalScale * 0.51f);
+			CHECK(stats.maxPositionError <= size / 32767.0f);
+		}
+
+		// Moves at or under the threshold aren't stored at all
+		DenseTarget tiny = MakeTarget(vertexCount, 0, vertexCount, 1e-4f, random);
+		for (unsigned int v = 0; v < 10; v++)
+			tiny.positions[v].x = 1.0f;
+		unsigned int t = set.AddTarget("tiny", tiny.positions.data(), nullptr, 0.5f);
+		CHECK(set.GetTargetStats(t).affectedVertices == 10);
+	}
+
+	// --------------------------------------------------------
+	// Frames of random weights (some zero) blended sparsely
+	// into one persistent output, against dense blends
+	//
+	// - Any vertex that changed since the last frame must be in
+	//   the written range
+	// --------------------------------------------------------
+	void TestBlendMatchesDense(std::mt19937& random)
+	{
+		const unsigned int vertexCount = 20000;
+		const unsigned int targetCount = 8;
+		std::vector<ObjVertex> base = MakeVertices(vertexCount, random);
+		std::vector<DenseTarget> dense;
+		MorphTargetSet set(vertexCount);
+		std::uniform_int_distribution<unsigned int> start(0, vertexCount - 1);
+		for (unsigned int t = 0; t < targetCount; t++)
+		{
+			dense.push_back(MakeTarget(vertexCount, start(random), 3000, 0.5f, random));
+			set.AddTarget("target", dense.back().positions.data(), dense.back().normals.data(), 0.0f);
+		}
+
+		std::vector<ObjVertex> output = base;
+		std::vector<ObjVertex> expected;
+		std::uniform_real_distribution<float> weight(0.0f, 1.0f);
+		float worst = 0.0f;
+		for (unsigned int frame = 0; frame < 40; frame++)
+		{
+			float weights[targetCount];
+			for (float& w : weights)
+				w = weight(random) < 0.5f ? 0.0f : weight(random);
+
+			std::vector<ObjVertex> previous = output;
+			unsigned int firstWritten = 0;
+			unsigned int lastWritten = 0;
+			set.Blend(base.data(), weights, output.data(), firstWritten, lastWritten);
+			BlendDense(base, dense, weights, expected);
+
+			bool inRange = true;
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				float d = Difference(output[v].Position, expected[v].Position);
+				float n = Difference(output[v].Normal, expected[v].Normal);
+				worst = d > worst ? d : worst;
+				worst = n > worst ? n : worst;
+				if (!SamePositionAndNormal(output[v], previous[v]))
+					inRange = inRange && firstWritten <= v && v <= lastWritten;
+			}
+			CHECK(inRange);
+		}
+		printf("  sparse blend: %g max difference from dense\n", worst);
+		CHECK(worst <= maxBlendDifference);
+	}
+
+	// --------------------------------------------------------
+	// Vertices moved last frame but not this one go exactly back
+	// to the base, and nothing is written once all is at rest
+	// --------------------------------------------------------
+	void TestRestoresLastFrame(std::mt19937& random)
+	{
+		const unsigned int vertexCount = 1000;
+		std::vector<ObjVertex> base = MakeVertices(vertexCount, random);
+		DenseTarget a = MakeTarget(vertexCount, 100, 100, 1.0f, random);
+		DenseTarget b = MakeTarget(vertexCount, 500, 100, 1.0f, random);
+		MorphTargetSet set(vertexCount);
+		set.AddTarget("a", a.positions.data(), a.normals.data(), 0.0f);
+		set.AddTarget("b", b.positions.data(), b.normals.data(), 0.0f);
+
+		std::vector<ObjVertex> output = base;
+		unsigned int firstWritten = 0;
+		unsigned int lastWritten = 0;
+		MorphBlendStats stats = {};
+
+		// Only a
+		const float onlyA[] = { 1.0f, 0.0f };
+		set.Blend(base.data(), onlyA, output.data(), firstWritten, lastWritten, &stats);
+		CHECK(firstWritten == 100 && lastWritten == 199);
+		CHECK(stats.activeTargets == 1 && stats.deltasApplied == 100 && stats.writtenVertices == 100);
+		CHECK(!SamePositionAndNormal(output[150], base[150]));
+
+		// Only b, so a's vertices are restored as well
+		const float onlyB[] = { 0.0f, 1.0f };
+		set.Blend(base.data(), onlyB, output.data(), firstWritten, lastWritten, &stats);
+		CHECK(firstWritten == 100 && lastWritten == 599);
+		CHECK(stats.writtenVertices == 200);
+		bool restored = true;
+		for (unsigned int v = 100; v < 200; v++)
+			restored = restored && SamePositionAndNormal(output[v], base[v]);
+		CHECK(restored);
+		CHECK(!SamePositionAndNormal(output[550], base[550]));
+
+		// Nothing, so b's vertices are restored
+		const float none[] = { 0.0f, 0.0f };
+		set.Blend(base.data(), none, output.data(), firstWritten, lastWritten, &stats);
+		CHECK(firstWritten == 500 && lastWritten == 599);
+		CHECK(stats.activeTargets == 0 && stats.writtenVertices == 100);
+
+		bool atRest = true;
+		for (unsigned int v = 0; v < vertexCount; v++)
+			atRest = atRest && SamePositionAndNormal(output[v], base[v]);
+		CHECK(atRest);
+
+		// Still nothing, so nothing is written
+		set.Blend(base.data(), none, output.data(), firstWritten, lastWritten, &stats);
+		CHECK(firstWritten > lastWritten);
+		CHECK(stats.writtenVertices == 0);
+
+		// Both at once, from rest
+		const float both[] = { 0.5f, 0.5f };
+		set.Blend(base.data(), both, output.data(), firstWritten, lastWritten, &stats);
+		CHECK(stats.writtenVertices == 200 && stats.deltasApplied == 200);
+	}
+
+	// --------------------------------------------------------
+	// 50 targets on 100k vertices, each moving a 2-10% patch,
+	// against dense float targets
+	//
+	// - Memory: the set (targets and blend scratch) against 24
+	//   bytes (position and normal delta) per vertex per target
+	// - Time: microseconds per blend with 1 to 50 targets active,
+	//   best of several frames. Dense blends every vertex of each
+	//   active target into a fresh copy of the base
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		const unsigned int vertexCount = 100000;
+		const unsigned int targetCount = 50;
+		std::mt19937 random(99);
+		std::vector<ObjVertex> base = MakeVertices(vertexCount, random);
+		std::uniform_int_distribution<unsigned int> patch(vertexCount / 50, vertexCount / 10);
+		std::uniform_int_distribution<unsigned int> start(0, vertexCount - 1);
+
+		std::vector<DenseTarget> dense;
+		MorphTargetSet set(vertexCount);
+		unsigned int totalDeltas = 0;
+		for (unsigned int t = 0; t < targetCount; t++)
+		{
+			dense.push_back(MakeTarget(vertexCount, start(random), patch(random), 0.5f, random));
+			unsigned int index = set.AddTarget("target", dense.back().positions.data(), dense.back().normals.data());
+			totalDeltas += set.GetTargetStats(index).affectedVertices;
+		}
+
+		size_t denseBytes = (size_t)targetCount * vertexCount * sizeof(ObjFloat3) * 2;
+		printf("\n%u targets, %u vertices, %u deltas\n", targetCount, vertexCount, totalDeltas);
+		printf("Memory: %.2f MB sparse (with scratch), %.2f MB dense\n", set.GetMemoryBytes() / (1024.0 * 1024.0), denseBytes / (1024.0 * 1024.0));
+
+		const unsigned int activeCounts[] = { 1, 4, 16, 50 };
+		printf("\nActive  Sparse (us)  Dense (us)  Written vertices\n");
+		std::vector<ObjVertex> output = base;
+		std::vector<ObjVertex> expected;
+		for (unsigned int active : activeCounts)
+		{
+			std::vector<float> weights(targetCount, 0.0f);
+			for (unsigned int t = 0; t < active; t++)
+				weights[t * targetCount / active] = 0.5f;
+
+			double best = 1e30;
+			MorphBlendStats stats = {};
+			for (unsigned int frame = 0; frame < 50; frame++)
+			{
+				// Nudge a weight so each frame really blends
+				weights[0] = 0.5f + (frame % 2) * 0.1f;
+				unsigned int firstWritten = 0;
+				unsigned int lastWritten = 0;
+				set.Blend(base.data(), weights.data(), output.data(), firstWritten, lastWritten, &stats);
+				best = stats.seconds < best ? stats.seconds : best;
+			}
+
+			double bestDense = 1e30;
+			for (unsigned int frame = 0; frame < 10; frame++)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				BlendDense(base, dense, weights.data(), expected);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				bestDense = seconds < bestDense ? seconds : bestDense;
+			}
+
+			benchmarkSink = output[0].Position.x + expected[0].Position.x;
+			printf("%6u  %11.1f  %10.1f  %16u\n", active, best * 1e6, bestDense * 1e6, stats.writtenVertices);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 random(1234);
+	TestQuantizationError(random);
+	TestBlendMatchesDense(random);
+	TestRestoresLastFrame(random);
+
+	int result = TestChecks::Finish("MorphTargets");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
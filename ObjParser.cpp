@@ -0,0 +1,395 @@
+#include "ObjParser.h"
+#include "ObjParserDetail.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+using namespace ObjParserDetail;
+
+namespace
+{
+	// --------------------------------------------------------
+	// Builds the final vertex for a corner (see MakeVertex)
+	// --------------------------------------------------------
+	inline ObjVertex BuildVertex(
+		const CornerKey& key,
+		const std::vector<ObjFloat3>& positions,
+		const std::vector<ObjFloat2>& uvs,
+		const std::vector<ObjFloat3>& normals)
+	{
+		return MakeVertex(
+			positions[key.position],
+			key.uv != missingAttribute ? &uvs[key.uv] : nullptr,
+			key.normal != missingAttribute ? &normals[key.normal] : nullptr);
+	}
+
+	// --------------------------------------------------------
+	// A triangle as read from one chunk of the file
+	//
+	// - Indices are 0-based; negative (relative) OBJ indices are
+	//   stored relative to the chunk's own attribute counts and
+	//   flagged in relativeMask, since chunks don't know how many
+	//   attributes came before them until all chunks are read
+	// --------------------------------------------------------
+	struct ChunkTriangle
+	{
+		int corners[3][3];	// [corner][position, uv, normal]
+		unsigned short relativeMask;
+	};
+
+	// Marks a raw corner element that wasn't present
+	const int missingRawIndex = -2147483647 - 1;
+
+	// --------------------------------------------------------
+	// A newline-aligned slice of the file and everything read from it
+	// --------------------------------------------------------
+	struct ParseChunk
+	{
+		const char* start;
+		const char* end;
+
+		std::vector<ObjFloat3> positions;
+		std::vector<ObjFloat2> uvs;
+		std::vector<ObjFloat3> normals;
+		std::vector<ChunkTriangle> triangles;
+		unsigned int faces;
+
+		// Where this chunk's data lands in the global arrays
+		size_t positionBase;
+		size_t uvBase;
+		size_t normalBase;
+		size_t triangleBase;
+	};
+
+	// Smaller chunks aren't worth the cost of a thread
+	const size_t minChunkBytes = 1 << 20;
+
+	// --------------------------------------------------------
+	// Runs work(i) for i in [0, count) across up to threadCount
+	// threads, or inline when there's only one thread
+	// --------------------------------------------------------
+	template<typename Work>
+	void RunParallel(unsigned int count, unsigned int threadCount, Work work)
+	{
+		if (threadCount <= 1 || count <= 1)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				work(i);
+			return;
+		}
+
+		unsigned int workerCount = threadCount < count ? threadCount : count;
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (unsigned int t = 0; t < workerCount; t++)
+		{
+			workers.emplace_back([=]()
+				{
+					for (unsigned int i = t; i < count; i += workerCount)
+						work(i);
+				});
+		}
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// --------------------------------------------------------
+	// Converts one raw OBJ index into the chunk's encoding,
+	// setting the relative bit when the index was negative
+	// --------------------------------------------------------
+	inline int EncodeIndex(long long index, size_t localCount, unsigned short relativeBit, unsigned short& relativeMask)
+	{
+		if (index > 0)
+			return index - 1 < 2147483647 ? (int)(index - 1) : missingRawIndex;
+
+		if (index < 0 && index > missingRawIndex)
+		{
+			relativeMask |= relativeBit;
+			return (int)((long long)localCount + index);
+		}
+
+		return missingRawIndex;
+	}
+
+	// --------------------------------------------------------
+	// Converts an encoded index into a global attribute index,
+	// returning missingAttribute if it's absent or out of range
+	// --------------------------------------------------------
+	inline unsigned int ResolveIndex(int index, bool relative, size_t base, size_t count)
+	{
+		if (index == missingRawIndex)
+			return missingAttribute;
+
+		long long global = relative ? (long long)base + index : index;
+		return global >= 0 && global < (long long)count ? (unsigned int)global : missingAttribute;
+	}
+
+	// --------------------------------------------------------
+	// Reads every line in a chunk
+	//
+	// - Attributes go into the chunk's own arrays
+	// - Faces are fan triangulated as corners are read, so only
+	//   the first and previous corners need to be remembered
+	// --------------------------------------------------------
+	void TokenizeChunk(ParseChunk& chunk)
+	{
+		const char* p = chunk.start;
+		const char* end = chunk.end;
+
+		while (p < end)
+		{
+			p = SkipSpaces(p, end);
+			if (p >= end)
+				break;
+
+			// Check the type of line
+			if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+			{
+				// Position - any 4th (w) component is ignored
+				ObjFloat3 pos;
+				p = ParseFloat(p + 1, end, pos.x);
+				p = ParseFloat(p, end, pos.y);
+				p = ParseFloat(p, end, pos.z);
+				chunk.positions.push_back(pos);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+			{
+				// UV - any 3rd (w) component is ignored
+				ObjFloat2 uv;
+				p = ParseFloat(p + 2, end, uv.x);
+				p = ParseFloat(p, end, uv.y);
+				chunk.uvs.push_back(uv);
+			}
+			else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+			{
+				ObjFloat3 norm;
+				p = ParseFloat(p + 2, end, norm.x);
+				p = ParseFloat(p, end, norm.y);
+				p = ParseFloat(p, end, norm.z);
+				chunk.normals.push_back(norm);
+			}
+			else if (p + 1 < end && p[0] == 'f' && IsSpace(p[1]))
+			{
+				p++;
+
+				// Corners are stored as [corner][attribute] with the
+				// relative flags packed into 3 bits per corner
+				int first[3] = {};
+				int previous[3] = {};
+				unsigned short firstMask = 0;
+				unsigned short previousMask = 0;
+				unsigned int cornerCount = 0;
+
+				long long v, vt, vn;
+				while (ParseCorner(p, end, v, vt, vn))
+				{
+					int current[3];
+					unsigned short currentMask = 0;
+					current[0] = EncodeIndex(v, chunk.positions.size(), 1, currentMask);
+					current[1] = EncodeIndex(vt, chunk.uvs.size(), 2, currentMask);
+					current[2] = EncodeIndex(vn, chunk.normals.size(), 4, currentMask);
+
+					// Add a whole triangle once we have three corners (flipping the winding order)
+					if (cornerCount >= 2)
+					{
+						ChunkTriangle tri;
+						for (int a = 0; a < 3; a++)
+						{
+							tri.corners[0][a] = first[a];
+							tri.corners[1][a] = current[a];
+							tri.corners[2][a] = previous[a];
+						}
+						tri.relativeMask = (unsigned short)(firstMask | (currentMask << 3) | (previousMask << 6));
+						chunk.triangles.push_back(tri);
+					}
+					else if (cornerCount == 0)
+					{
+						for (int a = 0; a < 3; a++)
+							first[a] = current[a];
+						firstMask = currentMask;
+					}
+
+					for (int a = 0; a < 3; a++)
+						previous[a] = current[a];
+					previousMask = currentMask;
+					cornerCount++;
+				}
+
+				if (cornerCount >= 3)
+					chunk.faces++;
+			}
+
+			// Move on to the next line, whatever its length
+			p = SkipLine(p, end);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Maps the given file and parses it
+// --------------------------------------------------------
+bool ObjParser::ParseFile(const char* fileName, ObjMeshData& output, unsigned int threadCount)
+{
+	MappedFile file;
+	if (!file.Open(fileName))
+		return false;
+
+	return Parse(file.GetData(), file.GetSize(), output, threadCount);
+}
+
+// --------------------------------------------------------
+// Parses OBJ text from memory
+//
+// The work is split into phases so that the tokenizing and
+// vertex assembly can run on several threads:
+//  1. Split the file into chunks at newline boundaries and
+//     tokenize each chunk on its own thread
+//  2. Prefix-sum the chunk counts into global offsets
+//  3. Copy attributes into the global arrays and resolve each
+//     chunk's triangle corners to global indices, in parallel
+//  4. Deduplicate corners in file order (serial, integer only)
+//  5. Build the unique vertices, in parallel
+//
+// Phase 4 is what keeps the output byte-identical no matter
+// how many threads are used, since vertex numbering follows
+// the first appearance of each corner in the file
+// --------------------------------------------------------
+bool ObjParser::Parse(const char* data, size_t size, ObjMeshData& output, unsigned int threadCount)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	output.vertices.clear();
+	output.indices.clear();
+	output.stats = {};
+	output.stats.bytes = size;
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+	// Phase 1: split at newlines, then tokenize each chunk
+	size_t chunkCount = size / minChunkBytes;
+	if (chunkCount > threadCount)
+		chunkCount = threadCount;
+	if (chunkCount < 1)
+		chunkCount = 1;
+
+	std::vector<ParseChunk> chunks(chunkCount);
+	const char* end = data + size;
+	const char* chunkStart = data;
+	for (size_t c = 0; c < chunkCount; c++)
+	{
+		const char* chunkEnd = end;
+		if (c + 1 < chunkCount)
+		{
+			chunkEnd = data + size * (c + 1) / chunkCount;
+			if (chunkEnd < chunkStart)
+				chunkEnd = chunkStart;
+			chunkEnd = SkipLine(chunkEnd, end);
+		}
+
+		chunks[c].start = chunkStart;
+		chunks[c].end = chunkEnd;
+		chunks[c].faces = 0;
+		chunkStart = chunkEnd;
+	}
+
+	unsigned int workerCount = (unsigned int)chunkCount;
+	RunParallel(workerCount, workerCount, [&](unsigned int c) { TokenizeChunk(chunks[c]); });
+
+	// Phase 2: turn the per-chunk counts into global offsets
+	size_t positionCount = 0;
+	size_t uvCount = 0;
+	size_t normalCount = 0;
+	size_t triangleCount = 0;
+	for (ParseChunk& chunk : chunks)
+	{
+		chunk.positionBase = positionCount;
+		chunk.uvBase = uvCount;
+		chunk.normalBase = normalCount;
+		chunk.triangleBase = triangleCount;
+
+		positionCount += chunk.positions.size();
+		uvCount += chunk.uvs.size();
+		normalCount += chunk.normals.size();
+		triangleCount += chunk.triangles.size();
+		output.stats.faces += chunk.faces;
+	}
+
+	// Phase 3: gather attributes and resolve corners to global indices
+	std::vector<ObjFloat3> positions(positionCount);
+	std::vector<ObjFloat2> uvs(uvCount);
+	std::vector<ObjFloat3> normals(normalCount);
+	std::vector<CornerKey> corners(triangleCount * 3);
+
+	RunParallel(workerCount, workerCount, [&](unsigned int c)
+		{
+			ParseChunk& chunk = chunks[c];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + chunk.positionBase);
+			std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + chunk.uvBase);
+			std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + chunk.normalBase);
+
+			CornerKey* out = corners.data() + chunk.triangleBase * 3;
+			for (const ChunkTriangle& tri : chunk.triangles)
+			{
+				for (int k = 0; k < 3; k++)
+				{
+					unsigned short mask = (unsigned short)(tri.relativeMask >> (k * 3));
+					out->position = ResolveIndex(tri.corners[k][0], (mask & 1) != 0, chunk.positionBase, positionCount);
+					out->uv = ResolveIndex(tri.corners[k][1], (mask & 2) != 0, chunk.uvBase, uvCount);
+					out->normal = ResolveIndex(tri.corners[k][2], (mask & 4) != 0, chunk.normalBase, normalCount);
+					out++;
+				}
+			}
+
+			// Free the chunk's memory as soon as it's been consumed
+			std::vector<ChunkTriangle>().swap(chunk.triangles);
+		});
+
+	// Phase 4: deduplicate corners in file order
+	// - Triangles referencing missing positions are dropped
+	std::vector<CornerKey> uniqueCorners;
+	CornerCache vertexCache;
+	output.indices.reserve(corners.size());
+	for (size_t t = 0; t < triangleCount; t++)
+	{
+		const CornerKey* tri = &corners[t * 3];
+		if (tri[0].position == missingAttribute ||
+			tri[1].position == missingAttribute ||
+			tri[2].position == missingAttribute)
+			continue;
+
+		for (int k = 0; k < 3; k++)
+		{
+			unsigned int index = vertexCache.FindOrInsert(tri[k], (unsigned int)uniqueCorners.size());
+			if (index == uniqueCorners.size())
+				uniqueCorners.push_back(tri[k]);
+
+			output.indices.push_back(index);
+		}
+		output.stats.triangles++;
+	}
+
+	// Phase 5: build the unique vertices in parallel ranges
+	size_t vertexCount = uniqueCorners.size();
+	output.vertices.resize(vertexCount);
+	unsigned int rangeCount = vertexCount >= 65536 ? threadCount : 1;
+	RunParallel(rangeCount, rangeCount, [&](unsigned int r)
+		{
+			size_t rangeStart = vertexCount * r / rangeCount;
+			size_t rangeEnd = vertexCount * (r + 1) / rangeCount;
+			for (size_t i = rangeStart; i < rangeEnd; i++)
+				output.vertices[i] = BuildVertex(uniqueCorners[i], positions, uvs, normals);
+		});
+
+	output.stats.positions = (unsigned int)positionCount;
+	output.stats.uvs = (unsigned int)uvCount;
+	output.stats.normals = (unsigned int)normalCount;
+	output.stats.uniqueVertices = (unsigned int)vertexCount;
+	output.stats.threads = workerCount > rangeCount ? workerCount : rangeCount;
+	output.stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	return !output.indices.empty();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// --------------------------------------------------------
+// Plain float vectors so the parser has no DirectX dependency
+// --------------------------------------------------------
+struct ObjFloat2
+{
+	float x;
+	float y;
+};
+
+struct ObjFloat3
+{
+	float x;
+	float y;
+	float z;
+};
+
+// --------------------------------------------------------
+// A vertex emitted by the parser
+//
+// - Matches the memory layout of Vertex (see Vertex.h), so
+//   the results can be handed straight to the mesh code
+// - Tangent is left zeroed; Mesh calculates it afterwards
+// --------------------------------------------------------
+struct ObjVertex
+{
+	ObjFloat3 Position;
+	ObjFloat3 Normal;
+	ObjFloat3 Tangent;
+	ObjFloat2 UV;
+};
+
+// --------------------------------------------------------
+// Counters gathered while parsing, used for benchmarking
+// --------------------------------------------------------
+struct ObjParseStats
+{
+	size_t bytes;
+	unsigned int positions;
+	unsigned int uvs;
+	unsigned int normals;
+	unsigned int faces;
+	unsigned int triangles;
+	unsigned int uniqueVertices;
+	unsigned int threads;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// The final, triangulated and indexed output of the parser
+//
+// - Each unique (position, uv, normal) triple becomes one vertex,
+//   and the indices reference those shared vertices
+// --------------------------------------------------------
+struct ObjMeshData
+{
+	std::vector<ObjVertex> vertices;
+	std::vector<unsigned int> indices;
+	ObjParseStats stats;
+};
+
+// --------------------------------------------------------
+// Parses Wavefront OBJ text into triangles
+//
+// - Works directly over the file bytes (memory mapped), with a
+//   hand-written number tokenizer and no per-line allocations
+// - Lines may be any length, and faces may have any number of
+//   corners (they're fan triangulated)
+// - Large files are split into chunks and parsed on several
+//   threads, with byte-identical results to a serial parse
+// - Corners are deduplicated, so the index buffer is meaningful
+//   and the post-transform vertex cache can actually get hits
+// - Produces the same output as the original sscanf_s loader:
+//   Z and normal Z are flipped (RH to LH), UV.y is flipped and
+//   the winding order is reversed
+// --------------------------------------------------------
+class ObjParser
+{
+public:
+	// A threadCount of 0 uses every hardware thread; small files
+	// are always parsed on the calling thread
+	static bool ParseFile(const char* fileName, ObjMeshData& output, unsigned int threadCount = 0);
+	static bool Parse(const char* data, size_t size, ObjMeshData& output, unsigned int threadCount = 0);
+};
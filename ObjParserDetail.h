@@ -0,0 +1,320 @@
+#pragma once
+#include <algorithm>
+#include <vector>
+
+#include "ObjParser.h"
+
+// --------------------------------------------------------
+// Text tokenizing and corner deduplication shared by the
+// in-memory OBJ parser and the streaming importer
+//
+// - Only meant to be included by their .cpp files
+// --------------------------------------------------------
+namespace ObjParserDetail
+{
+	// Exactly representable powers of ten used by the float tokenizer
+	const double powersOfTen[] =
+	{
+		1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+		1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+		1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+	const int maxPowerOfTen = 22;
+
+	inline bool IsDigit(char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	inline bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t';
+	}
+
+	inline const char* SkipSpaces(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+			++p;
+		return p;
+	}
+
+	// Moves to the first character of the next line, however long this one is
+	inline const char* SkipLine(const char* p, const char* end)
+	{
+		while (p < end && *p != '\n')
+			++p;
+		return p < end ? p + 1 : end;
+	}
+
+	// --------------------------------------------------------
+	// Reads a (possibly signed) integer, leaving 0 if there are no digits
+	// --------------------------------------------------------
+	inline const char* ParseInt(const char* p, const char* end, long long& result)
+	{
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		long long value = 0;
+		while (p < end && IsDigit(*p))
+		{
+			value = value * 10 + (*p - '0');
+			++p;
+		}
+
+		result = negative ? -value : value;
+		return p;
+	}
+
+	// --------------------------------------------------------
+	// Reads a decimal float such as "-1.25e-3"
+	//
+	// - Gathers up to 19 significant digits into an integer
+	//   mantissa, then scales once by an exact power of ten
+	// - Anything that isn't a number reads as 0
+	// --------------------------------------------------------
+	inline const char* ParseFloat(const char* p, const char* end, float& result)
+	{
+		p = SkipSpaces(p, end);
+
+		bool negative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			negative = *p == '-';
+			++p;
+		}
+
+		unsigned long long mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+
+		// Whole part - digits past what fits just scale the result
+		while (p < end && IsDigit(*p))
+		{
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + (*p - '0');
+				if (mantissa != 0)
+					significantDigits++;
+			}
+			else
+			{
+				exponent++;
+			}
+			++p;
+		}
+
+		// Fractional part - digits past what fits are dropped
+		if (p < end && *p == '.')
+		{
+			++p;
+			while (p < end && IsDigit(*p))
+			{
+				if (significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa != 0)
+						significantDigits++;
+					exponent--;
+				}
+				++p;
+			}
+		}
+
+		// Explicit exponent
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			long long explicitExponent = 0;
+			p = ParseInt(p + 1, end, explicitExponent);
+			exponent += (int)explicitExponent;
+		}
+
+		// Scale by dividing or multiplying by exact powers of ten,
+		// which keeps the rounding error to a minimum
+		double value = (double)mantissa;
+		if (mantissa != 0)
+		{
+			while (exponent < 0)
+			{
+				int step = -exponent < maxPowerOfTen ? -exponent : maxPowerOfTen;
+				value /= powersOfTen[step];
+				exponent += step;
+			}
+			while (exponent > 0)
+			{
+				int step = exponent < maxPowerOfTen ? exponent : maxPowerOfTen;
+				value *= powersOfTen[step];
+				exponent -= step;
+			}
+		}
+
+		result = (float)(negative ? -value : value);
+		return p;
+	}
+
+	// --------------------------------------------------------
+	// Reads a single face corner in any of the OBJ forms:
+	//   v, v/vt, v//vn or v/vt/vn
+	//
+	// - Missing elements are left as 0 (OBJ indices are never 0)
+	// - Returns false when there are no more corners on the line
+	// --------------------------------------------------------
+	inline bool ParseCorner(const char*& p, const char* end, long long& v, long long& vt, long long& vn)
+	{
+		p = SkipSpaces(p, end);
+		if (p >= end || !(IsDigit(*p) || *p == '-' || *p == '+'))
+			return false;
+
+		vt = 0;
+		vn = 0;
+		p = ParseInt(p, end, v);
+
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+				p = ParseInt(p, end, vt);
+
+			if (p < end && *p == '/')
+				p = ParseInt(p + 1, end, vn);
+		}
+
+		// Skip anything else glued to this corner
+		while (p < end && !IsSpace(*p) && *p != '\r' && *p != '\n')
+			++p;
+
+		return true;
+	}
+
+	// Marks a corner that has no UV or normal
+	const unsigned int missingAttribute = 0xFFFFFFFF;
+
+	// --------------------------------------------------------
+	// The attribute indices that make up a single face corner
+	// --------------------------------------------------------
+	struct CornerKey
+	{
+		unsigned int position;
+		unsigned int uv;
+		unsigned int normal;
+	};
+
+	inline bool operator==(const CornerKey& a, const CornerKey& b)
+	{
+		return a.position == b.position && a.uv == b.uv && a.normal == b.normal;
+	}
+
+	// --------------------------------------------------------
+	// Open-addressing hash table from corner keys to vertex indices
+	//
+	// - Keys are the attribute indices rather than the float values,
+	//   which is exact for OBJ files and much cheaper to hash
+	// - Stored flat (no per-entry allocations) and kept at most
+	//   half full so probe sequences stay short
+	// --------------------------------------------------------
+	class CornerCache
+	{
+	private:
+		struct Entry
+		{
+			CornerKey key;
+			unsigned int vertexIndex;
+		};
+
+		std::vector<Entry> entries;
+		size_t count;
+
+		static size_t Hash(const CornerKey& key)
+		{
+			// Multiplicative mixing of all three indices
+			unsigned long long h = key.position * 0x9E3779B97F4A7C15ull;
+			h ^= (key.uv + 0x632BE59BD9B4E019ull) * 0xC2B2AE3D27D4EB4Full;
+			h ^= (key.normal + 0x165667B19E3779F9ull) * 0x27D4EB2F165667C5ull;
+			return (size_t)(h ^ (h >> 29));
+		}
+
+		void Grow()
+		{
+			std::vector<Entry> oldEntries;
+			oldEntries.swap(entries);
+			entries.assign(oldEntries.empty() ? 1024 : oldEntries.size() * 2, Entry{ {}, missingAttribute });
+
+			size_t mask = entries.size() - 1;
+			for (const Entry& e : oldEntries)
+			{
+				if (e.vertexIndex == missingAttribute)
+					continue;
+
+				size_t slot = Hash(e.key) & mask;
+				while (entries[slot].vertexIndex != missingAttribute)
+					slot = (slot + 1) & mask;
+				entries[slot] = e;
+			}
+		}
+
+	public:
+		CornerCache() : count(0) {}
+
+		// Returns the existing vertex index for this key, or stores
+		// and returns newIndex if the key hasn't been seen yet
+		unsigned int FindOrInsert(const CornerKey& key, unsigned int newIndex)
+		{
+			if ((count + 1) * 2 > entries.size())
+				Grow();
+
+			size_t mask = entries.size() - 1;
+			size_t slot = Hash(key) & mask;
+			while (entries[slot].vertexIndex != missingAttribute)
+			{
+				if (entries[slot].key == key)
+					return entries[slot].vertexIndex;
+				slot = (slot + 1) & mask;
+			}
+
+			entries[slot].key = key;
+			entries[slot].vertexIndex = newIndex;
+			count++;
+			return newIndex;
+		}
+
+		// Empties the table but keeps its memory for reuse
+		void Clear()
+		{
+			std::fill(entries.begin(), entries.end(), Entry{ {}, missingAttribute });
+			count = 0;
+		}
+
+		size_t GetMemoryBytes() const
+		{
+			return entries.capacity() * sizeof(Entry);
+		}
+	};
+
+	// --------------------------------------------------------
+	// Builds the final vertex from a corner's attributes
+	//
+	// - Missing UVs and normals (nullptr) read as zero
+	// - Flips UV.y and the Z axis to match the original loader
+	// --------------------------------------------------------
+	inline ObjVertex MakeVertex(const ObjFloat3& position, const ObjFloat2* uv, const ObjFloat3* normal)
+	{
+		ObjVertex vertex = {};
+		vertex.Position = position;
+		if (uv)
+			vertex.UV = *uv;
+		if (normal)
+			vertex.Normal = *normal;
+
+		// Flip the UV's since they're probably "upside down"
+		vertex.UV.y = 1.0f - vertex.UV.y;
+
+		// Flip Z (LH vs. RH), along with the normal's Z
+		vertex.Position.z *= -1.0f;
+		vertex.Normal.z *= -1.0f;
+
+		return vertex;
+	}
+}
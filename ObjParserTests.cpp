@@ -0,0 +1,562 @@
+// --------------------------------------------------------
+// Tests and benchmark for ObjParser
+//
+// - Checks the corner forms (v, v/vt, v//vn, v/vt/vn) and
+//   negative (relative) indices, with missing UVs and normals
+//   reading as zero
+// - Checks CRLF line endings and a last line with no newline
+//   parse the same as plain LF files
+// - Checks every OBJ in Assets/ comes out the same as the
+//   original getline / sscanf_s loader, once the parser's
+//   indexed output is expanded back into triangles
+// - Checks large files split into chunks for several threads
+//   parse the same as on one thread, with the split landing
+//   on a face line, part way through one, or on a newline
+// - Given "bench", also compares throughput with the original
+//   loader on a generated grid, read from a file for both,
+//   and sweeps the parser over 1 to 16 threads
+// - Not part of the Visual Studio project. On Linux it's the
+//   objparser_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 ObjParserTests.cpp ObjParser.cpp
+//       MappedFile.cpp -lpthread -o objparser_tests
+//   (run from the repo root so Assets/ is found)
+// - Usage: objparser_tests [bench]
+// --------------------------------------------------------
+#include "ObjParser.h"
+#include "TestChecks.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef OBJPARSER_ASSET_DIRECTORY
+#define OBJPARSER_ASSET_DIRECTORY "Assets/"
+#endif
+
+#ifndef _MSC_VER
+#define sscanf_s sscanf
+#endif
+
+namespace
+{
+	bool ParseText(const std::string& text, ObjMeshData& output)
+	{
+		return ObjParser::Parse(text.data(), text.size(), output, 1);
+	}
+
+	bool SameVertex(const ObjVertex& a, const ObjVertex& b)
+	{
+		return memcmp(&a, &b, sizeof(ObjVertex)) == 0;
+	}
+
+	bool SameMesh(const ObjMeshData& a, const ObjMeshData& b)
+	{
+		if (a.vertices.size() != b.vertices.size() || a.indices != b.indices)
+			return false;
+
+		for (size_t i = 0; i < a.vertices.size(); i++)
+		{
+			if (!SameVertex(a.vertices[i], b.vertices[i]))
+				return false;
+		}
+		return true;
+	}
+
+	// The parser's triangles, one vertex per corner, as the original loader made them
+	std::vector<ObjVertex> Expand(const ObjMeshData& mesh)
+	{
+		std::vector<ObjVertex> corners;
+		for (unsigned int index : mesh.indices)
+			corners.push_back(mesh.vertices[index]);
+		return corners;
+	}
+
+	// --------------------------------------------------------
+	// The original loader from Mesh.cpp, over any stream
+	//
+	// - Kept as it was, 100 character line limit and all (so
+	//   only files it could load are given to it), with only
+	//   Vertex swapped for ObjVertex
+	// - Returns one vertex per triangle corner
+	// --------------------------------------------------------
+	std::vector<ObjVertex> LoadLegacy(std::istream& obj)
+	{
+		std::vector<ObjFloat3> positions;
+		std::vector<ObjFloat3> normals;
+		std::vector<ObjFloat2> uvs;
+		std::vector<ObjVertex> verts;
+		char chars[100];
+
+		while (obj.good())
+		{
+			obj.getline(chars, 100);
+
+			if (chars[0] == 'v' && chars[1] == 'n')
+			{
+				ObjFloat3 norm;
+				sscanf_s(chars, "vn %f %f %f", &norm.x, &norm.y, &norm.z);
+				normals.push_back(norm);
+			}
+			else if (chars[0] == 'v' && chars[1] == 't')
+			{
+				ObjFloat2 uv;
+				sscanf_s(chars, "vt %f %f", &uv.x, &uv.y);
+				uvs.push_back(uv);
+			}
+			else if (chars[0] == 'v')
+			{
+				ObjFloat3 pos;
+				sscanf_s(chars, "v %f %f %f", &pos.x, &pos.y, &pos.z);
+				positions.push_back(pos);
+			}
+			else if (chars[0] == 'f')
+			{
+				unsigned int i[12];
+				int numbersRead = sscanf_s(
+					chars,
+					"f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u",
+					&i[0], &i[1], &i[2],
+					&i[3], &i[4], &i[5],
+					&i[6], &i[7], &i[8],
+					&i[9], &i[10], &i[11]);
+
+				if (numbersRead == 1)
+				{
+					numbersRead = sscanf_s(
+						chars,
+						"f %u//%u %u//%u %u//%u %u//%u",
+						&i[0], &i[2],
+						&i[3], &i[5],
+						&i[6], &i[8],
+						&i[9], &i[11]);
+					i[1] = 1;
+					i[4] = 1;
+					i[7] = 1;
+					i[10] = 1;
+					if (uvs.size() == 0)
+						uvs.push_back({ 0, 0 });
+				}
+
+				ObjVertex v[4] = {};
+				unsigned int cornerCount = numbersRead == 12 || numbersRead == 8 ? 4 : 3;
+				for (unsigned int c = 0; c < cornerCount; c++)
+				{
+					v[c].Position = positions[i[c * 3] - 1];
+					v[c].UV = uvs[i[c * 3 + 1] - 1];
+					v[c].Normal = normals[i[c * 3 + 2] - 1];
+					v[c].UV.y = 1.0f - v[c].UV.y;
+					v[c].Position.z *= -1.0f;
+					v[c].Normal.z *= -1.0f;
+				}
+
+				verts.push_back(v[0]);
+				verts.push_back(v[2]);
+				verts.push_back(v[1]);
+				if (cornerCount == 4)
+				{
+					verts.push_back(v[0]);
+					verts.push_back(v[3]);
+					verts.push_back(v[2]);
+				}
+			}
+		}
+		return verts;
+	}
+
+	// A unit quad with every attribute, before its face line
+	const char* quadAttributes =
+		"v 0 0 1\n"
+		"v 1 0 1\n"
+		"v 1 1 1\n"
+		"v 0 1 1\n"
+		"vt 0 0\n"
+		"vt 1 0\n"
+		"vt 1 1\n"
+		"vt 0 1\n"
+		"vn 0 0 1\n";
+
+	// --------------------------------------------------------
+	// A quad is fan triangulated with the winding reversed,
+	// and Z and UV.y flipped, as the original loader did
+	//
+	// - Vertices are numbered in the order the triangles first
+	//   use them, so corner 3 is vertex 1
+	// --------------------------------------------------------
+	void TestQuad()
+	{
+		ObjMeshData mesh;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1\n", mesh));
+		CHECK(mesh.vertices.size() == 4);
+		CHECK(mesh.stats.faces == 1 && mesh.stats.triangles == 2);
+
+		const unsigned int expected[] = { 0, 1, 2, 0, 3, 1 };
+		CHECK(mesh.indices == std::vector<unsigned int>(expected, expected + 6));
+		if (mesh.vertices.size() == 4)
+		{
+			CHECK(mesh.vertices[1].Position.x == 1.0f && mesh.vertices[1].Position.y == 1.0f && mesh.vertices[1].Position.z == -1.0f);
+			CHECK(mesh.vertices[1].UV.x == 1.0f && mesh.vertices[1].UV.y == 0.0f);
+			CHECK(mesh.vertices[1].Normal.z == -1.0f);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Negative indices count back from the attributes read so
+	// far, so they match the same face written with absolute
+	// ones, even with more attributes after the face
+	// --------------------------------------------------------
+	void TestNegativeIndices()
+	{
+		std::string after = "v 5 5 5\nvt 0.5 0.5\nvn 1 0 0\n";
+		ObjMeshData absolute;
+		ObjMeshData relative;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1\n" + after, absolute));
+		CHECK(ParseText(std::string(quadAttributes) + "f -4/-4/-1 -3/-3/-1 -2/-2/-1 -1/-1/-1\n" + after, relative));
+		CHECK(SameMesh(absolute, relative));
+
+		// Mixed forms on one face
+		ObjMeshData mixed;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/-4/1 -3/2/-1 3/3/1 -1/4/-1\n" + after, mixed));
+		CHECK(SameMesh(absolute, mixed));
+
+		// Pointing before the first attribute drops the triangle
+		ObjMeshData outOfRange;
+		CHECK(!ParseText(std::string(quadAttributes) + "f -5/1/1 -3/2/1 -2/3/1\n", outOfRange));
+	}
+
+	// v//vn corners have a normal but no UV, which reads as 0 (1 once flipped)
+	void TestNormalsWithoutUVs()
+	{
+		ObjMeshData mesh;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1//1 2//1 3//1\n", mesh));
+		CHECK(mesh.vertices.size() == 3 && mesh.indices.size() == 3);
+
+		bool missingUVs = true;
+		for (const ObjVertex& vertex : mesh.vertices)
+			missingUVs = missingUVs && vertex.UV.x == 0.0f && vertex.UV.y == 1.0f && vertex.Normal.z == -1.0f;
+		CHECK(missingUVs);
+	}
+
+	// --------------------------------------------------------
+	// Corners with only a position, or a position and a UV, and
+	// a file with no vt or vn lines at all
+	// --------------------------------------------------------
+	void TestMissingUVs()
+	{
+		ObjMeshData mesh;
+		CHECK(ParseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 3\n", mesh));
+		CHECK(mesh.vertices.size() == 3 && mesh.stats.uvs == 0 && mesh.stats.normals == 0);
+
+		bool zeroed = true;
+		for (const ObjVertex& vertex : mesh.vertices)
+			zeroed = zeroed && vertex.UV.x == 0.0f && vertex.UV.y == 1.0f && vertex.Normal.x == 0.0f && vertex.Normal.y == 0.0f && vertex.Normal.z == 0.0f;
+		CHECK(zeroed);
+
+		// v/vt keeps the UV but has no normal
+		ObjMeshData withUVs;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1 2/2 3/3\n", withUVs));
+		CHECK(withUVs.vertices.size() == 3);
+		if (withUVs.vertices.size() == 3)
+			CHECK(withUVs.vertices[1].UV.x == 1.0f && withUVs.vertices[1].UV.y == 0.0f && withUVs.vertices[1].Normal.z == 0.0f);
+	}
+
+	// Windows line endings give exactly the same mesh
+	void TestCRLF()
+	{
+		std::string text = std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1\nf -1/1/1 -2/2/1 -3/3/1\n";
+		std::string crlf;
+		for (char c : text)
+		{
+			if (c == '\n')
+				crlf += '\r';
+			crlf += c;
+		}
+
+		ObjMeshData lf;
+		ObjMeshData windows;
+		CHECK(ParseText(text, lf));
+		CHECK(ParseText(crlf, windows));
+		CHECK(SameMesh(lf, windows));
+		CHECK(windows.stats.triangles == 3);
+	}
+
+	// --------------------------------------------------------
+	// The last line is read even without a newline, whether it's
+	// a face or an attribute (whose last number must not be cut)
+	// --------------------------------------------------------
+	void TestNoTrailingNewline()
+	{
+		ObjMeshData withNewline;
+		ObjMeshData without;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1\n", withNewline));
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1", without));
+		CHECK(SameMesh(withNewline, without));
+
+		ObjMeshData crlf;
+		CHECK(ParseText(std::string(quadAttributes) + "f 1/1/1 2/2/1 3/3/1 4/4/1\r", crlf));
+		CHECK(SameMesh(withNewline, crlf));
+
+		// The face comes before the last position here, so it's only seen in the stats
+		ObjMeshData lastAttribute;
+		CHECK(ParseText("v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 -1\nv 0 0 2.5", lastAttribute));
+		CHECK(lastAttribute.stats.positions == 4 && lastAttribute.indices.size() == 3);
+		ObjMeshData lastPosition;
+		CHECK(ParseText("v 0 0 0\nv 1 0 0\nv 0 0 2.5\nf 1 2 3", lastPosition));
+		CHECK(lastPosition.vertices.size() == 3);
+		if (lastPosition.vertices.size() == 3)
+			CHECK(lastPosition.vertices[1].Position.z == -2.5f);
+	}
+
+	// --------------------------------------------------------
+	// Every asset matches the original loader corner for corner,
+	// and the mapped file path matches parsing from memory
+	// --------------------------------------------------------
+	void TestAssetsMatchLegacy()
+	{
+		const char* assets[] = { "cube.obj", "cylinder.obj", "helix.obj", "quad.obj", "quad_double_sided.obj", "sphere.obj", "torus.obj" };
+		for (const char* asset : assets)
+		{
+			std::string fileName = std::string(OBJPARSER_ASSET_DIRECTORY) + asset;
+			std::ifstream file(fileName, std::ios::binary);
+			if (!CHECK(file.is_open()))
+				continue;
+
+			std::stringstream text;
+			text << file.rdbuf();
+			std::string contents = text.str();
+			std::istringstream legacyStream(contents);
+			std::vector<ObjVertex> legacy = LoadLegacy(legacyStream);
+
+			ObjMeshData mesh;
+			CHECK(ObjParser::ParseFile(fileName.c_str(), mesh, 1));
+			std::vector<ObjVertex> expanded = Expand(mesh);
+
+			bool same = legacy.size() == expanded.size();
+			for (size_t i = 0; same && i < legacy.size(); i++)
+				same = SameVertex(legacy[i], expanded[i]);
+			printf("  %s: %zu corners, %zu unique vertices, %s\n", asset, expanded.size(), mesh.vertices.size(), same ? "matches" : "differs");
+			CHECK(same);
+
+			ObjMeshData fromMemory;
+			CHECK(ParseText(contents, fromMemory));
+			CHECK(SameMesh(mesh, fromMemory));
+		}
+	}
+
+	// --------------------------------------------------------
+	// Rows of vertices, each followed by the quads joining it to
+	// the row before, so faces reach back across chunk splits
+	//
+	// - Odd rows use negative indices, even rows absolute ones
+	// - Records where each row's first face line starts
+	// --------------------------------------------------------
+	std::string MakeStrips(unsigned int width, unsigned int rows, std::vector<size_t>& firstFaces)
+	{
+		std::string text;
+		char line[100];
+		long long count = 0;
+		firstFaces.clear();
+		for (unsigned int y = 0; y < rows; y++)
+		{
+			for (unsigned int x = 0; x <= width; x++)
+			{
+				float u = (float)x / width;
+				float v = (float)y / rows;
+				snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f 1\n",
+					u * 10.0f, v * 10.0f, sinf(u * 6.0f) * cosf(v * 6.0f), u, v, u - 0.5f, v - 0.5f);
+				text += line;
+			}
+			count += width + 1;
+
+			firstFaces.push_back(text.size());
+			if (y == 0)
+				continue;
+
+			for (unsigned int x = 0; x < width; x++)
+			{
+				long long corners[4];
+				corners[0] = (long long)(y - 1) * (width + 1) + x + 1;
+				corners[1] = corners[0] + 1;
+				corners[2] = corners[1] + width + 1;
+				corners[3] = corners[0] + width + 1;
+				if (y % 2 == 1)
+				{
+					for (long long& corner : corners)
+						corner -= count + 1;
+				}
+				snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n",
+					corners[0], corners[0], corners[0], corners[1], corners[1], corners[1],
+					corners[2], corners[2], corners[2], corners[3], corners[3], corners[3]);
+				text += line;
+			}
+		}
+		return text;
+	}
+
+	// --------------------------------------------------------
+	// Chunked parses match the single threaded one exactly
+	//
+	// - Two chunks split the text at size / 2, so a comment line
+	//   is put in front to move that onto chosen bytes: the 'f'
+	//   starting a row of negative index faces, part way through
+	//   that line, the newline before it, the line after it and
+	//   the middle of a vertex line
+	// - Then more threads, splitting wherever they happen to
+	// --------------------------------------------------------
+	void TestChunkBoundaries()
+	{
+		std::vector<size_t> firstFaces;
+		std::string body = MakeStrips(200, 160, firstFaces);
+		size_t bodySize = body.size();
+
+		ObjMeshData single;
+		CHECK(ParseText(body, single));
+		CHECK(single.stats.threads == 1);
+
+		// The last odd row starting before the middle
+		size_t row = 0;
+		for (size_t r = 1; r < firstFaces.size(); r += 2)
+		{
+			if (firstFaces[r] + 1000 < bodySize / 2)
+				row = r;
+		}
+		size_t face = firstFaces[row];
+		size_t nextLine = body.find('\n', face) + 1;
+		CHECK(body[face] == 'f' && body[face - 1] == '\n');
+
+		const size_t splits[] = { face, face + 7, face - 1, nextLine, face - 5 };
+		for (size_t split : splits)
+		{
+			// Putting P bytes in front moves the middle to P + split when P = size - 2 * split
+			size_t prefixSize = bodySize - split * 2;
+			std::string text = "#" + std::string(prefixSize - 2, '-') + "\n" + body;
+			CHECK(text.size() / 2 == prefixSize + split);
+
+			ObjMeshData chunked;
+			CHECK(ObjParser::Parse(text.data(), text.size(), chunked, 2));
+			CHECK(chunked.stats.threads == 2);
+			CHECK(SameMesh(single, chunked));
+		}
+
+		for (unsigned int threadCount : { 2u, 3u, 4u, 8u })
+		{
+			ObjMeshData chunked;
+			CHECK(ObjParser::Parse(body.data(), body.size(), chunked, threadCount));
+			CHECK(chunked.stats.threads > 1);
+			CHECK(SameMesh(single, chunked));
+		}
+		printf("  %.1f MB in chunks: %zu indices, %zu unique vertices\n", bodySize / (1024.0 * 1024.0), single.indices.size(), single.vertices.size());
+	}
+
+	// --------------------------------------------------------
+	// A size x size grid of quads with every attribute, in the
+	// format the original loader expects
+	// --------------------------------------------------------
+	std::string MakeGrid(unsigned int size)
+	{
+		std::string text;
+		char line[100];
+		for (unsigned int y = 0; y <= size; y++)
+		{
+			for (unsigned int x = 0; x <= size; x++)
+			{
+				float u = (float)x / size;
+				float v = (float)y / size;
+				snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n",
+					u * 10.0f, v * 10.0f, sinf(u * 6.0f) * cosf(v * 6.0f), u, v, 0.0f, 0.0f, 1.0f);
+				text += line;
+			}
+		}
+		for (unsigned int y = 0; y < size; y++)
+		{
+			for (unsigned int x = 0; x < size; x++)
+			{
+				unsigned int a = y * (size + 1) + x + 1;
+				unsigned int b = a + 1;
+				unsigned int c = b + size + 1;
+				unsigned int d = a + size + 1;
+				snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				text += line;
+			}
+		}
+		return text;
+	}
+
+	// --------------------------------------------------------
+	// MB/s of the original loader against the parser, then the
+	// parser on 1 to 16 threads, best of 3 runs each
+	//
+	// - Both read the same file (warm in the OS cache), the
+	//   original through std::ifstream and the parser through
+	//   a memory mapping, as Mesh does
+	// - "Used" is how many threads the parser actually ran,
+	//   which is capped by the 1 MB minimum chunk size
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		std::filesystem::path fileName = std::filesystem::temp_directory_path() / "objparser_bench.obj";
+		{
+			std::string text = MakeGrid(600);
+			std::ofstream file(fileName, std::ios::binary);
+			file.write(text.data(), (std::streamsize)text.size());
+		}
+		double megabytes = std::filesystem::file_size(fileName) / (1024.0 * 1024.0);
+		printf("\n%.1f MB grid, %u hardware threads\n", megabytes, std::thread::hardware_concurrency());
+
+		double best = 1e30;
+		size_t corners = 0;
+		for (unsigned int run = 0; run < 3; run++)
+		{
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			std::ifstream file(fileName);
+			corners = LoadLegacy(file).size();
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			best = seconds < best ? seconds : best;
+		}
+		printf("getline / sscanf_s: %.1f MB/s (%zu corners)\n", megabytes / best, corners);
+		double legacySeconds = best;
+
+		printf("\nThreads  Used     MB/s  vs 1 thread  vs original\n");
+		double singleSeconds = 0.0;
+		for (unsigned int threadCount : { 1u, 2u, 4u, 8u, 16u })
+		{
+			ObjMeshData mesh;
+			best = 1e30;
+			for (unsigned int run = 0; run < 3; run++)
+			{
+				ObjParser::ParseFile(fileName.string().c_str(), mesh, threadCount);
+				best = mesh.stats.seconds < best ? mesh.stats.seconds : best;
+			}
+			singleSeconds = threadCount == 1 ? best : singleSeconds;
+			printf("%7u  %4u  %7.1f  %10.2fx  %10.2fx\n",
+				threadCount, mesh.stats.threads, megabytes / best, singleSeconds / best, legacySeconds / best);
+		}
+
+		std::filesystem::remove(fileName);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	TestQuad();
+	TestNegativeIndices();
+	TestNormalsWithoutUVs();
+	TestMissingUVs();
+	TestCRLF();
+	TestNoTrailingNewline();
+	TestAssetsMatchLegacy();
+	TestChunkBoundaries();
+
+	int result = TestChecks::Finish("ObjParser");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
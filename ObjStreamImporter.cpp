@@ -0,0 +1,747 @@
+#include "ObjStreamImporter.h"
+#include "ObjParserDetail.h"
+#include "CookedMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "TangentGenerator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace ObjParserDetail;
+
+namespace
+{
+	// Spill files are written and cached in pages this big
+	const size_t spillPageBytes = 64 * 1024;
+
+	// Smaller windows just mean more reads
+	const size_t minWindowBytes = 64 * 1024;
+
+	// Rough heap cost of one triangle in a batch: its indices and
+	// share of the vertices, the corner cache, and the working
+	// memory of the optimizer and meshlet builder
+	const size_t batchBytesPerTriangle = 512;
+
+	const unsigned long long noPage = ~0ull;
+	const unsigned int noSlot = 0xFFFFFFFF;
+
+	inline size_t RoundUpTo8(size_t value)
+	{
+		return (value + 7) & ~(size_t)7;
+	}
+
+	// --------------------------------------------------------
+	// Reads a text file a window at a time, handing out runs of
+	// whole lines
+	//
+	// - The partial line at the end of each window is carried
+	//   over to the next, so the buffer holds at most a window
+	//   plus the longest line
+	// - Reads are always a whole window, so the optional hasher
+	//   sees the file in multiples of 8 bytes
+	// --------------------------------------------------------
+	class TextWindows
+	{
+	private:
+		std::ifstream in;
+		std::vector<char> buffer;
+		size_t windowBytes;
+		size_t carryStart;
+		size_t carryEnd;
+		bool finished;
+		ContentHasher* hasher;
+		unsigned long long bytesRead;
+
+	public:
+		TextWindows(size_t windowBytes, ContentHasher* hasher) :
+			windowBytes(windowBytes), carryStart(0), carryEnd(0), finished(false), hasher(hasher), bytesRead(0)
+		{
+		}
+
+		bool Open(const char* fileName)
+		{
+			in.open(fileName, std::ios::binary);
+			return in.is_open();
+		}
+
+		// Gets the next run of whole lines, or false at the end of the file
+		bool Next(const char*& start, const char*& end)
+		{
+			// Move the carried over partial line to the front
+			size_t carry = carryEnd - carryStart;
+			if (carry > 0 && carryStart > 0)
+				memmove(buffer.data(), buffer.data() + carryStart, carry);
+			carryStart = 0;
+			carryEnd = carry;
+
+			while (true)
+			{
+				if (!finished)
+				{
+					if (buffer.size() < carryEnd + windowBytes)
+						buffer.resize(carryEnd + windowBytes);
+
+					in.read(buffer.data() + carryEnd, (std::streamsize)windowBytes);
+					size_t got = (size_t)in.gcount();
+					if (hasher)
+						hasher->Update(buffer.data() + carryEnd, got);
+
+					bytesRead += got;
+					carryEnd += got;
+					finished = got < windowBytes;
+				}
+
+				// Stop after the last newline, unless this is the end of the file
+				size_t linesEnd = carryEnd;
+				if (!finished)
+				{
+					while (linesEnd > 0 && buffer[linesEnd - 1] != '\n')
+						linesEnd--;
+				}
+
+				if (linesEnd > 0)
+				{
+					start = buffer.data();
+					end = buffer.data() + linesEnd;
+					carryStart = linesEnd;
+					return true;
+				}
+
+				if (finished)
+					return false;
+
+				// No newline yet - the line is longer than a window, so keep reading
+			}
+		}
+
+		size_t GetMemoryBytes() const
+		{
+			return buffer.capacity();
+		}
+
+		unsigned long long GetBytesRead() const
+		{
+			return this->bytesRead;
+		}
+	};
+
+	// --------------------------------------------------------
+	// A table of fixed size elements kept in a temporary file
+	//
+	// - Appended to through a one page write buffer, then read
+	//   back either in order (Read) or at random through a page
+	//   cache with CLOCK replacement (Get)
+	// - The file is deleted when the table is destroyed
+	// --------------------------------------------------------
+	class SpillTable
+	{
+	private:
+		std::fstream file;
+		std::string path;
+		size_t elementSize;
+		size_t pageElements;
+		unsigned long long count;
+		bool failed;
+
+		std::vector<char> writeBuffer;
+		size_t writeUsed;
+
+		// Page cache
+		std::vector<char> cache;
+		std::vector<unsigned long long> slotPages;
+		std::vector<unsigned char> slotUsed;
+		std::vector<unsigned int> pageSlots;
+		size_t clockHand;
+		unsigned long long hits;
+		unsigned long long misses;
+
+		void FlushWrites()
+		{
+			if (writeUsed == 0)
+				return;
+
+			file.write(writeBuffer.data(), (std::streamsize)writeUsed);
+			failed = failed || !file.good();
+			writeUsed = 0;
+		}
+
+	public:
+		SpillTable() :
+			elementSize(1), pageElements(1), count(0), failed(false), writeUsed(0), clockHand(0), hits(0), misses(0)
+		{
+		}
+
+		~SpillTable()
+		{
+			if (file.is_open())
+			{
+				file.close();
+				std::remove(path.c_str());
+			}
+		}
+
+		bool Open(const std::string& path, size_t elementSize)
+		{
+			this->path = path;
+			this->elementSize = elementSize;
+			pageElements = spillPageBytes / elementSize > 0 ? spillPageBytes / elementSize : 1;
+
+			file.open(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+			writeBuffer.resize(pageElements * elementSize);
+			return file.is_open();
+		}
+
+		void Append(const void* elements, size_t elementCount)
+		{
+			const char* data = static_cast<const char*>(elements);
+			size_t bytes = elementCount * elementSize;
+			while (bytes > 0)
+			{
+				size_t copy = writeBuffer.size() - writeUsed;
+				if (copy > bytes)
+					copy = bytes;
+
+				memcpy(writeBuffer.data() + writeUsed, data, copy);
+				writeUsed += copy;
+				data += copy;
+				bytes -= copy;
+
+				if (writeUsed == writeBuffer.size())
+					FlushWrites();
+			}
+			count += elementCount;
+		}
+
+		// --------------------------------------------------------
+		// Switches from writing to reading, with up to cacheBytes
+		// of pages cached for Get()
+		// --------------------------------------------------------
+		void FinishWriting(size_t cacheBytes)
+		{
+			FlushWrites();
+			file.flush();
+			std::vector<char>().swap(writeBuffer);
+
+			size_t pageBytes = pageElements * elementSize;
+			unsigned long long pageCount = (count + pageElements - 1) / pageElements;
+			size_t slotCount = cacheBytes / pageBytes;
+			if (slotCount < 1)
+				slotCount = 1;
+			if (slotCount > pageCount)
+				slotCount = (size_t)pageCount;
+
+			cache.resize(slotCount * pageBytes);
+			slotPages.assign(slotCount, noPage);
+			slotUsed.assign(slotCount, 0);
+			pageSlots.assign((size_t)pageCount, noSlot);
+			clockHand = 0;
+		}
+
+		// Reads elements [first, first + elementCount) into dest
+		bool Read(unsigned long long first, size_t elementCount, void* dest)
+		{
+			file.seekg((std::streamoff)(first * elementSize));
+			file.read(static_cast<char*>(dest), (std::streamsize)(elementCount * elementSize));
+			if (!file.good())
+			{
+				file.clear();
+				memset(dest, 0, elementCount * elementSize);
+				failed = true;
+				return false;
+			}
+			return true;
+		}
+
+		// --------------------------------------------------------
+		// Gets one element through the page cache
+		//
+		// - The pointer is only good until the next Get()
+		// - Evicts the first page that hasn't been used since the
+		//   clock hand last passed it
+		// --------------------------------------------------------
+		const char* Get(unsigned long long index)
+		{
+			unsigned long long page = index / pageElements;
+			unsigned int slot = pageSlots[(size_t)page];
+			if (slot != noSlot)
+			{
+				hits++;
+			}
+			else
+			{
+				misses++;
+				while (slotUsed[clockHand])
+				{
+					slotUsed[clockHand] = 0;
+					clockHand = (clockHand + 1) % slotPages.size();
+				}
+
+				slot = (unsigned int)clockHand;
+				clockHand = (clockHand + 1) % slotPages.size();
+				if (slotPages[slot] != noPage)
+					pageSlots[(size_t)slotPages[slot]] = noSlot;
+
+				unsigned long long first = page * pageElements;
+				size_t elementCount = (size_t)(count - first < pageElements ? count - first : pageElements);
+				Read(first, elementCount, cache.data() + slot * pageElements * elementSize);
+
+				slotPages[slot] = page;
+				pageSlots[(size_t)page] = slot;
+			}
+
+			slotUsed[slot] = 1;
+			return cache.data() + ((size_t)slot * pageElements + (size_t)(index - page * pageElements)) * elementSize;
+		}
+
+		unsigned long long GetCount() const { return count; }
+		unsigned long long GetBytes() const { return count * elementSize; }
+		unsigned long long GetHits() const { return hits; }
+		unsigned long long GetMisses() const { return misses; }
+		bool Failed() const { return failed; }
+
+		size_t GetMemoryBytes() const
+		{
+			return writeBuffer.capacity() + cache.capacity() +
+				slotPages.capacity() * sizeof(unsigned long long) +
+				slotUsed.capacity() +
+				pageSlots.capacity() * sizeof(unsigned int);
+		}
+	};
+
+	// --------------------------------------------------------
+	// Converts a raw OBJ index to a 0-based one
+	//
+	// - Negative indices count back from the attributes read so
+	//   far; positive ones can refer to any in the file
+	// --------------------------------------------------------
+	inline unsigned int ResolveStreamIndex(long long index, unsigned long long readSoFar, unsigned long long total)
+	{
+		long long resolved = index > 0 ? index - 1 : (long long)readSoFar + index;
+		if (index == 0 || resolved < 0 || (unsigned long long)resolved >= total || resolved >= missingAttribute)
+			return missingAttribute;
+
+		return (unsigned int)resolved;
+	}
+}
+
+// --------------------------------------------------------
+// Splits the budget between the pieces that use memory
+//
+// - The window gets a 32nd, since a read can need two of them
+//   (the carried over partial line plus a fresh window)
+// - The attribute cache gets half
+// - Whatever is left sets the batch size
+// --------------------------------------------------------
+ObjStreamConfig ObjStreamImporter::GetDefaultConfig(size_t memoryBudgetBytes)
+{
+	ObjStreamConfig config = {};
+	config.windowBytes = RoundUpTo8(memoryBudgetBytes / 32 > minWindowBytes ? memoryBudgetBytes / 32 : minWindowBytes);
+	config.attributeCacheBytes = memoryBudgetBytes / 2;
+
+	size_t used = config.windowBytes * 2 + config.attributeCacheBytes;
+	size_t batchBytes = memoryBudgetBytes > used ? memoryBudgetBytes - used : 0;
+	config.batchTriangles = (unsigned int)(batchBytes / batchBytesPerTriangle);
+	if (config.batchTriangles < 1024)
+		config.batchTriangles = 1024;
+
+	config.threadCount = 0;
+	return config;
+}
+
+// --------------------------------------------------------
+// Hashes a file a window at a time
+// --------------------------------------------------------
+bool ObjStreamImporter::HashFile(const char* fileName, size_t windowBytes, unsigned long long& hash, unsigned long long& size)
+{
+	std::error_code error;
+	size = std::filesystem::file_size(fileName, error);
+	if (error)
+		return false;
+
+	std::ifstream in(fileName, std::ios::binary);
+	if (!in.is_open())
+		return false;
+
+	std::vector<char> buffer(RoundUpTo8(windowBytes > minWindowBytes ? windowBytes : minWindowBytes));
+	ContentHasher hasher(size);
+	unsigned long long bytesRead = 0;
+	while (in)
+	{
+		in.read(buffer.data(), (std::streamsize)buffer.size());
+		size_t got = (size_t)in.gcount();
+		hasher.Update(buffer.data(), got);
+		bytesRead += got;
+	}
+
+	hash = hasher.Finish();
+	return bytesRead == size;
+}
+
+// --------------------------------------------------------
+// Imports an OBJ file into a cooked file (see the class
+// comment for the passes)
+// --------------------------------------------------------
+bool ObjStreamImporter::Import(const char* fileName, const char* cookedFileName, const ObjStreamConfig& config, ObjStreamStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	size_t windowBytes = RoundUpTo8(config.windowBytes > minWindowBytes ? config.windowBytes : minWindowBytes);
+	unsigned int batchTriangles = config.batchTriangles > 0 ? config.batchTriangles : 1;
+
+	ObjStreamStats result = {};
+	result.budgetBytes = windowBytes * 2 + config.attributeCacheBytes + (size_t)batchTriangles * batchBytesPerTriangle;
+
+	std::error_code error;
+	unsigned long long sourceSize = std::filesystem::file_size(fileName, error);
+	if (error)
+		return false;
+
+	// The spill files are named after the cooked file
+	std::filesystem::path spillBase = cookedFileName;
+	if (!config.spillDirectory.empty())
+		spillBase = std::filesystem::path(config.spillDirectory) / spillBase.filename();
+	std::string spillName = spillBase.string();
+
+	SpillTable positions;
+	SpillTable uvs;
+	SpillTable normals;
+	if (!positions.Open(spillName + ".positions.tmp", sizeof(ObjFloat3)) ||
+		!uvs.Open(spillName + ".uvs.tmp", sizeof(ObjFloat2)) ||
+		!normals.Open(spillName + ".normals.tmp", sizeof(ObjFloat3)))
+		return false;
+
+	// Pass 1: spill the attributes and hash the file
+	unsigned long long sourceHash = 0;
+	{
+		ContentHasher hasher(sourceSize);
+		TextWindows windows(windowBytes, &hasher);
+		if (!windows.Open(fileName))
+			return false;
+
+		const char* p;
+		const char* end;
+		while (windows.Next(p, end))
+		{
+			while (p < end)
+			{
+				p = SkipSpaces(p, end);
+				if (p >= end)
+					break;
+
+				if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+				{
+					ObjFloat3 pos;
+					p = ParseFloat(p + 1, end, pos.x);
+					p = ParseFloat(p, end, pos.y);
+					p = ParseFloat(p, end, pos.z);
+					positions.Append(&pos, 1);
+				}
+				else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+				{
+					ObjFloat2 uv;
+					p = ParseFloat(p + 2, end, uv.x);
+					p = ParseFloat(p, end, uv.y);
+					uvs.Append(&uv, 1);
+				}
+				else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+				{
+					ObjFloat3 norm;
+					p = ParseFloat(p + 2, end, norm.x);
+					p = ParseFloat(p, end, norm.y);
+					p = ParseFloat(p, end, norm.z);
+					normals.Append(&norm, 1);
+				}
+
+				p = SkipLine(p, end);
+			}
+
+			result.windows++;
+			size_t bytes = windows.GetMemoryBytes() + positions.GetMemoryBytes() + uvs.GetMemoryBytes() + normals.GetMemoryBytes();
+			if (bytes > result.peakBufferBytes)
+				result.peakBufferBytes = bytes;
+		}
+
+		// The file changed while it was being read
+		if (windows.GetBytesRead() != sourceSize)
+			return false;
+
+		sourceHash = hasher.Finish();
+	}
+
+	// Share the cache between the tables by size
+	unsigned long long attributeBytes = positions.GetBytes() + uvs.GetBytes() + normals.GetBytes();
+	if (positions.GetCount() == 0)
+		return false;
+
+	positions.FinishWriting((size_t)((double)config.attributeCacheBytes * positions.GetBytes() / attributeBytes));
+	uvs.FinishWriting((size_t)((double)config.attributeCacheBytes * uvs.GetBytes() / attributeBytes));
+	normals.FinishWriting((size_t)((double)config.attributeCacheBytes * normals.GetBytes() / attributeBytes));
+
+	// Pass 2: read faces and write each batch as it fills up
+	CookedMeshWriter writer;
+	SpillTable indexSpill;
+	SpillTable meshletSpill;
+	if (!writer.Begin(cookedFileName, sourceHash, sourceSize, sizeof(ObjVertex)) ||
+		!indexSpill.Open(spillName + ".indices.tmp", sizeof(unsigned int)) ||
+		!meshletSpill.Open(spillName + ".meshlets.tmp", sizeof(Meshlet)))
+		return false;
+
+	std::vector<ObjVertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Meshlet> meshlets;
+	CornerCache vertexCache;
+	indices.reserve((size_t)batchTriangles * 3);
+
+	unsigned long long vertexBase = 0;
+	unsigned long long indexBase = 0;
+	unsigned long long meshletBase = 0;
+	float boundsMin[3] = { 0, 0, 0 };
+	float boundsMax[3] = { 0, 0, 0 };
+	bool overflowed = false;
+
+	TextWindows windows(windowBytes, nullptr);
+	if (!windows.Open(fileName))
+		return false;
+
+	auto batchBytes = [&]()
+		{
+			return vertices.capacity() * sizeof(ObjVertex) +
+				indices.capacity() * sizeof(unsigned int) +
+				meshlets.capacity() * sizeof(Meshlet) +
+				vertexCache.GetMemoryBytes();
+		};
+
+	auto flushBatch = [&]()
+		{
+			if (indices.empty())
+				return;
+
+			unsigned int indexCount = (unsigned int)indices.size();
+			unsigned int vertexCount = MeshOptimizer::OptimizeMesh(
+				vertices.data(), (unsigned int)vertices.size(), sizeof(ObjVertex),
+				indices.data(), indexCount);
+			MeshletBuilder::BuildMeshlets(indices.data(), indexCount, vertices.data(), vertexCount, sizeof(ObjVertex), meshlets);
+			TangentGenerator::GenerateTangents(vertices.data(), vertexCount, indices.data(), indexCount, config.threadCount);
+
+			if (vertexBase + vertexCount > 0xFFFFFFFFull || indexBase + indexCount > 0xFFFFFFFFull)
+				overflowed = true;
+
+			for (unsigned int v = 0; v < vertexCount; v++)
+			{
+				const float* pos = &vertices[v].Position.x;
+				for (int a = 0; a < 3; a++)
+				{
+					if ((vertexBase == 0 && v == 0) || pos[a] < boundsMin[a])
+						boundsMin[a] = pos[a];
+					if ((vertexBase == 0 && v == 0) || pos[a] > boundsMax[a])
+						boundsMax[a] = pos[a];
+				}
+			}
+
+			// Vertices go straight into the cooked file, the rest waits until they're done
+			writer.WriteVertices(vertices.data(), vertexCount);
+
+			for (unsigned int& index : indices)
+				index += (unsigned int)vertexBase;
+			indexSpill.Append(indices.data(), indices.size());
+
+			for (Meshlet& meshlet : meshlets)
+				meshlet.indexOffset += (unsigned int)indexBase;
+			meshletSpill.Append(meshlets.data(), meshlets.size());
+
+			vertexBase += vertexCount;
+			indexBase += indexCount;
+			meshletBase += meshlets.size();
+			result.batches++;
+
+			size_t bytes = positions.GetMemoryBytes() + uvs.GetMemoryBytes() + normals.GetMemoryBytes() +
+				indexSpill.GetMemoryBytes() + meshletSpill.GetMemoryBytes() +
+				windows.GetMemoryBytes() + batchBytes();
+			if (bytes > result.peakBufferBytes)
+				result.peakBufferBytes = bytes;
+
+			vertices.clear();
+			indices.clear();
+			meshlets.clear();
+			vertexCache.Clear();
+		};
+
+	auto addCorner = [&](const CornerKey& key)
+		{
+			unsigned int index = vertexCache.FindOrInsert(key, (unsigned int)vertices.size());
+			if (index == vertices.size())
+			{
+				ObjFloat3 position;
+				memcpy(&position, positions.Get(key.position), sizeof(position));
+
+				ObjFloat2 uv = {};
+				if (key.uv != missingAttribute)
+					memcpy(&uv, uvs.Get(key.uv), sizeof(uv));
+
+				ObjFloat3 normal = {};
+				if (key.normal != missingAttribute)
+					memcpy(&normal, normals.Get(key.normal), sizeof(normal));
+
+				vertices.push_back(MakeVertex(
+					position,
+					key.uv != missingAttribute ? &uv : nullptr,
+					key.normal != missingAttribute ? &normal : nullptr));
+			}
+			indices.push_back(index);
+		};
+
+	{
+		// Relative indices count back from the attributes read so far
+		unsigned long long positionsRead = 0;
+		unsigned long long uvsRead = 0;
+		unsigned long long normalsRead = 0;
+
+		const char* p;
+		const char* end;
+		while (windows.Next(p, end))
+		{
+			while (p < end)
+			{
+				p = SkipSpaces(p, end);
+				if (p >= end)
+					break;
+
+				if (p + 1 < end && p[0] == 'v' && IsSpace(p[1]))
+				{
+					positionsRead++;
+				}
+				else if (p + 2 < end && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+				{
+					uvsRead++;
+				}
+				else if (p + 2 < end && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+				{
+					normalsRead++;
+				}
+				else if (p + 1 < end && p[0] == 'f' && IsSpace(p[1]))
+				{
+					p++;
+
+					// Fan triangulate, flipping the winding order like the in-memory parser
+					CornerKey first = {};
+					CornerKey previous = {};
+					unsigned int cornerCount = 0;
+
+					long long v, vt, vn;
+					while (ParseCorner(p, end, v, vt, vn))
+					{
+						CornerKey current;
+						current.position = ResolveStreamIndex(v, positionsRead, positions.GetCount());
+						current.uv = ResolveStreamIndex(vt, uvsRead, uvs.GetCount());
+						current.normal = ResolveStreamIndex(vn, normalsRead, normals.GetCount());
+
+						if (cornerCount >= 2 &&
+							first.position != missingAttribute &&
+							current.position != missingAttribute &&
+							previous.position != missingAttribute)
+						{
+							addCorner(first);
+							addCorner(current);
+							addCorner(previous);
+							result.triangles++;
+
+							if (indices.size() >= (size_t)batchTriangles * 3)
+								flushBatch();
+						}
+						else if (cornerCount == 0)
+						{
+							first = current;
+						}
+
+						previous = current;
+						cornerCount++;
+					}
+				}
+
+				p = SkipLine(p, end);
+			}
+
+			size_t bytes = windows.GetMemoryBytes() + positions.GetMemoryBytes() + uvs.GetMemoryBytes() + normals.GetMemoryBytes() +
+				indexSpill.GetMemoryBytes() + meshletSpill.GetMemoryBytes() + batchBytes();
+			if (bytes > result.peakBufferBytes)
+				result.peakBufferBytes = bytes;
+		}
+
+		flushBatch();
+	}
+
+	if (indexBase == 0 || overflowed || positions.Failed() || uvs.Failed() || normals.Failed())
+		return false;
+
+	// Copy the spilled indices and meshlets in after the vertices
+	indexSpill.FinishWriting(0);
+	meshletSpill.FinishWriting(0);
+	{
+		std::vector<unsigned int> indexChunk(windowBytes / sizeof(unsigned int));
+		for (unsigned long long first = 0; first < indexBase; first += indexChunk.size())
+		{
+			size_t count = (size_t)(indexBase - first < indexChunk.size() ? indexBase - first : indexChunk.size());
+			indexSpill.Read(first, count, indexChunk.data());
+			writer.WriteIndices(indexChunk.data(), (unsigned int)count);
+		}
+	}
+	{
+		std::vector<Meshlet> meshletChunk(windowBytes / sizeof(Meshlet));
+		for (unsigned long long first = 0; first < meshletBase; first += meshletChunk.size())
+		{
+			size_t count = (size_t)(meshletBase - first < meshletChunk.size() ? meshletBase - first : meshletChunk.size());
+			meshletSpill.Read(first, count, meshletChunk.data());
+			writer.WriteMeshlets(meshletChunk.data(), (unsigned int)count);
+		}
+	}
+
+	if (indexSpill.Failed() || meshletSpill.Failed())
+		return false;
+
+	MeshLOD lod = { 0, (unsigned int)indexBase, 0.0f };
+	if (!writer.Finish(&lod, 1, boundsMin, boundsMax))
+		return false;
+
+	result.bytes = sourceSize;
+	result.positions = (unsigned int)positions.GetCount();
+	result.uvs = (unsigned int)uvs.GetCount();
+	result.normals = (unsigned int)normals.GetCount();
+	result.vertices = (unsigned int)vertexBase;
+	result.meshlets = (unsigned int)meshletBase;
+	result.spillBytes = attributeBytes + indexSpill.GetBytes() + meshletSpill.GetBytes();
+	result.cacheHits = positions.GetHits() + uvs.GetHits() + normals.GetHits();
+	result.cacheMisses = positions.GetMisses() + uvs.GetMisses() + normals.GetMisses();
+	result.peakResidentBytes = GetPeakResidentBytes();
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+	if (stats)
+		*stats = result;
+	return true;
+}
+
+size_t ObjStreamImporter::GetPeakResidentBytes()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters = {};
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return 0;
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage = {};
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+	return (size_t)usage.ru_maxrss * 1024;
+#endif
+}
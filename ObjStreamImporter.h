@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// --------------------------------------------------------
+// Memory limits for a streaming import
+//
+// - windowBytes: how much OBJ text is read at a time (rounded
+//   up to a multiple of 8). A single line longer than this
+//   still has to fit in memory
+// - attributeCacheBytes: how much of the spilled position, UV
+//   and normal tables stays in memory while faces are read
+// - batchTriangles: how many triangles are deduplicated,
+//   optimized, clustered and written together. Batch memory
+//   (including the optimizer's) grows with this
+// - spillDirectory: where the temporary tables go; empty puts
+//   them next to the cooked file
+// --------------------------------------------------------
+struct ObjStreamConfig
+{
+	size_t windowBytes;
+	size_t attributeCacheBytes;
+	unsigned int batchTriangles;
+	unsigned int threadCount;
+	std::string spillDirectory;
+};
+
+// --------------------------------------------------------
+// Counters from a streaming import, used for benchmarking
+//
+// - peakBufferBytes is the high-water mark of the importer's
+//   own buffers (windows, caches, batches), which is what the
+//   config bounds
+// - peakResidentBytes is the whole process's peak working set
+//   (RSS) afterwards, for comparing against the in-memory path
+// - spillBytes counts the temporary tables written to disk
+// --------------------------------------------------------
+struct ObjStreamStats
+{
+	unsigned long long bytes;
+	unsigned int positions;
+	unsigned int uvs;
+	unsigned int normals;
+	unsigned int triangles;
+	unsigned int vertices;
+	unsigned int meshlets;
+	unsigned int windows;
+	unsigned int batches;
+	unsigned long long spillBytes;
+	unsigned long long cacheHits;
+	unsigned long long cacheMisses;
+	size_t budgetBytes;
+	size_t peakBufferBytes;
+	size_t peakResidentBytes;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Imports OBJ files too large to hold in memory, straight
+// into a cooked (.dxmesh) file
+//
+// The file is read twice, a window at a time:
+//  1. Attributes (v, vt, vn) are parsed and appended to spill
+//     files on disk, and the content hash is taken
+//  2. Faces are read and their corners looked up through a
+//     fixed size page cache over the spill files. Each batch
+//     of triangles is deduplicated, optimized, clustered and
+//     given tangents like the in-memory path, then its vertices
+//     go straight into the cooked file and its indices and
+//     meshlets into more spill files
+// Finally the indices and meshlets are copied in after the
+// vertices and the header is filled out
+//
+// - Peak memory is set by the config, not the file size
+// - Batches don't share vertices, so corners on the seams
+//   between batches are duplicated and their tangents only see
+//   their own batch's triangles
+// - There's no LOD chain, since simplifying needs the whole
+//   mesh; the result is a single LOD with meshlets
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class ObjStreamImporter
+{
+public:
+	// Mesh streams source files at least this big
+	static const unsigned long long DefaultThresholdBytes = 256ull << 20;
+	static const size_t DefaultMemoryBudget = 256 << 20;
+
+	// Splits a memory budget between the window, the attribute
+	// cache and the batches
+	static ObjStreamConfig GetDefaultConfig(size_t memoryBudgetBytes = DefaultMemoryBudget);
+
+	// Same result as CookedMesh::HashData over the whole file
+	static bool HashFile(const char* fileName, size_t windowBytes, unsigned long long& hash, unsigned long long& size);
+
+	static bool Import(const char* fileName, const char* cookedFileName, const ObjStreamConfig& config, ObjStreamStats* stats = nullptr);
+
+	// The process's peak working set so far, or 0 if unknown
+	static size_t GetPeakResidentBytes();
+};
@@ -0,0 +1,290 @@
+// --------------------------------------------------------
+// Tests for ObjStreamImporter
+//
+// - Streams a generated OBJ (quads, negative indices) through
+//   windows and an attribute cache far smaller than the file,
+//   and checks the cooked file is byte for byte the one the
+//   in-memory path (Mesh's parse, optimize, meshlets, tangents
+//   and write) makes, when it all fits in one batch
+// - With a small default budget (many batches) it can't match
+//   exactly, as seams duplicate vertices, so that checks the
+//   same triangles come out and the buffers stay in budget
+// - Not part of the Visual Studio project. On Linux it's the
+//   objstream_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 ObjStreamImporterTests.cpp
+//       ObjStreamImporter.cpp ObjParser.cpp CookedMesh.cpp
+//       MappedFile.cpp MeshOptimizer.cpp MeshletBuilder.cpp
+//       TangentGenerator.cpp -lpthread -o objstream_tests
+// - Usage: objstream_tests
+// --------------------------------------------------------
+#include "ObjStreamImporter.h"
+#include "ObjParser.h"
+#include "CookedMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshletBuilder.h"
+#include "TangentGenerator.h"
+#include "TestChecks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// --------------------------------------------------------
+	// Rows of vertices, each followed by the quads joining it to
+	// the row before, with negative indices on odd rows
+	// --------------------------------------------------------
+	std::string MakeObj(unsigned int width, unsigned int rows)
+	{
+		std::string text = "# generated by ObjStreamImporterTests\n";
+		char line[100];
+		long long count = 0;
+		for (unsigned int y = 0; y < rows; y++)
+		{
+			for (unsigned int x = 0; x <= width; x++)
+			{
+				float u = (float)x / width;
+				float v = (float)y / rows;
+				snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f 1\n",
+					u * 10.0f, v * 10.0f, sinf(u * 6.0f) * cosf(v * 6.0f), u, v, u - 0.5f, v - 0.5f);
+				text += line;
+			}
+			count += width + 1;
+			if (y == 0)
+				continue;
+
+			for (unsigned int x = 0; x < width; x++)
+			{
+				long long corners[4];
+				corners[0] = (long long)(y - 1) * (width + 1) + x + 1;
+				corners[1] = corners[0] + 1;
+				corners[2] = corners[1] + width + 1;
+				corners[3] = corners[0] + width + 1;
+				if (y % 2 == 1)
+				{
+					for (long long& corner : corners)
+						corner -= count + 1;
+				}
+				snprintf(line, sizeof(line), "f %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld %lld/%lld/%lld\n",
+					corners[0], corners[0], corners[0], corners[1], corners[1], corners[1],
+					corners[2], corners[2], corners[2], corners[3], corners[3], corners[3]);
+				text += line;
+			}
+		}
+		return text;
+	}
+
+	std::string ReadFile(const std::filesystem::path& fileName)
+	{
+		std::ifstream file(fileName, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	// --------------------------------------------------------
+	// Cooks a file the way Mesh does when it fits in memory
+	//
+	// - Minus the LOD chain, which the streamed path doesn't
+	//   build (GenerateLODs only appends indices after LOD 0,
+	//   so leaving it out changes nothing else)
+	// - Tangents on the given thread count, as threads can
+	//   change their last bits
+	// --------------------------------------------------------
+	bool CookInMemory(const char* fileName, const char* cookedFileName, unsigned int threadCount)
+	{
+		MappedFile source;
+		if (!source.Open(fileName))
+			return false;
+
+		ObjMeshData objData;
+		if (!ObjParser::Parse(source.GetData(), source.GetSize(), objData))
+			return false;
+
+		unsigned int indexCount = (unsigned int)objData.indices.size();
+		unsigned int vertexCount = MeshOptimizer::OptimizeMesh(
+			objData.vertices.data(), (unsigned int)objData.vertices.size(), sizeof(ObjVertex),
+			objData.indices.data(), indexCount);
+
+		std::vector<Meshlet> meshlets;
+		MeshletBuilder::BuildMeshlets(objData.indices.data(), indexCount, objData.vertices.data(), vertexCount, sizeof(ObjVertex), meshlets);
+		TangentGenerator::GenerateTangents(objData.vertices.data(), vertexCount, objData.indices.data(), indexCount, threadCount);
+
+		float boundsMin[3] = { 0, 0, 0 };
+		float boundsMax[3] = { 0, 0, 0 };
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			const float* pos = &objData.vertices[v].Position.x;
+			for (int a = 0; a < 3; a++)
+			{
+				boundsMin[a] = v == 0 || pos[a] < boundsMin[a] ? pos[a] : boundsMin[a];
+				boundsMax[a] = v == 0 || pos[a] > boundsMax[a] ? pos[a] : boundsMax[a];
+			}
+		}
+
+		MeshLOD lod = { 0, indexCount, 0.0f };
+		return CookedMesh::Write(
+			cookedFileName,
+			CookedMesh::HashData(source.GetData(), source.GetSize()), source.GetSize(),
+			objData.vertices.data(), vertexCount, sizeof(ObjVertex),
+			objData.indices.data(), indexCount,
+			&lod, 1,
+			meshlets.data(), (unsigned int)meshlets.size(),
+			boundsMin, boundsMax);
+	}
+
+	// --------------------------------------------------------
+	// A cooked file's triangles as position, UV and normal per
+	// corner (no tangents, which depend on the batch), each
+	// rotated to start at its smallest corner, then sorted
+	// --------------------------------------------------------
+	struct TriangleKey
+	{
+		float corners[3][8];
+
+		bool operator<(const TriangleKey& other) const
+		{
+			return memcmp(corners, other.corners, sizeof(corners)) < 0;
+		}
+
+		bool operator==(const TriangleKey& other) const
+		{
+			return memcmp(corners, other.corners, sizeof(corners)) == 0;
+		}
+	};
+
+	std::vector<TriangleKey> GetTriangles(const CookedMesh& cooked)
+	{
+		const ObjVertex* vertices = static_cast<const ObjVertex*>(cooked.GetVertexData());
+		const unsigned int* indices = cooked.GetIndices();
+		std::vector<TriangleKey> triangles(cooked.GetIndexCount() / 3);
+		for (unsigned int t = 0; t < triangles.size(); t++)
+		{
+			float corners[3][8];
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				const ObjVertex& vertex = vertices[indices[t * 3 + k]];
+				memcpy(&corners[k][0], &vertex.Position, sizeof(ObjFloat3));
+				memcpy(&corners[k][3], &vertex.Normal, sizeof(ObjFloat3));
+				memcpy(&corners[k][6], &vertex.UV, sizeof(ObjFloat2));
+			}
+
+			unsigned int first = 0;
+			for (unsigned int k = 1; k < 3; k++)
+				first = memcmp(corners[k], corners[first], sizeof(corners[k])) < 0 ? k : first;
+			for (unsigned int k = 0; k < 3; k++)
+				memcpy(triangles[t].corners[k], corners[(first + k) % 3], sizeof(corners[k]));
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// No spill tables are left behind next to the cooked file
+	bool NoSpillFiles(const std::filesystem::path& directory)
+	{
+		for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(directory))
+		{
+			if (entry.path().extension() == ".tmp")
+				return false;
+		}
+		return true;
+	}
+
+	// --------------------------------------------------------
+	// One batch, but windows and an attribute cache of a few
+	// spill pages, so the file is read in many pieces and the
+	// attribute tables don't fit in the cache
+	// --------------------------------------------------------
+	void TestMatchesInMemory(const std::filesystem::path& directory, const std::filesystem::path& objFile, unsigned int triangleCount)
+	{
+		std::filesystem::path streamed = directory / "streamed.dxmesh";
+		std::filesystem::path inMemory = directory / "in_memory.dxmesh";
+
+		ObjStreamConfig config = {};
+		config.windowBytes = 64 * 1024;
+		config.attributeCacheBytes = 256 * 1024;
+		config.batchTriangles = triangleCount;
+		config.threadCount = 1;
+
+		ObjStreamStats stats = {};
+		CHECK(ObjStreamImporter::Import(objFile.string().c_str(), streamed.string().c_str(), config, &stats));
+		CHECK(CookInMemory(objFile.string().c_str(), inMemory.string().c_str(), 1));
+		CHECK(stats.batches == 1 && stats.triangles == triangleCount);
+		CHECK(stats.windows > 10);
+		CHECK(stats.cacheMisses > 0);
+		CHECK(stats.positions * sizeof(ObjFloat3) + stats.uvs * sizeof(ObjFloat2) + stats.normals * sizeof(ObjFloat3) > config.attributeCacheBytes);
+		CHECK(NoSpillFiles(directory));
+
+		std::string streamedBytes = ReadFile(streamed);
+		std::string inMemoryBytes = ReadFile(inMemory);
+		CHECK(!streamedBytes.empty());
+		CHECK(streamedBytes == inMemoryBytes);
+		printf("  one batch: %u windows, %llu cache misses, %zu byte cooked files %s\n",
+			stats.windows, stats.cacheMisses, streamedBytes.size(), streamedBytes == inMemoryBytes ? "match" : "differ");
+
+		// And it opens against the streamed hash of the source
+		unsigned long long hash = 0;
+		unsigned long long size = 0;
+		CHECK(ObjStreamImporter::HashFile(objFile.string().c_str(), config.windowBytes, hash, size));
+		CookedMesh cooked;
+		CHECK(cooked.Open(streamed.string().c_str(), hash, size, sizeof(ObjVertex)));
+	}
+
+	// --------------------------------------------------------
+	// A 2 MB budget, which splits the file into many batches
+	// --------------------------------------------------------
+	void TestSmallBudget(const std::filesystem::path& directory, const std::filesystem::path& objFile)
+	{
+		std::filesystem::path streamed = directory / "small_budget.dxmesh";
+		std::filesystem::path inMemory = directory / "in_memory.dxmesh";
+
+		ObjStreamConfig config = ObjStreamImporter::GetDefaultConfig(2 << 20);
+		ObjStreamStats stats = {};
+		CHECK(ObjStreamImporter::Import(objFile.string().c_str(), streamed.string().c_str(), config, &stats));
+		CHECK(stats.batches > 1);
+		CHECK(stats.peakBufferBytes <= stats.budgetBytes);
+		CHECK(NoSpillFiles(directory));
+
+		unsigned long long hash = 0;
+		unsigned long long size = 0;
+		CHECK(ObjStreamImporter::HashFile(objFile.string().c_str(), config.windowBytes, hash, size));
+		CookedMesh streamedMesh;
+		CookedMesh inMemoryMesh;
+		CHECK(streamedMesh.Open(streamed.string().c_str(), hash, size, sizeof(ObjVertex)));
+		CHECK(inMemoryMesh.Open(inMemory.string().c_str(), hash, size, sizeof(ObjVertex)));
+		CHECK(streamedMesh.GetIndexCount() == inMemoryMesh.GetIndexCount());
+		CHECK(GetTriangles(streamedMesh) == GetTriangles(inMemoryMesh));
+
+		const CookedMeshHeader* a = streamedMesh.GetHeader();
+		const CookedMeshHeader* b = inMemoryMesh.GetHeader();
+		CHECK(memcmp(a->boundsMin, b->boundsMin, sizeof(a->boundsMin)) == 0 && memcmp(a->boundsMax, b->boundsMax, sizeof(a->boundsMax)) == 0);
+		printf("  %zu KB budget: %u batches, %u vertices (%u in memory), %zu KB peak buffers\n",
+			stats.budgetBytes / 1024, stats.batches, stats.vertices, inMemoryMesh.GetVertexCount(), stats.peakBufferBytes / 1024);
+	}
+}
+
+int main()
+{
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "objstream_tests";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+
+	const unsigned int width = 150;
+	const unsigned int rows = 150;
+	std::filesystem::path objFile = directory / "grid.obj";
+	{
+		std::string text = MakeObj(width, rows);
+		std::ofstream file(objFile, std::ios::binary);
+		file.write(text.data(), (std::streamsize)text.size());
+	}
+	printf("  %.1f MB source\n", std::filesystem::file_size(objFile) / (1024.0 * 1024.0));
+
+	TestMatchesInMemory(directory, objFile, width * (rows - 1) * 2);
+	TestSmallBudget(directory, objFile);
+
+	std::filesystem::remove_all(directory);
+	return TestChecks::Finish("ObjStreamImporter");
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+// Win32 virtual key codes, which Input uses everywhere. Other platforms
+// translate their keys to these, so key bindings and scripts are portable
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#define VK_LBUTTON	0x01
+#define VK_RBUTTON	0x02
+#define VK_MBUTTON	0x04
+#define VK_TAB		0x09
+#define VK_SHIFT	0x10
+#define VK_CONTROL	0x11
+#define VK_MENU		0x12
+#define VK_ESCAPE	0x1B
+#define VK_SPACE	0x20
+#endif
+
+// --------------------------------------------------------
+// One frame's input, as a platform reports it
+//
+// - keys is indexed by virtual key code, with 0x80 set for
+//   keys (and mouse buttons) that are down, like Win32's
+//   GetKeyboardState()
+// - The mouse position is relative to the window's client
+//   area, and the raw deltas are unaccelerated movement
+// --------------------------------------------------------
+struct PlatformInputState
+{
+	unsigned char keys[256];
+	int mouseX;
+	int mouseY;
+	int rawMouseXDelta;
+	int rawMouseYDelta;
+	float wheelDelta;
+};
+
+// --------------------------------------------------------
+// What a frame loop needs from the OS: messages, a clock,
+// a way to wait, and the start and end of each frame
+//
+// - DXCore is the Win32 one. HeadlessPlatform has no window
+//   or device, for benchmarking on machines without either
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class Platform
+{
+public:
+	virtual ~Platform() {}
+
+	// Handles anything the OS sent. Returns false once it's time to quit
+	virtual bool PumpMessages() = 0;
+
+	// Seconds since some fixed point, which never go backwards
+	virtual double GetSeconds() = 0;
+
+	// Waits until GetSeconds() reaches seconds, and returns how much of
+	// that was spent asleep (the rest being spent spinning)
+	virtual double WaitUntil(double seconds) = 0;
+
+	// Around each frame's callbacks, for input and anything per frame
+	virtual void BeginFrame(float deltaTime, float totalTime) = 0;
+	virtual void EndFrame() = 0;
+};
+
+// --------------------------------------------------------
+// What a frame loop calls each frame (see FrameLoop)
+// --------------------------------------------------------
+class FrameCallbacks
+{
+public:
+	virtual ~FrameCallbacks() {}
+
+	// One simulation tick. In fixed timestep mode this runs zero or more
+	// times per frame, before Update(), with deltaTime always the step.
+	// Otherwise it runs once per frame, with the frame's times.
+	// Does nothing by default, for games that simulate in Update()
+	virtual void FixedUpdate(float /*deltaTime*/, float /*totalTime*/) {}
+
+	virtual void Update(float deltaTime, float totalTime) = 0;
+	virtual void Draw(float deltaTime, float totalTime) = 0;
+};
@@ -0,0 +1,330 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Singleton requirement
+Profiler* Profiler::instance;
+std::atomic<bool> Profiler::enabled(false);
+
+// --------------------------------------------------------
+// One thread's ring buffer of finished zones
+//
+// - Only its own thread writes entries or depth. written is
+//   published after each entry, so readers on other threads
+//   know which entries are complete
+// --------------------------------------------------------
+class ProfilerThread
+{
+public:
+	struct Entry
+	{
+		const char* name;
+		unsigned long long start;
+		unsigned long long end;
+		unsigned int depth;
+	};
+
+	// 16K zones, or 512 KB, per thread
+	static const unsigned long long Capacity = 1 << 14;
+
+	unsigned int index;
+	std::string name;
+	unsigned int depth;
+	std::unique_ptr<Entry[]> entries;
+	std::atomic<unsigned long long> written;
+};
+
+namespace
+{
+	// This thread's buffer, once it has recorded a zone, and its name
+	thread_local ProfilerThread* currentThread = nullptr;
+	thread_local std::string currentThreadName;
+
+	double GetSteadySeconds()
+	{
+		return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Writes a string as a JSON string, escaping what has to be
+	void WriteJsonString(std::ofstream& out, const std::string& text)
+	{
+		out << '"';
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				out << '\\' << c;
+			else if ((unsigned char)c < 0x20)
+				out << ' ';
+			else
+				out << c;
+		}
+		out << '"';
+	}
+}
+
+Profiler::Profiler()
+	: startTicks(GetTicks()),
+	startSeconds(GetSteadySeconds()),
+	frameStartTicks(0),
+	previousFrameStartTicks(0)
+{
+}
+
+Profiler::~Profiler()
+{
+	enabled = false;
+}
+
+void Profiler::SetEnabled(bool enabled)
+{
+	Profiler::enabled = enabled;
+}
+
+bool Profiler::IsEnabled() const
+{
+	return enabled.load(std::memory_order_relaxed);
+}
+
+// --------------------------------------------------------
+// Marks the start of a frame
+//
+// - Frames are only counted while enabled, so the first full
+//   frame after enabling is the first one with every zone
+// --------------------------------------------------------
+void Profiler::BeginFrame()
+{
+	if (!IsEnabled())
+	{
+		frameStartTicks = 0;
+		previousFrameStartTicks = 0;
+		return;
+	}
+
+	previousFrameStartTicks = frameStartTicks;
+	frameStartTicks = GetTicks();
+}
+
+void Profiler::SetThreadName(const std::string& name)
+{
+	currentThreadName = name;
+
+	// A registered thread means the profiler exists
+	if (currentThread)
+	{
+		std::lock_guard<std::mutex> lock(instance->threadsMutex);
+		currentThread->name = name;
+	}
+}
+
+std::string Profiler::GetThreadName(unsigned int thread)
+{
+	std::lock_guard<std::mutex> lock(threadsMutex);
+	return thread < threads.size() ? threads[thread]->name : std::string();
+}
+
+bool Profiler::GetLastFrame(std::vector<ProfilerZone>& zones, double& frameStart, double& frameSeconds)
+{
+	zones.clear();
+	if (previousFrameStartTicks == 0)
+		return false;
+
+	double secondsPerTick = GetSecondsPerTick();
+	frameStart = (previousFrameStartTicks - startTicks) * secondsPerTick;
+	frameSeconds = (frameStartTicks - previousFrameStartTicks) * secondsPerTick;
+	CollectZones(zones, previousFrameStartTicks, frameStartTicks);
+	return true;
+}
+
+// --------------------------------------------------------
+// Writes every buffered zone as Chrome trace event JSON
+//
+// - Zones are complete ("X") events, with timestamps and
+//   durations in microseconds, and each thread is named
+//   with a metadata ("M") event
+// --------------------------------------------------------
+bool Profiler::ExportChromeTrace(const char* fileName)
+{
+	std::vector<ProfilerZone> zones;
+	CollectZones(zones, 0, ~0ull);
+
+	std::ofstream out(fileName, std::ios::trunc);
+	if (!out)
+		return false;
+
+	out.setf(std::ios::fixed);
+	out.precision(3);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool first = true;
+	unsigned int threadCount = GetStats().threads;
+	for (unsigned int t = 0; t < threadCount; t++)
+	{
+		out << (first ? "\n" : ",\n") << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":";
+		WriteJsonString(out, GetThreadName(t));
+		out << "}}";
+		first = false;
+	}
+
+	for (const ProfilerZone& zone : zones)
+	{
+		out << (first ? "\n" : ",\n") << "{\"ph\":\"X\",\"name\":";
+		WriteJsonString(out, zone.name);
+		out << ",\"pid\":0,\"tid\":" << zone.thread <<
+			",\"ts\":" << zone.start * 1000000.0 <<
+			",\"dur\":" << zone.duration * 1000000.0 << "}";
+		first = false;
+	}
+
+	out << "\n]}\n";
+	return (bool)out;
+}
+
+ProfilerStats Profiler::GetStats()
+{
+	std::lock_guard<std::mutex> lock(threadsMutex);
+
+	ProfilerStats stats = {};
+	stats.threads = (unsigned int)threads.size();
+	for (const std::unique_ptr<ProfilerThread>& thread : threads)
+	{
+		unsigned long long written = thread->written.load(std::memory_order_acquire);
+		stats.zones += written;
+		stats.overwritten += written > ProfilerThread::Capacity ? written - ProfilerThread::Capacity : 0;
+	}
+	return stats;
+}
+
+unsigned long long Profiler::GetTicks()
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return (unsigned long long)std::chrono::steady_clock::now().time_since_epoch().count();
+#endif
+}
+
+// --------------------------------------------------------
+// Gets this thread's buffer, registering one the first time
+// --------------------------------------------------------
+ProfilerThread* Profiler::GetCurrentThread()
+{
+	if (currentThread)
+		return currentThread;
+
+	Profiler& profiler = GetInstance();
+	std::lock_guard<std::mutex> lock(profiler.threadsMutex);
+
+	std::unique_ptr<ProfilerThread> thread = std::make_unique<ProfilerThread>();
+	thread->index = (unsigned int)profiler.threads.size();
+	thread->name = currentThreadName.empty() ? "Thread " + std::to_string(thread->index) : currentThreadName;
+	thread->depth = 0;
+	thread->entries = std::make_unique<ProfilerThread::Entry[]>(ProfilerThread::Capacity);
+	thread->written = 0;
+
+	currentThread = thread.get();
+	profiler.threads.push_back(std::move(thread));
+	return currentThread;
+}
+
+void Profiler::EndZone(ProfilerThread* thread, const char* name, unsigned long long startTicks)
+{
+	unsigned long long endTicks = GetTicks();
+	thread->depth--;
+
+	unsigned long long written = thread->written.load(std::memory_order_relaxed);
+	ProfilerThread::Entry& entry = thread->entries[written & (ProfilerThread::Capacity - 1)];
+	entry.name = name;
+	entry.start = startTicks;
+	entry.end = endTicks;
+	entry.depth = thread->depth;
+	thread->written.store(written + 1, std::memory_order_release);
+}
+
+// --------------------------------------------------------
+// Seconds per tick of GetTicks()
+//
+// - The time stamp counter's rate is measured against the
+//   steady clock over the profiler's whole life, so it gets
+//   more precise the longer it runs
+// --------------------------------------------------------
+double Profiler::GetSecondsPerTick() const
+{
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+	unsigned long long ticks = GetTicks() - startTicks;
+	double seconds = GetSteadySeconds() - startSeconds;
+	return ticks > 0 ? seconds / ticks : 0.0;
+#else
+	return (double)std::chrono::steady_clock::period::num / std::chrono::steady_clock::period::den;
+#endif
+}
+
+// --------------------------------------------------------
+// Copies every buffered zone that started in [firstTicks,
+// endTicks) out of every thread's ring buffer
+//
+// - Entries are copied, then any the writer could have
+//   lapped in the meantime are thrown away
+// --------------------------------------------------------
+void Profiler::CollectZones(std::vector<ProfilerZone>& zones, unsigned long long firstTicks, unsigned long long endTicks)
+{
+	std::vector<ProfilerThread*> threadList;
+	{
+		std::lock_guard<std::mutex> lock(threadsMutex);
+		for (const std::unique_ptr<ProfilerThread>& thread : threads)
+			threadList.push_back(thread.get());
+	}
+
+	double secondsPerTick = GetSecondsPerTick();
+	std::vector<ProfilerThread::Entry> entries;
+	for (ProfilerThread* thread : threadList)
+	{
+		unsigned long long written = thread->written.load(std::memory_order_acquire);
+		unsigned long long first = written > ProfilerThread::Capacity ? written - ProfilerThread::Capacity : 0;
+
+		entries.clear();
+		for (unsigned long long e = first; e < written; e++)
+			entries.push_back(thread->entries[e & (ProfilerThread::Capacity - 1)]);
+
+		// Anything before the writer's oldest live entry may have been overwritten
+		unsigned long long writtenAfter = thread->written.load(std::memory_order_acquire);
+		unsigned long long oldestLive = writtenAfter > ProfilerThread::Capacity ? writtenAfter - ProfilerThread::Capacity : 0;
+		unsigned long long skip = oldestLive > first ? oldestLive - first : 0;
+
+		size_t firstZone = zones.size();
+		for (size_t e = (size_t)skip; e < entries.size(); e++)
+		{
+			const ProfilerThread::Entry& entry = entries[e];
+			if (entry.start < firstTicks || entry.start >= endTicks)
+				continue;
+
+			ProfilerZone zone = {};
+			zone.name = entry.name;
+			zone.thread = thread->index;
+			zone.depth = entry.depth;
+			zone.start = (entry.start - startTicks) * secondsPerTick;
+			zone.duration = (entry.end - entry.start) * secondsPerTick;
+			zones.push_back(zone);
+		}
+
+		// Zones finish inner first, so put them back in start order
+		std::sort(zones.begin() + firstZone, zones.end(), [](const ProfilerZone& a, const ProfilerZone& b)
+			{
+				return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+			});
+	}
+}
+
+void ProfileZone::Begin()
+{
+	thread = Profiler::GetCurrentThread();
+	thread->depth++;
+	startTicks = Profiler::GetTicks();
+}
@@ -10,6 +10,27 @@ struct VertexShaderInput
     float4 shadowMapPos : SHADOW_POSITION; // Shadow map position
 };
 
+// Input for the compact vertex formats (see VertexCompression.h)
+struct CompactVertexShaderInput
+{
+    float4 position : POSITION; // float3, or unorm16 within the mesh bounds
+    float2 normal : NORMAL; // Octahedral, snorm16
+    int2 tangent : TANGENT; // Octahedral snorm16 bits, with the bitangent sign in the lowest bit of y
+    float2 uv : TEXCOORD; // unorm16 within the mesh's UV bounds
+};
+
+// Input for skinned meshes: the standard vertex, plus its joints
+// and weights from a second stream (see Skinning.h)
+struct SkinnedVertexShaderInput
+{
+    float3 localPosition : POSITION;
+    float3 normal : NORMAL;
+    float3 tangent : TANGENT;
+    float2 uv : TEXCOORD;
+    uint4 joints : BLENDINDICES;
+    float4 weights : BLENDWEIGHT; // unorm8, adding up to 1
+};
+
 struct VertexToPixel
 {
     float4 screenPosition : SV_POSITION; // XYZW position (System Value Position)
@@ -1,14 +1,39 @@
 #include "ShaderStructs.hlsli"
+#ifdef COMPACT_VERTEX
+#include "VertexCompression.hlsli"
+#endif
+#ifdef SKINNED_VERTEX
+#include "Skinning.hlsli"
+#endif
 
 cbuffer externalData : register(b0)
 {
-	matrix world;
+	row_major float3x4 world;
 	matrix view;
 	matrix projection;
+	
+#ifdef COMPACT_VERTEX
+	// Dequantization for the compact vertex formats
+    float3 positionScale;
+    float3 positionOffset;
+    float2 uvScale;
+    float2 uvOffset;
+#endif
 };
 
+#ifdef COMPACT_VERTEX
+float4 main(CompactVertexShaderInput compactInput) : SV_POSITION
+{
+    VertexShaderInput input = DecodeCompactVertex(compactInput, positionScale, positionOffset, uvScale, uvOffset);
+#elif defined(SKINNED_VERTEX)
+float4 main(SkinnedVertexShaderInput skinnedInput) : SV_POSITION
+{
+    VertexShaderInput input = SkinVertex(skinnedInput);
+#else
 float4 main(VertexShaderInput input) : SV_POSITION
 {
-	matrix wvp = mul(projection, mul(view, world));
-	return mul(wvp, float4(input.localPosition, 1.0f));
+#endif
+
+	float4 worldPosition = float4(mul(world, float4(input.localPosition, 1.0f)), 1.0f);
+	return mul(projection, mul(view, worldPosition));
 }
\ No newline at end of file
@@ -0,0 +1,259 @@
+#include "Skeleton.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Blends two quaternions along the shorter arc and renormalizes
+	void NlerpRotation(const float a[4], const float b[4], float t, float out[4])
+	{
+		float dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+		float sign = dot < 0.0f ? -1.0f : 1.0f;
+
+		float lengthSquared = 0.0f;
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			out[c] = a[c] + (b[c] * sign - a[c]) * t;
+			lengthSquared += out[c] * out[c];
+		}
+
+		float scale = lengthSquared > 0.0f ? 1.0f / sqrtf(lengthSquared) : 0.0f;
+		for (unsigned int c = 0; c < 4; c++)
+			out[c] *= scale;
+	}
+
+	JointPose BlendPoses(const JointPose& a, const JointPose& b, float t)
+	{
+		JointPose pose;
+		for (unsigned int c = 0; c < 3; c++)
+		{
+			pose.translation[c] = a.translation[c] + (b.translation[c] - a.translation[c]) * t;
+			pose.scale[c] = a.scale[c] + (b.scale[c] - a.scale[c]) * t;
+		}
+		NlerpRotation(a.rotation, b.rotation, t, pose.rotation);
+		return pose;
+	}
+}
+
+int Skeleton::AddJoint(const std::string& name, int parent, const JointPose& bindPose)
+{
+	if (joints.size() >= MaxJoints || parent >= (int)joints.size())
+		return -1;
+
+	SkeletonJoint joint;
+	joint.name = name;
+	joint.parent = parent < 0 ? -1 : parent;
+	joint.bindPose = bindPose;
+
+	// The parent's inverse bind is already known, so invert its model matrix back
+	SkinMatrix model = MatrixFromPose(bindPose);
+	if (joint.parent >= 0)
+		model = Multiply(Inverse(joints[joint.parent].inverseBind), model);
+	joint.inverseBind = Inverse(model);
+
+	joints.push_back(joint);
+	return (int)joints.size() - 1;
+}
+
+unsigned int Skeleton::GetJointCount() const
+{
+	return (unsigned int)this->joints.size();
+}
+
+const SkeletonJoint& Skeleton::GetJoint(unsigned int joint) const
+{
+	return this->joints[joint];
+}
+
+int Skeleton::FindJoint(const std::string& name) const
+{
+	for (size_t j = 0; j < joints.size(); j++)
+	{
+		if (joints[j].name == name)
+			return (int)j;
+	}
+	return -1;
+}
+
+void Skeleton::GetBindPose(JointPose* pose) const
+{
+	for (size_t j = 0; j < joints.size(); j++)
+		pose[j] = joints[j].bindPose;
+}
+
+void Skeleton::ComputeModelMatrices(const JointPose* pose, SkinMatrix* model) const
+{
+	for (size_t j = 0; j < joints.size(); j++)
+	{
+		SkinMatrix local = MatrixFromPose(pose[j]);
+		model[j] = joints[j].parent >= 0 ? Multiply(model[joints[j].parent], local) : local;
+	}
+}
+
+void Skeleton::ComputeSkinningPalette(const JointPose* pose, SkinMatrix* palette) const
+{
+	ComputeModelMatrices(pose, palette);
+	for (size_t j = 0; j < joints.size(); j++)
+		palette[j] = Multiply(palette[j], joints[j].inverseBind);
+}
+
+// --------------------------------------------------------
+// Builds translation * rotation * scale
+// --------------------------------------------------------
+SkinMatrix Skeleton::MatrixFromPose(const JointPose& pose)
+{
+	float x = pose.rotation[0];
+	float y = pose.rotation[1];
+	float z = pose.rotation[2];
+	float w = pose.rotation[3];
+
+	float rotation[3][3] =
+	{
+		{ 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y - z * w), 2.0f * (x * z + y * w) },
+		{ 2.0f * (x * y + z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z - x * w) },
+		{ 2.0f * (x * z - y * w), 2.0f * (y * z + x * w), 1.0f - 2.0f * (x * x + y * y) }
+	};
+
+	SkinMatrix m;
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+			m.rows[r][c] = rotation[r][c] * pose.scale[c];
+		m.rows[r][3] = pose.translation[r];
+	}
+	return m;
+}
+
+// --------------------------------------------------------
+// Returns a * b, which applies b first
+// --------------------------------------------------------
+SkinMatrix Skeleton::Multiply(const SkinMatrix& a, const SkinMatrix& b)
+{
+	SkinMatrix m;
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			m.rows[r][c] =
+				a.rows[r][0] * b.rows[0][c] +
+				a.rows[r][1] * b.rows[1][c] +
+				a.rows[r][2] * b.rows[2][c];
+		}
+		m.rows[r][3] += a.rows[r][3];
+	}
+	return m;
+}
+
+// --------------------------------------------------------
+// Inverts an affine matrix
+//
+// - The 3x3 part is inverted with cofactors, so scale doesn't
+//   need to be uniform. Singular matrices give the identity
+// --------------------------------------------------------
+SkinMatrix Skeleton::Inverse(const SkinMatrix& m)
+{
+	const float (*a)[4] = m.rows;
+	float cofactors[3][3] =
+	{
+		{ a[1][1] * a[2][2] - a[1][2] * a[2][1], a[1][2] * a[2][0] - a[1][0] * a[2][2], a[1][0] * a[2][1] - a[1][1] * a[2][0] },
+		{ a[0][2] * a[2][1] - a[0][1] * a[2][2], a[0][0] * a[2][2] - a[0][2] * a[2][0], a[0][1] * a[2][0] - a[0][0] * a[2][1] },
+		{ a[0][1] * a[1][2] - a[0][2] * a[1][1], a[0][2] * a[1][0] - a[0][0] * a[1][2], a[0][0] * a[1][1] - a[0][1] * a[1][0] }
+	};
+
+	float determinant = a[0][0] * cofactors[0][0] + a[0][1] * cofactors[0][1] + a[0][2] * cofactors[0][2];
+	if (determinant == 0.0f)
+		return Identity();
+
+	// The inverse is the transposed cofactors over the determinant
+	SkinMatrix inverse;
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		for (unsigned int c = 0; c < 3; c++)
+			inverse.rows[r][c] = cofactors[c][r] / determinant;
+	}
+
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		inverse.rows[r][3] = -(
+			inverse.rows[r][0] * a[0][3] +
+			inverse.rows[r][1] * a[1][3] +
+			inverse.rows[r][2] * a[2][3]);
+	}
+	return inverse;
+}
+
+SkinMatrix Skeleton::Identity()
+{
+	SkinMatrix m = {};
+	m.rows[0][0] = 1.0f;
+	m.rows[1][1] = 1.0f;
+	m.rows[2][2] = 1.0f;
+	return m;
+}
+
+AnimationClip::AnimationClip(float duration)
+	: duration(duration > 0.0f ? duration : 1.0f)
+{
+}
+
+void AnimationClip::AddKey(unsigned int joint, float time, const JointPose& pose)
+{
+	if (joint >= channels.size())
+		channels.resize(joint + 1);
+
+	// Keep the keys sorted, so sampling can binary search them
+	std::vector<AnimationKey>& keys = channels[joint];
+	std::vector<AnimationKey>::iterator position = std::upper_bound(
+		keys.begin(), keys.end(), time,
+		[](float t, const AnimationKey& key) { return t < key.time; });
+	keys.insert(position, { time, pose });
+}
+
+// --------------------------------------------------------
+// Samples every joint at a time within the (looping) clip
+//
+// - Before the first key and after the last, the nearest key
+//   is held rather than blending across the loop
+// --------------------------------------------------------
+void AnimationClip::Sample(const Skeleton& skeleton, float time, JointPose* pose) const
+{
+	time = fmodf(time, duration);
+	if (time < 0.0f)
+		time += duration;
+
+	for (unsigned int j = 0; j < skeleton.GetJointCount(); j++)
+	{
+		if (j >= channels.size() || channels[j].empty())
+		{
+			pose[j] = skeleton.GetJoint(j).bindPose;
+			continue;
+		}
+
+		const std::vector<AnimationKey>& keys = channels[j];
+		std::vector<AnimationKey>::const_iterator next = std::upper_bound(
+			keys.begin(), keys.end(), time,
+			[](float t, const AnimationKey& key) { return t < key.time; });
+
+		if (next == keys.begin())
+		{
+			pose[j] = keys.front().pose;
+		}
+		else if (next == keys.end())
+		{
+			pose[j] = keys.back().pose;
+		}
+		else
+		{
+			const AnimationKey& previous = *(next - 1);
+			float span = next->time - previous.time;
+			float t = span > 0.0f ? (time - previous.time) / span : 0.0f;
+			pose[j] = BlendPoses(previous.pose, next->pose, t);
+		}
+	}
+}
+
+float AnimationClip::GetDuration() const
+{
+	return this->duration;
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <string>
+#include <vector>
+
+// --------------------------------------------------------
+// One joint's transform relative to its parent
+//
+// - Applied as scale, then rotation, then translation
+// - rotation is a unit quaternion (x, y, z, w)
+// --------------------------------------------------------
+struct JointPose
+{
+	float translation[3];
+	float rotation[4];
+	float scale[3];
+};
+
+// --------------------------------------------------------
+// An affine transform stored as the top 3 rows of a 4x4
+// matrix that multiplies column vectors
+//
+// - p' = rows * (p, 1), so rows[r][3] is the translation
+// - This is the layout of an HLSL row_major float3x4, so a
+//   palette uploads to a shader as-is
+// --------------------------------------------------------
+struct SkinMatrix
+{
+	float rows[3][4];
+};
+
+struct SkeletonJoint
+{
+	std::string name;
+	int parent;
+	JointPose bindPose;
+	SkinMatrix inverseBind;
+};
+
+// --------------------------------------------------------
+// A hierarchy of joints that a mesh can be skinned to
+//
+// - Joints are stored parents first, so model space matrices
+//   are built in one pass from the front
+// - Each joint's inverse bind matrix takes mesh vertices from
+//   model space into that joint's space in the bind pose.
+//   The skinning palette is model space * inverse bind, which
+//   is the identity in the bind pose
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class Skeleton
+{
+public:
+	// Joint indices are stored as bytes, and a palette this size
+	// fits comfortably in one constant buffer (64 * 48 bytes)
+	static const unsigned int MaxJoints = 64;
+
+	// Adds a joint, whose parent must already be added (-1 for a root).
+	// Returns its index, or -1 if the skeleton is full
+	int AddJoint(const std::string& name, int parent, const JointPose& bindPose);
+
+	unsigned int GetJointCount() const;
+	const SkeletonJoint& GetJoint(unsigned int joint) const;
+	int FindJoint(const std::string& name) const;
+
+	// Fills pose with every joint's bind pose
+	void GetBindPose(JointPose* pose) const;
+
+	// Local poses (one per joint) -> model space matrices
+	void ComputeModelMatrices(const JointPose* pose, SkinMatrix* model) const;
+
+	// Local poses -> the matrices that skin bind pose vertices
+	void ComputeSkinningPalette(const JointPose* pose, SkinMatrix* palette) const;
+
+	// Matrix helpers shared with the skinning code
+	static SkinMatrix MatrixFromPose(const JointPose& pose);
+	static SkinMatrix Multiply(const SkinMatrix& a, const SkinMatrix& b);
+	static SkinMatrix Inverse(const SkinMatrix& m);
+	static SkinMatrix Identity();
+
+private:
+	std::vector<SkeletonJoint> joints;
+};
+
+struct AnimationKey
+{
+	float time;
+	JointPose pose;
+};
+
+// --------------------------------------------------------
+// Keyframed local poses for the joints of a skeleton
+//
+// - Each joint has its own keys, sorted by time. Joints
+//   without any keep their bind pose
+// - Sampling lerps translation and scale and nlerps rotation
+//   (along the shorter arc) between the keys either side
+// - Time wraps around the clip's duration, so it loops
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class AnimationClip
+{
+public:
+	AnimationClip(float duration = 1.0f);
+
+	// Keys for a joint can be added in any order
+	void AddKey(unsigned int joint, float time, const JointPose& pose);
+
+	// Fills one pose per joint of the skeleton
+	void Sample(const Skeleton& skeleton, float time, JointPose* pose) const;
+
+	float GetDuration() const;
+
+private:
+	float duration;
+	std::vector<std::vector<AnimationKey>> channels;
+};
@@ -0,0 +1,3 @@
+// ShadowVertexShader.hlsl built for GPU skinned meshes (see Skinning.h)
+#define SKINNED_VERTEX
+#include "ShadowVertexShader.hlsl"
\ No newline at end of file
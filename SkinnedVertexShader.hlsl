@@ -0,0 +1,3 @@
+// VertexShader.hlsl built for GPU skinned meshes (see Skinning.h)
+#define SKINNED_VERTEX
+#include "VertexShader.hlsl"
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "Skinning.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Smaller pieces of work aren't worth the cost of a thread
+	const unsigned int minVerticesPerTask = 1 << 13;
+
+	// Joint indices are bytes, so a palette this big covers any index
+	const unsigned int paletteSlots = 256;
+
+	// --------------------------------------------------------
+	// Runs work(i) for i in [0, count) across up to threadCount
+	// threads, or inline when there's only one thread
+	// --------------------------------------------------------
+	template<typename Work>
+	void RunParallel(unsigned int count, unsigned int threadCount, Work work)
+	{
+		if (threadCount <= 1 || count <= 1)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				work(i);
+			return;
+		}
+
+		unsigned int workerCount = threadCount < count ? threadCount : count;
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (unsigned int t = 0; t < workerCount; t++)
+		{
+			workers.emplace_back([=]()
+				{
+					for (unsigned int i = t; i < count; i += workerCount)
+						work(i);
+				});
+		}
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// A palette matrix as its 4 columns, with 0 in each 4th lane
+	struct ColumnMatrix
+	{
+		__m128 columns[4];
+	};
+
+	// Builds the column palette, with the identity in every unused slot
+	void BuildColumnPalette(const SkinMatrix* palette, unsigned int jointCount, std::vector<ColumnMatrix>& columns)
+	{
+		columns.resize(paletteSlots);
+		for (unsigned int j = 0; j < paletteSlots; j++)
+		{
+			SkinMatrix m = j < jointCount ? palette[j] : Skeleton::Identity();
+			for (unsigned int c = 0; c < 4; c++)
+				columns[j].columns[c] = _mm_setr_ps(m.rows[0][c], m.rows[1][c], m.rows[2][c], 0.0f);
+		}
+	}
+
+	// Scales a vector to unit length, leaving zero length vectors alone
+	inline __m128 Normalize3(__m128 v)
+	{
+		__m128 squared = _mm_mul_ps(v, v);
+		__m128 lengthSquared = _mm_add_ss(_mm_add_ss(squared, _mm_shuffle_ps(squared, squared, 0x55)), _mm_movehl_ps(squared, squared));
+		lengthSquared = _mm_shuffle_ps(lengthSquared, lengthSquared, 0x00);
+
+		__m128 nonZero = _mm_cmpneq_ps(lengthSquared, _mm_setzero_ps());
+		return _mm_and_ps(_mm_div_ps(v, _mm_sqrt_ps(lengthSquared)), nonZero);
+	}
+
+	// --------------------------------------------------------
+	// Skins vertices [first, last)
+	//
+	// - All 4 influences are blended even when some weights
+	//   are 0, which is cheaper than the branches it would take
+	//   to skip them
+	// - Each vertex is assembled in a local buffer (stores that
+	//   overlap by one float) and copied out whole, so the
+	//   output is written once, in order
+	// --------------------------------------------------------
+	void SkinRange(
+		const ObjVertex* bindVertices, const SkinWeights* weights,
+		const std::vector<ColumnMatrix>& palette,
+		ObjVertex* output,
+		unsigned int first, unsigned int last)
+	{
+		const __m128 weightScale = _mm_set1_ps(1.0f / 255.0f);
+		for (unsigned int v = first; v < last; v++)
+		{
+			const ObjVertex& vertex = bindVertices[v];
+			const SkinWeights& skin = weights[v];
+
+			__m128 w = _mm_mul_ps(_mm_setr_ps(skin.weights[0], skin.weights[1], skin.weights[2], skin.weights[3]), weightScale);
+			__m128 w0 = _mm_shuffle_ps(w, w, 0x00);
+			__m128 w1 = _mm_shuffle_ps(w, w, 0x55);
+			__m128 w2 = _mm_shuffle_ps(w, w, 0xAA);
+			__m128 w3 = _mm_shuffle_ps(w, w, 0xFF);
+
+			const ColumnMatrix& m0 = palette[skin.joints[0]];
+			const ColumnMatrix& m1 = palette[skin.joints[1]];
+			const ColumnMatrix& m2 = palette[skin.joints[2]];
+			const ColumnMatrix& m3 = palette[skin.joints[3]];
+
+			// Blend the matrices one column at a time
+			__m128 blended[4];
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				blended[c] = _mm_add_ps(
+					_mm_add_ps(
+						_mm_add_ps(_mm_mul_ps(m0.columns[c], w0), _mm_mul_ps(m1.columns[c], w1)),
+						_mm_mul_ps(m2.columns[c], w2)),
+					_mm_mul_ps(m3.columns[c], w3));
+			}
+
+			// Positions get the translation; normals and tangents don't
+			__m128 position = _mm_add_ps(
+				_mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(blended[0], _mm_set1_ps(vertex.Position.x)), _mm_mul_ps(blended[1], _mm_set1_ps(vertex.Position.y))),
+					_mm_mul_ps(blended[2], _mm_set1_ps(vertex.Position.z))),
+				blended[3]);
+			__m128 normal = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(blended[0], _mm_set1_ps(vertex.Normal.x)), _mm_mul_ps(blended[1], _mm_set1_ps(vertex.Normal.y))),
+				_mm_mul_ps(blended[2], _mm_set1_ps(vertex.Normal.z)));
+			__m128 tangent = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(blended[0], _mm_set1_ps(vertex.Tangent.x)), _mm_mul_ps(blended[1], _mm_set1_ps(vertex.Tangent.y))),
+				_mm_mul_ps(blended[2], _mm_set1_ps(vertex.Tangent.z)));
+
+			float skinned[12];
+			_mm_storeu_ps(skinned + 0, position);
+			_mm_storeu_ps(skinned + 3, Normalize3(normal));
+			_mm_storeu_ps(skinned + 6, Normalize3(tangent));
+			skinned[9] = vertex.UV.x;
+			skinned[10] = vertex.UV.y;
+			memcpy(&output[v], skinned, sizeof(ObjVertex));
+		}
+	}
+
+	// Splits [0, count) into taskCount ranges
+	inline unsigned int GetRangeStart(unsigned int count, unsigned int taskCount, unsigned int task)
+	{
+		return (unsigned int)((unsigned long long)count * task / taskCount);
+	}
+
+	// Transforms a vector by a matrix's 3x3 part, plus translation if w is 1
+	ObjFloat3 Transform(const float m[3][4], const ObjFloat3& v, float w)
+	{
+		return ObjFloat3{
+			m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3] * w,
+			m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3] * w,
+			m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z + m[2][3] * w };
+	}
+
+	ObjFloat3 Normalize(const ObjFloat3& v)
+	{
+		float lengthSquared = v.x * v.x + v.y * v.y + v.z * v.z;
+		if (lengthSquared == 0.0f)
+			return v;
+
+		float length = sqrtf(lengthSquared);
+		return ObjFloat3{ v.x / length, v.y / length, v.z / length };
+	}
+
+	// Squared distance from a point to the segment [a, b]
+	float DistanceSquaredToSegment(const ObjFloat3& p, const ObjFloat3& a, const ObjFloat3& b)
+	{
+		ObjFloat3 ab = { b.x - a.x, b.y - a.y, b.z - a.z };
+		ObjFloat3 ap = { p.x - a.x, p.y - a.y, p.z - a.z };
+		float lengthSquared = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+		float t = lengthSquared > 0.0f ? (ap.x * ab.x + ap.y * ab.y + ap.z * ab.z) / lengthSquared : 0.0f;
+		t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+
+		ObjFloat3 d = { ap.x - ab.x * t, ap.y - ab.y * t, ap.z - ab.z * t };
+		return d.x * d.x + d.y * d.y + d.z * d.z;
+	}
+}
+
+// --------------------------------------------------------
+// Skins with SSE across several threads
+// --------------------------------------------------------
+void Skinning::SkinVertices(
+	const ObjVertex* bindVertices, const SkinWeights* weights, unsigned int vertexCount,
+	const SkinMatrix* palette, unsigned int jointCount,
+	ObjVertex* output,
+	unsigned int threadCount,
+	SkinningStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+	unsigned int taskCount = vertexCount / minVerticesPerTask;
+	if (taskCount > threadCount)
+		taskCount = threadCount;
+	if (taskCount < 1)
+		taskCount = 1;
+
+	std::vector<ColumnMatrix> columns;
+	BuildColumnPalette(palette, jointCount, columns);
+
+	RunParallel(taskCount, taskCount, [&](unsigned int task)
+		{
+			SkinRange(
+				bindVertices, weights, columns, output,
+				GetRangeStart(vertexCount, taskCount, task),
+				GetRangeStart(vertexCount, taskCount, task + 1));
+		});
+
+	if (stats)
+	{
+		*stats = {};
+		stats->threads = taskCount;
+		stats->vertices = vertexCount;
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+		stats->verticesPerMillisecond = stats->seconds > 0.0 ? vertexCount / (stats->seconds * 1000.0) : 0.0;
+	}
+}
+
+// --------------------------------------------------------
+// Skins one vertex at a time, blending row by row
+// --------------------------------------------------------
+void Skinning::SkinVerticesReference(
+	const ObjVertex* bindVertices, const SkinWeights* weights, unsigned int vertexCount,
+	const SkinMatrix* palette, unsigned int jointCount,
+	ObjVertex* output)
+{
+	SkinMatrix identity = Skeleton::Identity();
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		// Blend the influences' matrices
+		SkinMatrix blended = {};
+		for (unsigned int k = 0; k < 4; k++)
+		{
+			const SkinMatrix& m = weights[v].joints[k] < jointCount ? palette[weights[v].joints[k]] : identity;
+			float w = weights[v].weights[k] * (1.0f / 255.0f);
+			for (unsigned int r = 0; r < 3; r++)
+			{
+				for (unsigned int c = 0; c < 4; c++)
+					blended.rows[r][c] += m.rows[r][c] * w;
+			}
+		}
+
+		output[v].Position = Transform(blended.rows, bindVertices[v].Position, 1.0f);
+		output[v].Normal = Normalize(Transform(blended.rows, bindVertices[v].Normal, 0.0f));
+		output[v].Tangent = Normalize(Transform(blended.rows, bindVertices[v].Tangent, 0.0f));
+		output[v].UV = bindVertices[v].UV;
+	}
+}
+
+float Skinning::CompareVertices(const ObjVertex* a, const ObjVertex* b, unsigned int vertexCount)
+{
+	float maxError = 0.0f;
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		const float* fa = &a[v].Position.x;
+		const float* fb = &b[v].Position.x;
+		for (unsigned int c = 0; c < sizeof(ObjVertex) / sizeof(float); c++)
+		{
+			float error = fabsf(fa[c] - fb[c]);
+			if (error > maxError)
+				maxError = error;
+		}
+	}
+	return maxError;
+}
+
+void Skinning::BindToNearestJoints(
+	const ObjVertex* vertices, unsigned int vertexCount,
+	const Skeleton& skeleton,
+	SkinWeights* weights)
+{
+	// Where each joint is in the bind pose
+	unsigned int jointCount = skeleton.GetJointCount();
+	std::vector<ObjFloat3> jointPositions(jointCount);
+	for (unsigned int j = 0; j < jointCount; j++)
+	{
+		SkinMatrix model = Skeleton::Inverse(skeleton.GetJoint(j).inverseBind);
+		jointPositions[j] = ObjFloat3{ model.rows[0][3], model.rows[1][3], model.rows[2][3] };
+	}
+
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		weights[v] = {};
+		if (jointCount == 0)
+			continue;
+
+		// Keep the 4 closest bones, closest first
+		unsigned int nearest[4] = { 0, 0, 0, 0 };
+		float nearestDistance[4] = { INFINITY, INFINITY, INFINITY, INFINITY };
+		for (unsigned int j = 0; j < jointCount; j++)
+		{
+			// A bone to each child, or just the joint itself for a leaf
+			float distance = INFINITY;
+			for (unsigned int child = j + 1; child < jointCount; child++)
+			{
+				if (skeleton.GetJoint(child).parent != (int)j)
+					continue;
+				float d = DistanceSquaredToSegment(vertices[v].Position, jointPositions[j], jointPositions[child]);
+				distance = d < distance ? d : distance;
+			}
+			if (distance == INFINITY)
+				distance = DistanceSquaredToSegment(vertices[v].Position, jointPositions[j], jointPositions[j]);
+
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				if (distance >= nearestDistance[k])
+					continue;
+
+				for (unsigned int s = 3; s > k; s--)
+				{
+					nearest[s] = nearest[s - 1];
+					nearestDistance[s] = nearestDistance[s - 1];
+				}
+				nearest[k] = j;
+				nearestDistance[k] = distance;
+				break;
+			}
+		}
+
+		// Inverse squared distance, quantized with any rounding left on the closest
+		float raw[4] = {};
+		float total = 0.0f;
+		for (unsigned int k = 0; k < 4 && k < jointCount; k++)
+		{
+			raw[k] = 1.0f / (nearestDistance[k] + 1e-6f);
+			total += raw[k];
+		}
+
+		int remaining = 255;
+		for (unsigned int k = 3; k > 0; k--)
+		{
+			int weight = (int)(raw[k] / total * 255.0f + 0.5f);
+			weights[v].joints[k] = (unsigned char)nearest[k];
+			weights[v].weights[k] = (unsigned char)weight;
+			remaining -= weight;
+		}
+		weights[v].joints[0] = (unsigned char)nearest[0];
+		weights[v].weights[0] = (unsigned char)remaining;
+	}
+}
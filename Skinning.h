@@ -0,0 +1,77 @@
+#pragma once
+#include "ObjParser.h"
+#include "Skeleton.h"
+
+// --------------------------------------------------------
+// The joints that move one vertex, and how much
+//
+// - Up to 4 influences; unused ones have a weight of 0
+// - Weights are unorm bytes that add up to exactly 255, so
+//   they upload as-is (R8G8B8A8_UINT + R8G8B8A8_UNORM)
+// --------------------------------------------------------
+struct SkinWeights
+{
+	unsigned char joints[4];
+	unsigned char weights[4];
+};
+
+// --------------------------------------------------------
+// Timings from skinning a mesh on the CPU
+// --------------------------------------------------------
+struct SkinningStats
+{
+	unsigned int threads;
+	unsigned int vertices;
+	double seconds;
+	double verticesPerMillisecond;
+};
+
+// --------------------------------------------------------
+// Linear blend skinning of bind pose vertices on the CPU
+//
+// - SkinVertices is the fast path. Each vertex blends its 4
+//   palette matrices with SSE (kept as columns, so the blend
+//   and the transform are both whole-vector multiply-adds,
+//   with no shuffles), then transforms its position, normal
+//   and tangent. Normals and tangents are renormalized
+// - Vertices are split into ranges across threads, and each
+//   range writes only its own output, which can be a mapped
+//   dynamic vertex buffer (it's written front to back)
+// - SkinVerticesReference is a plain scalar version to check
+//   the fast path against
+// - Joint indices past the palette use the identity
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class Skinning
+{
+public:
+	// A threadCount of 0 uses every hardware thread; small meshes
+	// always run on the calling thread
+	static void SkinVertices(
+		const ObjVertex* bindVertices, const SkinWeights* weights, unsigned int vertexCount,
+		const SkinMatrix* palette, unsigned int jointCount,
+		ObjVertex* output,
+		unsigned int threadCount = 0,
+		SkinningStats* stats = nullptr);
+
+	static void SkinVerticesReference(
+		const ObjVertex* bindVertices, const SkinWeights* weights, unsigned int vertexCount,
+		const SkinMatrix* palette, unsigned int jointCount,
+		ObjVertex* output);
+
+	// Largest per-component difference between two sets of skinned vertices
+	static float CompareVertices(const ObjVertex* a, const ObjVertex* b, unsigned int vertexCount);
+
+	// --------------------------------------------------------
+	// Automatic weights for meshes that weren't authored with any
+	//
+	// - Each joint's bone runs from it to each of its children
+	//   (a leaf joint is just a point), in the bind pose
+	// - A vertex takes the 4 nearest bones, weighted by inverse
+	//   squared distance
+	// --------------------------------------------------------
+	static void BindToNearestJoints(
+		const ObjVertex* vertices, unsigned int vertexCount,
+		const Skeleton& skeleton,
+		SkinWeights* weights);
+};
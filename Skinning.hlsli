@@ -0,0 +1,33 @@
+#ifndef __GPP_SKINNING__
+#define __GPP_SKINNING__
+
+#include "ShaderStructs.hlsli"
+
+// Must match Skeleton::MaxJoints
+#define MAX_JOINTS 64
+
+// The skinning palette, laid out like SkinMatrix (see Skeleton.h)
+cbuffer SkinningData : register(b2)
+{
+    row_major float3x4 bones[MAX_JOINTS];
+}
+
+// Blends a vertex's joint matrices and poses it with the result
+VertexShaderInput SkinVertex(SkinnedVertexShaderInput input)
+{
+    float3x4 skin =
+        bones[input.joints.x] * input.weights.x +
+        bones[input.joints.y] * input.weights.y +
+        bones[input.joints.z] * input.weights.z +
+        bones[input.joints.w] * input.weights.w;
+
+    VertexShaderInput output;
+    output.localPosition = mul(skin, float4(input.localPosition, 1.0f));
+    output.normal = normalize(mul((float3x3)skin, input.normal));
+    output.tangent = normalize(mul((float3x3)skin, input.tangent));
+    output.uv = input.uv;
+    output.shadowMapPos = float4(0, 0, 0, 0);
+    return output;
+}
+
+#endif
@@ -0,0 +1,322 @@
+// --------------------------------------------------------
+// Tests and benchmark for Skinning
+//
+// - Checks the SSE path against the scalar reference with 1
+//   to 4 influences per vertex, on one thread and split
+//   across several, plus the bind pose (which must leave
+//   vertices where they are) and joints past the palette
+// - Checks automatic weights add up and stay in the skeleton
+// - Given "bench", also measures vertices per millisecond at
+//   several mesh sizes and thread counts
+// - Not part of the Visual Studio project. On Linux it's the
+//   skinning_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 SkinningTests.cpp Skinning.cpp
+//       Skeleton.cpp -lpthread -o skinning_tests
+// - Usage: skinning_tests [bench]
+// --------------------------------------------------------
+#include "Skinning.h"
+#include "TestChecks.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// SSE blends in a different order than the reference, so allow for rounding
+	const float maxDifference = 1e-4f;
+
+	JointPose MakePose(float x, float y, float z, float angle, const float axis[3])
+	{
+		float s = sinf(angle * 0.5f);
+		JointPose pose = {};
+		pose.translation[0] = x;
+		pose.translation[1] = y;
+		pose.translation[2] = z;
+		pose.rotation[0] = axis[0] * s;
+		pose.rotation[1] = axis[1] * s;
+		pose.rotation[2] = axis[2] * s;
+		pose.rotation[3] = cosf(angle * 0.5f);
+		pose.scale[0] = pose.scale[1] = pose.scale[2] = 1.0f;
+		return pose;
+	}
+
+	// --------------------------------------------------------
+	// A spine of joints up Y, with an arm branching off every
+	// fourth one, so the palette has real depth and width
+	// --------------------------------------------------------
+	Skeleton MakeSkeleton()
+	{
+		const float up[3] = { 0.0f, 1.0f, 0.0f };
+		Skeleton skeleton;
+		int parent = skeleton.AddJoint("root", -1, MakePose(0.0f, 0.0f, 0.0f, 0.0f, up));
+		for (unsigned int j = 1; j < 32; j++)
+		{
+			int spine = skeleton.AddJoint("spine" + std::to_string(j), parent, MakePose(0.0f, 0.5f, 0.0f, 0.0f, up));
+			if (j % 4 == 0)
+				skeleton.AddJoint("arm" + std::to_string(j), spine, MakePose(0.8f, 0.0f, 0.0f, 0.0f, up));
+			parent = spine;
+		}
+		return skeleton;
+	}
+
+	// Every joint bent a little about a different axis, and stretched
+	std::vector<JointPose> MakeAnimatedPose(const Skeleton& skeleton, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::vector<JointPose> pose(skeleton.GetJointCount());
+		skeleton.GetBindPose(pose.data());
+		for (JointPose& joint : pose)
+		{
+			float axis[3] = { unit(random), unit(random), unit(random) };
+			float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+			for (float& a : axis)
+				a /= length;
+
+			JointPose bent = MakePose(joint.translation[0], joint.translation[1], joint.translation[2], unit(random) * 0.6f, axis);
+			bent.scale[0] = 1.0f + unit(random) * 0.1f;
+			joint = bent;
+		}
+		return pose;
+	}
+
+	ObjFloat3 RandomDirection(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		ObjFloat3 v = { unit(random), unit(random), unit(random) + 0.01f };
+		float length = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+		return { v.x / length, v.y / length, v.z / length };
+	}
+
+	// Vertices around the spine, in the bind pose
+	std::vector<ObjVertex> MakeVertices(unsigned int count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> across(-1.0f, 1.0f);
+		std::uniform_real_distribution<float> height(0.0f, 16.0f);
+		std::vector<ObjVertex> vertices(count);
+		for (ObjVertex& vertex : vertices)
+		{
+			vertex.Position = { across(random), height(random), across(random) };
+			vertex.Normal = RandomDirection(random);
+			vertex.Tangent = RandomDirection(random);
+			vertex.UV = { across(random), across(random) };
+		}
+		return vertices;
+	}
+
+	// --------------------------------------------------------
+	// influences joints per vertex, picked at random, with
+	// weights that add up to 255 and zeroes in unused slots
+	// --------------------------------------------------------
+	std::vector<SkinWeights> MakeWeights(unsigned int count, unsigned int influences, unsigned int jointCount, std::mt19937& random)
+	{
+		std::uniform_int_distribution<unsigned int> joint(0, jointCount - 1);
+		std::uniform_int_distribution<unsigned int> share(1, 100);
+		std::vector<SkinWeights> weights(count);
+		for (SkinWeights& skin : weights)
+		{
+			skin = {};
+			unsigned int raw[4] = {};
+			unsigned int total = 0;
+			for (unsigned int k = 0; k < influences; k++)
+			{
+				skin.joints[k] = (unsigned char)joint(random);
+				raw[k] = share(random);
+				total += raw[k];
+			}
+
+			int remaining = 255;
+			for (unsigned int k = 1; k < influences; k++)
+			{
+				skin.weights[k] = (unsigned char)(raw[k] * 255 / total);
+				remaining -= skin.weights[k];
+			}
+			skin.weights[0] = (unsigned char)remaining;
+		}
+		return weights;
+	}
+
+	// --------------------------------------------------------
+	// The fast path matches the reference for each number of
+	// influences, whether it runs on one thread or is split
+	// --------------------------------------------------------
+	void TestAgainstReference(std::mt19937& random)
+	{
+		Skeleton skeleton = MakeSkeleton();
+		std::vector<JointPose> pose = MakeAnimatedPose(skeleton, random);
+		std::vector<SkinMatrix> palette(skeleton.GetJointCount());
+		skeleton.ComputeSkinningPalette(pose.data(), palette.data());
+
+		// Big enough to be split into several ranges
+		const unsigned int vertexCount = 50000;
+		std::vector<ObjVertex> vertices = MakeVertices(vertexCount, random);
+		std::vector<ObjVertex> expected(vertexCount);
+		std::vector<ObjVertex> skinned(vertexCount);
+
+		for (unsigned int influences = 1; influences <= 4; influences++)
+		{
+			std::vector<SkinWeights> weights = MakeWeights(vertexCount, influences, skeleton.GetJointCount(), random);
+			Skinning::SkinVerticesReference(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), expected.data());
+
+			for (unsigned int threadCount : { 1u, 4u })
+			{
+				memset(skinned.data(), 0, skinned.size() * sizeof(ObjVertex));
+				SkinningStats stats = {};
+				Skinning::SkinVertices(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), skinned.data(), threadCount, &stats);
+
+				float difference = Skinning::CompareVertices(expected.data(), skinned.data(), vertexCount);
+				printf("  %u influences, %u threads: %g max difference\n", influences, stats.threads, difference);
+				CHECK(difference <= maxDifference);
+				CHECK(stats.vertices == vertexCount && stats.threads == threadCount);
+			}
+
+			// Skinning moved things, so the comparison means something
+			CHECK(Skinning::CompareVertices(vertices.data(), expected.data(), vertexCount) > 0.1f);
+		}
+
+		// Normals and tangents come out unit length
+		bool unit = true;
+		for (const ObjVertex& vertex : skinned)
+		{
+			float normal = vertex.Normal.x * vertex.Normal.x + vertex.Normal.y * vertex.Normal.y + vertex.Normal.z * vertex.Normal.z;
+			float tangent = vertex.Tangent.x * vertex.Tangent.x + vertex.Tangent.y * vertex.Tangent.y + vertex.Tangent.z * vertex.Tangent.z;
+			unit = unit && fabsf(normal - 1.0f) < 1e-4f && fabsf(tangent - 1.0f) < 1e-4f;
+		}
+		CHECK(unit);
+	}
+
+	// The bind pose palette is the identity, so nothing moves
+	void TestBindPose(std::mt19937& random)
+	{
+		Skeleton skeleton = MakeSkeleton();
+		std::vector<JointPose> pose(skeleton.GetJointCount());
+		skeleton.GetBindPose(pose.data());
+		std::vector<SkinMatrix> palette(skeleton.GetJointCount());
+		skeleton.ComputeSkinningPalette(pose.data(), palette.data());
+
+		const unsigned int vertexCount = 1000;
+		std::vector<ObjVertex> vertices = MakeVertices(vertexCount, random);
+		std::vector<SkinWeights> weights = MakeWeights(vertexCount, 4, skeleton.GetJointCount(), random);
+		std::vector<ObjVertex> skinned(vertexCount);
+		Skinning::SkinVertices(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), skinned.data(), 1);
+		CHECK(Skinning::CompareVertices(vertices.data(), skinned.data(), vertexCount) <= maxDifference);
+	}
+
+	// Joint indices past the end of the palette use the identity, on both paths
+	void TestJointsPastPalette(std::mt19937& random)
+	{
+		Skeleton skeleton = MakeSkeleton();
+		std::vector<JointPose> pose = MakeAnimatedPose(skeleton, random);
+		std::vector<SkinMatrix> palette(skeleton.GetJointCount());
+		skeleton.ComputeSkinningPalette(pose.data(), palette.data());
+
+		const unsigned int vertexCount = 100;
+		std::vector<ObjVertex> vertices = MakeVertices(vertexCount, random);
+		std::vector<SkinWeights> weights(vertexCount);
+		for (SkinWeights& skin : weights)
+			skin = { { 200, 0, 0, 0 }, { 255, 0, 0, 0 } };
+
+		std::vector<ObjVertex> expected(vertexCount);
+		std::vector<ObjVertex> skinned(vertexCount);
+		Skinning::SkinVerticesReference(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), expected.data());
+		Skinning::SkinVertices(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), skinned.data(), 1);
+		CHECK(Skinning::CompareVertices(vertices.data(), expected.data(), vertexCount) <= maxDifference);
+		CHECK(Skinning::CompareVertices(vertices.data(), skinned.data(), vertexCount) <= maxDifference);
+	}
+
+	// Automatic weights add up to 255 and only use joints that exist
+	void TestBindToNearestJoints(std::mt19937& random)
+	{
+		Skeleton skeleton = MakeSkeleton();
+		const unsigned int vertexCount = 2000;
+		std::vector<ObjVertex> vertices = MakeVertices(vertexCount, random);
+		std::vector<SkinWeights> weights(vertexCount);
+		Skinning::BindToNearestJoints(vertices.data(), vertexCount, skeleton, weights.data());
+
+		bool valid = true;
+		for (const SkinWeights& skin : weights)
+		{
+			unsigned int total = 0;
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				total += skin.weights[k];
+				valid = valid && skin.joints[k] < skeleton.GetJointCount();
+			}
+			valid = valid && total == 255;
+		}
+		CHECK(valid);
+	}
+
+	// --------------------------------------------------------
+	// Vertices per millisecond by mesh size and thread count,
+	// the best of several runs each
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		std::mt19937 random(99);
+		Skeleton skeleton = MakeSkeleton();
+		std::vector<JointPose> pose = MakeAnimatedPose(skeleton, random);
+		std::vector<SkinMatrix> palette(skeleton.GetJointCount());
+		skeleton.ComputeSkinningPalette(pose.data(), palette.data());
+
+		unsigned int hardwareThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+		const unsigned int vertexCounts[] = { 10000, 100000, 1000000 };
+		const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+		printf("\nVertices  Reference  ");
+		for (unsigned int threadCount : threadCounts)
+			printf("%u threads  ", threadCount);
+		printf("(vertices/ms)\n");
+
+		for (unsigned int vertexCount : vertexCounts)
+		{
+			std::vector<ObjVertex> vertices = MakeVertices(vertexCount, random);
+			std::vector<SkinWeights> weights = MakeWeights(vertexCount, 4, skeleton.GetJointCount(), random);
+			std::vector<ObjVertex> skinned(vertexCount);
+			unsigned int runs = 5000000 / vertexCount;
+
+			double best = 1e30;
+			for (unsigned int r = 0; r < runs; r++)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				Skinning::SkinVerticesReference(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), skinned.data());
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				best = seconds < best ? seconds : best;
+			}
+			printf("%8u  %9.0f  ", vertexCount, vertexCount / (best * 1000.0));
+
+			for (unsigned int threadCount : threadCounts)
+			{
+				double bestRate = 0.0;
+				for (unsigned int r = 0; r < runs; r++)
+				{
+					SkinningStats stats = {};
+					Skinning::SkinVertices(vertices.data(), weights.data(), vertexCount, palette.data(), (unsigned int)palette.size(), skinned.data(), threadCount, &stats);
+					bestRate = stats.verticesPerMillisecond > bestRate ? stats.verticesPerMillisecond : bestRate;
+				}
+				printf("%9.0f  ", bestRate);
+			}
+			printf("\n");
+		}
+		printf("(%u hardware threads; 4 influences per vertex)\n", hardwareThreads);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 random(1234);
+	TestAgainstReference(random);
+	TestBindPose(random);
+	TestJointsPastPalette(random);
+	TestBindToNearestJoints(random);
+
+	int result = TestChecks::Finish("Skinning");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
@@ -0,0 +1,444 @@
+#include "TangentGenerator.h"
+
+#include <chrono>
+#include <cmath>
+#include <emmintrin.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Smaller pieces of work aren't worth the cost of a thread
+	const unsigned int minTrianglesPerTask = 1 << 14;
+
+	// --------------------------------------------------------
+	// Runs work(i) for i in [0, count) across up to threadCount
+	// threads, or inline when there's only one thread
+	// --------------------------------------------------------
+	template<typename Work>
+	void RunParallel(unsigned int count, unsigned int threadCount, Work work)
+	{
+		if (threadCount <= 1 || count <= 1)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				work(i);
+			return;
+		}
+
+		unsigned int workerCount = threadCount < count ? threadCount : count;
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (unsigned int t = 0; t < workerCount; t++)
+		{
+			workers.emplace_back([=]()
+				{
+					for (unsigned int i = t; i < count; i += workerCount)
+						work(i);
+				});
+		}
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// Splits [0, count) into taskCount ranges, each starting on a multiple of 4
+	inline unsigned int GetRangeStart(unsigned int count, unsigned int taskCount, unsigned int task)
+	{
+		if (task >= taskCount)
+			return count;
+
+		unsigned long long start = (unsigned long long)count * task / taskCount;
+		return (unsigned int)(start & ~3ull);
+	}
+
+	// --------------------------------------------------------
+	// One task's share of the triangles, summed over its own
+	// window of vertices [firstVertex, firstVertex + vertexCount)
+	//
+	// - The first task sums straight into the vertices' Tangent
+	//   fields (stride of a whole vertex), which saves allocating
+	//   and faulting in a buffer the size of the mesh. The others
+	//   sum into their own storage (stride of 4 floats)
+	// - Sums are xyz triples; their 4th float is never written
+	// --------------------------------------------------------
+	struct PartialSums
+	{
+		unsigned int firstVertex;
+		unsigned int vertexCount;
+		float* sums;
+		size_t stride;
+		std::vector<float> storage;
+
+		float* Get(unsigned int vertex) const
+		{
+			return sums + (size_t)(vertex - firstVertex) * stride;
+		}
+
+		bool Contains(unsigned int vertex) const
+		{
+			return vertex >= firstVertex && vertex - firstVertex < vertexCount;
+		}
+	};
+
+	// Adds a tangent to a sum one float at a time. A 16-byte load right
+	// after 12-byte stores to the same vertex (neighbouring triangles
+	// share vertices) can't be store-forwarded and stalls badly
+	inline void AddToSum(float* sum, const float tangent[3])
+	{
+		sum[0] += tangent[0];
+		sum[1] += tangent[1];
+		sum[2] += tangent[2];
+	}
+
+	// --------------------------------------------------------
+	// Adds the tangents of triangles [first, last) to partial
+	//
+	// - Each triangle's edges are worked out as whole vectors,
+	//   reading the position straight out of the vertex (its 4th
+	//   float is Normal.x, which is ignored). The UV math is the
+	//   same scalar math as the reference
+	// - The adds happen in triangle order, exactly like the
+	//   reference
+	// - This loop is bound by the scattered adds, not the math,
+	//   so packing 4 triangles into SoA registers was slower
+	//   (the gathers cost more shuffles than the math saved)
+	// --------------------------------------------------------
+	template<size_t Stride>
+	void SumTriangleTangents(
+		const ObjVertex* vertices, const unsigned int* indices,
+		unsigned int first, unsigned int last,
+		const PartialSums& partial)
+	{
+		float* sums = partial.sums - (size_t)partial.firstVertex * Stride;
+		for (unsigned int t = first; t < last; t++)
+		{
+			const ObjVertex& v1 = vertices[indices[t * 3 + 0]];
+			const ObjVertex& v2 = vertices[indices[t * 3 + 1]];
+			const ObjVertex& v3 = vertices[indices[t * 3 + 2]];
+
+			__m128 p1 = _mm_loadu_ps(&v1.Position.x);
+			__m128 e1 = _mm_sub_ps(_mm_loadu_ps(&v2.Position.x), p1);
+			__m128 e2 = _mm_sub_ps(_mm_loadu_ps(&v3.Position.x), p1);
+
+			float s1 = v2.UV.x - v1.UV.x;
+			float t1 = v2.UV.y - v1.UV.y;
+			float s2 = v3.UV.x - v1.UV.x;
+			float t2 = v3.UV.y - v1.UV.y;
+			float r = 1.0f / (s1 * t2 - s2 * t1);
+
+			__m128 tangent = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(_mm_set1_ps(t2), e1), _mm_mul_ps(_mm_set1_ps(t1), e2)), _mm_set1_ps(r));
+			float quad[4];
+			_mm_storeu_ps(quad, tangent);
+
+			for (unsigned int c = 0; c < 3; c++)
+				AddToSum(sums + (size_t)indices[t * 3 + c] * Stride, quad);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Sets up a task's partial sums and fills them from
+	// triangles [first, last)
+	// --------------------------------------------------------
+	void AccumulateTangents(
+		ObjVertex* vertices, unsigned int vertexCount, const unsigned int* indices,
+		unsigned int first, unsigned int last,
+		bool inPlace, bool wholeMesh, PartialSums& partial)
+	{
+		// Vertex-fetch-optimized meshes number vertices by first use,
+		// so this window is usually a small part of the whole mesh.
+		// A single task covers everything, so it skips the search
+		unsigned int minVertex = 0;
+		unsigned int maxVertex = vertexCount - 1;
+		if (!wholeMesh)
+		{
+			minVertex = 0xFFFFFFFFu;
+			maxVertex = 0;
+			for (unsigned int i = first * 3; i < last * 3; i++)
+			{
+				minVertex = indices[i] < minVertex ? indices[i] : minVertex;
+				maxVertex = indices[i] > maxVertex ? indices[i] : maxVertex;
+			}
+		}
+
+		partial.firstVertex = minVertex;
+		partial.vertexCount = first < last && vertexCount > 0 ? maxVertex - minVertex + 1 : 0;
+		if (partial.vertexCount == 0)
+			return;
+
+		// The stride is a template argument so the scatter doesn't multiply by a variable
+		if (inPlace)
+		{
+			partial.sums = &vertices[minVertex].Tangent.x;
+			partial.stride = sizeof(ObjVertex) / sizeof(float);
+			for (unsigned int v = minVertex; v <= maxVertex; v++)
+				vertices[v].Tangent = ObjFloat3{ 0, 0, 0 };
+
+			SumTriangleTangents<sizeof(ObjVertex) / sizeof(float)>(vertices, indices, first, last, partial);
+		}
+		else
+		{
+			partial.storage.assign((size_t)partial.vertexCount * 4, 0.0f);
+			partial.sums = partial.storage.data();
+			partial.stride = 4;
+
+			SumTriangleTangents<4>(vertices, indices, first, last, partial);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Gram-Schmidt orthonormalizes up to 4 summed tangents
+	// against their normals and stores them
+	//
+	// - Zero length tangents stay zero, like XMVector3Normalize
+	// --------------------------------------------------------
+	void OrthonormalizeTangents(ObjVertex* vertices, unsigned int count, __m128 sums[4])
+	{
+		ObjFloat3 zero = { 0, 0, 0 };
+		const ObjFloat3& n0 = vertices[0].Normal;
+		const ObjFloat3& n1 = count > 1 ? vertices[1].Normal : zero;
+		const ObjFloat3& n2 = count > 2 ? vertices[2].Normal : zero;
+		const ObjFloat3& n3 = count > 3 ? vertices[3].Normal : zero;
+		__m128 nx = _mm_setr_ps(n0.x, n1.x, n2.x, n3.x);
+		__m128 ny = _mm_setr_ps(n0.y, n1.y, n2.y, n3.y);
+		__m128 nz = _mm_setr_ps(n0.z, n1.z, n2.z, n3.z);
+
+		__m128 tx = sums[0];
+		__m128 ty = sums[1];
+		__m128 tz = sums[2];
+		__m128 tw = sums[3];
+		_MM_TRANSPOSE4_PS(tx, ty, tz, tw);
+
+		// tangent - normal * dot(normal, tangent)
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, tx), _mm_mul_ps(ny, ty)), _mm_mul_ps(nz, tz));
+		tx = _mm_sub_ps(tx, _mm_mul_ps(nx, dot));
+		ty = _mm_sub_ps(ty, _mm_mul_ps(ny, dot));
+		tz = _mm_sub_ps(tz, _mm_mul_ps(nz, dot));
+
+		// Normalize
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(tx, tx), _mm_mul_ps(ty, ty)), _mm_mul_ps(tz, tz));
+		__m128 length = _mm_sqrt_ps(lengthSquared);
+		__m128 nonZero = _mm_cmpneq_ps(lengthSquared, _mm_setzero_ps());
+		tx = _mm_and_ps(_mm_div_ps(tx, length), nonZero);
+		ty = _mm_and_ps(_mm_div_ps(ty, length), nonZero);
+		tz = _mm_and_ps(_mm_div_ps(tz, length), nonZero);
+
+		float x[4], y[4], z[4];
+		_mm_storeu_ps(x, tx);
+		_mm_storeu_ps(y, ty);
+		_mm_storeu_ps(z, tz);
+		for (unsigned int k = 0; k < count; k++)
+			vertices[k].Tangent = ObjFloat3{ x[k], y[k], z[k] };
+	}
+
+	// --------------------------------------------------------
+	// Combines the partial sums for vertices [first, last) in
+	// task order and orthonormalizes them, 4 vertices at a time
+	// --------------------------------------------------------
+	void ResolveTangents(
+		ObjVertex* vertices,
+		unsigned int first, unsigned int last,
+		const std::vector<PartialSums>& partials)
+	{
+		for (unsigned int v = first; v < last; v += 4)
+		{
+			unsigned int count = last - v < 4 ? last - v : 4;
+
+			__m128 sums[4];
+			for (unsigned int k = 0; k < 4; k++)
+			{
+				sums[k] = _mm_setzero_ps();
+				if (k >= count)
+					continue;
+
+				for (const PartialSums& partial : partials)
+				{
+					if (partial.Contains(v + k))
+						sums[k] = _mm_add_ps(sums[k], _mm_loadu_ps(partial.Get(v + k)));
+				}
+			}
+
+			OrthonormalizeTangents(vertices + v, count, sums);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Generates tangents with SSE across several threads
+//
+// - Pass 1 (parallel over triangle ranges): each task sums its
+//   triangles' tangents into its own partial sums
+// - Pass 2 (parallel over vertex ranges): each vertex adds up
+//   its partial sums, then gets orthonormalized
+// - Vertices shared between tasks are summed in a different
+//   order than the reference, so they may differ in the last bits
+// --------------------------------------------------------
+void TangentGenerator::GenerateTangents(
+	ObjVertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount,
+	unsigned int threadCount,
+	TangentStats* stats)
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	unsigned int triangleCount = indexCount / 3;
+	if (threadCount == 0)
+		threadCount = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+
+	unsigned int taskCount = triangleCount / minTrianglesPerTask;
+	if (taskCount > threadCount)
+		taskCount = threadCount;
+	if (taskCount < 1)
+		taskCount = 1;
+
+	// Pass 1: partial sums per task
+	std::vector<PartialSums> partials(taskCount);
+	RunParallel(taskCount, taskCount, [&](unsigned int task)
+		{
+			AccumulateTangents(
+				vertices, vertexCount, indices,
+				GetRangeStart(triangleCount, taskCount, task),
+				GetRangeStart(triangleCount, taskCount, task + 1),
+				task == 0, taskCount == 1, partials[task]);
+		});
+
+	// Pass 2: combine and orthonormalize
+	RunParallel(taskCount, taskCount, [&](unsigned int task)
+		{
+			ResolveTangents(
+				vertices,
+				GetRangeStart(vertexCount, taskCount, task),
+				GetRangeStart(vertexCount, taskCount, task + 1),
+				partials);
+		});
+
+	if (stats)
+	{
+		*stats = {};
+		stats->threads = taskCount;
+		stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+	}
+}
+
+// --------------------------------------------------------
+// Author: Chris Cascioli
+// Purpose: Calculates the tangents of the vertices in a mesh
+//
+// - You are allowed to directly copy/paste this into your code base
+//   for assignments, given that you clearly cite that this is not
+//   code of your own design.
+//
+// - Code originally adapted from: http://www.terathon.com/code/tangent.html
+//   - Updated version now found here: http://foundationsofgameenginedev.com/FGED2-sample.pdf
+//   - See listing 7.4 in section 7.5 (page 9 of the PDF)
+//
+// - Moved here from Mesh::CalculateTangents as the scalar
+//   reference for GenerateTangents, with DirectXMath swapped
+//   for plain floats
+// --------------------------------------------------------
+void TangentGenerator::GenerateTangentsReference(
+	ObjVertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount)
+{
+	// Reset tangents
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		vertices[i].Tangent = ObjFloat3{ 0, 0, 0 };
+	}
+
+	// Calculate tangents one whole triangle at a time
+	for (unsigned int i = 0; i + 2 < indexCount;)
+	{
+		// Grab indices and vertices of first triangle
+		unsigned int i1 = indices[i++];
+		unsigned int i2 = indices[i++];
+		unsigned int i3 = indices[i++];
+		ObjVertex* v1 = &vertices[i1];
+		ObjVertex* v2 = &vertices[i2];
+		ObjVertex* v3 = &vertices[i3];
+
+		// Calculate vectors relative to triangle positions
+		float x1 = v2->Position.x - v1->Position.x;
+		float y1 = v2->Position.y - v1->Position.y;
+		float z1 = v2->Position.z - v1->Position.z;
+
+		float x2 = v3->Position.x - v1->Position.x;
+		float y2 = v3->Position.y - v1->Position.y;
+		float z2 = v3->Position.z - v1->Position.z;
+
+		// Do the same for vectors relative to triangle uv's
+		float s1 = v2->UV.x - v1->UV.x;
+		float t1 = v2->UV.y - v1->UV.y;
+
+		float s2 = v3->UV.x - v1->UV.x;
+		float t2 = v3->UV.y - v1->UV.y;
+
+		// Create vectors for tangent calculation
+		float r = 1.0f / (s1 * t2 - s2 * t1);
+
+		float tx = (t2 * x1 - t1 * x2) * r;
+		float ty = (t2 * y1 - t1 * y2) * r;
+		float tz = (t2 * z1 - t1 * z2) * r;
+
+		// Adjust tangents of each vert of the triangle
+		v1->Tangent.x += tx;
+		v1->Tangent.y += ty;
+		v1->Tangent.z += tz;
+
+		v2->Tangent.x += tx;
+		v2->Tangent.y += ty;
+		v2->Tangent.z += tz;
+
+		v3->Tangent.x += tx;
+		v3->Tangent.y += ty;
+		v3->Tangent.z += tz;
+	}
+
+	// Ensure all of the tangents are orthogonal to the normals
+	for (unsigned int i = 0; i < vertexCount; i++)
+	{
+		// Grab the two vectors
+		ObjFloat3 normal = vertices[i].Normal;
+		ObjFloat3 tangent = vertices[i].Tangent;
+
+		// Use Gram-Schmidt orthonormalize to ensure
+		// the normal and tangent are exactly 90 degrees apart
+		float dot = normal.x * tangent.x + normal.y * tangent.y + normal.z * tangent.z;
+		tangent.x -= normal.x * dot;
+		tangent.y -= normal.y * dot;
+		tangent.z -= normal.z * dot;
+
+		float lengthSquared = tangent.x * tangent.x + tangent.y * tangent.y + tangent.z * tangent.z;
+		float length = sqrtf(lengthSquared);
+		if (lengthSquared == 0.0f)
+			length = 1.0f;
+
+		// Store the tangent
+		vertices[i].Tangent = ObjFloat3{ tangent.x / length, tangent.y / length, tangent.z / length };
+	}
+}
+
+// --------------------------------------------------------
+// Compares two sets of tangents component by component
+// --------------------------------------------------------
+float TangentGenerator::CompareTangents(const ObjVertex* a, const ObjVertex* b, unsigned int vertexCount)
+{
+	float maxError = 0.0f;
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		const float* ta = &a[v].Tangent.x;
+		const float* tb = &b[v].Tangent.x;
+		for (int k = 0; k < 3; k++)
+		{
+			bool nanA = ta[k] != ta[k];
+			bool nanB = tb[k] != tb[k];
+			if (nanA && nanB)
+				continue;
+
+			// Only one NaN can't be within any epsilon
+			float error = nanA || nanB ? INFINITY : fabsf(ta[k] - tb[k]);
+			if (error > maxError)
+				maxError = error;
+		}
+	}
+	return maxError;
+}
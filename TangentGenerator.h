@@ -0,0 +1,52 @@
+#pragma once
+#include "ObjParser.h"
+
+// --------------------------------------------------------
+// Timings and accuracy from generating tangents
+//
+// - The reference fields are only filled in when the scalar
+//   reference is run alongside for comparison (debug builds)
+// - maxReferenceError is the largest per-component difference
+// --------------------------------------------------------
+struct TangentStats
+{
+	unsigned int threads;
+	double seconds;
+	double referenceSeconds;
+	float maxReferenceError;
+};
+
+// --------------------------------------------------------
+// Generates per-vertex tangents from positions and UVs
+//
+// - GenerateTangents is the fast path. Triangles are split
+//   between threads, and each thread sums its triangles'
+//   tangents into its own partial sums (the first one straight
+//   into the vertices), so no two threads write the same memory.
+//   The partial sums are then added up per vertex in thread
+//   order and orthonormalized 4 vertices at a time with SSE
+// - On one thread the sums happen in exactly the reference's
+//   order, so the results are bit-identical to it
+// - GenerateTangentsReference is the original one triangle at
+//   a time version, kept to check the fast path against
+// - Has no DirectX dependency, so it can be used by tools
+// --------------------------------------------------------
+class TangentGenerator
+{
+public:
+	// A threadCount of 0 uses every hardware thread; small meshes
+	// always run on the calling thread
+	static void GenerateTangents(
+		ObjVertex* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount,
+		unsigned int threadCount = 0,
+		TangentStats* stats = nullptr);
+
+	static void GenerateTangentsReference(
+		ObjVertex* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount);
+
+	// Largest per-component difference between two sets of tangents,
+	// where both being NaN counts as a match
+	static float CompareTangents(const ObjVertex* a, const ObjVertex* b, unsigned int vertexCount);
+};
@@ -0,0 +1,260 @@
+// --------------------------------------------------------
+// Tests and benchmark for TangentGenerator
+//
+// - Checks the SSE path against the scalar reference (the
+//   original Mesh::CalculateTangents): bit for bit on one
+//   thread, and within rounding when the triangles are split
+//   across several, including with the triangles shuffled so
+//   every task touches the whole mesh
+// - Checks vertex counts that aren't a multiple of 4, unused
+//   vertices (which stay zero) and triangles with no UV area
+// - Given "bench", also times the reference against the fast
+//   path at several mesh sizes and thread counts
+// - Not part of the Visual Studio project. On Linux it's the
+//   tangent_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 TangentGeneratorTests.cpp
+//       TangentGenerator.cpp -lpthread -o tangent_tests
+// - Usage: tangent_tests [bench]
+// --------------------------------------------------------
+#include "TangentGenerator.h"
+#include "TestChecks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Threads add shared vertices' sums in a different order, so allow for rounding
+	const float maxDifference = 1e-5f;
+
+	struct TestMesh
+	{
+		std::vector<ObjVertex> vertices;
+		std::vector<unsigned int> indices;
+	};
+
+	// --------------------------------------------------------
+	// A bumpy size x size grid of quads, numbered in first use
+	// order like a vertex fetch optimized mesh
+	// --------------------------------------------------------
+	TestMesh MakeGrid(unsigned int size, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+		TestMesh mesh;
+		mesh.vertices.resize((size_t)(size + 1) * (size + 1));
+		for (unsigned int y = 0; y <= size; y++)
+		{
+			for (unsigned int x = 0; x <= size; x++)
+			{
+				ObjVertex& vertex = mesh.vertices[(size_t)y * (size + 1) + x];
+				vertex = {};
+				vertex.Position = ObjFloat3{ x + jitter(random), sinf(x * 0.3f) * cosf(y * 0.2f), y + jitter(random) };
+				ObjFloat3 normal = { jitter(random), 1.0f, jitter(random) };
+				float length = sqrtf(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+				vertex.Normal = ObjFloat3{ normal.x / length, normal.y / length, normal.z / length };
+				vertex.UV = ObjFloat2{ (float)x / size + jitter(random) * 0.01f, (float)y / size };
+			}
+		}
+
+		for (unsigned int y = 0; y < size; y++)
+		{
+			for (unsigned int x = 0; x < size; x++)
+			{
+				unsigned int a = y * (size + 1) + x;
+				unsigned int b = a + 1;
+				unsigned int c = b + size + 1;
+				unsigned int d = a + size + 1;
+				const unsigned int quad[] = { a, c, b, a, d, c };
+				mesh.indices.insert(mesh.indices.end(), quad, quad + 6);
+			}
+		}
+		return mesh;
+	}
+
+	// The same triangles in a random order
+	void ShuffleTriangles(TestMesh& mesh, std::mt19937& random)
+	{
+		unsigned int triangleCount = (unsigned int)mesh.indices.size() / 3;
+		for (unsigned int t = triangleCount - 1; t > 0; t--)
+		{
+			unsigned int other = std::uniform_int_distribution<unsigned int>(0, t)(random);
+			for (unsigned int k = 0; k < 3; k++)
+				std::swap(mesh.indices[t * 3 + k], mesh.indices[other * 3 + k]);
+		}
+	}
+
+	// Runs both on copies of the mesh, returning the largest difference
+	float CompareWithReference(const TestMesh& mesh, unsigned int threadCount, TangentStats& stats)
+	{
+		std::vector<ObjVertex> reference = mesh.vertices;
+		std::vector<ObjVertex> fast = mesh.vertices;
+		TangentGenerator::GenerateTangentsReference(reference.data(), (unsigned int)reference.size(), mesh.indices.data(), (unsigned int)mesh.indices.size());
+		TangentGenerator::GenerateTangents(fast.data(), (unsigned int)fast.size(), mesh.indices.data(), (unsigned int)mesh.indices.size(), threadCount, &stats);
+		return TangentGenerator::CompareTangents(fast.data(), reference.data(), (unsigned int)mesh.vertices.size());
+	}
+
+	// --------------------------------------------------------
+	// On one thread the sums happen in the reference's order,
+	// so every tangent matches exactly, at any size
+	// --------------------------------------------------------
+	void TestOneThreadExact(std::mt19937& random)
+	{
+		const unsigned int sizes[] = { 1, 2, 7, 64, 300 };
+		for (unsigned int size : sizes)
+		{
+			TestMesh mesh = MakeGrid(size, random);
+			TangentStats stats;
+			CHECK(CompareWithReference(mesh, 1, stats) == 0.0f);
+			CHECK(stats.threads == 1);
+
+			ShuffleTriangles(mesh, random);
+			CHECK(CompareWithReference(mesh, 1, stats) == 0.0f);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Split across threads, in first use order and shuffled (so
+	// each task's window of vertices is the whole mesh)
+	// --------------------------------------------------------
+	void TestThreadsMatch(std::mt19937& random)
+	{
+		TestMesh mesh = MakeGrid(300, random);
+		TestMesh shuffled = mesh;
+		ShuffleTriangles(shuffled, random);
+
+		for (unsigned int threadCount : { 2u, 3u, 4u, 8u })
+		{
+			TangentStats stats;
+			float difference = CompareWithReference(mesh, threadCount, stats);
+			CHECK(stats.threads > 1);
+			CHECK(difference <= maxDifference);
+
+			float shuffledDifference = CompareWithReference(shuffled, threadCount, stats);
+			CHECK(shuffledDifference <= maxDifference);
+			printf("  %u threads (%u tasks): %g max difference, %g shuffled\n", threadCount, stats.threads, difference, shuffledDifference);
+		}
+	}
+
+	// --------------------------------------------------------
+	// Results are unit length and at right angles to the normal
+	// --------------------------------------------------------
+	void TestOrthonormal(std::mt19937& random)
+	{
+		TestMesh mesh = MakeGrid(200, random);
+		TangentGenerator::GenerateTangents(mesh.vertices.data(), (unsigned int)mesh.vertices.size(), mesh.indices.data(), (unsigned int)mesh.indices.size(), 4);
+
+		float worstLength = 0.0f;
+		float worstDot = 0.0f;
+		for (const ObjVertex& vertex : mesh.vertices)
+		{
+			const ObjFloat3& t = vertex.Tangent;
+			const ObjFloat3& n = vertex.Normal;
+			float length = fabsf(sqrtf(t.x * t.x + t.y * t.y + t.z * t.z) - 1.0f);
+			float dot = fabsf(t.x * n.x + t.y * n.y + t.z * n.z);
+			worstLength = length > worstLength ? length : worstLength;
+			worstDot = dot > worstDot ? dot : worstDot;
+		}
+		CHECK(worstLength <= 1e-5f);
+		CHECK(worstDot <= 1e-5f);
+	}
+
+	// --------------------------------------------------------
+	// Vertices no triangle uses come out zero (not NaN), and a
+	// triangle with no UV area gives NaN in both versions
+	// --------------------------------------------------------
+	void TestUnusedAndDegenerate(std::mt19937& random)
+	{
+		TestMesh mesh = MakeGrid(4, random);
+		ObjVertex unused = {};
+		unused.Normal = ObjFloat3{ 0, 1, 0 };
+		unused.Tangent = ObjFloat3{ 5, 5, 5 };
+		mesh.vertices.push_back(unused);
+		mesh.vertices.push_back(unused);
+
+		TangentStats stats;
+		CHECK(CompareWithReference(mesh, 1, stats) == 0.0f);
+
+		std::vector<ObjVertex> fast = mesh.vertices;
+		TangentGenerator::GenerateTangents(fast.data(), (unsigned int)fast.size(), mesh.indices.data(), (unsigned int)mesh.indices.size(), 1);
+		const ObjFloat3& tangent = fast.back().Tangent;
+		CHECK(tangent.x == 0.0f && tangent.y == 0.0f && tangent.z == 0.0f);
+
+		// Every UV the same
+		for (ObjVertex& vertex : mesh.vertices)
+			vertex.UV = ObjFloat2{ 0.5f, 0.5f };
+		CHECK(CompareWithReference(mesh, 1, stats) == 0.0f);
+		fast = mesh.vertices;
+		TangentGenerator::GenerateTangents(fast.data(), (unsigned int)fast.size(), mesh.indices.data(), (unsigned int)mesh.indices.size(), 1);
+		CHECK(fast[0].Tangent.x != fast[0].Tangent.x);
+	}
+
+	// --------------------------------------------------------
+	// Milliseconds for the reference and the fast path at
+	// several thread counts, best of several runs each
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		std::mt19937 random(99);
+		unsigned int hardwareThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+		const unsigned int sizes[] = { 32, 100, 316, 1000 };
+		const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+		printf("\nTriangles  Reference  ");
+		for (unsigned int threadCount : threadCounts)
+			printf("%u threads  ", threadCount);
+		printf("(ms)\n");
+
+		for (unsigned int size : sizes)
+		{
+			TestMesh mesh = MakeGrid(size, random);
+			unsigned int vertexCount = (unsigned int)mesh.vertices.size();
+			unsigned int indexCount = (unsigned int)mesh.indices.size();
+			unsigned int runs = 4000000 / indexCount + 3;
+
+			double best = 1e30;
+			for (unsigned int r = 0; r < runs; r++)
+			{
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				TangentGenerator::GenerateTangentsReference(mesh.vertices.data(), vertexCount, mesh.indices.data(), indexCount);
+				double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				best = seconds < best ? seconds : best;
+			}
+			printf("%9u  %9.3f  ", indexCount / 3, best * 1000.0);
+
+			for (unsigned int threadCount : threadCounts)
+			{
+				best = 1e30;
+				for (unsigned int r = 0; r < runs; r++)
+				{
+					TangentStats stats = {};
+					TangentGenerator::GenerateTangents(mesh.vertices.data(), vertexCount, mesh.indices.data(), indexCount, threadCount, &stats);
+					best = stats.seconds < best ? stats.seconds : best;
+				}
+				printf("%9.3f  ", best * 1000.0);
+			}
+			printf("\n");
+		}
+		printf("(%u hardware threads; below 32768 triangles it always runs on one)\n", hardwareThreads);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 random(1234);
+	TestOneThreadExact(random);
+	TestThreadsMatch(random);
+	TestOrthonormal(random);
+	TestUnusedAndDegenerate(random);
+
+	int result = TestChecks::Finish("TangentGenerator");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdio>
+
+// --------------------------------------------------------
+// Bare-bones checks for the standalone test programs
+// (the *Tests.cpp files, built by CMakeLists.txt)
+//
+// - A failed check prints where it was and carries on, so
+//   one run reports every failure
+// - main() returns TestChecks::Finish(), which is non-zero if
+//   anything failed, for ctest
+// --------------------------------------------------------
+namespace TestChecks
+{
+	inline unsigned int& Failures()
+	{
+		static unsigned int failures = 0;
+		return failures;
+	}
+
+	inline unsigned int& Checks()
+	{
+		static unsigned int checks = 0;
+		return checks;
+	}
+
+	inline bool Check(bool passed, const char* expression, const char* file, int line)
+	{
+		Checks()++;
+		if (!passed)
+		{
+			Failures()++;
+			printf("%s(%d): check failed: %s\n", file, line, expression);
+		}
+		return passed;
+	}
+
+	inline int Finish(const char* name)
+	{
+		printf("%s: %u checks, %u failed\n", name, Checks(), Failures());
+		return Failures() == 0 ? 0 : 1;
+	}
+}
+
+#define CHECK(expression) TestChecks::Check((expression), #expression, __FILE__, __LINE__)
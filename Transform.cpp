@@ -1,64 +1,91 @@
 #include "Transform.h"
 
+#include <cmath>
+
 using namespace DirectX;
 
 Transform::Transform() :
 	position(0.0f, 0.0f, 0.0f),
-	rotation(0.0f, 0.0f, 0.0f),
 	scale(1.0f, 1.0f, 1.0f),
+	rotation(0.0f, 0.0f, 0.0f, 1.0f),
+	pitchYawRoll(0.0f, 0.0f, 0.0f),
+	dirtyMatrices(false),
+	dirtyVectors(false),
 	rightVec(1.0f, 0.0f, 0.0f),
 	upVec(0.0f, 1.0f, 0.0f),
 	forwardVec(0.0f, 0.0f, 1.0f),
-	dirtyMatrices(false),
-	dirtyVectors(false)
+	slot(TransformSystem::InvalidSlot)
 {
 	// Initialize matrices
-	XMStoreFloat4x4(&worldMatrix, XMMatrixIdentity());
-	XMStoreFloat4x4(&worldInvTransMatrix, XMMatrixIdentity());
+	worldMatrix = AffineMatrix::Compose(position, rotation, scale);
+	worldInvTransMatrix = AffineMatrix::ComposeInverseTranspose(rotation, scale);
+}
+
+Transform::Transform(std::shared_ptr<TransformSystem> system) : Transform()
+{
+	// Take a slot in the system, which starts as the identity
+	if (system)
+	{
+		this->system = system;
+		slot = system->Add();
+	}
+}
+
+Transform::Transform(const Transform& other) : Transform(other.system)
+{
+	*this = other;
+}
+
+Transform& Transform::operator=(const Transform& other)
+{
+	// Copy the state, but keep our own slot (if any)
+	if (this != &other)
+	{
+		SetPosition(other.GetPosition());
+		SetScale(other.GetScale());
+
+		// Copy both rotations as is, rather than converting again
+		rotation = other.rotation;
+		pitchYawRoll = other.pitchYawRoll;
+		CommitRotation();
+	}
+	return *this;
 }
 
 Transform::~Transform()
 {
+	// Give the slot back to the system
+	if (system)
+		system->Remove(slot);
 }
 
 void Transform::Rotate(float pitch, float yaw, float roll)
 {
 	// Add the rotation components to the current rotation
-	rotation.x += pitch;
-	rotation.y += yaw;
-	rotation.z += roll;
-
-	// Notify dirty matrices and vectors
-	dirtyMatrices = true;
-	dirtyVectors = true;
+	XMFLOAT3 rotation = GetPitchYawRoll();
+	SetRotation(rotation.x + pitch, rotation.y + yaw, rotation.z + roll);
 }
 
 void Transform::Rotate(DirectX::XMFLOAT3 pyrRotation)
 {
-	// Add the rotation components to the current rotation
-	this->rotation.x += pyrRotation.x;
-	this->rotation.y += pyrRotation.y;
-	this->rotation.z += pyrRotation.z;
-
-	// Notify dirty matrices and vectors
-	dirtyMatrices = true;
-	dirtyVectors = true;
+	// Call the base function using the components of the XMFLOAT3
+	Rotate(pyrRotation.x, pyrRotation.y, pyrRotation.z);
 }
 
 void Transform::SetPosition(float x, float y, float z)
 {
-	// Set the position
-	position.x = x;
-	position.y = y;
-	position.z = z;
-
-	// Notify dirty matrices
-	dirtyMatrices = true;
+	// Call the base function using an XMFLOAT3
+	SetPosition(XMFLOAT3(x, y, z));
 }
 
 void Transform::SetPosition(DirectX::XMFLOAT3 position)
 {
-	// Set the position
+	// Set the position (the system tracks its own dirty matrices)
+	if (system)
+	{
+		system->SetPosition(slot, position);
+		return;
+	}
 	this->position = position;
 
 	// Notify dirty matrices
@@ -67,20 +94,42 @@ void Transform::SetPosition(DirectX::XMFLOAT3 position)
 
 void Transform::SetRotation(float pitch, float yaw, float roll)
 {
-	// Set the rotation
-	rotation.x = pitch;
-	rotation.y = yaw;
-	rotation.z = roll;
-
-	// Notify dirty matrices and vectors
-	dirtyMatrices = true;
-	dirtyVectors = true;
+	// Call the base function using an XMFLOAT3
+	SetRotation(XMFLOAT3(pitch, yaw, roll));
 }
 
 void Transform::SetRotation(DirectX::XMFLOAT3 rotation)
 {
-	// Set the rotation
-	this->rotation = rotation;
+	// Keep the angles, and convert them to a quaternion once here
+	pitchYawRoll = rotation;
+	XMStoreFloat4(&this->rotation, XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation)));
+	CommitRotation();
+}
+
+void Transform::SetRotation(DirectX::XMFLOAT4 quaternion)
+{
+	// Keep the quaternion normalized
+	XMVECTOR rotQuat = XMQuaternionNormalize(XMLoadFloat4(&quaternion));
+	XMStoreFloat4(&rotation, rotQuat);
+
+	// Derive the angles, from the rotated forward and the right and up
+	// rows (the rotation is roll, then pitch, then yaw)
+	XMFLOAT4X4 rot;
+	XMStoreFloat4x4(&rot, XMMatrixRotationQuaternion(rotQuat));
+	float sinPitch = -rot._32;
+	sinPitch = sinPitch > 1.0f ? 1.0f : (sinPitch < -1.0f ? -1.0f : sinPitch);
+	pitchYawRoll.x = asinf(sinPitch);
+	pitchYawRoll.y = atan2f(rot._31, rot._33);
+	pitchYawRoll.z = atan2f(rot._12, rot._22);
+
+	CommitRotation();
+}
+
+void Transform::CommitRotation()
+{
+	// Hand the quaternion to the system (it tracks its own dirty matrices)
+	if (system)
+		system->SetRotation(slot, rotation);
 
 	// Notify dirty matrices and vectors
 	dirtyMatrices = true;
@@ -89,49 +138,95 @@ void Transform::SetRotation(DirectX::XMFLOAT3 rotation)
 
 void Transform::SetScale(float x, float y, float z)
 {
-	// Set the scale
-	scale.x = x;
-	scale.y = y;
-	scale.z = z;
-
-	// Notify dirty matrices
-	dirtyMatrices = true;
+	// Call the base function using an XMFLOAT3
+	SetScale(XMFLOAT3(x, y, z));
 }
 
 void Transform::SetScale(DirectX::XMFLOAT3 scale)
 {
-	// Set the scale
+	// Set the scale (the system tracks its own dirty matrices)
+	if (system)
+	{
+		system->SetScale(slot, scale);
+		return;
+	}
 	this->scale = scale;
 
 	// Notify dirty matrices
 	dirtyMatrices = true;
 }
 
+bool Transform::SetParent(const Transform* parent)
+{
+	// Only transforms stored together can be parented
+	if (!system || (parent && parent->system != system))
+		return false;
+
+	return system->SetParent(slot, parent ? parent->slot : TransformSystem::InvalidSlot);
+}
+
 DirectX::XMFLOAT3 Transform::GetPosition() const
 {
-	return position;
+	return system ? system->GetPosition(slot) : position;
 }
 
 DirectX::XMFLOAT3 Transform::GetPitchYawRoll() const
+{
+	return pitchYawRoll;
+}
+
+DirectX::XMFLOAT4 Transform::GetRotation() const
 {
 	return rotation;
 }
 
 DirectX::XMFLOAT3 Transform::GetScale() const
 {
-	return scale;
+	return system ? system->GetScale(slot) : scale;
 }
 
 DirectX::XMFLOAT4X4 Transform::GetWorldMatrix()
 {
+	// The system rebuilds its matrices in batches
+	if (system)
+		return system->GetWorldMatrix(slot);
+
 	// Update the matrices
 	UpdateMatrices();
 
-	return worldMatrix;
+	return worldMatrix.ToMatrix();
 }
 
 DirectX::XMFLOAT4X4 Transform::GetWorldInverseTransposeMatrix()
 {
+	// The system rebuilds its matrices in batches
+	if (system)
+		return system->GetWorldInverseTransposeMatrix(slot);
+
+	// Update the matrices
+	UpdateMatrices();
+
+	return worldInvTransMatrix.ToMatrix();
+}
+
+AffineMatrix Transform::GetWorldAffine()
+{
+	// The system keeps full 4x4s, which only need their 4th columns dropped
+	if (system)
+		return AffineMatrix::FromMatrix(system->GetWorldMatrix(slot));
+
+	// Update the matrices
+	UpdateMatrices();
+
+	return worldMatrix;
+}
+
+AffineMatrix Transform::GetWorldInverseTransposeAffine()
+{
+	// The system keeps full 4x4s, which only need their 4th columns dropped
+	if (system)
+		return AffineMatrix::FromMatrix(system->GetWorldInverseTransposeMatrix(slot));
+
 	// Update the matrices
 	UpdateMatrices();
 
@@ -164,21 +259,14 @@ DirectX::XMFLOAT3 Transform::GetForward()
 
 void Transform::UpdateMatrices()
 {
-	// If there are no dirty matrices, return
-	if (!dirtyMatrices)
+	// If there are no dirty matrices, or the system owns them, return
+	if (!dirtyMatrices || system)
 		return;
 
-	// Create the transformation matrices
-	XMMATRIX trans = XMMatrixTranslationFromVector(XMLoadFloat3(&position));
-	XMMATRIX rot = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
-	XMMATRIX sc = XMMatrixScalingFromVector(XMLoadFloat3(&scale));
-
-	// Create the world matrix
-	XMMATRIX world = sc * rot * trans;
-
-	// Store the matrices
-	XMStoreFloat4x4(&worldMatrix, world);
-	XMStoreFloat4x4(&worldInvTransMatrix, XMMatrixInverse(0, XMMatrixTranspose(world)));
+	// Build both matrices straight from the components, as the
+	// world matrix is always scale * rotation * translation
+	worldMatrix = AffineMatrix::Compose(position, rotation, scale);
+	worldInvTransMatrix = AffineMatrix::ComposeInverseTranspose(rotation, scale);
 
 	// Clean the matrices
 	dirtyMatrices = false;
@@ -190,11 +278,11 @@ void Transform::UpdateVectors()
 	if (!dirtyVectors)
 		return;
 
-	// Update all vectors
-	XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
-	XMStoreFloat3(&rightVec, XMVector3Rotate(XMVectorSet(1, 0, 0, 0), rotQuat));
-	XMStoreFloat3(&upVec, XMVector3Rotate(XMVectorSet(0, 1, 0, 0), rotQuat));
-	XMStoreFloat3(&forwardVec, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rotQuat));
+	// Update all vectors, which are the rows of the rotation matrix
+	XMMATRIX rot = XMMatrixRotationQuaternion(XMLoadFloat4(&rotation));
+	XMStoreFloat3(&rightVec, rot.r[0]);
+	XMStoreFloat3(&upVec, rot.r[1]);
+	XMStoreFloat3(&forwardVec, rot.r[2]);
 
 	// Clean the vectors
 	dirtyVectors = false;
@@ -205,20 +293,16 @@ void Transform::MoveRelative(float x, float y, float z)
 	// Create the movement vector
 	XMVECTOR directionVec = XMVectorSet(x, y, z, 0);
 
-	// Represent the transform's rotation using a quaternion
-	XMVECTOR currentRotQuat = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
-
 	// Rotate to the given direction
-	XMVECTOR directedRot = XMVector3Rotate(directionVec, currentRotQuat);
+	XMVECTOR directedRot = XMVector3Rotate(directionVec, XMLoadFloat4(&rotation));
 
 	// Load the existing position and add it to the new directoin
+	XMFLOAT3 position = GetPosition();
 	XMVECTOR finalPos = XMVectorAdd(XMLoadFloat3(&position), directedRot);
 
 	// Store the new position
 	XMStoreFloat3(&position, finalPos);
-	
-	// Notify dirty matrices
-	dirtyMatrices = true;
+	SetPosition(position);
 }
 
 void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
@@ -229,11 +313,8 @@ void Transform::MoveRelative(DirectX::XMFLOAT3 offset)
 
 void Transform::MoveAbsolute(float x, float y, float z)
 {
-	position.x += x;
-	position.y += y;
-	position.z += z;
-
-	dirtyMatrices = true;
+	XMFLOAT3 position = GetPosition();
+	SetPosition(position.x + x, position.y + y, position.z + z);
 }
 
 void Transform::MoveAbsolute(DirectX::XMFLOAT3 offset)
@@ -1,18 +1,29 @@
 #pragma once
 #include <DirectXMath.h>
+#include <memory>
+
+#include "AffineMatrix.h"
+#include "TransformSystem.h"
 
 class Transform
 {
 private:
 	// Transform variables
 	DirectX::XMFLOAT3 position;
-	DirectX::XMFLOAT3 rotation;
 	DirectX::XMFLOAT3 scale;
 
-	// Matrix variables
+	// Rotation
+	// - rotation is a normalized quaternion, and the vectors, matrices
+	//   and relative moves all come from it without redoing any trig
+	// - pitchYawRoll is only kept for the UI and angle based input, and
+	//   is the angles last set (or derived from the last quaternion set)
+	DirectX::XMFLOAT4 rotation;
+	DirectX::XMFLOAT3 pitchYawRoll;
+
+	// Matrix variables (see AffineMatrix.h)
 	bool dirtyMatrices;
-	DirectX::XMFLOAT4X4 worldMatrix;
-	DirectX::XMFLOAT4X4 worldInvTransMatrix;
+	AffineMatrix worldMatrix;
+	AffineMatrix worldInvTransMatrix;
 
 	// Vector variables
 	bool dirtyVectors;
@@ -20,9 +31,18 @@ private:
 	DirectX::XMFLOAT3 upVec;
 	DirectX::XMFLOAT3 forwardVec;
 
+	// Batched storage (see TransformSystem.h)
+	// - When set, position/rotation/scale and the matrices live in the
+	//   system's slot instead of the variables above
+	std::shared_ptr<TransformSystem> system;
+	unsigned int slot;
+
 public:
 	// Constructor/Destructor
 	Transform();
+	explicit Transform(std::shared_ptr<TransformSystem> system);
+	Transform(const Transform& other);
+	Transform& operator=(const Transform& other);
 	~Transform();
 
 	//
@@ -34,15 +54,23 @@ public:
 	void SetPosition(DirectX::XMFLOAT3 posiiton);
 	void SetRotation(float pitch, float yaw, float roll);
 	void SetRotation(DirectX::XMFLOAT3 rotation);
+	void SetRotation(DirectX::XMFLOAT4 quaternion);
 	void SetScale(float x, float y, float z);
 	void SetScale(DirectX::XMFLOAT3 scale);
 
+	// Attaches to another transform in the same TransformSystem, or detaches
+	// for nullptr. Position, rotation and scale are then relative to the parent
+	bool SetParent(const Transform* parent);
+
 	// Getters
 	DirectX::XMFLOAT3 GetPosition() const;
 	DirectX::XMFLOAT3 GetPitchYawRoll() const;
+	DirectX::XMFLOAT4 GetRotation() const;
 	DirectX::XMFLOAT3 GetScale() const;
 	DirectX::XMFLOAT4X4 GetWorldMatrix();
 	DirectX::XMFLOAT4X4 GetWorldInverseTransposeMatrix();
+	AffineMatrix GetWorldAffine();
+	AffineMatrix GetWorldInverseTransposeAffine();
 	DirectX::XMFLOAT3 GetRight();
 	DirectX::XMFLOAT3 GetUp();
 	DirectX::XMFLOAT3 GetForward();
@@ -54,4 +82,7 @@ public:
 	void MoveRelative(DirectX::XMFLOAT3 offset);
 	void MoveAbsolute(float x, float y, float z);
 	void MoveAbsolute(DirectX::XMFLOAT3 offset);
+
+private:
+	void CommitRotation();
 };
\ No newline at end of file
@@ -0,0 +1,847 @@
+#include "TransformSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <emmintrin.h>
+#include <thread>
+
+using namespace DirectX;
+
+namespace
+{
+	// Smaller batches aren't worth the cost of a thread
+	const unsigned int minSlotsPerTask = 1 << 12;
+
+	// --------------------------------------------------------
+	// Runs work(i) for i in [0, count) across up to threadCount
+	// threads, or inline when there's only one thread
+	// --------------------------------------------------------
+	template<typename Work>
+	void RunParallel(unsigned int count, unsigned int threadCount, Work work)
+	{
+		if (threadCount <= 1 || count <= 1)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				work(i);
+			return;
+		}
+
+		unsigned int workerCount = threadCount < count ? threadCount : count;
+		std::vector<std::thread> workers;
+		workers.reserve(workerCount);
+		for (unsigned int t = 0; t < workerCount; t++)
+		{
+			workers.emplace_back([=]()
+				{
+					for (unsigned int i = t; i < count; i += workerCount)
+						work(i);
+				});
+		}
+
+		for (std::thread& worker : workers)
+			worker.join();
+	}
+
+	// Splits count items into taskCount contiguous ranges
+	inline unsigned int GetRangeStart(unsigned int count, unsigned int taskCount, unsigned int task)
+	{
+		return (unsigned int)((unsigned long long)count * task / taskCount);
+	}
+
+	XMFLOAT4X4 IdentityMatrix()
+	{
+		XMFLOAT4X4 m = {};
+		m.m[0][0] = 1.0f;
+		m.m[1][1] = 1.0f;
+		m.m[2][2] = 1.0f;
+		m.m[3][3] = 1.0f;
+		return m;
+	}
+
+	// Returns local * parent, which applies local first
+	inline void Multiply(XMFLOAT4X4& local, const XMFLOAT4X4& parent)
+	{
+		__m128 parentRows[4] = { _mm_loadu_ps(parent.m[0]), _mm_loadu_ps(parent.m[1]), _mm_loadu_ps(parent.m[2]), _mm_loadu_ps(parent.m[3]) };
+		for (unsigned int r = 0; r < 4; r++)
+		{
+			__m128 row = _mm_mul_ps(_mm_set1_ps(local.m[r][0]), parentRows[0]);
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(local.m[r][1]), parentRows[1]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(local.m[r][2]), parentRows[2]));
+			row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(local.m[r][3]), parentRows[3]));
+			_mm_storeu_ps(local.m[r], row);
+		}
+	}
+
+	// Blends 4 lanes of a component from its previous to its current value
+	inline __m128 LoadBlended(const std::vector<float>& previous, const std::vector<float>& current, unsigned int base, __m128 alpha)
+	{
+		__m128 from = _mm_loadu_ps(&previous[base]);
+		return _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&current[base]), from), alpha));
+	}
+
+	// Puts values into the given order of entries, leaving any padding alone
+	template<typename T>
+	void Reorder(std::vector<T>& values, const std::vector<unsigned int>& order, std::vector<T>& scratch)
+	{
+		scratch = values;
+		for (unsigned int entry = 0; entry < order.size(); entry++)
+			values[entry] = scratch[order[entry]];
+	}
+
+	// Transposes one row held across 4 lanes into that row of 4 matrices
+	inline void StoreRow(XMFLOAT4X4* matrices, unsigned int row, __m128 x, __m128 y, __m128 z, __m128 w)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(matrices[0].m[row], x);
+		_mm_storeu_ps(matrices[1].m[row], y);
+		_mm_storeu_ps(matrices[2].m[row], z);
+		_mm_storeu_ps(matrices[3].m[row], w);
+	}
+}
+
+TransformSystem::TransformSystem(std::shared_ptr<JobSystem> jobSystem)
+	: count(0), childCount(0), interpolation(1.0f), stats(), jobSystem(jobSystem)
+{
+}
+
+unsigned int TransformSystem::Add()
+{
+	// A freed slot is always a childless root, so it can be reused where it is
+	if (!freeSlots.empty())
+	{
+		unsigned int slot = freeSlots.back();
+		freeSlots.pop_back();
+		ResetEntry(slotEntries[slot]);
+		return slot;
+	}
+
+	// Grow a whole group at a time, so the padding lanes are valid identities
+	if (count % 4 == 0)
+	{
+		unsigned int padded = count + 4;
+		entrySlots.resize(padded, InvalidSlot);
+		parents.resize(padded, InvalidSlot);
+		subtreeEnds.resize(padded, 0);
+		positionX.resize(padded, 0.0f);
+		positionY.resize(padded, 0.0f);
+		positionZ.resize(padded, 0.0f);
+		rotationX.resize(padded, 0.0f);
+		rotationY.resize(padded, 0.0f);
+		rotationZ.resize(padded, 0.0f);
+		rotationW.resize(padded, 1.0f);
+		scaleX.resize(padded, 1.0f);
+		scaleY.resize(padded, 1.0f);
+		scaleZ.resize(padded, 1.0f);
+		previousPositionX.resize(padded, 0.0f);
+		previousPositionY.resize(padded, 0.0f);
+		previousPositionZ.resize(padded, 0.0f);
+		previousRotationX.resize(padded, 0.0f);
+		previousRotationY.resize(padded, 0.0f);
+		previousRotationZ.resize(padded, 0.0f);
+		previousRotationW.resize(padded, 1.0f);
+		previousScaleX.resize(padded, 1.0f);
+		previousScaleY.resize(padded, 1.0f);
+		previousScaleZ.resize(padded, 1.0f);
+		worldMatrices.resize(padded, IdentityMatrix());
+		worldInvTransMatrices.resize(padded, IdentityMatrix());
+		dirtyBits.resize((padded + 63) / 64, 0);
+		composeBits.resize(dirtyBits.size(), 0);
+		blendBits.resize(dirtyBits.size(), 0);
+	}
+
+	// New roots go at the end, which keeps the order depth-first
+	unsigned int slot = (unsigned int)slotEntries.size();
+	unsigned int entry = count++;
+	slotEntries.push_back(entry);
+	parentSlots.push_back(InvalidSlot);
+	childCounts.push_back(0);
+	entrySlots[entry] = slot;
+	parents[entry] = InvalidSlot;
+	subtreeEnds[entry] = entry + 1;
+	ResetEntry(entry);
+	return slot;
+}
+
+// --------------------------------------------------------
+// Frees a slot for reuse
+//
+// - Its children become roots, and it's left as a childless
+//   identity root, so the batch stays valid
+// --------------------------------------------------------
+void TransformSystem::Remove(unsigned int slot)
+{
+	if (slot >= slotEntries.size())
+		return;
+
+	for (unsigned int child = 0; childCounts[slot] > 0 && child < parentSlots.size(); child++)
+	{
+		if (parentSlots[child] == slot)
+			SetParent(child, InvalidSlot);
+	}
+	SetParent(slot, InvalidSlot);
+
+	ResetEntry(slotEntries[slot]);
+	freeSlots.push_back(slot);
+}
+
+void TransformSystem::Reserve(unsigned int reserveCount)
+{
+	unsigned int padded = (reserveCount + 3) & ~3u;
+	slotEntries.reserve(padded);
+	parentSlots.reserve(padded);
+	childCounts.reserve(padded);
+	entrySlots.reserve(padded);
+	parents.reserve(padded);
+	subtreeEnds.reserve(padded);
+	positionX.reserve(padded);
+	positionY.reserve(padded);
+	positionZ.reserve(padded);
+	rotationX.reserve(padded);
+	rotationY.reserve(padded);
+	rotationZ.reserve(padded);
+	rotationW.reserve(padded);
+	scaleX.reserve(padded);
+	scaleY.reserve(padded);
+	scaleZ.reserve(padded);
+	previousPositionX.reserve(padded);
+	previousPositionY.reserve(padded);
+	previousPositionZ.reserve(padded);
+	previousRotationX.reserve(padded);
+	previousRotationY.reserve(padded);
+	previousRotationZ.reserve(padded);
+	previousRotationW.reserve(padded);
+	previousScaleX.reserve(padded);
+	previousScaleY.reserve(padded);
+	previousScaleZ.reserve(padded);
+	worldMatrices.reserve(padded);
+	worldInvTransMatrices.reserve(padded);
+	dirtyBits.reserve((padded + 63) / 64);
+	composeBits.reserve((padded + 63) / 64);
+	blendBits.reserve((padded + 63) / 64);
+}
+
+unsigned int TransformSystem::GetCount() const
+{
+	return this->count - (unsigned int)this->freeSlots.size();
+}
+
+// --------------------------------------------------------
+// Attaches a slot to a new parent
+//
+// - Walking up from the new parent finds the slot if it would
+//   become its own ancestor (only needed if it has children)
+// - The entries are re-sorted by the next Update()
+// --------------------------------------------------------
+bool TransformSystem::SetParent(unsigned int slot, unsigned int parent)
+{
+	if (slot >= slotEntries.size() || (parent != InvalidSlot && parent >= slotEntries.size()))
+		return false;
+
+	// A slot without children can only be its own ancestor by being the parent
+	if (parent == slot)
+		return false;
+	if (childCounts[slot] > 0)
+	{
+		for (unsigned int ancestor = parent; ancestor != InvalidSlot; ancestor = parentSlots[ancestor])
+		{
+			if (ancestor == slot)
+				return false;
+		}
+	}
+
+	if (parentSlots[slot] != parent)
+	{
+		if (parentSlots[slot] != InvalidSlot)
+			childCounts[parentSlots[slot]]--;
+		if (parent != InvalidSlot)
+			childCounts[parent]++;
+
+		parentSlots[slot] = parent;
+		reparentedSlots.push_back(slot);
+	}
+	return true;
+}
+
+unsigned int TransformSystem::GetParent(unsigned int slot) const
+{
+	return this->parentSlots[slot];
+}
+
+void TransformSystem::SetPosition(unsigned int slot, DirectX::XMFLOAT3 position)
+{
+	unsigned int entry = slotEntries[slot];
+	positionX[entry] = position.x;
+	positionY[entry] = position.y;
+	positionZ[entry] = position.z;
+	MarkMoved(entry);
+}
+
+void TransformSystem::SetRotation(unsigned int slot, DirectX::XMFLOAT4 rotation)
+{
+	unsigned int entry = slotEntries[slot];
+	rotationX[entry] = rotation.x;
+	rotationY[entry] = rotation.y;
+	rotationZ[entry] = rotation.z;
+	rotationW[entry] = rotation.w;
+	MarkMoved(entry);
+}
+
+void TransformSystem::SetScale(unsigned int slot, DirectX::XMFLOAT3 scale)
+{
+	unsigned int entry = slotEntries[slot];
+	scaleX[entry] = scale.x;
+	scaleY[entry] = scale.y;
+	scaleZ[entry] = scale.z;
+	MarkMoved(entry);
+}
+
+DirectX::XMFLOAT3 TransformSystem::GetPosition(unsigned int slot) const
+{
+	unsigned int entry = slotEntries[slot];
+	return XMFLOAT3(positionX[entry], positionY[entry], positionZ[entry]);
+}
+
+DirectX::XMFLOAT4 TransformSystem::GetRotation(unsigned int slot) const
+{
+	unsigned int entry = slotEntries[slot];
+	return XMFLOAT4(rotationX[entry], rotationY[entry], rotationZ[entry], rotationW[entry]);
+}
+
+DirectX::XMFLOAT3 TransformSystem::GetScale(unsigned int slot) const
+{
+	unsigned int entry = slotEntries[slot];
+	return XMFLOAT3(scaleX[entry], scaleY[entry], scaleZ[entry]);
+}
+
+const DirectX::XMFLOAT4X4& TransformSystem::GetWorldMatrix(unsigned int slot)
+{
+	if (IsStale(slotEntries[slot]))
+		Update(1);
+
+	return this->worldMatrices[slotEntries[slot]];
+}
+
+const DirectX::XMFLOAT4X4& TransformSystem::GetWorldInverseTransposeMatrix(unsigned int slot)
+{
+	if (IsStale(slotEntries[slot]))
+		Update(1);
+
+	return this->worldInvTransMatrices[slotEntries[slot]];
+}
+
+// --------------------------------------------------------
+// Rebuilds the dirty matrices
+//
+// - The dirty words are split into contiguous ranges, so
+//   each thread writes its own part of the matrix arrays
+// - Composing with parents runs on this thread afterwards,
+//   as a child may be in another thread's range
+// --------------------------------------------------------
+void TransformSystem::Update(unsigned int threadCount)
+{
+	PROFILE_ZONE("TransformSystem::Update");
+
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	if (threadCount == 0)
+		threadCount = jobSystem ? jobSystem->GetThreadCount() :
+			(std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1);
+
+	if (!reparentedSlots.empty())
+		SortEntries();
+
+	// Children of anything dirty need new world matrices too,
+	// and need to remember that once the local rebuild clears their bits.
+	// Groups are rebuilt whole, so a clean entry sharing a group with a
+	// dirty one needs composing again as well
+	if (childCount > 0)
+	{
+		PropagateDirty();
+		for (unsigned int word = 0; word < dirtyBits.size(); word++)
+		{
+			unsigned long long bits = dirtyBits[word];
+			unsigned long long groups = (bits | (bits >> 1) | (bits >> 2) | (bits >> 3)) & 0x1111111111111111ull;
+			composeBits[word] = groups * 0xF;
+		}
+	}
+
+	unsigned int rebuilt = 0;
+	for (unsigned long long bits : dirtyBits)
+		rebuilt += (unsigned int)std::popcount(bits);
+
+	unsigned int taskCount = count / minSlotsPerTask;
+	if (taskCount > threadCount)
+		taskCount = threadCount;
+	if (taskCount < 1)
+		taskCount = 1;
+
+	unsigned int composed = 0;
+	if (rebuilt > 0)
+	{
+		unsigned int wordCount = (unsigned int)dirtyBits.size();
+		if (jobSystem && taskCount > 1)
+		{
+			jobSystem->ParallelFor(wordCount, minSlotsPerTask / 64, [&](unsigned int firstWord, unsigned int endWord)
+				{
+					RebuildWords(firstWord, endWord);
+				});
+		}
+		else
+		{
+			RunParallel(taskCount, taskCount, [&](unsigned int task)
+				{
+					RebuildWords(
+						GetRangeStart(wordCount, taskCount, task),
+						GetRangeStart(wordCount, taskCount, task + 1));
+				});
+		}
+
+		if (childCount > 0)
+			composed = ComposeChildren();
+	}
+
+	stats = {};
+	stats.threads = taskCount;
+	stats.transforms = GetCount();
+	stats.rebuilt = rebuilt;
+	stats.composed = composed;
+	stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+TransformSystemStats TransformSystem::GetStats() const
+{
+	return this->stats;
+}
+
+// --------------------------------------------------------
+// Starts a simulation tick
+//
+// - Only entries set during the last tick can differ from
+//   their previous state, so only they're copied
+// - Their matrices were built part way between the two, so
+//   they're dirtied to catch up with the current state
+// --------------------------------------------------------
+void TransformSystem::BeginTick()
+{
+	for (unsigned int word = 0; word < blendBits.size(); word++)
+	{
+		unsigned long long bits = blendBits[word];
+		if (bits == 0)
+			continue;
+
+		if (interpolation < 1.0f)
+			dirtyBits[word] |= bits;
+
+		while (bits)
+		{
+			unsigned int entry = word * 64 + (unsigned int)std::countr_zero(bits);
+			bits &= bits - 1;
+
+			previousPositionX[entry] = positionX[entry];
+			previousPositionY[entry] = positionY[entry];
+			previousPositionZ[entry] = positionZ[entry];
+			previousRotationX[entry] = rotationX[entry];
+			previousRotationY[entry] = rotationY[entry];
+			previousRotationZ[entry] = rotationZ[entry];
+			previousRotationW[entry] = rotationW[entry];
+			previousScaleX[entry] = scaleX[entry];
+			previousScaleY[entry] = scaleY[entry];
+			previousScaleZ[entry] = scaleZ[entry];
+		}
+		blendBits[word] = 0;
+	}
+}
+
+// A new alpha only changes the matrices of entries still blending
+void TransformSystem::SetInterpolation(float alpha)
+{
+	alpha = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+	if (alpha == interpolation)
+		return;
+
+	for (unsigned int word = 0; word < blendBits.size(); word++)
+		dirtyBits[word] |= blendBits[word];
+	interpolation = alpha;
+}
+
+float TransformSystem::GetInterpolation() const
+{
+	return this->interpolation;
+}
+
+bool TransformSystem::IsDirty(unsigned int entry) const
+{
+	return (dirtyBits[entry / 64] & (1ull << (entry % 64))) != 0;
+}
+
+// An entry's world matrix is stale if it or any ancestor is dirty, or it may have moved
+bool TransformSystem::IsStale(unsigned int entry) const
+{
+	if (!reparentedSlots.empty())
+		return true;
+
+	for (; entry != InvalidSlot; entry = parents[entry])
+	{
+		if (IsDirty(entry))
+			return true;
+	}
+	return false;
+}
+
+void TransformSystem::MarkDirty(unsigned int entry)
+{
+	dirtyBits[entry / 64] |= 1ull << (entry % 64);
+}
+
+// Dirties an entry whose state was set, and notes that it now differs from its previous state
+void TransformSystem::MarkMoved(unsigned int entry)
+{
+	dirtyBits[entry / 64] |= 1ull << (entry % 64);
+	blendBits[entry / 64] |= 1ull << (entry % 64);
+}
+
+// Marks [firstEntry, endEntry) dirty, a word at a time
+void TransformSystem::MarkDirty(unsigned int firstEntry, unsigned int endEntry)
+{
+	while (firstEntry < endEntry)
+	{
+		unsigned int bit = firstEntry % 64;
+		unsigned int bits = endEntry - firstEntry < 64 - bit ? endEntry - firstEntry : 64 - bit;
+		unsigned long long mask = bits == 64 ? ~0ull : ((1ull << bits) - 1) << bit;
+		dirtyBits[firstEntry / 64] |= mask;
+		firstEntry += bits;
+	}
+}
+
+void TransformSystem::ResetEntry(unsigned int entry)
+{
+	positionX[entry] = positionY[entry] = positionZ[entry] = 0.0f;
+	rotationX[entry] = rotationY[entry] = rotationZ[entry] = 0.0f;
+	rotationW[entry] = 1.0f;
+	scaleX[entry] = scaleY[entry] = scaleZ[entry] = 1.0f;
+
+	// A reused entry mustn't blend from whatever was there before
+	previousPositionX[entry] = previousPositionY[entry] = previousPositionZ[entry] = 0.0f;
+	previousRotationX[entry] = previousRotationY[entry] = previousRotationZ[entry] = 0.0f;
+	previousRotationW[entry] = 1.0f;
+	previousScaleX[entry] = previousScaleY[entry] = previousScaleZ[entry] = 1.0f;
+	blendBits[entry / 64] &= ~(1ull << (entry % 64));
+	MarkDirty(entry);
+}
+
+// --------------------------------------------------------
+// Puts the entries back into depth-first order
+//
+// - Children are listed in their current entry order, so the
+//   sort is stable and untouched subtrees keep their layout
+// - The walk follows first child / next sibling links up and
+//   down the tree, so it needs no stack
+// - Dirty bits move with their entries, and each reparented
+//   slot is dirtied so its subtree picks up the new parent
+// --------------------------------------------------------
+void TransformSystem::SortEntries()
+{
+	unsigned int slotCount = (unsigned int)slotEntries.size();
+	std::vector<unsigned int> firstChild(slotCount, InvalidSlot);
+	std::vector<unsigned int> lastChild(slotCount, InvalidSlot);
+	std::vector<unsigned int> nextSibling(slotCount, InvalidSlot);
+	std::vector<unsigned int> roots;
+	for (unsigned int entry = 0; entry < count; entry++)
+	{
+		unsigned int slot = entrySlots[entry];
+		unsigned int parent = parentSlots[slot];
+		if (parent == InvalidSlot)
+		{
+			roots.push_back(slot);
+			continue;
+		}
+
+		if (lastChild[parent] == InvalidSlot)
+			firstChild[parent] = slot;
+		else
+			nextSibling[lastChild[parent]] = slot;
+		lastChild[parent] = slot;
+	}
+
+	// The old entry of each slot, in the new order
+	std::vector<unsigned int> order;
+	order.reserve(count);
+	for (unsigned int root : roots)
+	{
+		unsigned int slot = root;
+		while (true)
+		{
+			order.push_back(slotEntries[slot]);
+			if (firstChild[slot] != InvalidSlot)
+			{
+				slot = firstChild[slot];
+				continue;
+			}
+
+			while (slot != root && nextSibling[slot] == InvalidSlot)
+				slot = parentSlots[slot];
+			if (slot == root)
+				break;
+			slot = nextSibling[slot];
+		}
+	}
+
+	std::vector<float> floatScratch;
+	Reorder(positionX, order, floatScratch);
+	Reorder(positionY, order, floatScratch);
+	Reorder(positionZ, order, floatScratch);
+	Reorder(rotationX, order, floatScratch);
+	Reorder(rotationY, order, floatScratch);
+	Reorder(rotationZ, order, floatScratch);
+	Reorder(rotationW, order, floatScratch);
+	Reorder(scaleX, order, floatScratch);
+	Reorder(scaleY, order, floatScratch);
+	Reorder(scaleZ, order, floatScratch);
+	Reorder(previousPositionX, order, floatScratch);
+	Reorder(previousPositionY, order, floatScratch);
+	Reorder(previousPositionZ, order, floatScratch);
+	Reorder(previousRotationX, order, floatScratch);
+	Reorder(previousRotationY, order, floatScratch);
+	Reorder(previousRotationZ, order, floatScratch);
+	Reorder(previousRotationW, order, floatScratch);
+	Reorder(previousScaleX, order, floatScratch);
+	Reorder(previousScaleY, order, floatScratch);
+	Reorder(previousScaleZ, order, floatScratch);
+
+	std::vector<XMFLOAT4X4> matrixScratch;
+	Reorder(worldMatrices, order, matrixScratch);
+	Reorder(worldInvTransMatrices, order, matrixScratch);
+
+	std::vector<unsigned int> slotScratch;
+	Reorder(entrySlots, order, slotScratch);
+
+	std::vector<unsigned long long> oldDirtyBits = dirtyBits;
+	std::vector<unsigned long long> oldBlendBits = blendBits;
+	std::fill(dirtyBits.begin(), dirtyBits.end(), 0);
+	std::fill(blendBits.begin(), blendBits.end(), 0);
+	for (unsigned int entry = 0; entry < count; entry++)
+	{
+		unsigned long long bit = 1ull << (order[entry] % 64);
+		if (oldDirtyBits[order[entry] / 64] & bit)
+			MarkDirty(entry);
+		if (oldBlendBits[order[entry] / 64] & bit)
+			blendBits[entry / 64] |= 1ull << (entry % 64);
+	}
+
+	// Rebuild the lookups. Subtree ends are found back to front, as each
+	// child is after its parent and its own subtree is already known
+	for (unsigned int entry = 0; entry < count; entry++)
+		slotEntries[entrySlots[entry]] = entry;
+
+	childCount = 0;
+	for (unsigned int entry = 0; entry < count; entry++)
+	{
+		unsigned int parent = parentSlots[entrySlots[entry]];
+		parents[entry] = parent == InvalidSlot ? InvalidSlot : slotEntries[parent];
+		subtreeEnds[entry] = entry + 1;
+		childCount += parents[entry] != InvalidSlot;
+	}
+
+	for (unsigned int entry = count; entry-- > 0;)
+	{
+		unsigned int parent = parents[entry];
+		if (parent != InvalidSlot && subtreeEnds[entry] > subtreeEnds[parent])
+			subtreeEnds[parent] = subtreeEnds[entry];
+	}
+
+	for (unsigned int slot : reparentedSlots)
+		MarkDirty(slotEntries[slot]);
+	reparentedSlots.clear();
+}
+
+// --------------------------------------------------------
+// Dirties every entry below a dirty one
+//
+// - A dirty entry's whole subtree is marked and then skipped,
+//   so each subtree is handled once, from its highest dirty
+//   entry, and clean subtrees aren't visited at all
+// --------------------------------------------------------
+void TransformSystem::PropagateDirty()
+{
+	unsigned int entry = 0;
+	while (entry < count)
+	{
+		// Find the next dirty entry
+		unsigned int word = entry / 64;
+		unsigned long long bits = dirtyBits[word] & (~0ull << (entry % 64));
+		while (bits == 0 && ++word < dirtyBits.size())
+			bits = dirtyBits[word];
+		if (bits == 0)
+			break;
+
+		entry = word * 64 + (unsigned int)std::countr_zero(bits);
+		if (entry >= count)
+			break;
+
+		MarkDirty(entry, subtreeEnds[entry]);
+		entry = subtreeEnds[entry];
+	}
+}
+
+// --------------------------------------------------------
+// Rebuilds the 4 entries starting at group * 4, one per lane
+//
+// - Rotation is XMMatrixRotationQuaternion's, straight from
+//   the stored quaternion with no trig, with each row of
+//   world scaled by that axis' scale
+// - The inverse transpose of scale * rotation * translation
+//   divides each rotation row by its scale instead, and its
+//   4th column undoes the translation. Zero scales give 0
+//   rather than infinity
+// - These are local matrices; ComposeChildren() takes care of
+//   any parent
+// - While interpolating, each component is blended from its
+//   previous value first. Rotations blend along the shorter
+//   arc and are renormalized, which is close enough to a
+//   slerp for the small change of a single tick
+// --------------------------------------------------------
+void TransformSystem::RebuildGroup(unsigned int group)
+{
+	unsigned int base = group * 4;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	__m128 quaternion[4];
+	__m128 translation[3];
+	__m128 scale[3];
+	if (interpolation < 1.0f)
+	{
+		__m128 alpha = _mm_set1_ps(interpolation);
+		__m128 from[4] = { _mm_loadu_ps(&previousRotationX[base]), _mm_loadu_ps(&previousRotationY[base]), _mm_loadu_ps(&previousRotationZ[base]), _mm_loadu_ps(&previousRotationW[base]) };
+		__m128 to[4] = { _mm_loadu_ps(&rotationX[base]), _mm_loadu_ps(&rotationY[base]), _mm_loadu_ps(&rotationZ[base]), _mm_loadu_ps(&rotationW[base]) };
+
+		// q and -q are the same rotation, so flip whichever is the long way round
+		__m128 dot = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(from[0], to[0]), _mm_mul_ps(from[1], to[1])),
+			_mm_add_ps(_mm_mul_ps(from[2], to[2]), _mm_mul_ps(from[3], to[3])));
+		__m128 flip = _mm_and_ps(dot, _mm_set1_ps(-0.0f));
+		__m128 lengthSquared = zero;
+		for (unsigned int c = 0; c < 4; c++)
+		{
+			to[c] = _mm_xor_ps(to[c], flip);
+			quaternion[c] = _mm_add_ps(from[c], _mm_mul_ps(_mm_sub_ps(to[c], from[c]), alpha));
+			lengthSquared = _mm_add_ps(lengthSquared, _mm_mul_ps(quaternion[c], quaternion[c]));
+		}
+
+		__m128 inverseLength = _mm_div_ps(one, _mm_sqrt_ps(lengthSquared));
+		for (unsigned int c = 0; c < 4; c++)
+			quaternion[c] = _mm_mul_ps(quaternion[c], inverseLength);
+
+		translation[0] = LoadBlended(previousPositionX, positionX, base, alpha);
+		translation[1] = LoadBlended(previousPositionY, positionY, base, alpha);
+		translation[2] = LoadBlended(previousPositionZ, positionZ, base, alpha);
+		scale[0] = LoadBlended(previousScaleX, scaleX, base, alpha);
+		scale[1] = LoadBlended(previousScaleY, scaleY, base, alpha);
+		scale[2] = LoadBlended(previousScaleZ, scaleZ, base, alpha);
+	}
+	else
+	{
+		quaternion[0] = _mm_loadu_ps(&rotationX[base]);
+		quaternion[1] = _mm_loadu_ps(&rotationY[base]);
+		quaternion[2] = _mm_loadu_ps(&rotationZ[base]);
+		quaternion[3] = _mm_loadu_ps(&rotationW[base]);
+		translation[0] = _mm_loadu_ps(&positionX[base]);
+		translation[1] = _mm_loadu_ps(&positionY[base]);
+		translation[2] = _mm_loadu_ps(&positionZ[base]);
+		scale[0] = _mm_loadu_ps(&scaleX[base]);
+		scale[1] = _mm_loadu_ps(&scaleY[base]);
+		scale[2] = _mm_loadu_ps(&scaleZ[base]);
+	}
+
+	__m128 x2 = _mm_add_ps(quaternion[0], quaternion[0]);
+	__m128 y2 = _mm_add_ps(quaternion[1], quaternion[1]);
+	__m128 z2 = _mm_add_ps(quaternion[2], quaternion[2]);
+	__m128 xx = _mm_mul_ps(quaternion[0], x2);
+	__m128 yy = _mm_mul_ps(quaternion[1], y2);
+	__m128 zz = _mm_mul_ps(quaternion[2], z2);
+	__m128 xy = _mm_mul_ps(quaternion[0], y2);
+	__m128 xz = _mm_mul_ps(quaternion[0], z2);
+	__m128 yz = _mm_mul_ps(quaternion[1], z2);
+	__m128 wx = _mm_mul_ps(quaternion[3], x2);
+	__m128 wy = _mm_mul_ps(quaternion[3], y2);
+	__m128 wz = _mm_mul_ps(quaternion[3], z2);
+	__m128 rotation[3][3] =
+	{
+		{ _mm_sub_ps(one, _mm_add_ps(yy, zz)), _mm_add_ps(xy, wz), _mm_sub_ps(xz, wy) },
+		{ _mm_sub_ps(xy, wz), _mm_sub_ps(one, _mm_add_ps(xx, zz)), _mm_add_ps(yz, wx) },
+		{ _mm_add_ps(xz, wy), _mm_sub_ps(yz, wx), _mm_sub_ps(one, _mm_add_ps(xx, yy)) }
+	};
+
+	XMFLOAT4X4* world = &worldMatrices[base];
+	XMFLOAT4X4* worldInvTrans = &worldInvTransMatrices[base];
+	for (unsigned int r = 0; r < 3; r++)
+	{
+		StoreRow(world, r,
+			_mm_mul_ps(rotation[r][0], scale[r]),
+			_mm_mul_ps(rotation[r][1], scale[r]),
+			_mm_mul_ps(rotation[r][2], scale[r]),
+			zero);
+
+		__m128 inverseScale = _mm_andnot_ps(_mm_cmpeq_ps(scale[r], zero), _mm_div_ps(one, scale[r]));
+		__m128 along = _mm_add_ps(
+			_mm_add_ps(_mm_mul_ps(translation[0], rotation[r][0]), _mm_mul_ps(translation[1], rotation[r][1])),
+			_mm_mul_ps(translation[2], rotation[r][2]));
+		StoreRow(worldInvTrans, r,
+			_mm_mul_ps(rotation[r][0], inverseScale),
+			_mm_mul_ps(rotation[r][1], inverseScale),
+			_mm_mul_ps(rotation[r][2], inverseScale),
+			_mm_sub_ps(zero, _mm_mul_ps(along, inverseScale)));
+	}
+	StoreRow(world, 3, translation[0], translation[1], translation[2], one);
+	StoreRow(worldInvTrans, 3, zero, zero, zero, one);
+
+	// A group never straddles two words, as 64 is a multiple of 4
+	dirtyBits[base / 64] &= ~(0xFull << (base % 64));
+}
+
+// Rebuilds each group with a dirty entry in [firstWord, endWord)
+void TransformSystem::RebuildWords(unsigned int firstWord, unsigned int endWord)
+{
+	for (unsigned int w = firstWord; w < endWord; w++)
+	{
+		while (dirtyBits[w])
+		{
+			unsigned int bit = (unsigned int)std::countr_zero(dirtyBits[w]);
+			RebuildGroup(w * 16 + bit / 4);
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Multiplies each dirty child's local matrices by its parent's
+// world matrices, front to back
+//
+// - Parents come first, so a parent is always final by the
+//   time its children read it. Reads stay close together, as
+//   a child's parent is usually only a few entries back
+// --------------------------------------------------------
+unsigned int TransformSystem::ComposeChildren()
+{
+	unsigned int composed = 0;
+	for (unsigned int word = 0; word < composeBits.size(); word++)
+	{
+		unsigned long long bits = composeBits[word];
+		while (bits)
+		{
+			unsigned int entry = word * 64 + (unsigned int)std::countr_zero(bits);
+			bits &= bits - 1;
+
+			unsigned int parent = parents[entry];
+			if (parent == InvalidSlot)
+				continue;
+
+			Multiply(worldMatrices[entry], worldMatrices[parent]);
+			Multiply(worldInvTransMatrices[entry], worldInvTransMatrices[parent]);
+			composed++;
+		}
+		composeBits[word] = 0;
+	}
+	return composed;
+}
@@ -0,0 +1,168 @@
+#pragma once
+#include <DirectXMath.h>
+#include <memory>
+#include <vector>
+
+#include "JobSystem.h"
+
+// --------------------------------------------------------
+// Timings from rebuilding a TransformSystem's matrices
+//
+// - rebuilt counts every slot whose world matrix changed,
+//   including children of moved parents
+// - composed is how many of those were combined with a parent
+// --------------------------------------------------------
+struct TransformSystemStats
+{
+	unsigned int threads;
+	unsigned int transforms;
+	unsigned int rebuilt;
+	unsigned int composed;
+	double seconds;
+};
+
+// --------------------------------------------------------
+// Many transforms, stored as structure-of-arrays
+//
+// - Positions, rotations (normalized quaternions) and scales
+//   are one array per component, and each entry has a dirty bit
+// - Each slot may have a parent, and its position, rotation
+//   and scale are then relative to the parent
+// - The arrays are kept in depth-first order, so parents come
+//   before their children and every subtree is a contiguous
+//   range. Slots are stable handles that map to an entry
+// - Reparenting only records the new parent. The next Update()
+//   re-sorts the entries once, however many slots moved
+// - Update() then runs in three steps:
+//   1. Each dirty entry dirties the rest of its subtree, as a
+//      range of bits rather than a walk
+//   2. The local matrices of every dirty entry are rebuilt, 4
+//      at a time with SSE (one per lane), split across threads
+//      (the job system's, if it was given one)
+//   3. One front to back pass multiplies each dirty child by
+//      its parent, which is always final by then
+// - The inverse transpose comes straight from the scale and
+//   rotation, as a local matrix is always scale * rotation *
+//   translation, and composes like world does
+// - Reading a matrix before Update() that's stale (its entry
+//   or an ancestor is dirty) runs Update() first
+// - With a fixed timestep, BeginTick() keeps the state from
+//   before each tick, and the matrices are built between that
+//   and the current state by SetInterpolation()'s alpha. Only
+//   entries set during the last tick differ, so only they are
+//   rebuilt when alpha changes. The getters always return the
+//   current (simulated) state
+// - Removed slots are reused by later Add() calls
+// --------------------------------------------------------
+class TransformSystem
+{
+public:
+	static constexpr unsigned int InvalidSlot = 0xFFFFFFFFu;
+
+	explicit TransformSystem(std::shared_ptr<JobSystem> jobSystem = nullptr);
+
+	// Adds an identity transform with no parent and returns its slot
+	unsigned int Add();
+
+	// Frees a slot. Its children keep their local transforms, as roots
+	void Remove(unsigned int slot);
+	void Reserve(unsigned int count);
+	unsigned int GetCount() const;
+
+	// Attaches a slot (and its children) under parent, or detaches it
+	// for InvalidSlot. Fails if parent is the slot or one of its children
+	bool SetParent(unsigned int slot, unsigned int parent);
+	unsigned int GetParent(unsigned int slot) const;
+
+	void SetPosition(unsigned int slot, DirectX::XMFLOAT3 position);
+	void SetRotation(unsigned int slot, DirectX::XMFLOAT4 rotation);
+	void SetScale(unsigned int slot, DirectX::XMFLOAT3 scale);
+
+	DirectX::XMFLOAT3 GetPosition(unsigned int slot) const;
+	DirectX::XMFLOAT4 GetRotation(unsigned int slot) const;
+	DirectX::XMFLOAT3 GetScale(unsigned int slot) const;
+	const DirectX::XMFLOAT4X4& GetWorldMatrix(unsigned int slot);
+	const DirectX::XMFLOAT4X4& GetWorldInverseTransposeMatrix(unsigned int slot);
+
+	// Rebuilds every dirty matrix. A threadCount of 0 uses every hardware
+	// thread (or the job system's); small batches always run on the calling thread
+	void Update(unsigned int threadCount = 0);
+
+	// Fixed timestep interpolation. Call BeginTick() before each simulation
+	// tick, and SetInterpolation() with how far rendering is past the last
+	// tick (0 is the previous state, 1 the current one) before Update()
+	void BeginTick();
+	void SetInterpolation(float alpha);
+	float GetInterpolation() const;
+	TransformSystemStats GetStats() const;
+
+private:
+	// Entries in use, with the arrays padded to a multiple of 4 (one per SSE lane)
+	unsigned int count;
+	std::vector<unsigned int> freeSlots;
+
+	// Slot -> entry, and entry -> slot
+	std::vector<unsigned int> slotEntries;
+	std::vector<unsigned int> entrySlots;
+
+	// Each slot's parent slot (or InvalidSlot) and number of children,
+	// and the slots reparented since the entries were last sorted
+	std::vector<unsigned int> parentSlots;
+	std::vector<unsigned int> childCounts;
+	std::vector<unsigned int> reparentedSlots;
+
+	// Per entry: the parent's entry (or InvalidSlot), and one past the
+	// entry's last descendant
+	std::vector<unsigned int> parents;
+	std::vector<unsigned int> subtreeEnds;
+	unsigned int childCount;
+
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> rotationX;
+	std::vector<float> rotationY;
+	std::vector<float> rotationZ;
+	std::vector<float> rotationW;
+	std::vector<float> scaleX;
+	std::vector<float> scaleY;
+	std::vector<float> scaleZ;
+
+	// The state before the last tick, which the matrices are blended from
+	std::vector<float> previousPositionX;
+	std::vector<float> previousPositionY;
+	std::vector<float> previousPositionZ;
+	std::vector<float> previousRotationX;
+	std::vector<float> previousRotationY;
+	std::vector<float> previousRotationZ;
+	std::vector<float> previousRotationW;
+	std::vector<float> previousScaleX;
+	std::vector<float> previousScaleY;
+	std::vector<float> previousScaleZ;
+	float interpolation;
+
+	std::vector<DirectX::XMFLOAT4X4> worldMatrices;
+	std::vector<DirectX::XMFLOAT4X4> worldInvTransMatrices;
+
+	// One bit per entry, 64 entries per word
+	std::vector<unsigned long long> dirtyBits;
+	std::vector<unsigned long long> composeBits;
+
+	// Entries set since the last BeginTick(), whose previous state differs
+	std::vector<unsigned long long> blendBits;
+
+	TransformSystemStats stats;
+	std::shared_ptr<JobSystem> jobSystem;
+
+	bool IsDirty(unsigned int entry) const;
+	bool IsStale(unsigned int entry) const;
+	void MarkDirty(unsigned int entry);
+	void MarkMoved(unsigned int entry);
+	void MarkDirty(unsigned int firstEntry, unsigned int endEntry);
+	void ResetEntry(unsigned int entry);
+	void SortEntries();
+	void PropagateDirty();
+	void RebuildGroup(unsigned int group);
+	void RebuildWords(unsigned int firstWord, unsigned int endWord);
+	unsigned int ComposeChildren();
+};
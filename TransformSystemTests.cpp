@@ -0,0 +1,724 @@
+// --------------------------------------------------------
+// Tests and benchmark for TransformSystem
+//
+// - Checks the batched world and inverse transpose matrices
+//   against AffineMatrix::Compose() for random transforms, on
+//   one thread and split across several
+// - Checks only dirty entries are rebuilt, and that reading a
+//   stale matrix updates it first
+// - Checks rotations are kept as the quaternions given (so a
+//   Transform in a system matches a standalone one, even near
+//   straight up), and blend along the shorter arc
+// - Checks hierarchies against multiplying each local matrix
+//   by its parent's world matrix: reparenting, rejecting
+//   cycles, re-sorting after Remove() and dirtying the whole
+//   subtree (grandchildren included) of a moved parent
+// - Given "bench", also times rebuilding every matrix at 10k,
+//   100k and 1M transforms, against Transform::UpdateMatrices()
+//   on each of the same number of standalone Transforms, and
+//   updating deep and wide hierarchies
+// - Not part of the Visual Studio project. On Linux it's the
+//   transform_system_tests target in CMakeLists.txt (which
+//   needs DirectXMath), or:
+//     g++ -O2 -std=c++20 TransformSystemTests.cpp
+//       TransformSystem.cpp Transform.cpp AffineMatrix.cpp
+//       JobSystem.cpp Profiler.cpp -lpthread -o transform_system_tests
+// - Usage: transform_system_tests [bench]
+// --------------------------------------------------------
+#include "Transform.h"
+#include "TransformSystem.h"
+#include "TestChecks.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// The system builds rotations and inverse scales 4 at a time with SSE
+	const float maxDifference = 1e-4f;
+
+	struct TestTransform
+	{
+		XMFLOAT3 position;
+		XMFLOAT3 pitchYawRoll;
+		XMFLOAT3 scale;
+	};
+
+	TestTransform RandomTransform(std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> place(-50.0f, 50.0f);
+		std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+		std::uniform_real_distribution<float> size(0.25f, 4.0f);
+
+		TestTransform transform = {};
+		transform.position = XMFLOAT3(place(random), place(random), place(random));
+		transform.pitchYawRoll = XMFLOAT3(angle(random), angle(random), angle(random));
+		transform.scale = XMFLOAT3(size(random), size(random), size(random));
+		return transform;
+	}
+
+	XMFLOAT4 ToQuaternion(XMFLOAT3 pitchYawRoll)
+	{
+		XMFLOAT4 rotation;
+		XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(pitchYawRoll.x, pitchYawRoll.y, pitchYawRoll.z));
+		return rotation;
+	}
+
+	float MaxDifference(const XMFLOAT4X4& a, const XMFLOAT4X4& b, unsigned int size)
+	{
+		float difference = 0.0f;
+		for (unsigned int r = 0; r < size; r++)
+		{
+			for (unsigned int c = 0; c < size; c++)
+			{
+				float d = fabsf(a.m[r][c] - b.m[r][c]);
+				difference = d > difference ? d : difference;
+			}
+		}
+		return difference;
+	}
+
+	// a * transpose(b), which is the identity for a matrix and its inverse transpose
+	XMFLOAT4X4 MultiplyTransposed(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		XMFLOAT4X4 result;
+		for (unsigned int r = 0; r < 4; r++)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				float sum = 0.0f;
+				for (unsigned int k = 0; k < 4; k++)
+					sum += a.m[r][k] * b.m[c][k];
+				result.m[r][c] = sum;
+			}
+		}
+		return result;
+	}
+
+	XMFLOAT4X4 Identity()
+	{
+		XMFLOAT4X4 m = {};
+		m.m[0][0] = m.m[1][1] = m.m[2][2] = m.m[3][3] = 1.0f;
+		return m;
+	}
+
+	// a * b, which applies a first
+	XMFLOAT4X4 Multiply(const XMFLOAT4X4& a, const XMFLOAT4X4& b)
+	{
+		XMFLOAT4X4 result;
+		for (unsigned int r = 0; r < 4; r++)
+		{
+			for (unsigned int c = 0; c < 4; c++)
+			{
+				float sum = 0.0f;
+				for (unsigned int k = 0; k < 4; k++)
+					sum += a.m[r][k] * b.m[k][c];
+				result.m[r][c] = sum;
+			}
+		}
+		return result;
+	}
+
+	// --------------------------------------------------------
+	// A TransformSystem, plus what each slot should hold, so
+	// hierarchies can be checked against the math done longhand
+	//
+	// - Locals stay near the unit scale, so deep chains don't
+	//   grow or shrink out of float range
+	// --------------------------------------------------------
+	struct TestHierarchy
+	{
+		TransformSystem system;
+		std::vector<TestTransform> locals;
+		std::vector<unsigned int> parents;
+		std::vector<bool> live;
+
+		unsigned int Add(std::mt19937& random)
+		{
+			TestTransform local = RandomTransform(random);
+			local.position = XMFLOAT3(local.position.x * 0.1f, local.position.y * 0.1f, local.position.z * 0.1f);
+			local.scale = XMFLOAT3(0.8f + local.scale.x * 0.1f, 0.8f + local.scale.y * 0.1f, 0.8f + local.scale.z * 0.1f);
+
+			unsigned int slot = system.Add();
+			if (slot >= locals.size())
+			{
+				locals.resize(slot + 1);
+				parents.resize(slot + 1, TransformSystem::InvalidSlot);
+				live.resize(slot + 1, false);
+			}
+			locals[slot] = local;
+			parents[slot] = TransformSystem::InvalidSlot;
+			live[slot] = true;
+
+			system.SetPosition(slot, local.position);
+			system.SetRotation(slot, ToQuaternion(local.pitchYawRoll));
+			system.SetScale(slot, local.scale);
+			return slot;
+		}
+
+		// Mirrors TransformSystem::Remove(): children are left as roots
+		void Remove(unsigned int slot)
+		{
+			for (unsigned int child = 0; child < parents.size(); child++)
+			{
+				if (parents[child] == slot)
+					parents[child] = TransformSystem::InvalidSlot;
+			}
+			parents[slot] = TransformSystem::InvalidSlot;
+			live[slot] = false;
+			system.Remove(slot);
+		}
+
+		// Reparents in the system, and checks it only refuses cycles
+		bool SetParent(unsigned int slot, unsigned int parent)
+		{
+			bool cycle = false;
+			for (unsigned int ancestor = parent; ancestor != TransformSystem::InvalidSlot; ancestor = parents[ancestor])
+				cycle = cycle || ancestor == slot;
+
+			bool attached = system.SetParent(slot, parent);
+			CHECK(attached == !cycle);
+			if (attached)
+				parents[slot] = parent;
+			return attached;
+		}
+
+		XMFLOAT4X4 ExpectedWorld(unsigned int slot) const
+		{
+			const TestTransform& local = locals[slot];
+			XMFLOAT4X4 world = AffineMatrix::Compose(local.position, ToQuaternion(local.pitchYawRoll), local.scale).ToMatrix();
+			return parents[slot] == TransformSystem::InvalidSlot ? world : Multiply(world, ExpectedWorld(parents[slot]));
+		}
+
+		// The largest difference of any live slot from its expected world
+		// matrix, and of world * inverse transpose from the identity
+		float MaxWorldDifference()
+		{
+			float difference = 0.0f;
+			for (unsigned int slot = 0; slot < locals.size(); slot++)
+			{
+				if (!live[slot])
+					continue;
+
+				XMFLOAT4X4 world = system.GetWorldMatrix(slot);
+				float d = MaxDifference(world, ExpectedWorld(slot), 4);
+				difference = d > difference ? d : difference;
+				d = MaxDifference(MultiplyTransposed(world, system.GetWorldInverseTransposeMatrix(slot)), Identity(), 4);
+				difference = d > difference ? d : difference;
+				CHECK(system.GetParent(slot) == parents[slot]);
+			}
+			return difference;
+		}
+	};
+
+	// --------------------------------------------------------
+	// Each slot's matrices match building it on its own, both
+	// when the batch runs on one thread and when it's split
+	// --------------------------------------------------------
+	void TestAgainstCompose(std::mt19937& random)
+	{
+		// Not a multiple of 4, so the last group has padding lanes,
+		// and big enough to be split across threads
+		const unsigned int transformCount = 10001;
+
+		for (unsigned int threadCount : { 1u, 4u })
+		{
+			TransformSystem system;
+			std::vector<TestTransform> transforms(transformCount);
+			for (TestTransform& transform : transforms)
+			{
+				transform = RandomTransform(random);
+				unsigned int slot = system.Add();
+				system.SetPosition(slot, transform.position);
+				system.SetRotation(slot, ToQuaternion(transform.pitchYawRoll));
+				system.SetScale(slot, transform.scale);
+			}
+			system.Update(threadCount);
+			CHECK((system.GetStats().threads > 1) == (threadCount > 1));
+			CHECK(system.GetStats().rebuilt == transformCount);
+
+			float worldDifference = 0.0f;
+			float inverseDifference = 0.0f;
+			float identityDifference = 0.0f;
+			for (unsigned int slot = 0; slot < transformCount; slot++)
+			{
+				const TestTransform& transform = transforms[slot];
+				XMFLOAT4 rotation = ToQuaternion(transform.pitchYawRoll);
+				XMFLOAT4X4 world = system.GetWorldMatrix(slot);
+				XMFLOAT4X4 worldInvTrans = system.GetWorldInverseTransposeMatrix(slot);
+
+				// Positions are up to 50, so compare relative to them
+				float d = MaxDifference(world, AffineMatrix::Compose(transform.position, rotation, transform.scale).ToMatrix(), 4) / 50.0f;
+				worldDifference = d > worldDifference ? d : worldDifference;
+
+				// ComposeInverseTranspose() leaves out translation, so only
+				// the 3x3 part matches. The full 4x4 must invert world
+				d = MaxDifference(worldInvTrans, AffineMatrix::ComposeInverseTranspose(rotation, transform.scale).ToMatrix(), 3);
+				inverseDifference = d > inverseDifference ? d : inverseDifference;
+				d = MaxDifference(MultiplyTransposed(world, worldInvTrans), Identity(), 4) / 50.0f;
+				identityDifference = d > identityDifference ? d : identityDifference;
+			}
+			printf("  %u threads: world %g, inverse transpose %g, world * inverse %g max difference\n",
+				threadCount, worldDifference, inverseDifference, identityDifference);
+			CHECK(worldDifference <= maxDifference);
+			CHECK(inverseDifference <= maxDifference);
+			CHECK(identityDifference <= maxDifference);
+		}
+	}
+
+	// Only the entries set since the last Update() are rebuilt
+	void TestOnlyDirtyRebuilt(std::mt19937& random)
+	{
+		TransformSystem system;
+		for (unsigned int i = 0; i < 1000; i++)
+			system.Add();
+		system.Update(1);
+		CHECK(system.GetStats().rebuilt == 1000);
+
+		system.Update(1);
+		CHECK(system.GetStats().rebuilt == 0);
+
+		const unsigned int moved[] = { 3, 4, 500, 999 };
+		for (unsigned int slot : moved)
+			system.SetPosition(slot, RandomTransform(random).position);
+		system.Update(1);
+		CHECK(system.GetStats().rebuilt == 4);
+		CHECK(system.GetStats().transforms == 1000);
+	}
+
+	// Reading a matrix before Update() gives the current state, not the last built
+	void TestStaleRead(std::mt19937& random)
+	{
+		TransformSystem system;
+		unsigned int slot = system.Add();
+		system.Update(1);
+
+		TestTransform transform = RandomTransform(random);
+		system.SetPosition(slot, transform.position);
+		system.SetRotation(slot, ToQuaternion(transform.pitchYawRoll));
+		system.SetScale(slot, transform.scale);
+
+		XMFLOAT4X4 expected = AffineMatrix::Compose(transform.position, ToQuaternion(transform.pitchYawRoll), transform.scale).ToMatrix();
+		CHECK(MaxDifference(system.GetWorldMatrix(slot), expected, 4) / 50.0f <= maxDifference);
+	}
+
+	// A removed slot is reused as an identity
+	void TestRemoveReuses(std::mt19937& random)
+	{
+		TransformSystem system;
+		unsigned int first = system.Add();
+		unsigned int second = system.Add();
+		system.SetPosition(first, RandomTransform(random).position);
+		system.Remove(first);
+		CHECK(system.GetCount() == 1);
+
+		unsigned int reused = system.Add();
+		CHECK(reused == first && reused != second);
+		CHECK(system.GetCount() == 2);
+		CHECK(MaxDifference(system.GetWorldMatrix(reused), Identity(), 4) == 0.0f);
+	}
+
+	// --------------------------------------------------------
+	// Rotations are stored as given, with no trip through
+	// angles, so a Transform in a system builds the same matrix
+	// as one on its own, even pitched almost straight up
+	// --------------------------------------------------------
+	void TestQuaternionStorage(std::mt19937& random)
+	{
+		std::shared_ptr<TransformSystem> system = std::make_shared<TransformSystem>();
+		const float pitches[] = { 1.5706f, -1.5706f, 1.5707963f, 0.3f };
+		float difference = 0.0f;
+		for (float pitch : pitches)
+		{
+			TestTransform transform = RandomTransform(random);
+			XMFLOAT4 rotation = ToQuaternion(XMFLOAT3(pitch, transform.pitchYawRoll.y, transform.pitchYawRoll.z));
+
+			Transform stored(system);
+			Transform standalone;
+			for (Transform* t : { &stored, &standalone })
+			{
+				t->SetPosition(transform.position);
+				t->SetRotation(rotation);
+				t->SetScale(transform.scale);
+			}
+
+			float d = MaxDifference(stored.GetWorldMatrix(), standalone.GetWorldMatrix(), 4) / 50.0f;
+			difference = d > difference ? d : difference;
+		}
+		printf("  near vertical: %g max difference\n", difference);
+		CHECK(difference <= maxDifference);
+
+		// The quaternion comes back as it went in
+		unsigned int slot = system->Add();
+		XMFLOAT4 rotation = ToQuaternion(XMFLOAT3(1.5707963f, 0.5f, -0.25f));
+		system->SetRotation(slot, rotation);
+		XMFLOAT4 stored = system->GetRotation(slot);
+		CHECK(stored.x == rotation.x && stored.y == rotation.y && stored.z == rotation.z && stored.w == rotation.w);
+	}
+
+	// --------------------------------------------------------
+	// Halfway from a yaw of 170 degrees to one of -170 is 180,
+	// not 0, though the two quaternions are on opposite sides
+	// --------------------------------------------------------
+	void TestInterpolationShorterArc()
+	{
+		const float degrees = 3.14159265f / 180.0f;
+		TransformSystem system;
+		unsigned int slot = system.Add();
+		system.SetRotation(slot, ToQuaternion(XMFLOAT3(0.0f, 170.0f * degrees, 0.0f)));
+		system.BeginTick();
+		system.SetRotation(slot, ToQuaternion(XMFLOAT3(0.0f, -170.0f * degrees, 0.0f)));
+		system.SetInterpolation(0.5f);
+		system.Update(1);
+
+		XMFLOAT4X4 expected = AffineMatrix::Compose(XMFLOAT3(0.0f, 0.0f, 0.0f), ToQuaternion(XMFLOAT3(0.0f, 180.0f * degrees, 0.0f)), XMFLOAT3(1.0f, 1.0f, 1.0f)).ToMatrix();
+		CHECK(MaxDifference(system.GetWorldMatrix(slot), expected, 4) <= maxDifference);
+
+		// And the blend is still a pure rotation
+		XMFLOAT4X4 world = system.GetWorldMatrix(slot);
+		CHECK(MaxDifference(MultiplyTransposed(world, world), Identity(), 4) <= maxDifference);
+	}
+
+	// --------------------------------------------------------
+	// Children follow their parents, and follow a new parent
+	// after reparenting, including to one added after them
+	// (which has to move ahead of them in the arrays)
+	// --------------------------------------------------------
+	void TestReparent(std::mt19937& random)
+	{
+		TestHierarchy hierarchy;
+		unsigned int child = hierarchy.Add(random);
+		unsigned int grandchild = hierarchy.Add(random);
+		unsigned int first = hierarchy.Add(random);
+		unsigned int second = hierarchy.Add(random);
+
+		CHECK(hierarchy.SetParent(child, first));
+		CHECK(hierarchy.SetParent(grandchild, child));
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+		CHECK(hierarchy.system.GetStats().composed == 2);
+
+		// Moving the child takes its own child along
+		CHECK(hierarchy.SetParent(child, second));
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+
+		// Detaching leaves the local transform as the world transform
+		CHECK(hierarchy.SetParent(child, TransformSystem::InvalidSlot));
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+		CHECK(MaxDifference(hierarchy.system.GetWorldMatrix(child), hierarchy.ExpectedWorld(child), 4) <= maxDifference);
+
+		// Setting the same parent again changes nothing
+		hierarchy.system.Update(1);
+		CHECK(hierarchy.SetParent(grandchild, child));
+		hierarchy.system.Update(1);
+		CHECK(hierarchy.system.GetStats().rebuilt == 0);
+	}
+
+	// A slot can't be its own parent, or the parent of any of its ancestors
+	void TestCycleRejection(std::mt19937& random)
+	{
+		TestHierarchy hierarchy;
+		unsigned int root = hierarchy.Add(random);
+		unsigned int child = hierarchy.Add(random);
+		unsigned int grandchild = hierarchy.Add(random);
+		CHECK(hierarchy.SetParent(child, root));
+		CHECK(hierarchy.SetParent(grandchild, child));
+
+		CHECK(!hierarchy.system.SetParent(root, root));
+		CHECK(!hierarchy.system.SetParent(root, child));
+		CHECK(!hierarchy.system.SetParent(root, grandchild));
+		CHECK(!hierarchy.system.SetParent(child, grandchild));
+		CHECK(!hierarchy.system.SetParent(grandchild, grandchild));
+		CHECK(!hierarchy.system.SetParent(child, 1000));
+		CHECK(!hierarchy.system.SetParent(1000, root));
+
+		// Nothing changed, and the hierarchy still builds
+		CHECK(hierarchy.system.GetParent(root) == TransformSystem::InvalidSlot);
+		CHECK(hierarchy.system.GetParent(child) == root);
+		CHECK(hierarchy.system.GetParent(grandchild) == child);
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+
+		// A grandchild can still become the root's sibling
+		CHECK(hierarchy.SetParent(grandchild, TransformSystem::InvalidSlot));
+		CHECK(hierarchy.SetParent(root, grandchild));
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+	}
+
+	// --------------------------------------------------------
+	// Random adds, removes and reparents, checking every world
+	// matrix along the way
+	//
+	// - Removing a parent leaves its children as roots, and
+	//   reused slots are added back wherever they were, so the
+	//   depth-first order has to be rebuilt around them
+	// - Some checks read matrices without an Update() first
+	// --------------------------------------------------------
+	void TestRemoveReorders(std::mt19937& random)
+	{
+		TestHierarchy hierarchy;
+		for (unsigned int i = 0; i < 64; i++)
+			hierarchy.Add(random);
+
+		std::uniform_int_distribution<unsigned int> operation(0, 9);
+		float difference = 0.0f;
+		unsigned int removed = 0;
+		for (unsigned int step = 0; step < 2000; step++)
+		{
+			std::uniform_int_distribution<unsigned int> pick(0, (unsigned int)hierarchy.locals.size() - 1);
+			unsigned int slot = pick(random);
+			unsigned int op = operation(random);
+			if (!hierarchy.live[slot])
+				hierarchy.Add(random);
+			else if (op == 0)
+			{
+				hierarchy.Remove(slot);
+				removed++;
+			}
+			else if (op == 1)
+				hierarchy.SetParent(slot, TransformSystem::InvalidSlot);
+			else
+			{
+				unsigned int parent = pick(random);
+				if (hierarchy.live[parent])
+					hierarchy.SetParent(slot, parent);
+			}
+
+			if (step % 50 == 0)
+				hierarchy.system.Update(1);
+			if (step % 20 == 0)
+			{
+				float d = hierarchy.MaxWorldDifference();
+				difference = d > difference ? d : difference;
+			}
+		}
+		printf("  %u removed: %g max difference\n", removed, difference);
+		CHECK(removed > 0);
+		CHECK(difference <= maxDifference);
+	}
+
+	// --------------------------------------------------------
+	// Moving a parent rebuilds its whole subtree, grandchildren
+	// included, and nothing outside it
+	// --------------------------------------------------------
+	void TestGrandchildDirty(std::mt19937& random)
+	{
+		TestHierarchy hierarchy;
+		unsigned int root = hierarchy.Add(random);
+		unsigned int child = hierarchy.Add(random);
+		unsigned int grandchild = hierarchy.Add(random);
+		for (unsigned int i = 0; i < 8; i++)
+			hierarchy.Add(random);
+
+		// In a group of its own, as a whole group of 4 is rebuilt together
+		unsigned int other = hierarchy.Add(random);
+		CHECK(hierarchy.SetParent(child, root));
+		CHECK(hierarchy.SetParent(grandchild, child));
+		hierarchy.system.Update(1);
+
+		TestTransform moved = RandomTransform(random);
+		hierarchy.locals[root].position = moved.position;
+		hierarchy.system.SetPosition(root, moved.position);
+		hierarchy.system.Update(1);
+		CHECK(hierarchy.system.GetStats().rebuilt == 3);
+		CHECK(hierarchy.system.GetStats().composed >= 2);
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+
+		// Moving the child leaves the root alone
+		hierarchy.locals[child].pitchYawRoll = moved.pitchYawRoll;
+		hierarchy.system.SetRotation(child, ToQuaternion(moved.pitchYawRoll));
+		hierarchy.system.Update(1);
+		CHECK(hierarchy.system.GetStats().rebuilt == 2);
+		CHECK(hierarchy.MaxWorldDifference() <= maxDifference);
+
+		// Reading the grandchild alone catches up with a moved root
+		hierarchy.locals[root].scale = XMFLOAT3(2.0f, 2.0f, 2.0f);
+		hierarchy.system.SetScale(root, hierarchy.locals[root].scale);
+		CHECK(MaxDifference(hierarchy.system.GetWorldMatrix(grandchild), hierarchy.ExpectedWorld(grandchild), 4) <= maxDifference);
+
+		// A slot outside the subtree is never rebuilt
+		hierarchy.system.SetPosition(other, moved.position);
+		hierarchy.system.Update(1);
+		CHECK(hierarchy.system.GetStats().rebuilt == 1);
+		CHECK(hierarchy.system.GetStats().composed == 0);
+	}
+
+	// --------------------------------------------------------
+	// Milliseconds to rebuild every matrix, the best of several
+	// frames, with everything moved before each frame
+	//
+	// - The per-object path is Transform::UpdateMatrices() on
+	//   each standalone Transform, as GameEntity used before
+	//   transforms moved into a system
+	// - Only the rebuild is timed, not setting the new state
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		std::mt19937 random(99);
+		unsigned int hardwareThreads = std::thread::hardware_concurrency() > 0 ? std::thread::hardware_concurrency() : 1;
+		const unsigned int transformCounts[] = { 10000, 100000, 1000000 };
+		const unsigned int threadCounts[] = { 1, 2, 4, 8 };
+
+		printf("\nTransforms  Per object  ");
+		for (unsigned int threadCount : threadCounts)
+			printf("%u threads  ", threadCount);
+		printf("(ms per frame)\n");
+
+		for (unsigned int transformCount : transformCounts)
+		{
+			std::vector<TestTransform> transforms(transformCount);
+			for (TestTransform& transform : transforms)
+				transform = RandomTransform(random);
+			unsigned int frames = 20000000 / transformCount;
+			frames = frames > 50 ? 50 : frames;
+
+			// One Transform each, in its own scope so both paths
+			// aren't holding a million transforms at once
+			double best = 1e30;
+			{
+				std::vector<Transform> objects(transformCount);
+				for (unsigned int frame = 0; frame < frames; frame++)
+				{
+					for (unsigned int i = 0; i < transformCount; i++)
+					{
+						objects[i].SetPosition(transforms[i].position);
+						objects[i].SetRotation(transforms[i].pitchYawRoll.x + frame * 0.01f, transforms[i].pitchYawRoll.y, transforms[i].pitchYawRoll.z);
+						objects[i].SetScale(transforms[i].scale);
+					}
+
+					std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+					for (Transform& object : objects)
+						object.UpdateMatrices();
+					double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+					best = seconds < best ? seconds : best;
+				}
+			}
+			printf("%10u  %10.3f  ", transformCount, best * 1000.0);
+
+			for (unsigned int threadCount : threadCounts)
+			{
+				TransformSystem system;
+				system.Reserve(transformCount);
+				for (unsigned int i = 0; i < transformCount; i++)
+					system.Add();
+
+				best = 1e30;
+				for (unsigned int frame = 0; frame < frames; frame++)
+				{
+					for (unsigned int i = 0; i < transformCount; i++)
+					{
+						system.SetPosition(i, transforms[i].position);
+						system.SetRotation(i, ToQuaternion(XMFLOAT3(transforms[i].pitchYawRoll.x + frame * 0.01f, transforms[i].pitchYawRoll.y, transforms[i].pitchYawRoll.z)));
+						system.SetScale(i, transforms[i].scale);
+					}
+
+					system.Update(threadCount);
+					double seconds = system.GetStats().seconds;
+					best = seconds < best ? seconds : best;
+				}
+				printf("%9.3f  ", best * 1000.0);
+			}
+			printf("\n");
+		}
+		printf("(%u hardware threads; batches under 4096 transforms stay on one thread)\n", hardwareThreads);
+	}
+
+	// --------------------------------------------------------
+	// Updating hierarchies of different shapes, in milliseconds
+	// (the best of several frames)
+	//
+	// - Flat: every transform a root. Wide: one root with every
+	//   other transform as its child. Deep: one long chain.
+	//   Tree: each transform has 4 children
+	// - Slots are linked in a shuffled order, so the first
+	//   Update() (Sort) has to re-sort every entry
+	// - Root moves the first transform, which for everything
+	//   but Flat dirties the whole hierarchy. 1% moves that
+	//   many random transforms, and so only their subtrees
+	// --------------------------------------------------------
+	void RunHierarchyBenchmark()
+	{
+		std::mt19937 random(99);
+		const unsigned int transformCounts[] = { 100000, 1000000 };
+		const char* shapes[] = { "Flat", "Wide", "Deep", "Tree" };
+
+		printf("\nTransforms  Shape      Sort  Root moved  (rebuilt)   1%% moved  (rebuilt)  (ms)\n");
+		for (unsigned int transformCount : transformCounts)
+		{
+			std::vector<unsigned int> order(transformCount);
+			for (unsigned int i = 0; i < transformCount; i++)
+				order[i] = i;
+			std::shuffle(order.begin(), order.end(), random);
+
+			for (unsigned int shape = 0; shape < 4; shape++)
+			{
+				TransformSystem system;
+				system.Reserve(transformCount);
+				for (unsigned int i = 0; i < transformCount; i++)
+					system.Add();
+
+				// order[i] is the i-th transform of the shape, and order[0] the root
+				for (unsigned int i = 1; i < transformCount && shape > 0; i++)
+				{
+					unsigned int parent = shape == 1 ? 0 : (shape == 2 ? i - 1 : (i - 1) / 4);
+					system.SetParent(order[i], order[parent]);
+				}
+				system.Update();
+				double sortSeconds = system.GetStats().seconds;
+
+				double rootSeconds = 1e30;
+				unsigned int rootRebuilt = 0;
+				double someSeconds = 1e30;
+				unsigned int someRebuilt = 0;
+				std::uniform_int_distribution<unsigned int> pick(0, transformCount - 1);
+				for (unsigned int frame = 0; frame < 5; frame++)
+				{
+					system.SetPosition(order[0], XMFLOAT3(frame * 0.1f, 0.0f, 0.0f));
+					system.Update();
+					rootSeconds = system.GetStats().seconds < rootSeconds ? system.GetStats().seconds : rootSeconds;
+					rootRebuilt = system.GetStats().rebuilt;
+
+					for (unsigned int i = 0; i < transformCount / 100; i++)
+						system.SetPosition(pick(random), XMFLOAT3(0.0f, frame * 0.1f, 0.0f));
+					system.Update();
+					someSeconds = system.GetStats().seconds < someSeconds ? system.GetStats().seconds : someSeconds;
+					someRebuilt = system.GetStats().rebuilt;
+				}
+
+				printf("%10u  %-5s  %8.3f  %10.3f  (%7u)  %8.3f  (%7u)\n", transformCount, shapes[shape],
+					sortSeconds * 1000.0, rootSeconds * 1000.0, rootRebuilt, someSeconds * 1000.0, someRebuilt);
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 random(1234);
+	TestAgainstCompose(random);
+	TestOnlyDirtyRebuilt(random);
+	TestStaleRead(random);
+	TestRemoveReuses(random);
+	TestQuaternionStorage(random);
+	TestInterpolationShorterArc();
+	TestReparent(random);
+	TestCycleRejection(random);
+	TestRemoveReorders(random);
+	TestGrandchildDirty(random);
+
+	int result = TestChecks::Finish("TransformSystem");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+	{
+		RunBenchmark();
+		RunHierarchyBenchmark();
+	}
+
+	return result;
+}
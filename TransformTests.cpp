@@ -0,0 +1,259 @@
+// --------------------------------------------------------
+// Tests and benchmark for Transform's rotations
+//
+// - Checks the angles derived from a quaternion give the
+//   same rotation back, and that the right, up and forward
+//   vectors are the world matrix's rotated axes
+// - Checks MoveRelative() follows the rotation, and copies
+//   keep the quaternion exactly
+// - Given "bench", also times a camera style loop (move,
+//   mouse look, then read the position and forward vector as
+//   Camera::UpdateViewMatrix() does) against the same loop on
+//   a copy of Transform from before it stored a quaternion
+// - Not part of the Visual Studio project. On Linux it's the
+//   transform_tests target in CMakeLists.txt (which needs
+//   DirectXMath), or:
+//     g++ -O2 -std=c++20 TransformTests.cpp Transform.cpp
+//       AffineMatrix.cpp TransformSystem.cpp JobSystem.cpp
+//       Profiler.cpp -lpthread -o transform_tests
+// - Usage: transform_tests [bench]
+// --------------------------------------------------------
+#include "Transform.h"
+#include "TestChecks.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+	const float maxDifference = 1e-5f;
+
+	// Where the benchmark loops put their results, so they aren't optimized away
+	volatile float benchmarkSink;
+
+	float Difference(XMFLOAT3 a, XMFLOAT3 b)
+	{
+		float x = fabsf(a.x - b.x);
+		float y = fabsf(a.y - b.y);
+		float z = fabsf(a.z - b.z);
+		return x > y ? (x > z ? x : z) : (y > z ? y : z);
+	}
+
+	// q and -q are the same rotation, so compare whichever is closer
+	float Difference(XMFLOAT4 a, XMFLOAT4 b)
+	{
+		float sign = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w < 0.0f ? -1.0f : 1.0f;
+		float d = 0.0f;
+		const float differences[] = { a.x - b.x * sign, a.y - b.y * sign, a.z - b.z * sign, a.w - b.w * sign };
+		for (float difference : differences)
+			d = fabsf(difference) > d ? fabsf(difference) : d;
+		return d;
+	}
+
+	XMFLOAT4 RandomRotation(std::mt19937& random, float maxPitch)
+	{
+		std::uniform_real_distribution<float> pitch(-maxPitch, maxPitch);
+		std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+		XMFLOAT4 rotation;
+		XMStoreFloat4(&rotation, XMQuaternionRotationRollPitchYaw(pitch(random), angle(random), angle(random)));
+		return rotation;
+	}
+
+	// --------------------------------------------------------
+	// Angles derived from a quaternion convert back to it, away
+	// from straight up or down (where yaw and roll blur together)
+	// --------------------------------------------------------
+	void TestDerivedAngles(std::mt19937& random)
+	{
+		float difference = 0.0f;
+		for (unsigned int i = 0; i < 10000; i++)
+		{
+			XMFLOAT4 rotation = RandomRotation(random, 1.5f);
+			Transform transform;
+			transform.SetRotation(rotation);
+
+			Transform fromAngles;
+			fromAngles.SetRotation(transform.GetPitchYawRoll());
+			float d = Difference(fromAngles.GetRotation(), rotation);
+			difference = d > difference ? d : difference;
+		}
+		printf("  derived angles: %g max difference\n", difference);
+		CHECK(difference <= 1e-4f);
+	}
+
+	// The basis vectors are the world matrix's rows, when unscaled
+	void TestBasisVectors(std::mt19937& random)
+	{
+		float difference = 0.0f;
+		for (unsigned int i = 0; i < 1000; i++)
+		{
+			Transform transform;
+			transform.SetPosition(1.0f, 2.0f, 3.0f);
+			transform.SetRotation(RandomRotation(random, 1.5707963f));
+			XMFLOAT4X4 world = transform.GetWorldMatrix();
+
+			float d = Difference(transform.GetRight(), XMFLOAT3(world._11, world._12, world._13));
+			difference = d > difference ? d : difference;
+			d = Difference(transform.GetUp(), XMFLOAT3(world._21, world._22, world._23));
+			difference = d > difference ? d : difference;
+			d = Difference(transform.GetForward(), XMFLOAT3(world._31, world._32, world._33));
+			difference = d > difference ? d : difference;
+		}
+		CHECK(difference <= maxDifference);
+	}
+
+	// Relative moves go along the basis vectors, and absolute ones don't
+	void TestMoves(std::mt19937& random)
+	{
+		Transform transform;
+		transform.SetRotation(RandomRotation(random, 1.5707963f));
+		XMFLOAT3 right = transform.GetRight();
+		XMFLOAT3 up = transform.GetUp();
+		XMFLOAT3 forward = transform.GetForward();
+
+		transform.MoveRelative(2.0f, 3.0f, 4.0f);
+		XMFLOAT3 expected(
+			right.x * 2.0f + up.x * 3.0f + forward.x * 4.0f,
+			right.y * 2.0f + up.y * 3.0f + forward.y * 4.0f,
+			right.z * 2.0f + up.z * 3.0f + forward.z * 4.0f);
+		CHECK(Difference(transform.GetPosition(), expected) <= maxDifference * 10.0f);
+
+		transform.MoveAbsolute(1.0f, 0.0f, 0.0f);
+		expected.x += 1.0f;
+		CHECK(Difference(transform.GetPosition(), expected) <= maxDifference * 10.0f);
+	}
+
+	// Copies keep the quaternion and angles as they are, with no conversion
+	void TestCopy(std::mt19937& random)
+	{
+		Transform transform;
+		transform.SetRotation(RandomRotation(random, 1.5707963f));
+		Transform copy = transform;
+		XMFLOAT4 a = transform.GetRotation();
+		XMFLOAT4 b = copy.GetRotation();
+		CHECK(a.x == b.x && a.y == b.y && a.z == b.z && a.w == b.w);
+		CHECK(Difference(transform.GetPitchYawRoll(), copy.GetPitchYawRoll()) == 0.0f);
+	}
+
+	// --------------------------------------------------------
+	// Transform's rotation handling from before it stored a
+	// quaternion, kept only to compare against
+	//
+	// - MoveRelative() and the basis vectors each converted
+	//   the angles to a quaternion again
+	// --------------------------------------------------------
+	class EulerTransform
+	{
+	public:
+		XMFLOAT3 position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 rotation = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		XMFLOAT3 forwardVec = XMFLOAT3(0.0f, 0.0f, 1.0f);
+		bool dirtyVectors = false;
+
+		void SetRotation(XMFLOAT3 pitchYawRoll)
+		{
+			rotation = pitchYawRoll;
+			dirtyVectors = true;
+		}
+
+		XMFLOAT3 GetForward()
+		{
+			if (dirtyVectors)
+			{
+				XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+				XMStoreFloat3(&forwardVec, XMVector3Rotate(XMVectorSet(0, 0, 1, 0), rotQuat));
+				dirtyVectors = false;
+			}
+			return forwardVec;
+		}
+
+		void MoveRelative(XMFLOAT3 offset)
+		{
+			XMVECTOR rotQuat = XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&rotation));
+			XMVECTOR directedRot = XMVector3Rotate(XMLoadFloat3(&offset), rotQuat);
+			XMStoreFloat3(&position, XMVectorAdd(XMLoadFloat3(&position), directedRot));
+		}
+	};
+
+	// --------------------------------------------------------
+	// Nanoseconds per frame of a camera flying around, as
+	// UserInput::UpdateCameraInput() and Camera do it
+	//
+	// - Look frames turn the camera as well as moving it. The
+	//   rest only move, which now needs no trig at all
+	// --------------------------------------------------------
+	void RunBenchmark()
+	{
+		const unsigned int frames = 2000000;
+		const unsigned int lookEvery[] = { 1, 4, 0 };
+
+		printf("\nLook frames  Angles (ns)  Quaternion (ns)\n");
+		for (unsigned int every : lookEvery)
+		{
+			float sum = 0.0f;
+
+			// Start turned, as sines and cosines of 0 are quicker than most
+			EulerTransform euler;
+			euler.SetRotation(XMFLOAT3(0.3f, 0.5f, 0.0f));
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < frames; frame++)
+			{
+				euler.MoveRelative(XMFLOAT3(0.01f, 0.0f, 0.02f));
+				euler.position.y += 0.001f;
+				if (every > 0 && frame % every == 0)
+				{
+					XMFLOAT3 rotation = euler.rotation;
+					rotation.x = sinf(frame * 0.001f);
+					rotation.y += 0.001f;
+					euler.SetRotation(rotation);
+				}
+				XMFLOAT3 forward = euler.GetForward();
+				sum += euler.position.x + forward.z;
+			}
+			double eulerSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			Transform transform;
+			transform.SetRotation(XMFLOAT3(0.3f, 0.5f, 0.0f));
+			start = std::chrono::steady_clock::now();
+			for (unsigned int frame = 0; frame < frames; frame++)
+			{
+				transform.MoveRelative(XMFLOAT3(0.01f, 0.0f, 0.02f));
+				transform.MoveAbsolute(XMFLOAT3(0.0f, 0.001f, 0.0f));
+				if (every > 0 && frame % every == 0)
+				{
+					XMFLOAT3 rotation = transform.GetPitchYawRoll();
+					rotation.x = sinf(frame * 0.001f);
+					rotation.y += 0.001f;
+					transform.SetRotation(rotation);
+				}
+				XMFLOAT3 forward = transform.GetForward();
+				sum += transform.GetPosition().x + forward.z;
+			}
+			double quaternionSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+			benchmarkSink = sum;
+			printf("%11s  %11.1f  %15.1f\n", every == 1 ? "every" : (every == 0 ? "none" : "1 in 4"),
+				eulerSeconds * 1e9 / frames, quaternionSeconds * 1e9 / frames);
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::mt19937 random(1234);
+	TestDerivedAngles(random);
+	TestBasisVectors(random);
+	TestMoves(random);
+	TestCopy(random);
+
+	int result = TestChecks::Finish("Transform");
+
+	if (argc > 1 && strcmp(argv[1], "bench") == 0)
+		RunBenchmark();
+
+	return result;
+}
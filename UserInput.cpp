@@ -87,12 +87,11 @@ void UserInput::UpdateCameraInput(Input& input, float currentSpeed)
         float xDelt = input.GetMouseXDelta() * lookSpeed;
         float yDelt = input.GetMouseYDelta() * lookSpeed;
 
-        // Rotate by the deltas in opposite order
-        currentTarget.Rotate(yDelt, xDelt, 0);
-
-        // Clamp the x rotation
+        // Rotate by the deltas in opposite order, clamping the x rotation
+        // before it's set, so the rotation is only converted once
         XMFLOAT3 currentRotation = currentTarget.GetPitchYawRoll();
-        currentRotation.x = MathUtils::Clamp(currentRotation.x, XM_PIDIV2, -XM_PIDIV2);
+        currentRotation.x = MathUtils::Clamp(currentRotation.x + yDelt, XM_PIDIV2, -XM_PIDIV2);
+        currentRotation.y += xDelt;
         currentTarget.SetRotation(currentRotation);
     }
 }
@@ -0,0 +1,336 @@
+#include "VertexCompression.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const float radiansToDegrees = 57.2957795f;
+
+	const char* formatNames[] = { "Standard", "Compact", "Compact (quantized positions)" };
+
+	inline float Dot(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	inline ObjFloat3 Cross(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	inline short ToSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return (short)std::lround(value * 32767.0f);
+	}
+
+	inline float FromSnorm16(short value)
+	{
+		float result = value / 32767.0f;
+		return result < -1.0f ? -1.0f : result;
+	}
+
+	// --------------------------------------------------------
+	// Angle between two directions, treating bad input as no error
+	//
+	// - From atan2 of the sine and cosine, as acos can't resolve
+	//   angles this small in floats (it bottoms out near 0.02 deg)
+	// --------------------------------------------------------
+	inline float AngleDegrees(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		if (!(Dot(a, a) > 0.0f) || !(Dot(b, b) > 0.0f))
+			return 0.0f;
+
+		ObjFloat3 cross = Cross(a, b);
+		return std::atan2(std::sqrt(Dot(cross, cross)), Dot(a, b)) * radiansToDegrees;
+	}
+
+	// --------------------------------------------------------
+	// Works out which way the UVs' bitangent points for each
+	// vertex, relative to cross(T, N) which the pixel shader uses
+	//
+	// - Same accumulation as Mesh::CalculateTangents, but for
+	//   the bitangent instead
+	// --------------------------------------------------------
+	void CalculateBitangentSigns(
+		const ObjVertex* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount,
+		std::vector<float>& signs)
+	{
+		std::vector<ObjFloat3> bitangents(vertexCount, ObjFloat3{ 0, 0, 0 });
+		for (unsigned int i = 0; i + 2 < indexCount; i += 3)
+		{
+			const ObjVertex& v1 = vertices[indices[i]];
+			const ObjVertex& v2 = vertices[indices[i + 1]];
+			const ObjVertex& v3 = vertices[indices[i + 2]];
+
+			ObjFloat3 e1 = { v2.Position.x - v1.Position.x, v2.Position.y - v1.Position.y, v2.Position.z - v1.Position.z };
+			ObjFloat3 e2 = { v3.Position.x - v1.Position.x, v3.Position.y - v1.Position.y, v3.Position.z - v1.Position.z };
+			float s1 = v2.UV.x - v1.UV.x;
+			float t1 = v2.UV.y - v1.UV.y;
+			float s2 = v3.UV.x - v1.UV.x;
+			float t2 = v3.UV.y - v1.UV.y;
+
+			float determinant = s1 * t2 - s2 * t1;
+			if (determinant == 0.0f)
+				continue;
+
+			float r = 1.0f / determinant;
+			ObjFloat3 b = { (s1 * e2.x - s2 * e1.x) * r, (s1 * e2.y - s2 * e1.y) * r, (s1 * e2.z - s2 * e1.z) * r };
+			for (unsigned int k = 0; k < 3; k++)
+			{
+				ObjFloat3& sum = bitangents[indices[i + k]];
+				sum.x += b.x;
+				sum.y += b.y;
+				sum.z += b.z;
+			}
+		}
+
+		signs.resize(vertexCount);
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			ObjFloat3 reconstructed = Cross(vertices[v].Tangent, vertices[v].Normal);
+			signs[v] = Dot(reconstructed, bitangents[v]) < 0.0f ? -1.0f : 1.0f;
+		}
+	}
+}
+
+// --------------------------------------------------------
+// Compresses vertices into one of the compact formats
+//
+// - Returns false for VertexFormat::Standard, which needs no work
+// - UVs (and positions, if quantized) are stored as 16-bit
+//   fractions of the bounds of these vertices
+// --------------------------------------------------------
+bool VertexCompression::Compress(
+	const ObjVertex* vertices, unsigned int vertexCount,
+	const unsigned int* indices, unsigned int indexCount,
+	VertexFormat format,
+	CompressedVertices& output)
+{
+	output.data.clear();
+	output.stats = {};
+	output.stride = GetStride(format);
+	for (int i = 0; i < 3; i++)
+	{
+		output.positionScale[i] = 1.0f;
+		output.positionOffset[i] = 0.0f;
+	}
+	for (int i = 0; i < 2; i++)
+	{
+		output.uvScale[i] = 1.0f;
+		output.uvOffset[i] = 0.0f;
+	}
+
+	if (format == VertexFormat::Standard || vertexCount == 0)
+		return false;
+
+	// Find the position and UV bounds to quantize within
+	float minPos[3] = { vertices[0].Position.x, vertices[0].Position.y, vertices[0].Position.z };
+	float maxPos[3] = { minPos[0], minPos[1], minPos[2] };
+	float minUV[2] = { vertices[0].UV.x, vertices[0].UV.y };
+	float maxUV[2] = { minUV[0], minUV[1] };
+	for (unsigned int v = 1; v < vertexCount; v++)
+	{
+		const float* p = &vertices[v].Position.x;
+		for (int i = 0; i < 3; i++)
+		{
+			minPos[i] = p[i] < minPos[i] ? p[i] : minPos[i];
+			maxPos[i] = p[i] > maxPos[i] ? p[i] : maxPos[i];
+		}
+
+		const float* uv = &vertices[v].UV.x;
+		for (int i = 0; i < 2; i++)
+		{
+			minUV[i] = uv[i] < minUV[i] ? uv[i] : minUV[i];
+			maxUV[i] = uv[i] > maxUV[i] ? uv[i] : maxUV[i];
+		}
+	}
+
+	bool quantized = format == VertexFormat::CompactQuantized;
+	if (quantized)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			output.positionOffset[i] = minPos[i];
+			output.positionScale[i] = maxPos[i] - minPos[i];
+		}
+	}
+
+	for (int i = 0; i < 2; i++)
+	{
+		output.uvOffset[i] = minUV[i];
+		output.uvScale[i] = maxUV[i] - minUV[i];
+	}
+
+	std::vector<float> bitangentSigns;
+	CalculateBitangentSigns(vertices, vertexCount, indices, indexCount, bitangentSigns);
+
+	output.data.resize((size_t)vertexCount * output.stride);
+	for (unsigned int v = 0; v < vertexCount; v++)
+	{
+		const ObjVertex& source = vertices[v];
+
+		// Both layouts share everything after the position
+		short normal[2];
+		short tangent[2];
+		unsigned short uv[2];
+		EncodeOctahedral(source.Normal, normal);
+		EncodeTangent(source.Tangent, bitangentSigns[v], tangent);
+		uv[0] = QuantizeUnorm16(source.UV.x, output.uvOffset[0], output.uvScale[0]);
+		uv[1] = QuantizeUnorm16(source.UV.y, output.uvOffset[1], output.uvScale[1]);
+
+		unsigned char* destination = &output.data[(size_t)v * output.stride];
+		ObjFloat3 decodedPosition;
+		if (quantized)
+		{
+			QuantizedVertex packed = {};
+			const float* p = &source.Position.x;
+			float* decoded = &decodedPosition.x;
+			for (int i = 0; i < 3; i++)
+			{
+				packed.Position[i] = QuantizeUnorm16(p[i], output.positionOffset[i], output.positionScale[i]);
+				decoded[i] = DequantizeUnorm16(packed.Position[i], output.positionOffset[i], output.positionScale[i]);
+			}
+			memcpy(packed.Normal, normal, sizeof(normal));
+			memcpy(packed.Tangent, tangent, sizeof(tangent));
+			memcpy(packed.UV, uv, sizeof(uv));
+			memcpy(destination, &packed, sizeof(packed));
+		}
+		else
+		{
+			CompactVertex packed = {};
+			memcpy(packed.Position, &source.Position, sizeof(packed.Position));
+			memcpy(packed.Normal, normal, sizeof(normal));
+			memcpy(packed.Tangent, tangent, sizeof(tangent));
+			memcpy(packed.UV, uv, sizeof(uv));
+			memcpy(destination, &packed, sizeof(packed));
+			decodedPosition = source.Position;
+		}
+
+		// Decode everything again to measure the round-trip error
+		VertexCompressionStats& stats = output.stats;
+		float decodedSign;
+		ObjFloat3 decodedNormal = DecodeOctahedral(normal);
+		ObjFloat3 decodedTangent = DecodeTangent(tangent, &decodedSign);
+
+		float positionError = std::fmax(std::fabs(decodedPosition.x - source.Position.x),
+			std::fmax(std::fabs(decodedPosition.y - source.Position.y), std::fabs(decodedPosition.z - source.Position.z)));
+		float uvError = std::fmax(
+			std::fabs(DequantizeUnorm16(uv[0], output.uvOffset[0], output.uvScale[0]) - source.UV.x),
+			std::fabs(DequantizeUnorm16(uv[1], output.uvOffset[1], output.uvScale[1]) - source.UV.y));
+
+		stats.maxPositionError = std::fmax(stats.maxPositionError, positionError);
+		stats.maxNormalErrorDegrees = std::fmax(stats.maxNormalErrorDegrees, AngleDegrees(decodedNormal, source.Normal));
+		stats.maxTangentErrorDegrees = std::fmax(stats.maxTangentErrorDegrees, AngleDegrees(decodedTangent, source.Tangent));
+		stats.maxUVError = std::fmax(stats.maxUVError, uvError);
+		if (decodedSign != bitangentSigns[v])
+			stats.mismatchedTangentSigns++;
+	}
+
+	output.stats.sourceBytes = vertexCount * (unsigned int)sizeof(ObjVertex);
+	output.stats.compressedBytes = (unsigned int)output.data.size();
+	return true;
+}
+
+unsigned int VertexCompression::GetStride(VertexFormat format)
+{
+	switch (format)
+	{
+	case VertexFormat::Compact: return sizeof(CompactVertex);
+	case VertexFormat::CompactQuantized: return sizeof(QuantizedVertex);
+	default: return sizeof(ObjVertex);
+	}
+}
+
+const char* VertexCompression::GetFormatName(VertexFormat format)
+{
+	return formatNames[(int)format];
+}
+
+// --------------------------------------------------------
+// 0xFFFF is left unused since it's the strip cut value
+// --------------------------------------------------------
+bool VertexCompression::FitsIn16BitIndices(unsigned int vertexCount)
+{
+	return vertexCount < 0xFFFF;
+}
+
+// --------------------------------------------------------
+// Maps a unit vector onto an octahedron, then unfolds the
+// lower half over the upper half so it fits in a square
+// --------------------------------------------------------
+void VertexCompression::EncodeOctahedral(const ObjFloat3& v, short out[2])
+{
+	float length = std::fabs(v.x) + std::fabs(v.y) + std::fabs(v.z);
+	if (!(length > 0.0f) || !std::isfinite(length))
+	{
+		// Zero or invalid vectors point straight up
+		out[0] = 0;
+		out[1] = 0;
+		return;
+	}
+
+	float x = v.x / length;
+	float y = v.y / length;
+	if (v.z < 0.0f)
+	{
+		float foldedX = (1.0f - std::fabs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - std::fabs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+
+	out[0] = ToSnorm16(x);
+	out[1] = ToSnorm16(y);
+}
+
+ObjFloat3 VertexCompression::DecodeOctahedral(const short in[2])
+{
+	ObjFloat3 v;
+	v.x = FromSnorm16(in[0]);
+	v.y = FromSnorm16(in[1]);
+	v.z = 1.0f - std::fabs(v.x) - std::fabs(v.y);
+
+	// Unfold the lower half
+	float t = v.z < 0.0f ? -v.z : 0.0f;
+	v.x += v.x >= 0.0f ? -t : t;
+	v.y += v.y >= 0.0f ? -t : t;
+
+	float length = std::sqrt(Dot(v, v));
+	v.x /= length;
+	v.y /= length;
+	v.z /= length;
+	return v;
+}
+
+void VertexCompression::EncodeTangent(const ObjFloat3& tangent, float bitangentSign, short out[2])
+{
+	EncodeOctahedral(tangent, out);
+	out[1] = (short)((out[1] & ~1) | (bitangentSign < 0.0f ? 1 : 0));
+}
+
+ObjFloat3 VertexCompression::DecodeTangent(const short in[2], float* bitangentSign)
+{
+	if (bitangentSign)
+		*bitangentSign = (in[1] & 1) ? -1.0f : 1.0f;
+
+	short masked[2] = { in[0], (short)(in[1] & ~1) };
+	return DecodeOctahedral(masked);
+}
+
+unsigned short VertexCompression::QuantizeUnorm16(float value, float offset, float scale)
+{
+	if (!(scale > 0.0f))
+		return 0;
+
+	float normalized = (value - offset) / scale;
+	normalized = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+	return (unsigned short)std::lround(normalized * 65535.0f);
+}
+
+float VertexCompression::DequantizeUnorm16(unsigned short value, float offset, float scale)
+{
+	return value / 65535.0f * scale + offset;
+}
@@ -0,0 +1,114 @@
+#pragma once
+#include <vector>
+
+#include "ObjParser.h"
+
+// --------------------------------------------------------
+// How a mesh's vertices are laid out in its GPU buffer
+//
+// - Standard: the full 44 byte Vertex (see Vertex.h)
+// - Compact: float positions with octahedral normals/tangents
+//   and 16-bit UVs (24 bytes)
+// - CompactQuantized: as Compact, but with positions quantized
+//   to 16 bits within the mesh bounds (20 bytes)
+// --------------------------------------------------------
+enum class VertexFormat
+{
+	Standard,
+	Compact,
+	CompactQuantized
+};
+
+// --------------------------------------------------------
+// GPU layouts for the compact formats
+//
+// - Normal and Tangent are octahedral encoded snorm16 pairs
+// - The lowest bit of Tangent[1] holds the bitangent sign
+//   (set means -1), so it's read as SINT and masked in the shader
+// - UV is a unorm16 pair within the mesh's UV bounds, which is
+//   more precise than half floats once UVs tile past 1
+// --------------------------------------------------------
+struct CompactVertex
+{
+	float Position[3];
+	short Normal[2];
+	short Tangent[2];
+	unsigned short UV[2];
+};
+
+struct QuantizedVertex
+{
+	unsigned short Position[4];	// unorm16 within the bounds, w unused
+	short Normal[2];
+	short Tangent[2];
+	unsigned short UV[2];
+};
+
+// --------------------------------------------------------
+// Worst-case error from decoding every compressed vertex and
+// comparing it to the original, plus the memory saved
+// --------------------------------------------------------
+struct VertexCompressionStats
+{
+	float maxPositionError;
+	float maxNormalErrorDegrees;
+	float maxTangentErrorDegrees;
+	float maxUVError;
+	unsigned int mismatchedTangentSigns;
+	unsigned int sourceBytes;
+	unsigned int compressedBytes;
+};
+
+// --------------------------------------------------------
+// The output of a compression pass, ready to upload
+//
+// - The shader rebuilds positions as
+//   position * positionScale + positionOffset, and UVs the same
+//   way with uvScale and uvOffset
+// --------------------------------------------------------
+struct CompressedVertices
+{
+	std::vector<unsigned char> data;
+	unsigned int stride;
+	float positionScale[3];
+	float positionOffset[3];
+	float uvScale[2];
+	float uvOffset[2];
+	VertexCompressionStats stats;
+};
+
+// --------------------------------------------------------
+// Encodes vertices into the compact GPU formats
+//
+// - Has no DirectX dependency, so the encoders and decoders
+//   can be checked against each other on the CPU
+// - Every Compress call decodes its own output again and
+//   records the round-trip error in the stats
+// --------------------------------------------------------
+class VertexCompression
+{
+public:
+	static bool Compress(
+		const ObjVertex* vertices, unsigned int vertexCount,
+		const unsigned int* indices, unsigned int indexCount,
+		VertexFormat format,
+		CompressedVertices& output);
+
+	static unsigned int GetStride(VertexFormat format);
+	static const char* GetFormatName(VertexFormat format);
+
+	// 16-bit indices can address every vertex
+	static bool FitsIn16BitIndices(unsigned int vertexCount);
+
+	// Octahedral unit vectors
+	static void EncodeOctahedral(const ObjFloat3& v, short out[2]);
+	static ObjFloat3 DecodeOctahedral(const short in[2]);
+
+	// Tangents with the bitangent sign in the lowest bit
+	static void EncodeTangent(const ObjFloat3& tangent, float bitangentSign, short out[2]);
+	static ObjFloat3 DecodeTangent(const short in[2], float* bitangentSign);
+
+	// 16-bit fixed point within [offset, offset + scale]
+	static unsigned short QuantizeUnorm16(float value, float offset, float scale);
+	static float DequantizeUnorm16(unsigned short value, float offset, float scale);
+};
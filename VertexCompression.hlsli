@@ -0,0 +1,38 @@
+#ifndef __GPP_VERTEX_COMPRESSION__
+#define __GPP_VERTEX_COMPRESSION__
+
+#include "ShaderStructs.hlsli"
+
+// Rebuilds a unit vector from its octahedral encoding
+float3 DecodeOctahedral(float2 encoded)
+{
+    float3 v = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    
+    // Unfold the lower half of the octahedron
+    float t = saturate(-v.z);
+    v.xy += v.xy >= 0.0f ? -t : t;
+    return normalize(v);
+}
+
+// Unpacks a compact vertex into the standard vertex input
+VertexShaderInput DecodeCompactVertex(
+    CompactVertexShaderInput input,
+    float3 positionScale, float3 positionOffset,
+    float2 uvScale, float2 uvOffset)
+{
+    VertexShaderInput output;
+    output.localPosition = input.position.xyz * positionScale + positionOffset;
+    output.normal = DecodeOctahedral(input.normal);
+    
+    // Mask off the bitangent sign before decoding the tangent
+    // - The sign isn't needed yet, as the pixel shader rebuilds B = cross(T, N)
+    int2 tangentBits = input.tangent;
+    tangentBits.y &= ~1;
+    output.tangent = DecodeOctahedral(max(float2(tangentBits) / 32767.0f, -1.0f));
+    
+    output.uv = input.uv * uvScale + uvOffset;
+    output.shadowMapPos = float4(0, 0, 0, 0);
+    return output;
+}
+
+#endif
@@ -0,0 +1,414 @@
+// --------------------------------------------------------
+// Tests for VertexCompression
+//
+// - Compresses a UV sphere and a few hand-made quads into
+//   each VertexFormat, decodes the buffers independently of
+//   Compress()'s own stats, and checks the worst position,
+//   normal, tangent and UV errors against fixed limits
+// - Octahedral edge cases: the poles (+-Z), the fold seam
+//   (z = 0, and just under it), the axes and zero vectors
+// - Bitangent signs survive, including on zero (degenerate)
+//   tangents and on triangles with degenerate UVs
+// - Not part of the Visual Studio project. On Linux it's the
+//   vertex_compression_tests target in CMakeLists.txt, or:
+//     g++ -O2 -std=c++20 VertexCompressionTests.cpp
+//       VertexCompression.cpp -o vertex_compression_tests
+// --------------------------------------------------------
+#include "VertexCompression.h"
+#include "TestChecks.h"
+
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// Limits for 16-bit encodings. Tangents lose their lowest bit to the sign
+	const float maxNormalErrorDegrees = 0.005f;
+	const float maxTangentErrorDegrees = 0.01f;
+
+	float Dot(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+
+	ObjFloat3 Normalize(const ObjFloat3& v)
+	{
+		float length = sqrtf(Dot(v, v));
+		return { v.x / length, v.y / length, v.z / length };
+	}
+
+	// In doubles, and from atan2 rather than acos, which can't
+	// resolve angles this small
+	float AngleDegrees(const ObjFloat3& a, const ObjFloat3& b)
+	{
+		double cross[3] =
+		{
+			(double)a.y * b.z - (double)a.z * b.y,
+			(double)a.z * b.x - (double)a.x * b.z,
+			(double)a.x * b.y - (double)a.y * b.x,
+		};
+		double sine = sqrt(cross[0] * cross[0] + cross[1] * cross[1] + cross[2] * cross[2]);
+		double cosine = (double)a.x * b.x + (double)a.y * b.y + (double)a.z * b.z;
+		return (float)(atan2(sine, cosine) * 57.29577951308232);
+	}
+
+	struct TestMesh
+	{
+		std::vector<ObjVertex> vertices;
+		std::vector<unsigned int> indices;
+
+		// Expected bitangent sign per vertex, or 0 where it isn't known
+		std::vector<float> signs;
+	};
+
+	// --------------------------------------------------------
+	// A sphere away from the origin, with UVs tiling 4 x 2
+	// times, so the UV bounds aren't [0, 1]
+	// --------------------------------------------------------
+	void AddSphere(TestMesh& mesh, unsigned int rings, unsigned int segments)
+	{
+		unsigned int first = (unsigned int)mesh.vertices.size();
+		for (unsigned int r = 0; r <= rings; r++)
+		{
+			float phi = 3.14159265f * r / rings;
+			for (unsigned int s = 0; s <= segments; s++)
+			{
+				float theta = 6.28318531f * s / segments;
+				ObjFloat3 normal = { sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta) };
+
+				ObjVertex vertex = {};
+				vertex.Position = { normal.x * 3.0f + 10.0f, normal.y * 3.0f - 2.0f, normal.z * 3.0f + 0.5f };
+				vertex.Normal = normal;
+				vertex.Tangent = { -sinf(theta), 0.0f, cosf(theta) };
+				vertex.UV = { 4.0f * s / segments, 2.0f * r / rings };
+				mesh.vertices.push_back(vertex);
+				mesh.signs.push_back(0.0f);
+			}
+		}
+
+		for (unsigned int r = 0; r < rings; r++)
+		{
+			for (unsigned int s = 0; s < segments; s++)
+			{
+				unsigned int a = first + r * (segments + 1) + s;
+				unsigned int b = a + segments + 1;
+				mesh.indices.insert(mesh.indices.end(), { a, a + 1, b, a + 1, b + 1, b });
+			}
+		}
+	}
+
+	// --------------------------------------------------------
+	// A quad in the XY plane facing -Z, with the tangent along
+	// +X, so cross(T, N) is +Y
+	//
+	// - vUp maps V along +Y (sign +1), otherwise along -Y like
+	//   D3D textures (sign -1)
+	// - flatUV gives every corner the same UV, so the bitangent
+	//   can't be found and the sign falls back to +1
+	// - zeroTangent leaves the tangent zeroed, as degenerate
+	//   input would
+	// --------------------------------------------------------
+	void AddQuad(TestMesh& mesh, float x, bool vUp, bool flatUV, bool zeroTangent)
+	{
+		unsigned int first = (unsigned int)mesh.vertices.size();
+		const float corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+		for (const float* corner : corners)
+		{
+			ObjVertex vertex = {};
+			vertex.Position = { x + corner[0], corner[1], 0.0f };
+			vertex.Normal = { 0.0f, 0.0f, -1.0f };
+			vertex.Tangent = zeroTangent ? ObjFloat3{ 0.0f, 0.0f, 0.0f } : ObjFloat3{ 1.0f, 0.0f, 0.0f };
+			vertex.UV = flatUV ? ObjFloat2{ 0.25f, 0.25f } : ObjFloat2{ corner[0], vUp ? corner[1] : 1.0f - corner[1] };
+			mesh.vertices.push_back(vertex);
+
+			// A zeroed tangent's cross(T, N) is zero, so any bitangent counts as +1
+			mesh.signs.push_back(flatUV || zeroTangent || vUp ? 1.0f : -1.0f);
+		}
+		mesh.indices.insert(mesh.indices.end(), { first, first + 1, first + 2, first, first + 2, first + 3 });
+	}
+
+	// One decoded vertex, read back out of a compressed buffer
+	struct DecodedVertex
+	{
+		ObjFloat3 position;
+		ObjFloat3 normal;
+		ObjFloat3 tangent;
+		float sign;
+		ObjFloat2 uv;
+	};
+
+	DecodedVertex Decode(const CompressedVertices& compressed, VertexFormat format, unsigned int index)
+	{
+		const unsigned char* source = &compressed.data[(size_t)index * compressed.stride];
+		const short* normal;
+		const short* tangent;
+		const unsigned short* uv;
+
+		DecodedVertex decoded = {};
+		CompactVertex compact;
+		QuantizedVertex quantized;
+		if (format == VertexFormat::CompactQuantized)
+		{
+			memcpy(&quantized, source, sizeof(quantized));
+			float* position = &decoded.position.x;
+			for (int i = 0; i < 3; i++)
+				position[i] = VertexCompression::DequantizeUnorm16(quantized.Position[i], compressed.positionOffset[i], compressed.positionScale[i]);
+			normal = quantized.Normal;
+			tangent = quantized.Tangent;
+			uv = quantized.UV;
+		}
+		else
+		{
+			memcpy(&compact, source, sizeof(compact));
+			decoded.position = { compact.Position[0], compact.Position[1], compact.Position[2] };
+			normal = compact.Normal;
+			tangent = compact.Tangent;
+			uv = compact.UV;
+		}
+
+		decoded.normal = VertexCompression::DecodeOctahedral(normal);
+		decoded.tangent = VertexCompression::DecodeTangent(tangent, &decoded.sign);
+		decoded.uv.x = VertexCompression::DequantizeUnorm16(uv[0], compressed.uvOffset[0], compressed.uvScale[0]);
+		decoded.uv.y = VertexCompression::DequantizeUnorm16(uv[1], compressed.uvOffset[1], compressed.uvScale[1]);
+		return decoded;
+	}
+
+	// --------------------------------------------------------
+	// Round trips a whole mesh through one format
+	//
+	// - Positions are exact unless quantized, then within half a
+	//   step of the bounds; UVs are within half a step of theirs
+	// --------------------------------------------------------
+	void TestFormat(const TestMesh& mesh, VertexFormat format)
+	{
+		unsigned int vertexCount = (unsigned int)mesh.vertices.size();
+		CompressedVertices compressed;
+		bool compressedAny = VertexCompression::Compress(
+			mesh.vertices.data(), vertexCount,
+			mesh.indices.data(), (unsigned int)mesh.indices.size(),
+			format, compressed);
+
+		CHECK(compressed.stride == VertexCompression::GetStride(format));
+		if (format == VertexFormat::Standard)
+		{
+			CHECK(!compressedAny);
+			CHECK(compressed.data.empty());
+			CHECK(compressed.stride == sizeof(ObjVertex));
+			return;
+		}
+
+		CHECK(compressedAny);
+		CHECK(compressed.data.size() == (size_t)vertexCount * compressed.stride);
+		CHECK(compressed.stats.mismatchedTangentSigns == 0);
+
+		bool quantized = format == VertexFormat::CompactQuantized;
+		float maxPositionError = 0.0f;
+		float maxNormalError = 0.0f;
+		float maxTangentError = 0.0f;
+		float maxUVError[2] = { 0.0f, 0.0f };
+		bool positionsInBounds = true;
+		bool signsMatch = true;
+		for (unsigned int v = 0; v < vertexCount; v++)
+		{
+			const ObjVertex& source = mesh.vertices[v];
+			DecodedVertex decoded = Decode(compressed, format, v);
+
+			const float* original = &source.Position.x;
+			const float* position = &decoded.position.x;
+			for (int i = 0; i < 3; i++)
+			{
+				float error = fabsf(position[i] - original[i]);
+				float allowed = quantized ? compressed.positionScale[i] / 65535.0f * 0.5f + 1e-5f : 0.0f;
+				positionsInBounds = positionsInBounds && error <= allowed;
+				maxPositionError = error > maxPositionError ? error : maxPositionError;
+			}
+
+			float normalError = AngleDegrees(decoded.normal, source.Normal);
+			maxNormalError = normalError > maxNormalError ? normalError : maxNormalError;
+
+			if (Dot(source.Tangent, source.Tangent) > 0.0f)
+			{
+				float tangentError = AngleDegrees(decoded.tangent, source.Tangent);
+				maxTangentError = tangentError > maxTangentError ? tangentError : maxTangentError;
+			}
+
+			maxUVError[0] = fmaxf(maxUVError[0], fabsf(decoded.uv.x - source.UV.x));
+			maxUVError[1] = fmaxf(maxUVError[1], fabsf(decoded.uv.y - source.UV.y));
+
+			if (mesh.signs[v] != 0.0f)
+				signsMatch = signsMatch && decoded.sign == mesh.signs[v];
+		}
+
+		printf("  %s: position %g, normal %.4f deg, tangent %.4f deg, uv %g / %g, %u -> %u bytes\n",
+			VertexCompression::GetFormatName(format), maxPositionError, maxNormalError, maxTangentError,
+			maxUVError[0], maxUVError[1], compressed.stats.sourceBytes, compressed.stats.compressedBytes);
+
+		CHECK(positionsInBounds);
+		CHECK(maxNormalError <= maxNormalErrorDegrees);
+		CHECK(maxTangentError <= maxTangentErrorDegrees);
+		CHECK(maxUVError[0] <= compressed.uvScale[0] / 65535.0f * 0.5f + 1e-5f);
+		CHECK(maxUVError[1] <= compressed.uvScale[1] / 65535.0f * 0.5f + 1e-5f);
+		CHECK(signsMatch);
+
+		// Compress()'s own stats measure the same thing
+		CHECK(fabsf(compressed.stats.maxPositionError - maxPositionError) <= 1e-6f);
+		CHECK(fabsf(compressed.stats.maxNormalErrorDegrees - maxNormalError) <= 1e-4f);
+		CHECK(fabsf(compressed.stats.maxTangentErrorDegrees - maxTangentError) <= 1e-4f);
+		CHECK(fabsf(compressed.stats.maxUVError - fmaxf(maxUVError[0], maxUVError[1])) <= 1e-6f);
+	}
+
+	// --------------------------------------------------------
+	// Octahedral encoding where it's easiest to get wrong
+	// --------------------------------------------------------
+	void TestOctahedralEdgeCases()
+	{
+		const ObjFloat3 exact[] =
+		{
+			{ 0, 0, 1 }, { 0, 0, -1 },
+			{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 },
+		};
+
+		// Poles and axes come back exactly
+		for (const ObjFloat3& v : exact)
+		{
+			short encoded[2];
+			VertexCompression::EncodeOctahedral(v, encoded);
+			ObjFloat3 decoded = VertexCompression::DecodeOctahedral(encoded);
+			CHECK(fabsf(decoded.x - v.x) <= 1e-6f && fabsf(decoded.y - v.y) <= 1e-6f && fabsf(decoded.z - v.z) <= 1e-6f);
+		}
+
+		// On and around the fold, in every quadrant, including x or y of zero
+		const ObjFloat3 seam[] =
+		{
+			{ 0.6f, -0.8f, 0.0f }, { -0.6f, 0.8f, 0.0f }, { -0.7f, -0.7f, 0.0f },
+			{ 0.7f, 0.7f, -1e-4f }, { -0.3f, 0.9f, -1e-6f }, { 0.5f, -0.5f, 1e-6f },
+			{ 0.0f, 0.6f, -0.8f }, { 0.0f, -0.6f, -0.8f }, { 0.6f, 0.0f, -0.8f }, { -0.6f, 0.0f, -0.8f },
+			{ -0.0f, -0.0f, -1.0f }, { 1e-6f, -1e-6f, -1.0f }, { -1e-6f, 1e-6f, 1.0f },
+			{ 0.577f, -0.577f, -0.577f }, { -0.577f, -0.577f, -0.577f },
+		};
+
+		float worstSeam = 0.0f;
+		for (const ObjFloat3& v : seam)
+		{
+			ObjFloat3 unit = Normalize(v);
+			short encoded[2];
+			VertexCompression::EncodeOctahedral(unit, encoded);
+			float error = AngleDegrees(VertexCompression::DecodeOctahedral(encoded), unit);
+			worstSeam = error > worstSeam ? error : worstSeam;
+		}
+		printf("  Octahedral seam: %.4f deg\n", worstSeam);
+		CHECK(worstSeam <= maxNormalErrorDegrees);
+
+		// Sweep the whole sphere, densest across the seam
+		float worstSweep = 0.0f;
+		for (unsigned int i = 0; i <= 400; i++)
+		{
+			float z = -1.0f + 2.0f * i / 400.0f;
+			z = z * z * z;
+			for (unsigned int j = 0; j < 64; j++)
+			{
+				float angle = 6.28318531f * j / 64.0f;
+				float ring = sqrtf(1.0f - z * z);
+				ObjFloat3 unit = Normalize({ ring * cosf(angle), ring * sinf(angle), z });
+				short encoded[2];
+				VertexCompression::EncodeOctahedral(unit, encoded);
+				float error = AngleDegrees(VertexCompression::DecodeOctahedral(encoded), unit);
+				worstSweep = error > worstSweep ? error : worstSweep;
+			}
+		}
+		printf("  Octahedral sweep: %.4f deg\n", worstSweep);
+		CHECK(worstSweep <= maxNormalErrorDegrees);
+
+		// Zero and invalid vectors point straight up rather than becoming NaN
+		const ObjFloat3 invalid[] = { { 0, 0, 0 }, { NAN, 0, 1 }, { INFINITY, 0, 0 } };
+		for (const ObjFloat3& v : invalid)
+		{
+			short encoded[2];
+			VertexCompression::EncodeOctahedral(v, encoded);
+			ObjFloat3 decoded = VertexCompression::DecodeOctahedral(encoded);
+			CHECK(decoded.x == 0.0f && decoded.y == 0.0f && decoded.z == 1.0f);
+		}
+	}
+
+	// --------------------------------------------------------
+	// The sign bit never disturbs the direction, and is kept
+	// whatever the tangent, even a zeroed one
+	// --------------------------------------------------------
+	void TestTangentSigns()
+	{
+		const ObjFloat3 tangents[] =
+		{
+			{ 0, 0, 0 },
+			{ 1, 0, 0 }, { 0, -1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+			{ 0.6f, -0.8f, 0.0f }, { -0.577f, 0.577f, -0.577f },
+		};
+
+		for (const ObjFloat3& tangent : tangents)
+		{
+			bool zero = Dot(tangent, tangent) == 0.0f;
+			for (float sign : { 1.0f, -1.0f })
+			{
+				short encoded[2];
+				VertexCompression::EncodeTangent(zero ? tangent : Normalize(tangent), sign, encoded);
+
+				float decodedSign = 0.0f;
+				ObjFloat3 decoded = VertexCompression::DecodeTangent(encoded, &decodedSign);
+				CHECK(decodedSign == sign);
+				CHECK(std::isfinite(decoded.x) && std::isfinite(decoded.y) && std::isfinite(decoded.z));
+				if (!zero)
+					CHECK(AngleDegrees(decoded, tangent) <= maxTangentErrorDegrees);
+			}
+		}
+
+		// No sign to read is fine too
+		short encoded[2];
+		VertexCompression::EncodeTangent({ 1, 0, 0 }, -1.0f, encoded);
+		ObjFloat3 decoded = VertexCompression::DecodeTangent(encoded, nullptr);
+		CHECK(decoded.x > 0.999f);
+	}
+
+	// --------------------------------------------------------
+	// 16-bit fixed point, including empty ranges (a mesh with
+	// one UV everywhere) and values just outside the range
+	// --------------------------------------------------------
+	void TestUnorm16()
+	{
+		CHECK(VertexCompression::QuantizeUnorm16(-3.0f, -3.0f, 5.0f) == 0);
+		CHECK(VertexCompression::QuantizeUnorm16(2.0f, -3.0f, 5.0f) == 65535);
+		CHECK(VertexCompression::QuantizeUnorm16(-4.0f, -3.0f, 5.0f) == 0);
+		CHECK(VertexCompression::QuantizeUnorm16(9.0f, -3.0f, 5.0f) == 65535);
+		CHECK(VertexCompression::DequantizeUnorm16(0, -3.0f, 5.0f) == -3.0f);
+		CHECK(VertexCompression::DequantizeUnorm16(65535, -3.0f, 5.0f) == 2.0f);
+
+		CHECK(VertexCompression::QuantizeUnorm16(0.25f, 0.25f, 0.0f) == 0);
+		CHECK(VertexCompression::DequantizeUnorm16(0, 0.25f, 0.0f) == 0.25f);
+	}
+}
+
+int main()
+{
+	TestMesh mesh;
+	AddSphere(mesh, 32, 64);
+	AddQuad(mesh, 20.0f, true, false, false);
+	AddQuad(mesh, 22.0f, false, false, false);
+	AddQuad(mesh, 24.0f, false, true, false);
+	AddQuad(mesh, 26.0f, false, false, true);
+
+	for (VertexFormat format : { VertexFormat::Standard, VertexFormat::Compact, VertexFormat::CompactQuantized })
+		TestFormat(mesh, format);
+
+	CHECK(VertexCompression::GetStride(VertexFormat::Compact) == 24);
+	CHECK(VertexCompression::GetStride(VertexFormat::CompactQuantized) == 20);
+
+	// Empty input compresses to nothing
+	CompressedVertices empty;
+	CHECK(!VertexCompression::Compress(nullptr, 0, nullptr, 0, VertexFormat::Compact, empty));
+	CHECK(empty.data.empty());
+
+	TestOctahedralEdgeCases();
+	TestTangentSigns();
+	TestUnorm16();
+
+	return TestChecks::Finish("VertexCompression");
+}
@@ -1,12 +1,27 @@
 #include "ShaderStructs.hlsli"
+#ifdef COMPACT_VERTEX
+#include "VertexCompression.hlsli"
+#endif
+#ifdef SKINNED_VERTEX
+#include "Skinning.hlsli"
+#endif
 
 cbuffer EntityData : register(b0)
 {
-	matrix world;
-	matrix worldInvTranspose;
+	// Affine 3x4s, as the 4th row is always (0, 0, 0, 1) (see AffineMatrix.h)
+	row_major float3x4 world;
+	row_major float3x4 worldInvTranspose;
 	
     matrix lightView;
     matrix lightProjection;
+	
+#ifdef COMPACT_VERTEX
+	// Dequantization for the compact vertex formats
+    float3 positionScale;
+    float3 positionOffset;
+    float2 uvScale;
+    float2 uvOffset;
+#endif
 }
 
 cbuffer FrameData : register(b1)
@@ -15,14 +30,27 @@ cbuffer FrameData : register(b1)
 	matrix projection;
 }
 
+#ifdef COMPACT_VERTEX
+VertexToPixel main(CompactVertexShaderInput compactInput)
+{
+	// Unpack into the standard vertex, then carry on as usual
+    VertexShaderInput input = DecodeCompactVertex(compactInput, positionScale, positionOffset, uvScale, uvOffset);
+#elif defined(SKINNED_VERTEX)
+VertexToPixel main(SkinnedVertexShaderInput skinnedInput)
+{
+	// Pose the bind pose vertex, then carry on as usual
+    VertexShaderInput input = SkinVertex(skinnedInput);
+#else
 VertexToPixel main(VertexShaderInput input)
 {
+#endif
+
 	// Set up output struct
 	VertexToPixel output;
 	
-	// Get the screen position of the vertex
-	matrix wvp = mul(projection, mul(view, world));
-    output.screenPosition = mul(wvp, float4(input.localPosition, 1.0f));
+	// Get the world and screen positions of the vertex
+    float4 worldPosition = float4(mul(world, float4(input.localPosition, 1.0f)), 1.0f);
+    output.screenPosition = mul(projection, mul(view, worldPosition));
 
 	// Set UV and Normals
     output.uv = input.uv;
@@ -30,10 +58,9 @@ VertexToPixel main(VertexShaderInput input)
     output.tangent = mul((float3x3)world, input.tangent);
 	
 	// Set world position
-	output.worldPosition = mul(world, float4(input.localPosition, 1)).xyz;
+	output.worldPosition = worldPosition.xyz;
 	
-    matrix shadowWVP = mul(lightProjection, mul(lightView, world));
-    output.shadowMapPos = mul(shadowWVP, float4(input.localPosition, 1.0f));
+    output.shadowMapPos = mul(lightProjection, mul(lightView, worldPosition));
 	
 	return output;
 }
\ No newline at end of file